@@ -0,0 +1,820 @@
+#pragma once
+#pragma region --- INCLUDES ---
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <immintrin.h>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <vector>
+#pragma endregion INCLUDES
+
+struct Aabb {
+	std::array<float, 3> min = { std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max() };
+	std::array<float, 3> max = { -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max() };
+
+	void grow(const Aabb& other) {
+		for (int axis = 0; axis < 3; axis++)
+		{
+			min[axis] = std::min(min[axis], other.min[axis]);
+			max[axis] = std::max(max[axis], other.max[axis]);
+		}
+	}
+
+	void grow(const std::array<float, 3>& point) {
+		for (int axis = 0; axis < 3; axis++)
+		{
+			min[axis] = std::min(min[axis], point[axis]);
+			max[axis] = std::max(max[axis], point[axis]);
+		}
+	}
+
+	float surfaceArea() const {
+		float x = max[0] - min[0];
+		float y = max[1] - min[1];
+		float z = max[2] - min[2];
+		return 2.0f * (x * y + y * z + z * x);
+	}
+
+	bool operator==(const Aabb& other) const {
+		return min == other.min && max == other.max;
+	}
+};
+
+// six planes with their normals pointing inwards
+struct Frustum {
+	// a point p is on the inside of a plane when dot(xyz, p) + w >= 0
+	std::array<std::array<float, 4>, 6> planes;
+
+	// from a column major view projection matrix with Vulkan's 0 to 1 depth range
+	static Frustum fromMatrix(const std::array<float, 16>& matrix) {
+		auto row = [&](int r) {
+			return std::array<float, 4>{ matrix[r], matrix[4 + r], matrix[8 + r], matrix[12 + r] };
+		};
+		auto add = [](const std::array<float, 4>& a, const std::array<float, 4>& b, float sign) {
+			return std::array<float, 4>{ a[0] + sign * b[0], a[1] + sign * b[1], a[2] + sign * b[2], a[3] + sign * b[3] };
+		};
+		std::array<float, 4> x = row(0);
+		std::array<float, 4> y = row(1);
+		std::array<float, 4> z = row(2);
+		std::array<float, 4> w = row(3);
+
+		// left, right, top, bottom, near, far
+		return { { add(w, x, 1.0f), add(w, x, -1.0f), add(w, y, 1.0f), add(w, y, -1.0f), z, add(w, z, -1.0f) } };
+	}
+
+	// conservative: boxes close to the edges of the frustum can pass without actually touching it
+	bool intersects(const Aabb& box) const {
+		for (const std::array<float, 4>& plane : planes)
+		{
+			// the corner furthest along the normal
+			float distance = plane[3];
+			for (int axis = 0; axis < 3; axis++)
+			{
+				distance += plane[axis] * (plane[axis] >= 0.0f ? box.max[axis] : box.min[axis]);
+			}
+			if (distance < 0.0f)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+};
+
+// a dynamic bounding volume hierarchy for frustum culling on the CPU
+// inner nodes have four children and leaves hold up to eight objects, both with their boxes stored per component
+// (center x of every child, then center y, ...) so a single SSE instruction tests four boxes against a plane,
+// or a single AVX instruction all eight objects of a leaf when compiled with /arch:AVX.
+// moving objects only refits the boxes above them, objects being added or removed, or refitting having
+// made the tree a lot worse than it was, rebuilds it from scratch with a binned surface area heuristic.
+// culling splits the top of the tree into tasks that the calling thread and the workers take from.
+class BoundingVolumeHierarchy {
+public:
+	static constexpr uint32_t NODE_WIDTH = 4;
+	static constexpr uint32_t LEAF_SIZE = 8;
+	static constexpr uint32_t BIN_COUNT = 16;
+	// surface area cost compared to right after the last build
+	static constexpr float REBUILD_COST_RATIO = 1.5f;
+	// fewer objects than this get culled on the calling thread alone, waking the workers would cost more than it saves
+	static constexpr size_t PARALLEL_THRESHOLD = 4096;
+	// tasks per thread culling in parallel, more of them spread the work more evenly
+	static constexpr size_t TASKS_PER_THREAD = 4;
+	static constexpr uint32_t INVALID = 0xFFFFFFFF;
+
+	explicit BoundingVolumeHierarchy(size_t workerCount = 0) {
+		threadResults.resize(workerCount + 1);
+		threadStacks.resize(workerCount + 1);
+		for (size_t i = 0; i < workerCount; i++)
+		{
+			workers.emplace_back(&BoundingVolumeHierarchy::workerLoop, this, i + 1);
+		}
+	}
+
+	~BoundingVolumeHierarchy() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		wake.notify_all();
+		for (std::thread& worker : workers)
+		{
+			worker.join();
+		}
+	}
+
+	BoundingVolumeHierarchy(const BoundingVolumeHierarchy&) = delete;
+	BoundingVolumeHierarchy& operator=(const BoundingVolumeHierarchy&) = delete;
+
+	// payload is whatever the caller needs to find the object again, it's what culling hands back
+	// returns the id to move or remove the object with
+	uint32_t add(const Aabb& bounds, uint32_t payload) {
+		uint32_t id;
+		if (freeObjects.empty())
+		{
+			id = static_cast<uint32_t>(objects.size());
+			objects.emplace_back();
+		}
+		else
+		{
+			id = freeObjects.back();
+			freeObjects.pop_back();
+		}
+		objects[id] = { bounds, payload, INVALID, 0, true };
+		objectCount++;
+		needsRebuild = true;
+		return id;
+	}
+
+	void remove(uint32_t id) {
+		objects[id].alive = false;
+		freeObjects.push_back(id);
+		objectCount--;
+		needsRebuild = true;
+	}
+
+	void move(uint32_t id, const Aabb& bounds) {
+		Object& object = objects[id];
+		if (object.bounds == bounds)
+		{
+			return;
+		}
+		object.bounds = bounds;
+
+		// not in the tree yet, the next build picks it up
+		if (needsRebuild || object.leaf == INVALID)
+		{
+			return;
+		}
+		writeBox(leaves[object.leaf].bounds[0], LEAF_SIZE, object.slot, bounds);
+		if (!leafDirty[object.leaf])
+		{
+			leafDirty[object.leaf] = true;
+			dirtyLeaves.push_back(object.leaf);
+		}
+	}
+
+	void clear() {
+		objects.clear();
+		freeObjects.clear();
+		objectCount = 0;
+		needsRebuild = true;
+	}
+
+	size_t size() const {
+		return objectCount;
+	}
+
+	// has to be called after adding, moving or removing objects and before culling
+	void update() {
+		if (!needsRebuild && !dirtyLeaves.empty())
+		{
+			refit();
+			needsRebuild = cost > builtCost * REBUILD_COST_RATIO;
+		}
+		if (needsRebuild)
+		{
+			build();
+		}
+	}
+
+	uint32_t rebuildCount() const {
+		return rebuilds;
+	}
+
+	// payloads of every object that might be inside the frustum, in no particular order
+	void cull(const Frustum& frustum, std::vector<uint32_t>& visible, bool parallel = true) {
+		visible.clear();
+		if (root == INVALID)
+		{
+			return;
+		}
+
+		FrustumLanes lanes(frustum);
+		if (!parallel || workers.empty() || objectCount < PARALLEL_THRESHOLD)
+		{
+			cullFrom(lanes, root, visible, threadStacks[0]);
+			return;
+		}
+
+		splitIntoTasks(lanes);
+		sharedLanes = &lanes;
+		nextTask = 0;
+		for (std::vector<uint32_t>& results : threadResults)
+		{
+			results.clear();
+		}
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			runningWorkers = workers.size();
+			generation++;
+		}
+		wake.notify_all();
+
+		runTasks(0);
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			done.wait(lock, [this]() { return runningWorkers == 0; });
+		}
+
+		for (const std::vector<uint32_t>& results : threadResults)
+		{
+			visible.insert(visible.end(), results.begin(), results.end());
+		}
+	}
+
+private:
+	// references to children have this bit set when they point at a leaf
+	static constexpr uint32_t LEAF_BIT = 0x80000000;
+
+	struct Object {
+		Aabb bounds;
+		uint32_t payload;
+		uint32_t leaf;
+		uint32_t slot;
+		bool alive;
+	};
+
+	// rows: center x, y, z, half extent x, y, z
+	struct Node {
+		float bounds[6][NODE_WIDTH];
+		uint32_t children[NODE_WIDTH];
+		uint32_t count;
+		uint32_t parent;
+		uint32_t parentSlot;
+	};
+
+	struct Leaf {
+		float bounds[6][LEAF_SIZE];
+		uint32_t payloads[LEAF_SIZE];
+		uint32_t count;
+		uint32_t parent;
+		uint32_t parentSlot;
+	};
+
+	// the planes broadcast into every lane once per cull, instead of once per test
+	struct FrustumLanes {
+		// per plane: normal x, y, z, distance, absolute normal x, y, z
+		std::array<std::array<__m128, 7>, 6> planes4;
+#ifdef __AVX__
+		std::array<std::array<__m256, 7>, 6> planes8;
+#endif
+
+		explicit FrustumLanes(const Frustum& frustum) {
+			for (size_t p = 0; p < 6; p++)
+			{
+				const std::array<float, 4>& plane = frustum.planes[p];
+				std::array<float, 7> values = { plane[0], plane[1], plane[2], plane[3],
+					std::abs(plane[0]), std::abs(plane[1]), std::abs(plane[2]) };
+				for (size_t i = 0; i < 7; i++)
+				{
+					planes4[p][i] = _mm_set1_ps(values[i]);
+#ifdef __AVX__
+					planes8[p][i] = _mm256_set1_ps(values[i]);
+#endif
+				}
+			}
+		}
+	};
+
+	struct BuildItem {
+		std::array<float, 3> centroid;
+		uint32_t object;
+	};
+
+	struct Task {
+		uint32_t reference;
+		// entirely inside the frustum, nothing below it needs testing
+		bool inside;
+	};
+
+	std::vector<Object> objects;
+	std::vector<uint32_t> freeObjects;
+	size_t objectCount = 0;
+
+	// parents always come before their children
+	std::vector<Node> nodes;
+	std::vector<Leaf> leaves;
+	uint32_t root = INVALID;
+	std::vector<BuildItem> buildItems;
+	bool needsRebuild = false;
+	uint32_t rebuilds = 0;
+
+	std::vector<bool> leafDirty;
+	std::vector<uint32_t> dirtyLeaves;
+	std::vector<bool> nodeDirty;
+	// surface area of every box below the root relative to the root itself
+	float cost = 0.0f;
+	float builtCost = 0.0f;
+
+	#pragma region --- WORKERS ---
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::condition_variable done;
+	uint64_t generation = 0;
+	size_t runningWorkers = 0;
+	bool stopping = false;
+
+	std::vector<Task> tasks;
+	std::vector<Task> expandedTasks;
+	std::atomic<size_t> nextTask{ 0 };
+	const FrustumLanes* sharedLanes = nullptr;
+	// index 0 belongs to the calling thread
+	std::vector<std::vector<uint32_t>> threadResults;
+	std::vector<std::vector<uint32_t>> threadStacks;
+	#pragma endregion WORKERS
+
+	#pragma region --- BOXES ---
+	static void writeBox(float* bounds, uint32_t stride, uint32_t slot, const Aabb& box) {
+		for (uint32_t axis = 0; axis < 3; axis++)
+		{
+			bounds[axis * stride + slot] = (box.min[axis] + box.max[axis]) * 0.5f;
+			bounds[(axis + 3) * stride + slot] = (box.max[axis] - box.min[axis]) * 0.5f;
+		}
+	}
+
+	static Aabb readBoxes(const float* bounds, uint32_t stride, uint32_t count) {
+		Aabb box;
+		for (uint32_t slot = 0; slot < count; slot++)
+		{
+			for (uint32_t axis = 0; axis < 3; axis++)
+			{
+				float center = bounds[axis * stride + slot];
+				float extent = bounds[(axis + 3) * stride + slot];
+				box.min[axis] = std::min(box.min[axis], center - extent);
+				box.max[axis] = std::max(box.max[axis], center + extent);
+			}
+		}
+		return box;
+	}
+
+	Aabb boundsOf(uint32_t reference) const {
+		if (reference & LEAF_BIT)
+		{
+			const Leaf& leaf = leaves[reference & ~LEAF_BIT];
+			return readBoxes(leaf.bounds[0], LEAF_SIZE, leaf.count);
+		}
+		const Node& node = nodes[reference];
+		return readBoxes(node.bounds[0], NODE_WIDTH, node.count);
+	}
+	#pragma endregion BOXES
+
+	#pragma region --- FRUSTUM TESTS ---
+	// tests four boxes at once, bit i of the result is set when box i might be visible
+	// insideMask gets the boxes that are entirely inside every plane
+	static uint32_t testBoxes4(const FrustumLanes& lanes, const float* bounds, uint32_t stride, uint32_t& insideMask) {
+		__m128 centerX = _mm_loadu_ps(bounds);
+		__m128 centerY = _mm_loadu_ps(bounds + stride);
+		__m128 centerZ = _mm_loadu_ps(bounds + stride * 2);
+		__m128 extentX = _mm_loadu_ps(bounds + stride * 3);
+		__m128 extentY = _mm_loadu_ps(bounds + stride * 4);
+		__m128 extentZ = _mm_loadu_ps(bounds + stride * 5);
+
+		__m128 zero = _mm_setzero_ps();
+		__m128 outside = zero;
+		__m128 crossing = zero;
+		for (const std::array<__m128, 7>& plane : lanes.planes4)
+		{
+			__m128 distance = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(plane[0], centerX), _mm_mul_ps(plane[1], centerY)),
+				_mm_add_ps(_mm_mul_ps(plane[2], centerZ), plane[3]));
+			// how far the box reaches along the normal
+			__m128 radius = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(plane[4], extentX), _mm_mul_ps(plane[5], extentY)),
+				_mm_mul_ps(plane[6], extentZ));
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), zero));
+			crossing = _mm_or_ps(crossing, _mm_cmplt_ps(_mm_sub_ps(distance, radius), zero));
+		}
+
+		insideMask = ~static_cast<uint32_t>(_mm_movemask_ps(crossing)) & 0xF;
+		return ~static_cast<uint32_t>(_mm_movemask_ps(outside)) & 0xF;
+	}
+
+	// eight boxes, without the inside mask as the objects in a leaf have no children to skip testing
+	static uint32_t testBoxes8(const FrustumLanes& lanes, const float* bounds) {
+#ifdef __AVX__
+		__m256 centerX = _mm256_loadu_ps(bounds);
+		__m256 centerY = _mm256_loadu_ps(bounds + 8);
+		__m256 centerZ = _mm256_loadu_ps(bounds + 16);
+		__m256 extentX = _mm256_loadu_ps(bounds + 24);
+		__m256 extentY = _mm256_loadu_ps(bounds + 32);
+		__m256 extentZ = _mm256_loadu_ps(bounds + 40);
+
+		__m256 zero = _mm256_setzero_ps();
+		__m256 outside = zero;
+		for (const std::array<__m256, 7>& plane : lanes.planes8)
+		{
+			__m256 distance = _mm256_add_ps(
+				_mm256_add_ps(_mm256_mul_ps(plane[0], centerX), _mm256_mul_ps(plane[1], centerY)),
+				_mm256_add_ps(_mm256_mul_ps(plane[2], centerZ), plane[3]));
+			__m256 radius = _mm256_add_ps(
+				_mm256_add_ps(_mm256_mul_ps(plane[4], extentX), _mm256_mul_ps(plane[5], extentY)),
+				_mm256_mul_ps(plane[6], extentZ));
+			outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(distance, radius), zero, _CMP_LT_OQ));
+		}
+		return ~static_cast<uint32_t>(_mm256_movemask_ps(outside)) & 0xFF;
+#else
+		uint32_t inside;
+		return testBoxes4(lanes, bounds, LEAF_SIZE, inside) | (testBoxes4(lanes, bounds + 4, LEAF_SIZE, inside) << 4);
+#endif
+	}
+	#pragma endregion FRUSTUM TESTS
+
+	#pragma region --- TRAVERSAL ---
+	void cullFrom(const FrustumLanes& lanes, uint32_t reference, std::vector<uint32_t>& visible, std::vector<uint32_t>& stack) const {
+		stack.clear();
+		stack.push_back(reference);
+		while (!stack.empty())
+		{
+			uint32_t current = stack.back();
+			stack.pop_back();
+
+			if (current & LEAF_BIT)
+			{
+				const Leaf& leaf = leaves[current & ~LEAF_BIT];
+				uint32_t visibleMask = testBoxes8(lanes, leaf.bounds[0]) & ((1u << leaf.count) - 1);
+				for (uint32_t slot = 0; slot < leaf.count; slot++)
+				{
+					if (visibleMask & (1u << slot))
+					{
+						visible.push_back(leaf.payloads[slot]);
+					}
+				}
+				continue;
+			}
+
+			const Node& node = nodes[current];
+			uint32_t insideMask;
+			uint32_t visibleMask = testBoxes4(lanes, node.bounds[0], NODE_WIDTH, insideMask) & ((1u << node.count) - 1);
+			for (uint32_t slot = 0; slot < node.count; slot++)
+			{
+				if (!(visibleMask & (1u << slot)))
+				{
+					continue;
+				}
+				if (insideMask & (1u << slot))
+				{
+					appendSubtree(node.children[slot], visible);
+				}
+				else
+				{
+					stack.push_back(node.children[slot]);
+				}
+			}
+		}
+	}
+
+	void appendSubtree(uint32_t reference, std::vector<uint32_t>& visible) const {
+		if (reference & LEAF_BIT)
+		{
+			const Leaf& leaf = leaves[reference & ~LEAF_BIT];
+			visible.insert(visible.end(), leaf.payloads, leaf.payloads + leaf.count);
+			return;
+		}
+		const Node& node = nodes[reference];
+		for (uint32_t slot = 0; slot < node.count; slot++)
+		{
+			appendSubtree(node.children[slot], visible);
+		}
+	}
+
+	// expands the top of the tree breadth first until there are enough tasks to go around
+	void splitIntoTasks(const FrustumLanes& lanes) {
+		tasks.clear();
+		tasks.push_back({ root, false });
+
+		size_t wanted = (workers.size() + 1) * TASKS_PER_THREAD;
+		bool expanded = true;
+		while (tasks.size() < wanted && expanded)
+		{
+			expanded = false;
+			expandedTasks.clear();
+			for (const Task& task : tasks)
+			{
+				if (task.inside || (task.reference & LEAF_BIT))
+				{
+					expandedTasks.push_back(task);
+					continue;
+				}
+
+				const Node& node = nodes[task.reference];
+				uint32_t insideMask;
+				uint32_t visibleMask = testBoxes4(lanes, node.bounds[0], NODE_WIDTH, insideMask) & ((1u << node.count) - 1);
+				for (uint32_t slot = 0; slot < node.count; slot++)
+				{
+					if (visibleMask & (1u << slot))
+					{
+						expandedTasks.push_back({ node.children[slot], (insideMask & (1u << slot)) != 0 });
+					}
+				}
+				expanded = true;
+			}
+			tasks.swap(expandedTasks);
+		}
+	}
+
+	void runTasks(size_t thread) {
+		std::vector<uint32_t>& results = threadResults[thread];
+		for (size_t i = nextTask.fetch_add(1); i < tasks.size(); i = nextTask.fetch_add(1))
+		{
+			const Task& task = tasks[i];
+			if (task.inside)
+			{
+				appendSubtree(task.reference, results);
+			}
+			else
+			{
+				cullFrom(*sharedLanes, task.reference, results, threadStacks[thread]);
+			}
+		}
+	}
+
+	void workerLoop(size_t thread) {
+		uint64_t seenGeneration = 0;
+		while (true)
+		{
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				wake.wait(lock, [&]() { return stopping || generation != seenGeneration; });
+				if (stopping)
+				{
+					return;
+				}
+				seenGeneration = generation;
+			}
+
+			runTasks(thread);
+
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				runningWorkers--;
+			}
+			done.notify_one();
+		}
+	}
+	#pragma endregion TRAVERSAL
+
+	#pragma region --- BUILD ---
+	void build() {
+		nodes.clear();
+		leaves.clear();
+		dirtyLeaves.clear();
+		root = INVALID;
+
+		buildItems.clear();
+		for (uint32_t id = 0; id < objects.size(); id++)
+		{
+			Object& object = objects[id];
+			object.leaf = INVALID;
+			if (!object.alive)
+			{
+				continue;
+			}
+			BuildItem item;
+			for (int axis = 0; axis < 3; axis++)
+			{
+				item.centroid[axis] = (object.bounds.min[axis] + object.bounds.max[axis]) * 0.5f;
+			}
+			item.object = id;
+			buildItems.push_back(item);
+		}
+
+		if (!buildItems.empty())
+		{
+			root = buildRange(0, buildItems.size(), INVALID, 0);
+		}
+		leafDirty.assign(leaves.size(), false);
+		nodeDirty.assign(nodes.size(), false);
+		cost = computeCost();
+		builtCost = cost;
+		needsRebuild = false;
+		rebuilds++;
+	}
+
+	// returns a reference to the node or leaf holding buildItems[begin, end)
+	uint32_t buildRange(size_t begin, size_t end, uint32_t parent, uint32_t parentSlot) {
+		if (end - begin <= LEAF_SIZE)
+		{
+			uint32_t index = static_cast<uint32_t>(leaves.size());
+			leaves.emplace_back();
+			Leaf& leaf = leaves.back();
+			leaf.count = static_cast<uint32_t>(end - begin);
+			leaf.parent = parent;
+			leaf.parentSlot = parentSlot;
+			for (uint32_t slot = 0; slot < LEAF_SIZE; slot++)
+			{
+				// unused slots get masked out, they only need to be something that isn't NaN
+				Object* object = slot < leaf.count ? &objects[buildItems[begin + slot].object] : nullptr;
+				writeBox(leaf.bounds[0], LEAF_SIZE, slot, object ? object->bounds : Aabb{ { 0, 0, 0 }, { 0, 0, 0 } });
+				leaf.payloads[slot] = object ? object->payload : 0;
+				if (object)
+				{
+					object->leaf = index;
+					object->slot = slot;
+				}
+			}
+			return index | LEAF_BIT;
+		}
+
+		uint32_t index = static_cast<uint32_t>(nodes.size());
+		nodes.emplace_back();
+		nodes[index].parent = parent;
+		nodes[index].parentSlot = parentSlot;
+
+		// split in two until there are four groups, always splitting the largest one
+		std::array<std::pair<size_t, size_t>, NODE_WIDTH> groups;
+		groups[0] = { begin, end };
+		uint32_t groupCount = 1;
+		while (groupCount < NODE_WIDTH)
+		{
+			uint32_t largest = 0;
+			for (uint32_t group = 1; group < groupCount; group++)
+			{
+				if (groups[group].second - groups[group].first > groups[largest].second - groups[largest].first)
+				{
+					largest = group;
+				}
+			}
+			if (groups[largest].second - groups[largest].first <= LEAF_SIZE)
+			{
+				break;
+			}
+			size_t middle = splitRange(groups[largest].first, groups[largest].second);
+			groups[groupCount++] = { middle, groups[largest].second };
+			groups[largest].second = middle;
+		}
+
+		// building the children adds nodes, so no references into the vector past this point
+		for (uint32_t slot = 0; slot < NODE_WIDTH; slot++)
+		{
+			if (slot < groupCount)
+			{
+				uint32_t child = buildRange(groups[slot].first, groups[slot].second, index, slot);
+				nodes[index].children[slot] = child;
+				writeBox(nodes[index].bounds[0], NODE_WIDTH, slot, boundsOf(child));
+			}
+			else
+			{
+				nodes[index].children[slot] = INVALID;
+				writeBox(nodes[index].bounds[0], NODE_WIDTH, slot, Aabb{ { 0, 0, 0 }, { 0, 0, 0 } });
+			}
+		}
+		nodes[index].count = groupCount;
+		return index;
+	}
+
+	// partitions buildItems[begin, end) where the binned surface area heuristic finds the cheapest split, returns where
+	size_t splitRange(size_t begin, size_t end) {
+		Aabb centroidBounds;
+		for (size_t i = begin; i < end; i++)
+		{
+			centroidBounds.grow(buildItems[i].centroid);
+		}
+		int axis = 0;
+		for (int candidate = 1; candidate < 3; candidate++)
+		{
+			if (centroidBounds.max[candidate] - centroidBounds.min[candidate] > centroidBounds.max[axis] - centroidBounds.min[axis])
+			{
+				axis = candidate;
+			}
+		}
+
+		float extent = centroidBounds.max[axis] - centroidBounds.min[axis];
+		if (extent > 0.0f)
+		{
+			struct Bin {
+				Aabb bounds;
+				uint32_t count = 0;
+			};
+			std::array<Bin, BIN_COUNT> bins;
+			float scale = BIN_COUNT / extent;
+			float origin = centroidBounds.min[axis];
+			auto binOf = [&](const BuildItem& item) {
+				return std::min(static_cast<uint32_t>((item.centroid[axis] - origin) * scale), BIN_COUNT - 1);
+			};
+
+			for (size_t i = begin; i < end; i++)
+			{
+				Bin& bin = bins[binOf(buildItems[i])];
+				bin.bounds.grow(objects[buildItems[i].object].bounds);
+				bin.count++;
+			}
+
+			// cost of everything right of every split, then sweep from the left
+			std::array<float, BIN_COUNT> rightCosts{};
+			Aabb right;
+			uint32_t rightCount = 0;
+			for (uint32_t bin = BIN_COUNT - 1; bin > 0; bin--)
+			{
+				right.grow(bins[bin].bounds);
+				rightCount += bins[bin].count;
+				rightCosts[bin] = rightCount > 0 ? right.surfaceArea() * rightCount : 0.0f;
+			}
+
+			Aabb left;
+			uint32_t leftCount = 0;
+			uint32_t total = static_cast<uint32_t>(end - begin);
+			uint32_t bestSplit = 0;
+			float bestCost = std::numeric_limits<float>::max();
+			for (uint32_t split = 1; split < BIN_COUNT; split++)
+			{
+				left.grow(bins[split - 1].bounds);
+				leftCount += bins[split - 1].count;
+				if (leftCount == 0 || leftCount == total)
+				{
+					continue;
+				}
+				float splitCost = left.surfaceArea() * leftCount + rightCosts[split];
+				if (splitCost < bestCost)
+				{
+					bestCost = splitCost;
+					bestSplit = split;
+				}
+			}
+
+			if (bestSplit > 0)
+			{
+				auto middle = std::partition(buildItems.begin() + begin, buildItems.begin() + end,
+					[&](const BuildItem& item) { return binOf(item) < bestSplit; });
+				return static_cast<size_t>(middle - buildItems.begin());
+			}
+		}
+
+		// every centroid in the same spot
+		size_t middle = begin + (end - begin) / 2;
+		std::nth_element(buildItems.begin() + begin, buildItems.begin() + middle, buildItems.begin() + end,
+			[axis](const BuildItem& a, const BuildItem& b) { return a.centroid[axis] < b.centroid[axis]; });
+		return middle;
+	}
+	#pragma endregion BUILD
+
+	#pragma region --- REFIT ---
+	void refit() {
+		for (uint32_t index : dirtyLeaves)
+		{
+			leafDirty[index] = false;
+			const Leaf& leaf = leaves[index];
+			if (leaf.parent != INVALID)
+			{
+				writeBox(nodes[leaf.parent].bounds[0], NODE_WIDTH, leaf.parentSlot, readBoxes(leaf.bounds[0], LEAF_SIZE, leaf.count));
+				nodeDirty[leaf.parent] = true;
+			}
+		}
+		dirtyLeaves.clear();
+
+		// backwards, so every node is refit before its parent
+		for (size_t index = nodes.size(); index-- > 0;)
+		{
+			const Node& node = nodes[index];
+			if (nodeDirty[index] && node.parent != INVALID)
+			{
+				writeBox(nodes[node.parent].bounds[0], NODE_WIDTH, node.parentSlot, readBoxes(node.bounds[0], NODE_WIDTH, node.count));
+				nodeDirty[node.parent] = true;
+			}
+			nodeDirty[index] = false;
+		}
+		cost = computeCost();
+	}
+
+	float computeCost() const {
+		if (root == INVALID || (root & LEAF_BIT))
+		{
+			return 0.0f;
+		}
+		float area = 0.0f;
+		for (const Node& node : nodes)
+		{
+			for (uint32_t slot = 0; slot < node.count; slot++)
+			{
+				area += readBoxes(node.bounds[0] + slot, NODE_WIDTH, 1).surfaceArea();
+			}
+		}
+		return area / std::max(boundsOf(root).surfaceArea(), std::numeric_limits<float>::min());
+	}
+	#pragma endregion REFIT
+};
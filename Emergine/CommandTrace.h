@@ -0,0 +1,547 @@
+#pragma once
+#pragma region --- INCLUDES ---
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#pragma endregion INCLUDES
+
+// the parts of the render path a command belongs to, each with its own pipelines, layout and geometry buffers
+enum class TraceGroup : uint8_t {
+	SCENE,
+	MESH,
+	SPRITE,
+	COUNT
+};
+
+// static buffers whose contents get recorded once at the start of a trace
+enum class TraceBuffer : uint8_t {
+	MESH_VERTICES,
+	MESH_INDICES,
+	COUNT
+};
+
+// buffers the CPU writes every frame
+enum class TraceRing : uint8_t {
+	MESH_INSTANCES,
+	SPRITE_VERTICES,
+	COUNT
+};
+
+// arguments in the order they get written, all little endian
+enum class TraceOp : uint8_t {
+	// uint32 render width, uint32 render height, uint8 TRACE_FRAME_* flags
+	FRAME,
+	// uint8 TraceBuffer, uint32 size, contents
+	UPLOAD,
+	// uint8 TraceRing, uint32 size, uint32 encoded size, contents encoded against the previous frame's
+	STREAM,
+	// uint8 TraceGroup, uint8 pipeline within the group
+	BIND_PIPELINE,
+	// uint8 TraceGroup, binds the vertex and index buffers of the group
+	BIND_GEOMETRY,
+	// uint16 texture
+	BIND_TEXTURE,
+	// uint8 TraceGroup, uint8 offset, uint8 size, contents
+	PUSH_CONSTANTS,
+	// uint32 vertex count, instance count, first vertex, first instance
+	DRAW,
+	// uint32 index count, instance count, first index, int32 vertex offset, uint32 first instance
+	DRAW_INDEXED
+};
+
+// the frame built the depth pyramid, which comes with its barriers and compute work
+const uint8_t TRACE_FRAME_HI_Z = 1 << 0;
+
+// one decoded command, which fields mean something depends on the op
+struct TraceCommand {
+	TraceOp op;
+	// TraceGroup, TraceBuffer or TraceRing
+	uint8_t target;
+	// pipeline within the group, push constant offset
+	uint8_t index;
+	// draw arguments, FRAME's width, height and flags, BIND_TEXTURE's texture
+	std::array<uint32_t, 5> args;
+	// UPLOAD, STREAM and PUSH_CONSTANTS contents, valid until the next command
+	const uint8_t* data;
+	uint32_t size;
+};
+
+// shared by the writer and the reader
+// file layout:
+//		"EMTRC\0" magic, uint16 version
+//		chunks: uint32 size, commands
+// the first chunk holds the uploads, every chunk after that is a frame starting with FRAME.
+// a ring's contents get XORed with what the same ring held the frame before, so everything that didn't move turns into zeros,
+// then zeros get run-length encoded: a control byte n < 128 is followed by n + 1 literal bytes, n >= 128 stands for n - 126 zeros
+class CommandTrace {
+public:
+	static constexpr uint16_t FILE_VERSION = 1;
+	static constexpr char MAGIC[6] = { 'E', 'M', 'T', 'R', 'C', '\0' };
+
+protected:
+	static constexpr uint32_t MAX_LITERALS = 128;
+	static constexpr uint32_t MIN_ZERO_RUN = 2;
+	static constexpr uint32_t MAX_ZERO_RUN = 255 - 126;
+
+	// what every ring held the previous frame
+	std::array<std::vector<uint8_t>, static_cast<size_t>(TraceRing::COUNT)> previousRings;
+};
+
+// collects the commands of a frame on the render thread and writes the whole frame at its end
+// every call does nothing while no trace is open, so the render path can call them unconditionally
+class CommandTraceWriter : public CommandTrace {
+public:
+	CommandTraceWriter() = default;
+
+	~CommandTraceWriter() {
+		close();
+	}
+
+	CommandTraceWriter(const CommandTraceWriter&) = delete;
+	CommandTraceWriter& operator=(const CommandTraceWriter&) = delete;
+
+	// the uploads go into the first chunk, so they have to come right after this
+	bool open(const std::string& path) {
+		close();
+
+		file.open(path, std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+		{
+			return false;
+		}
+
+		file.write(MAGIC, sizeof(MAGIC));
+		file.write(reinterpret_cast<const char*>(&FILE_VERSION), sizeof(FILE_VERSION));
+
+		for (std::vector<uint8_t>& ring : previousRings)
+		{
+			ring.clear();
+		}
+		chunk.clear();
+		frames = 0;
+		bytesWritten = sizeof(MAGIC) + sizeof(FILE_VERSION);
+		return true;
+	}
+
+	void close() {
+		if (!file.is_open())
+		{
+			return;
+		}
+		flushChunk();
+		file.close();
+	}
+
+	bool isOpen() const {
+		return file.is_open();
+	}
+
+	uint64_t framesWritten() const {
+		return frames;
+	}
+
+	uint64_t sizeWritten() const {
+		return bytesWritten;
+	}
+
+	#pragma region --- COMMANDS ---
+	void beginFrame(uint32_t width, uint32_t height, uint8_t flags) {
+		if (!file.is_open())
+		{
+			return;
+		}
+		// ends the uploads, or a frame that never got ended
+		flushChunk();
+		put(TraceOp::FRAME);
+		put(width);
+		put(height);
+		put(flags);
+	}
+
+	void endFrame() {
+		if (!file.is_open())
+		{
+			return;
+		}
+		flushChunk();
+		frames++;
+	}
+
+	void upload(TraceBuffer buffer, const void* contents, uint32_t size) {
+		if (!file.is_open())
+		{
+			return;
+		}
+		put(TraceOp::UPLOAD);
+		put(buffer);
+		put(size);
+		putBytes(contents, size);
+	}
+
+	void stream(TraceRing ring, const void* contents, uint32_t size) {
+		if (!file.is_open())
+		{
+			return;
+		}
+		put(TraceOp::STREAM);
+		put(ring);
+		put(size);
+
+		// the encoded size goes in front of the contents once it's known
+		size_t sizeOffset = chunk.size();
+		put(uint32_t{ 0 });
+		std::vector<uint8_t>& previous = previousRings[static_cast<size_t>(ring)];
+		encode(static_cast<const uint8_t*>(contents), size, previous);
+		uint32_t encodedSize = static_cast<uint32_t>(chunk.size() - sizeOffset - sizeof(uint32_t));
+		std::memcpy(&chunk[sizeOffset], &encodedSize, sizeof(encodedSize));
+
+		previous.assign(static_cast<const uint8_t*>(contents), static_cast<const uint8_t*>(contents) + size);
+	}
+
+	void bindPipeline(TraceGroup group, uint8_t pipeline) {
+		if (!file.is_open())
+		{
+			return;
+		}
+		put(TraceOp::BIND_PIPELINE);
+		put(group);
+		put(pipeline);
+	}
+
+	void bindGeometry(TraceGroup group) {
+		if (!file.is_open())
+		{
+			return;
+		}
+		put(TraceOp::BIND_GEOMETRY);
+		put(group);
+	}
+
+	void bindTexture(uint16_t texture) {
+		if (!file.is_open())
+		{
+			return;
+		}
+		put(TraceOp::BIND_TEXTURE);
+		put(texture);
+	}
+
+	void pushConstants(TraceGroup group, uint8_t offset, uint8_t size, const void* contents) {
+		if (!file.is_open())
+		{
+			return;
+		}
+		put(TraceOp::PUSH_CONSTANTS);
+		put(group);
+		put(offset);
+		put(size);
+		putBytes(contents, size);
+	}
+
+	void draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance) {
+		if (!file.is_open())
+		{
+			return;
+		}
+		put(TraceOp::DRAW);
+		put(vertexCount);
+		put(instanceCount);
+		put(firstVertex);
+		put(firstInstance);
+	}
+
+	void drawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t vertexOffset, uint32_t firstInstance) {
+		if (!file.is_open())
+		{
+			return;
+		}
+		put(TraceOp::DRAW_INDEXED);
+		put(indexCount);
+		put(instanceCount);
+		put(firstIndex);
+		put(vertexOffset);
+		put(firstInstance);
+	}
+	#pragma endregion COMMANDS
+
+private:
+	std::ofstream file;
+	// the chunk being built
+	std::vector<uint8_t> chunk;
+	uint64_t frames = 0;
+	uint64_t bytesWritten = 0;
+
+	template<typename T>
+	void put(const T& value) {
+		putBytes(&value, sizeof(T));
+	}
+
+	void putBytes(const void* bytes, size_t size) {
+		const uint8_t* begin = static_cast<const uint8_t*>(bytes);
+		chunk.insert(chunk.end(), begin, begin + size);
+	}
+
+	void flushChunk() {
+		if (chunk.empty())
+		{
+			return;
+		}
+		uint32_t size = static_cast<uint32_t>(chunk.size());
+		file.write(reinterpret_cast<const char*>(&size), sizeof(size));
+		file.write(reinterpret_cast<const char*>(chunk.data()), chunk.size());
+		bytesWritten += sizeof(size) + chunk.size();
+		chunk.clear();
+	}
+
+	void encode(const uint8_t* contents, uint32_t size, const std::vector<uint8_t>& previous) {
+		auto delta = [&](uint32_t i) {
+			return i < previous.size() ? static_cast<uint8_t>(contents[i] ^ previous[i]) : contents[i];
+		};
+
+		uint32_t i = 0;
+		while (i < size)
+		{
+			uint32_t zeros = 0;
+			while (i + zeros < size && zeros < MAX_ZERO_RUN && delta(i + zeros) == 0)
+			{
+				zeros++;
+			}
+			if (zeros >= MIN_ZERO_RUN)
+			{
+				chunk.push_back(static_cast<uint8_t>(zeros + 126));
+				i += zeros;
+				continue;
+			}
+
+			// literals up to the next run of zeros worth encoding
+			uint32_t literals = 0;
+			while (i + literals < size && literals < MAX_LITERALS
+				&& !(delta(i + literals) == 0 && i + literals + 1 < size && delta(i + literals + 1) == 0))
+			{
+				literals++;
+			}
+			literals = std::max(literals, 1u);
+			chunk.push_back(static_cast<uint8_t>(literals - 1));
+			for (uint32_t j = 0; j < literals; j++)
+			{
+				chunk.push_back(delta(i + j));
+			}
+			i += literals;
+		}
+	}
+};
+
+// loads a whole trace into memory and decodes its commands one at a time, frame after frame
+class CommandTraceReader : public CommandTrace {
+public:
+	bool open(const std::string& path) {
+		std::ifstream file(path, std::ios::binary);
+		if (!file.is_open())
+		{
+			return false;
+		}
+		contents.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+		size_t headerSize = sizeof(MAGIC) + sizeof(FILE_VERSION);
+		uint16_t version = 0;
+		if (contents.size() < headerSize || std::memcmp(contents.data(), MAGIC, sizeof(MAGIC)) != 0)
+		{
+			return false;
+		}
+		std::memcpy(&version, contents.data() + sizeof(MAGIC), sizeof(version));
+		if (version != FILE_VERSION)
+		{
+			return false;
+		}
+
+		chunks.clear();
+		size_t offset = headerSize;
+		while (offset + sizeof(uint32_t) <= contents.size())
+		{
+			uint32_t size;
+			std::memcpy(&size, contents.data() + offset, sizeof(size));
+			offset += sizeof(size);
+			if (offset + size > contents.size())
+			{
+				// cut off while recording, the frames before it are still fine
+				break;
+			}
+			chunks.push_back({ offset, offset + size });
+			offset += size;
+		}
+
+		firstFrame = !chunks.empty() && static_cast<TraceOp>(contents[chunks[0].begin]) != TraceOp::FRAME ? 1 : 0;
+		return frameCount() > 0;
+	}
+
+	size_t frameCount() const {
+		return chunks.size() - firstFrame;
+	}
+
+	// the uploads, if the trace has any
+	void seekUploads() {
+		if (firstFrame > 0)
+		{
+			seek(chunks[0].begin, chunks[0].end);
+		}
+		else
+		{
+			seek(0, 0);
+		}
+	}
+
+	// frames have to be read in order, they're encoded against each other, going back to 0 starts over
+	void seekFrame(size_t frame) {
+		if (frame == 0)
+		{
+			for (std::vector<uint8_t>& ring : previousRings)
+			{
+				ring.clear();
+			}
+		}
+		const Chunk& chunk = chunks[firstFrame + frame];
+		seek(chunk.begin, chunk.end);
+	}
+
+	// false once the chunk is done
+	bool next(TraceCommand& command) {
+		if (cursor >= end)
+		{
+			return false;
+		}
+
+		command.op = get<TraceOp>();
+		command.data = nullptr;
+		command.size = 0;
+		switch (command.op)
+		{
+		case TraceOp::FRAME:
+			command.args[0] = get<uint32_t>();
+			command.args[1] = get<uint32_t>();
+			command.args[2] = get<uint8_t>();
+			break;
+		case TraceOp::UPLOAD:
+			command.target = get<uint8_t>();
+			command.size = get<uint32_t>();
+			command.data = getBytes(command.size);
+			break;
+		case TraceOp::STREAM:
+		{
+			command.target = get<uint8_t>();
+			command.size = get<uint32_t>();
+			uint32_t encodedSize = get<uint32_t>();
+			std::vector<uint8_t>& ring = previousRings[command.target % static_cast<size_t>(TraceRing::COUNT)];
+			decode(getBytes(encodedSize), encodedSize, command.size, ring);
+			command.data = ring.data();
+			break;
+		}
+		case TraceOp::BIND_PIPELINE:
+			command.target = get<uint8_t>();
+			command.index = get<uint8_t>();
+			break;
+		case TraceOp::BIND_GEOMETRY:
+			command.target = get<uint8_t>();
+			break;
+		case TraceOp::BIND_TEXTURE:
+			command.args[0] = get<uint16_t>();
+			break;
+		case TraceOp::PUSH_CONSTANTS:
+			command.target = get<uint8_t>();
+			command.index = get<uint8_t>();
+			command.size = get<uint8_t>();
+			command.data = getBytes(command.size);
+			break;
+		case TraceOp::DRAW:
+			for (size_t i = 0; i < 4; i++)
+			{
+				command.args[i] = get<uint32_t>();
+			}
+			break;
+		case TraceOp::DRAW_INDEXED:
+			for (size_t i = 0; i < 5; i++)
+			{
+				command.args[i] = get<uint32_t>();
+			}
+			break;
+		default:
+			// nothing after an unknown op can be trusted
+			cursor = end;
+			return false;
+		}
+
+		// a command cut off at the end of the chunk
+		if (cursor > end)
+		{
+			cursor = end;
+			return false;
+		}
+		return true;
+	}
+
+private:
+	struct Chunk {
+		size_t begin;
+		size_t end;
+	};
+
+	std::vector<uint8_t> contents;
+	std::vector<Chunk> chunks;
+	// 1 when the first chunk holds uploads
+	size_t firstFrame = 0;
+	size_t cursor = 0;
+	size_t end = 0;
+
+	void seek(size_t begin, size_t chunkEnd) {
+		cursor = begin;
+		end = chunkEnd;
+	}
+
+	// past the end of the chunk reads zeros, next() notices the overrun afterwards
+	template<typename T>
+	T get() {
+		T value{};
+		if (cursor + sizeof(T) <= end)
+		{
+			std::memcpy(&value, contents.data() + cursor, sizeof(T));
+		}
+		cursor += sizeof(T);
+		return value;
+	}
+
+	const uint8_t* getBytes(size_t size) {
+		const uint8_t* bytes = cursor + size <= end ? contents.data() + cursor : nullptr;
+		cursor += size;
+		return bytes;
+	}
+
+	// in place, ring holds the previous frame's contents and ends up with this frame's
+	static void decode(const uint8_t* encoded, uint32_t encodedSize, uint32_t size, std::vector<uint8_t>& ring) {
+		ring.resize(size, 0);
+		if (encoded == nullptr)
+		{
+			return;
+		}
+
+		uint32_t in = 0;
+		uint32_t out = 0;
+		while (in < encodedSize && out < size)
+		{
+			uint8_t control = encoded[in++];
+			if (control >= MAX_LITERALS)
+			{
+				// unchanged
+				out += control - 126;
+				continue;
+			}
+			for (uint32_t j = 0; j <= control && in < encodedSize && out < size; j++)
+			{
+				ring[out++] ^= encoded[in++];
+			}
+		}
+	}
+};
@@ -0,0 +1,75 @@
+#pragma once
+#pragma region --- INCLUDES ---
+#include <vulkan/vulkan.h>
+#pragma endregion INCLUDES
+
+// device level functions the frame loop calls, X(name)
+// adding a function to one of the lists is all it takes to get it into the table
+#define EMERGINE_DEVICE_FUNCTIONS(X) \
+	X(vkAcquireNextImageKHR) \
+	X(vkQueuePresentKHR) \
+	X(vkQueueSubmit) \
+	X(vkWaitForFences) \
+	X(vkResetFences) \
+	X(vkGetQueryPoolResults) \
+	X(vkInvalidateMappedMemoryRanges) \
+	X(vkBeginCommandBuffer) \
+	X(vkEndCommandBuffer) \
+	X(vkResetCommandBuffer) \
+	X(vkCmdBeginQuery) \
+	X(vkCmdBeginRenderPass) \
+	X(vkCmdBindDescriptorSets) \
+	X(vkCmdBindIndexBuffer) \
+	X(vkCmdBindPipeline) \
+	X(vkCmdBindVertexBuffers) \
+	X(vkCmdBlitImage) \
+	X(vkCmdCopyBuffer) \
+	X(vkCmdCopyBufferToImage) \
+	X(vkCmdCopyImageToBuffer) \
+	X(vkCmdDispatch) \
+	X(vkCmdDraw) \
+	X(vkCmdDrawIndexed) \
+	X(vkCmdEndQuery) \
+	X(vkCmdEndRenderPass) \
+	X(vkCmdExecuteCommands) \
+	X(vkCmdPipelineBarrier) \
+	X(vkCmdPushConstants) \
+	X(vkCmdResetQueryPool) \
+	X(vkCmdSetScissor) \
+	X(vkCmdSetViewport) \
+	X(vkCmdWriteTimestamp)
+
+// only there with the matching version or extension, stay null otherwise
+#define EMERGINE_OPTIONAL_DEVICE_FUNCTIONS(X) \
+	X(vkWaitSemaphores)
+
+// entry points of one device, straight from the driver or the first enabled layer.
+// the exported vk* functions are loader trampolines, every call looks the dispatch table up through the handle first,
+// these skip that. members are named like the functions, so dispatch.vkCmdDraw(...) reads like vkCmdDraw(...).
+// setup and teardown keep going through the loader, they don't run often enough to matter
+struct DeviceDispatch {
+#define EMERGINE_DISPATCH_MEMBER(name) PFN_##name name = nullptr;
+	EMERGINE_DEVICE_FUNCTIONS(EMERGINE_DISPATCH_MEMBER)
+	EMERGINE_OPTIONAL_DEVICE_FUNCTIONS(EMERGINE_DISPATCH_MEMBER)
+#undef EMERGINE_DISPATCH_MEMBER
+
+	// returns the name of the first required function the device didn't provide, nullptr once all of them are loaded
+	const char* load(VkDevice device) {
+		const char* missing = nullptr;
+#define EMERGINE_DISPATCH_LOAD(name) \
+		name = reinterpret_cast<PFN_##name>(vkGetDeviceProcAddr(device, #name)); \
+		if (name == nullptr && missing == nullptr) \
+		{ \
+			missing = #name; \
+		}
+		EMERGINE_DEVICE_FUNCTIONS(EMERGINE_DISPATCH_LOAD)
+#undef EMERGINE_DISPATCH_LOAD
+
+#define EMERGINE_DISPATCH_LOAD_OPTIONAL(name) \
+		name = reinterpret_cast<PFN_##name>(vkGetDeviceProcAddr(device, #name));
+		EMERGINE_OPTIONAL_DEVICE_FUNCTIONS(EMERGINE_DISPATCH_LOAD_OPTIONAL)
+#undef EMERGINE_DISPATCH_LOAD_OPTIONAL
+
+		return missing;
+	}
+};
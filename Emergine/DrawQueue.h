@@ -0,0 +1,136 @@
+#pragma once
+#pragma region --- INCLUDES ---
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+#pragma endregion INCLUDES
+
+// collects the draws of a frame as 64 bit sort keys and puts them in submission order with a radix sort
+// key layout, most significant bit first:
+//		opaque:			0 | coarse depth (4) | pipeline (8) | material (16) | unused (11) | depth (24)
+//		transparent:	1 | inverted depth (24) | pipeline (8) | material (16) | unused (15)
+// opaque draws go before transparent ones and roughly front to back, so early depth testing can reject hidden fragments.
+// within a depth bucket they're grouped by pipeline and material to save binds, and sorted front to back again after that.
+// more depth buckets reject more fragments, fewer save more binds.
+// transparent draws have to blend back to front, state only gets grouped between draws at the exact same depth
+class DrawQueue {
+public:
+	static constexpr uint32_t DEPTH_BUCKET_BITS = 4;
+	static constexpr uint32_t DEPTH_BITS = 24;
+	static constexpr uint32_t MAX_PIPELINES = 1 << 8;
+	static constexpr uint32_t MAX_MATERIALS = 1 << 16;
+
+	// depth in [0, 1], 0 being closest to the camera
+	static uint64_t opaqueKey(uint32_t pipeline, uint32_t material, float depth) {
+		uint64_t quantizedDepth = quantizeDepth(depth);
+		uint64_t bucket = quantizedDepth >> (DEPTH_BITS - DEPTH_BUCKET_BITS);
+		return (bucket << 59)
+			| (static_cast<uint64_t>(pipeline & 0xFF) << 51)
+			| (static_cast<uint64_t>(material & 0xFFFF) << 35)
+			| quantizedDepth;
+	}
+
+	static uint64_t transparentKey(uint32_t pipeline, uint32_t material, float depth) {
+		uint64_t invertedDepth = quantizeDepth(depth) ^ ((1ull << DEPTH_BITS) - 1);
+		return (1ull << 63)
+			| (invertedDepth << 39)
+			| (static_cast<uint64_t>(pipeline & 0xFF) << 31)
+			| (static_cast<uint64_t>(material & 0xFFFF) << 15);
+	}
+
+	void clear() {
+		entries.clear();
+	}
+
+	// payload is whatever the caller needs to find the draw again, usually an index into its own list
+	void push(uint64_t key, uint32_t payload) {
+		entries.push_back({ key, payload });
+	}
+
+	// payloads in draw order, stable for equal keys
+	const std::vector<uint32_t>& sort() {
+		radixSort();
+
+		sortedPayloads.resize(entries.size());
+		for (size_t i = 0; i < entries.size(); i++)
+		{
+			sortedPayloads[i] = entries[i].payload;
+		}
+		return sortedPayloads;
+	}
+
+	size_t size() const {
+		return entries.size();
+	}
+
+	// passes the last sort actually had to do, digits all keys agree on get skipped
+	uint32_t lastSortPasses() const {
+		return sortPasses;
+	}
+
+private:
+	struct Entry {
+		uint64_t key;
+		uint32_t payload;
+	};
+
+	std::vector<Entry> entries;
+	std::vector<Entry> scratch;
+	std::vector<uint32_t> sortedPayloads;
+	uint32_t sortPasses = 0;
+
+	static uint64_t quantizeDepth(float depth) {
+		float clamped = std::clamp(depth, 0.0f, 1.0f);
+		return static_cast<uint64_t>(clamped * static_cast<float>((1u << DEPTH_BITS) - 1) + 0.5f);
+	}
+
+	// least significant digit first, 8 bits per pass
+	// every histogram gets built in a single read over the keys
+	void radixSort() {
+		sortPasses = 0;
+		size_t count = entries.size();
+		if (count < 2)
+		{
+			return;
+		}
+
+		std::array<std::array<uint32_t, 256>, 8> histograms{};
+		for (const Entry& entry : entries)
+		{
+			for (uint32_t digit = 0; digit < 8; digit++)
+			{
+				histograms[digit][(entry.key >> (digit * 8)) & 0xFF]++;
+			}
+		}
+
+		scratch.resize(count);
+		for (uint32_t digit = 0; digit < 8; digit++)
+		{
+			std::array<uint32_t, 256>& histogram = histograms[digit];
+
+			// every key has the same value for this digit, so the pass wouldn't move anything
+			uint32_t firstKeyBucket = static_cast<uint32_t>((entries[0].key >> (digit * 8)) & 0xFF);
+			if (histogram[firstKeyBucket] == count)
+			{
+				continue;
+			}
+
+			// histogram to starting offsets
+			uint32_t offset = 0;
+			for (uint32_t& bucket : histogram)
+			{
+				uint32_t bucketSize = bucket;
+				bucket = offset;
+				offset += bucketSize;
+			}
+
+			for (const Entry& entry : entries)
+			{
+				scratch[histogram[(entry.key >> (digit * 8)) & 0xFF]++] = entry;
+			}
+			entries.swap(scratch);
+			sortPasses++;
+		}
+	}
+};
@@ -0,0 +1,250 @@
+#pragma once
+#pragma region --- INCLUDES ---
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#pragma endregion INCLUDES
+
+// a frame that finished copying into host visible memory
+// the pixels stay in the readback buffer they were copied to, the writer reads them from there
+// and clears busy once it's done, after which the buffer can be reused for another frame
+struct CapturedFrame {
+	uint64_t frameNumber;
+	uint32_t width;
+	uint32_t height;
+	// VkFormat of the pixels, 4 bytes per pixel, tightly packed rows
+	uint32_t format;
+	const uint8_t* pixels;
+	std::atomic<bool>* busy;
+};
+
+// streams captured frames to a single file on a background thread
+// file layout, all little endian:
+//		"EMCAP\0" magic, uint16 version
+//		per frame: uint64 frame number, uint32 width, uint32 height, uint32 format,
+//			uint32 compressed (0 or 1), uint64 payload size, payload
+// compressed payloads are run-length encoded 32 bit pixels: a control byte n < 128 is followed by n + 1 literal pixels,
+// n >= 128 is followed by a single pixel repeated n - 126 times
+class FrameCaptureWriter {
+public:
+	static constexpr uint16_t FILE_VERSION = 1;
+
+	FrameCaptureWriter() = default;
+
+	~FrameCaptureWriter() {
+		close();
+	}
+
+	FrameCaptureWriter(const FrameCaptureWriter&) = delete;
+	FrameCaptureWriter& operator=(const FrameCaptureWriter&) = delete;
+
+	bool open(const std::string& path, bool compressFrames) {
+		close();
+
+		file.open(path, std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+		{
+			return false;
+		}
+
+		const char magic[6] = { 'E', 'M', 'C', 'A', 'P', '\0' };
+		file.write(magic, sizeof(magic));
+		writeValue(FILE_VERSION);
+
+		compress = compressFrames;
+		running = true;
+		writer = std::thread(&FrameCaptureWriter::writerLoop, this);
+		return true;
+	}
+
+	// writes out what's still queued before returning
+	void close() {
+		if (!writer.joinable())
+		{
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			running = false;
+		}
+		wakeCondition.notify_one();
+		writer.join();
+		file.close();
+	}
+
+	bool isOpen() const {
+		return writer.joinable();
+	}
+
+	// never waits on the disk, only on the short lock around the queue
+	void submit(const CapturedFrame& frame) {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			queue.push_back(frame);
+		}
+		wakeCondition.notify_one();
+	}
+
+	// blocks until every submitted frame has been written, only meant for when the readback buffers get replaced
+	void waitIdle() {
+		std::unique_lock<std::mutex> lock(mutex);
+		idleCondition.wait(lock, [this]() { return queue.empty() && !writing; });
+	}
+
+	#pragma region --- STATS ---
+	uint64_t framesWritten() const {
+		return writtenFrames.load(std::memory_order_relaxed);
+	}
+
+	uint64_t bytesWritten() const {
+		return writtenBytes.load(std::memory_order_relaxed);
+	}
+
+	// time the writer thread spent encoding and writing
+	double writeTimeMs() const {
+		return writeTimeNs.load(std::memory_order_relaxed) / 1000000.0;
+	}
+	#pragma endregion STATS
+
+private:
+	std::ofstream file;
+	bool compress = false;
+
+	std::thread writer;
+	std::mutex mutex;
+	std::condition_variable wakeCondition;
+	std::condition_variable idleCondition;
+	std::deque<CapturedFrame> queue;
+	// guarded by mutex
+	bool running = false;
+	bool writing = false;
+
+	std::atomic<uint64_t> writtenFrames{ 0 };
+	std::atomic<uint64_t> writtenBytes{ 0 };
+	std::atomic<uint64_t> writeTimeNs{ 0 };
+
+	// only touched by the writer thread
+	std::vector<uint8_t> encoded;
+
+	void writerLoop() {
+		std::unique_lock<std::mutex> lock(mutex);
+
+		while (true)
+		{
+			wakeCondition.wait(lock, [this]() { return !queue.empty() || !running; });
+			if (queue.empty())
+			{
+				// only reached once running got cleared
+				break;
+			}
+
+			CapturedFrame frame = queue.front();
+			queue.pop_front();
+			writing = true;
+			lock.unlock();
+
+			writeFrame(frame);
+			frame.busy->store(false, std::memory_order_release);
+
+			lock.lock();
+			writing = false;
+			if (queue.empty())
+			{
+				idleCondition.notify_all();
+			}
+		}
+
+		file.flush();
+	}
+
+	void writeFrame(const CapturedFrame& frame) {
+		auto start = std::chrono::steady_clock::now();
+
+		size_t pixelCount = static_cast<size_t>(frame.width) * frame.height;
+		const uint8_t* payload = frame.pixels;
+		uint64_t payloadSize = pixelCount * 4;
+
+		if (compress)
+		{
+			encode(frame.pixels, pixelCount);
+			payload = encoded.data();
+			payloadSize = encoded.size();
+		}
+
+		writeValue(frame.frameNumber);
+		writeValue(frame.width);
+		writeValue(frame.height);
+		writeValue(frame.format);
+		writeValue(static_cast<uint32_t>(compress ? 1 : 0));
+		writeValue(payloadSize);
+		file.write(reinterpret_cast<const char*>(payload), static_cast<std::streamsize>(payloadSize));
+
+		writtenFrames.fetch_add(1, std::memory_order_relaxed);
+		writtenBytes.fetch_add(payloadSize, std::memory_order_relaxed);
+		writeTimeNs.fetch_add(static_cast<uint64_t>(
+			std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count()),
+			std::memory_order_relaxed);
+	}
+
+	// run-length encoding on whole pixels, rendered frames tend to have large flat areas
+	void encode(const uint8_t* pixels, size_t pixelCount) {
+		encoded.clear();
+		// worst case: one control byte per 128 literal pixels
+		encoded.reserve(pixelCount * 4 + pixelCount / 128 + 1);
+
+		auto pixelAt = [pixels](size_t i) {
+			uint32_t pixel;
+			std::memcpy(&pixel, pixels + i * 4, 4);
+			return pixel;
+		};
+		auto appendPixel = [this](uint32_t pixel) {
+			const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&pixel);
+			encoded.insert(encoded.end(), bytes, bytes + 4);
+		};
+
+		size_t i = 0;
+		while (i < pixelCount)
+		{
+			uint32_t pixel = pixelAt(i);
+			size_t run = 1;
+			while (i + run < pixelCount && run < 129 && pixelAt(i + run) == pixel)
+			{
+				run++;
+			}
+
+			if (run >= 2)
+			{
+				encoded.push_back(static_cast<uint8_t>(run + 126));
+				appendPixel(pixel);
+				i += run;
+				continue;
+			}
+
+			// literals, up to the next run of at least 2
+			size_t literals = 1;
+			while (i + literals < pixelCount && literals < 128
+				&& !(i + literals + 1 < pixelCount && pixelAt(i + literals) == pixelAt(i + literals + 1)))
+			{
+				literals++;
+			}
+
+			encoded.push_back(static_cast<uint8_t>(literals - 1));
+			encoded.insert(encoded.end(), pixels + i * 4, pixels + (i + literals) * 4);
+			i += literals;
+		}
+	}
+
+	template <typename T>
+	void writeValue(T value) {
+		file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+};
@@ -0,0 +1,515 @@
+#pragma once
+#pragma region --- INCLUDES ---
+#include <vulkan/vulkan.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+#pragma endregion INCLUDES
+
+// engine-side lifetime of the allocations the driver makes
+// set by the engine around the calls it makes, see HostAllocator::ArenaScope
+enum class HostArena : uint8_t {
+	// instance, device and anything else that lives until shutdown
+	DEVICE,
+	// swap chain and everything rebuilt along with it
+	SWAPCHAIN,
+	// shader modules, pipelines and their layouts
+	PIPELINE_BUILD,
+	// command scope allocations made while recording, submitting and presenting
+	FRAME,
+	COUNT
+};
+
+// host allocator handed to the driver through VkAllocationCallbacks
+// small allocations are served from size-class pools, one set of pools per arena,
+// so blocks freed after a pipeline build or swap chain recreation get reused by the next one
+// instead of going back through malloc.
+// every allocation gets tagged with its arena, VkSystemAllocationScope and the object type
+// it was made for, so current and peak usage can be reported along each of those.
+class HostAllocator {
+public:
+	static constexpr size_t SIZE_CLASS_COUNT = 9;
+	// largest size served from the pools, anything bigger goes straight to malloc
+	static constexpr size_t MAX_POOLED_SIZE = 4096;
+	static constexpr size_t CHUNK_SIZE = 64 * 1024;
+	// pool blocks are only guaranteed to be aligned to this
+	static constexpr size_t POOL_ALIGNMENT = 16;
+	static constexpr size_t SCOPE_COUNT = VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE + 1;
+
+	// object types that get their own set of callbacks
+	static constexpr std::array<VkObjectType, 23> TRACKED_OBJECT_TYPES = {
+		VK_OBJECT_TYPE_UNKNOWN,
+		VK_OBJECT_TYPE_INSTANCE,
+		VK_OBJECT_TYPE_DEVICE,
+		VK_OBJECT_TYPE_SURFACE_KHR,
+		VK_OBJECT_TYPE_SWAPCHAIN_KHR,
+		VK_OBJECT_TYPE_DEBUG_UTILS_MESSENGER_EXT,
+		VK_OBJECT_TYPE_IMAGE,
+		VK_OBJECT_TYPE_IMAGE_VIEW,
+		VK_OBJECT_TYPE_FRAMEBUFFER,
+		VK_OBJECT_TYPE_RENDER_PASS,
+		VK_OBJECT_TYPE_SHADER_MODULE,
+		VK_OBJECT_TYPE_PIPELINE_LAYOUT,
+		VK_OBJECT_TYPE_PIPELINE,
+		VK_OBJECT_TYPE_PIPELINE_CACHE,
+		VK_OBJECT_TYPE_COMMAND_POOL,
+		VK_OBJECT_TYPE_SEMAPHORE,
+		VK_OBJECT_TYPE_FENCE,
+		VK_OBJECT_TYPE_BUFFER,
+		VK_OBJECT_TYPE_DEVICE_MEMORY,
+		VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT,
+		VK_OBJECT_TYPE_DESCRIPTOR_POOL,
+		VK_OBJECT_TYPE_SAMPLER,
+		VK_OBJECT_TYPE_QUERY_POOL
+	};
+
+	HostAllocator() {
+		for (size_t i = 0; i < TRACKED_OBJECT_TYPES.size(); i++)
+		{
+			tags[i].owner = this;
+			tags[i].index = static_cast<uint8_t>(i);
+
+			VkAllocationCallbacks& allocationCallbacks = callbacksPerType[i];
+			allocationCallbacks.pUserData = &tags[i];
+			allocationCallbacks.pfnAllocation = allocation;
+			allocationCallbacks.pfnReallocation = reallocation;
+			allocationCallbacks.pfnFree = freeMemory;
+			allocationCallbacks.pfnInternalAllocation = internalAllocation;
+			allocationCallbacks.pfnInternalFree = internalFree;
+		}
+	}
+
+	~HostAllocator() {
+		for (Arena& arena : arenas)
+		{
+			for (void* chunk : arena.chunks)
+			{
+				std::free(chunk);
+			}
+		}
+	}
+
+	HostAllocator(const HostAllocator&) = delete;
+	HostAllocator& operator=(const HostAllocator&) = delete;
+
+	// callbacks to pass as pAllocator when creating or destroying an object of the given type
+	// all of them are compatible with each other, they only differ in how allocations get tagged
+	const VkAllocationCallbacks* callbacks(VkObjectType objectType) {
+		for (size_t i = 0; i < TRACKED_OBJECT_TYPES.size(); i++)
+		{
+			if (TRACKED_OBJECT_TYPES[i] == objectType)
+			{
+				return &callbacksPerType[i];
+			}
+		}
+
+		return &callbacksPerType[0];
+	}
+
+	#pragma region --- ARENA SCOPE ---
+	// tags the driver's allocations on this thread with an arena for as long as it lives
+	// allocations from driver-internal threads always end up in the DEVICE arena
+	class ArenaScope {
+	public:
+		explicit ArenaScope(HostArena arena) : previous(currentArena) {
+			currentArena = arena;
+		}
+
+		~ArenaScope() {
+			currentArena = previous;
+		}
+
+		ArenaScope(const ArenaScope&) = delete;
+		ArenaScope& operator=(const ArenaScope&) = delete;
+
+	private:
+		HostArena previous;
+	};
+	#pragma endregion ARENA SCOPE
+
+	#pragma region --- STATS ---
+	struct Usage {
+		std::atomic<int64_t> currentBytes{ 0 };
+		std::atomic<int64_t> peakBytes{ 0 };
+		std::atomic<int64_t> liveAllocations{ 0 };
+		std::atomic<uint64_t> totalAllocations{ 0 };
+		// current bytes at the last call to markSteadyState()
+		std::atomic<int64_t> steadyBytes{ 0 };
+
+		void add(int64_t bytes) {
+			int64_t current = currentBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+			int64_t peak = peakBytes.load(std::memory_order_relaxed);
+			while (current > peak && !peakBytes.compare_exchange_weak(peak, current, std::memory_order_relaxed)) {}
+			liveAllocations.fetch_add(1, std::memory_order_relaxed);
+			totalAllocations.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		void remove(int64_t bytes) {
+			currentBytes.fetch_sub(bytes, std::memory_order_relaxed);
+			liveAllocations.fetch_sub(1, std::memory_order_relaxed);
+		}
+	};
+
+	// total amount of allocations made so far, handy to measure churn around a block of code
+	uint64_t allocationCount() const {
+		return totalAllocations.load(std::memory_order_relaxed);
+	}
+
+	// amount of allocations that had to go to malloc, rather than being served by a pool
+	uint64_t systemAllocationCount() const {
+		return systemAllocations.load(std::memory_order_relaxed);
+	}
+
+	// remembers the current usage as the steady state, call once startup is done and frames are running
+	void markSteadyState() {
+		for (Usage& usage : scopeUsage) usage.steadyBytes.store(usage.currentBytes.load());
+		for (Usage& usage : arenaUsage) usage.steadyBytes.store(usage.currentBytes.load());
+		for (Usage& usage : typeUsage) usage.steadyBytes.store(usage.currentBytes.load());
+		for (Usage& usage : internalUsage) usage.steadyBytes.store(usage.currentBytes.load());
+	}
+
+	std::string report() const {
+		std::ostringstream out;
+		out << "host memory (bytes)        current       steady         peak   live allocs  total allocs\n";
+
+		for (size_t i = 0; i < SCOPE_COUNT; i++)
+		{
+			appendUsage(out, std::string("scope ") + scopeName(static_cast<VkSystemAllocationScope>(i)), scopeUsage[i]);
+		}
+		for (size_t i = 0; i < SCOPE_COUNT; i++)
+		{
+			if (internalUsage[i].totalAllocations.load() > 0)
+			{
+				appendUsage(out, std::string("internal ") + scopeName(static_cast<VkSystemAllocationScope>(i)), internalUsage[i]);
+			}
+		}
+		for (size_t i = 0; i < static_cast<size_t>(HostArena::COUNT); i++)
+		{
+			appendUsage(out, std::string("arena ") + arenaName(static_cast<HostArena>(i)), arenaUsage[i]);
+		}
+		for (size_t i = 0; i < TRACKED_OBJECT_TYPES.size(); i++)
+		{
+			if (typeUsage[i].totalAllocations.load() > 0)
+			{
+				appendUsage(out, std::string("type ") + objectTypeName(TRACKED_OBJECT_TYPES[i]), typeUsage[i]);
+			}
+		}
+
+		out << "served by pools: " << pooledAllocations.load() << " of " << allocationCount() << " allocations"
+			<< ", malloc calls: " << systemAllocationCount();
+
+		return out.str();
+	}
+	#pragma endregion STATS
+
+private:
+	// what pUserData points to, so the static callbacks know which object type they are for
+	struct Tag {
+		HostAllocator* owner;
+		uint8_t index;
+	};
+
+	// stored right in front of every pointer handed to the driver
+	// 16 bytes, so the pointer after it keeps the pool alignment
+	struct alignas(16) Header {
+		uint32_t size;
+		// distance back to the start of the malloc'ed block, only used for non-pooled allocations
+		uint32_t offset;
+		// SIZE_CLASS_COUNT for allocations that didn't come from a pool
+		uint8_t sizeClass;
+		uint8_t arena;
+		uint8_t scope;
+		uint8_t typeIndex;
+	};
+	static_assert(sizeof(Header) == POOL_ALIGNMENT, "header must keep pool blocks aligned");
+
+	struct FreeBlock {
+		FreeBlock* next;
+	};
+
+	struct Arena {
+		std::mutex mutex;
+		std::array<FreeBlock*, SIZE_CLASS_COUNT> freeLists{};
+		std::vector<void*> chunks;
+	};
+
+	std::array<Tag, TRACKED_OBJECT_TYPES.size()> tags;
+	std::array<VkAllocationCallbacks, TRACKED_OBJECT_TYPES.size()> callbacksPerType;
+	std::array<Arena, static_cast<size_t>(HostArena::COUNT)> arenas;
+
+	std::array<Usage, SCOPE_COUNT> scopeUsage;
+	std::array<Usage, SCOPE_COUNT> internalUsage;
+	std::array<Usage, static_cast<size_t>(HostArena::COUNT)> arenaUsage;
+	std::array<Usage, TRACKED_OBJECT_TYPES.size()> typeUsage;
+	std::atomic<uint64_t> totalAllocations{ 0 };
+	std::atomic<uint64_t> systemAllocations{ 0 };
+	std::atomic<uint64_t> pooledAllocations{ 0 };
+
+	static inline thread_local HostArena currentArena = HostArena::DEVICE;
+
+	#pragma region --- CALLBACKS ---
+	static void* VKAPI_CALL allocation(void* pUserData, size_t size, size_t alignment, VkSystemAllocationScope scope) {
+		auto tag = static_cast<Tag*>(pUserData);
+		return tag->owner->allocate(size, alignment, scope, tag->index);
+	}
+
+	static void* VKAPI_CALL reallocation(void* pUserData, void* pOriginal, size_t size, size_t alignment, VkSystemAllocationScope scope) {
+		auto tag = static_cast<Tag*>(pUserData);
+
+		if (pOriginal == nullptr)
+		{
+			return tag->owner->allocate(size, alignment, scope, tag->index);
+		}
+
+		if (size == 0)
+		{
+			tag->owner->deallocate(pOriginal);
+			return nullptr;
+		}
+
+		Header* original = headerOf(pOriginal);
+		// the block it's already in might be big enough
+		if (original->sizeClass < SIZE_CLASS_COUNT && size <= classSize(original->sizeClass)
+			&& alignment <= POOL_ALIGNMENT)
+		{
+			HostAllocator* owner = tag->owner;
+			owner->untrack(*original);
+			original->size = static_cast<uint32_t>(size);
+			original->scope = static_cast<uint8_t>(scope);
+			original->typeIndex = tag->index;
+			owner->track(*original);
+			return pOriginal;
+		}
+
+		void* memory = tag->owner->allocate(size, alignment, scope, tag->index);
+		if (memory != nullptr)
+		{
+			memcpy(memory, pOriginal, std::min<size_t>(size, original->size));
+			tag->owner->deallocate(pOriginal);
+		}
+		return memory;
+	}
+
+	static void VKAPI_CALL freeMemory(void* pUserData, void* pMemory) {
+		if (pMemory != nullptr)
+		{
+			static_cast<Tag*>(pUserData)->owner->deallocate(pMemory);
+		}
+	}
+
+	// the driver made an allocation itself, usually executable memory, we only get to count it
+	static void VKAPI_CALL internalAllocation(void* pUserData, size_t size, VkInternalAllocationType type, VkSystemAllocationScope scope) {
+		static_cast<Tag*>(pUserData)->owner->internalUsage[scope].add(static_cast<int64_t>(size));
+	}
+
+	static void VKAPI_CALL internalFree(void* pUserData, size_t size, VkInternalAllocationType type, VkSystemAllocationScope scope) {
+		static_cast<Tag*>(pUserData)->owner->internalUsage[scope].remove(static_cast<int64_t>(size));
+	}
+	#pragma endregion CALLBACKS
+
+	#pragma region --- ALLOCATION ---
+	void* allocate(size_t size, size_t alignment, VkSystemAllocationScope scope, uint8_t typeIndex) {
+		if (size == 0)
+		{
+			return nullptr;
+		}
+
+		HostArena arena = currentArena;
+		Header* header;
+		uint8_t sizeClass = sizeClassOf(size);
+
+		if (sizeClass < SIZE_CLASS_COUNT && alignment <= POOL_ALIGNMENT)
+		{
+			header = popBlock(arenas[static_cast<size_t>(arena)], sizeClass);
+			if (header == nullptr)
+			{
+				return nullptr;
+			}
+			header->offset = 0;
+			pooledAllocations.fetch_add(1, std::memory_order_relaxed);
+		}
+		else
+		{
+			// room for the header in front, plus enough slack to align the pointer after it
+			alignment = std::max(alignment, POOL_ALIGNMENT);
+			char* block = static_cast<char*>(std::malloc(size + sizeof(Header) + alignment));
+			if (block == nullptr)
+			{
+				return nullptr;
+			}
+			systemAllocations.fetch_add(1, std::memory_order_relaxed);
+
+			uintptr_t user = (reinterpret_cast<uintptr_t>(block) + sizeof(Header) + alignment - 1) & ~(uintptr_t)(alignment - 1);
+			header = reinterpret_cast<Header*>(user) - 1;
+			header->offset = static_cast<uint32_t>(user - reinterpret_cast<uintptr_t>(block));
+			sizeClass = SIZE_CLASS_COUNT;
+		}
+
+		header->size = static_cast<uint32_t>(size);
+		header->sizeClass = sizeClass;
+		header->arena = static_cast<uint8_t>(arena);
+		header->scope = static_cast<uint8_t>(scope);
+		header->typeIndex = typeIndex;
+		track(*header);
+
+		return header + 1;
+	}
+
+	void deallocate(void* memory) {
+		Header* header = headerOf(memory);
+		untrack(*header);
+
+		if (header->sizeClass < SIZE_CLASS_COUNT)
+		{
+			// goes back to the arena it came from, not the current one
+			pushBlock(arenas[header->arena], header->sizeClass, header);
+		}
+		else
+		{
+			std::free(reinterpret_cast<char*>(header + 1) - header->offset);
+		}
+	}
+
+	Header* popBlock(Arena& arena, uint8_t sizeClass) {
+		std::lock_guard<std::mutex> lock(arena.mutex);
+
+		if (arena.freeLists[sizeClass] == nullptr)
+		{
+			// carve a new chunk into blocks of this size class
+			size_t blockSize = sizeof(Header) + classSize(sizeClass);
+			size_t blockCount = std::max<size_t>(CHUNK_SIZE / blockSize, 8);
+			char* chunk = static_cast<char*>(std::malloc(blockSize * blockCount));
+			if (chunk == nullptr)
+			{
+				return nullptr;
+			}
+			systemAllocations.fetch_add(1, std::memory_order_relaxed);
+			arena.chunks.push_back(chunk);
+
+			for (size_t i = blockCount; i > 0; i--)
+			{
+				auto block = reinterpret_cast<FreeBlock*>(chunk + (i - 1) * blockSize);
+				block->next = arena.freeLists[sizeClass];
+				arena.freeLists[sizeClass] = block;
+			}
+		}
+
+		FreeBlock* block = arena.freeLists[sizeClass];
+		arena.freeLists[sizeClass] = block->next;
+		return reinterpret_cast<Header*>(block);
+	}
+
+	void pushBlock(Arena& arena, uint8_t sizeClass, Header* header) {
+		std::lock_guard<std::mutex> lock(arena.mutex);
+
+		auto block = reinterpret_cast<FreeBlock*>(header);
+		block->next = arena.freeLists[sizeClass];
+		arena.freeLists[sizeClass] = block;
+	}
+
+	void track(const Header& header) {
+		int64_t size = header.size;
+		scopeUsage[header.scope].add(size);
+		arenaUsage[header.arena].add(size);
+		typeUsage[header.typeIndex].add(size);
+		totalAllocations.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void untrack(const Header& header) {
+		int64_t size = header.size;
+		scopeUsage[header.scope].remove(size);
+		arenaUsage[header.arena].remove(size);
+		typeUsage[header.typeIndex].remove(size);
+	}
+
+	static Header* headerOf(void* memory) {
+		return static_cast<Header*>(memory) - 1;
+	}
+
+	// 16, 32, 64, ... 4096
+	static size_t classSize(uint8_t sizeClass) {
+		return size_t(16) << sizeClass;
+	}
+
+	static uint8_t sizeClassOf(size_t size) {
+		uint8_t sizeClass = 0;
+		while (sizeClass < SIZE_CLASS_COUNT && classSize(sizeClass) < size)
+		{
+			sizeClass++;
+		}
+		return sizeClass;
+	}
+	#pragma endregion ALLOCATION
+
+	#pragma region --- REPORT ---
+	static void appendUsage(std::ostringstream& out, const std::string& name, const Usage& usage) {
+		out << std::left << std::setw(22) << name << std::right
+			<< std::setw(13) << usage.currentBytes.load()
+			<< std::setw(13) << usage.steadyBytes.load()
+			<< std::setw(13) << usage.peakBytes.load()
+			<< std::setw(14) << usage.liveAllocations.load()
+			<< std::setw(14) << usage.totalAllocations.load() << '\n';
+	}
+
+	static const char* scopeName(VkSystemAllocationScope scope) {
+		switch (scope)
+		{
+		case VK_SYSTEM_ALLOCATION_SCOPE_COMMAND: return "command";
+		case VK_SYSTEM_ALLOCATION_SCOPE_OBJECT: return "object";
+		case VK_SYSTEM_ALLOCATION_SCOPE_CACHE: return "cache";
+		case VK_SYSTEM_ALLOCATION_SCOPE_DEVICE: return "device";
+		case VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE: return "instance";
+		default: return "unknown";
+		}
+	}
+
+	static const char* arenaName(HostArena arena) {
+		switch (arena)
+		{
+		case HostArena::DEVICE: return "device";
+		case HostArena::SWAPCHAIN: return "swapchain";
+		case HostArena::PIPELINE_BUILD: return "pipeline build";
+		case HostArena::FRAME: return "frame";
+		default: return "unknown";
+		}
+	}
+
+	static const char* objectTypeName(VkObjectType objectType) {
+		switch (objectType)
+		{
+		case VK_OBJECT_TYPE_INSTANCE: return "instance";
+		case VK_OBJECT_TYPE_DEVICE: return "device";
+		case VK_OBJECT_TYPE_SURFACE_KHR: return "surface";
+		case VK_OBJECT_TYPE_SWAPCHAIN_KHR: return "swapchain";
+		case VK_OBJECT_TYPE_DEBUG_UTILS_MESSENGER_EXT: return "debug messenger";
+		case VK_OBJECT_TYPE_IMAGE: return "image";
+		case VK_OBJECT_TYPE_IMAGE_VIEW: return "image view";
+		case VK_OBJECT_TYPE_FRAMEBUFFER: return "framebuffer";
+		case VK_OBJECT_TYPE_RENDER_PASS: return "render pass";
+		case VK_OBJECT_TYPE_SHADER_MODULE: return "shader module";
+		case VK_OBJECT_TYPE_PIPELINE_LAYOUT: return "pipeline layout";
+		case VK_OBJECT_TYPE_PIPELINE: return "pipeline";
+		case VK_OBJECT_TYPE_PIPELINE_CACHE: return "pipeline cache";
+		case VK_OBJECT_TYPE_COMMAND_POOL: return "command pool";
+		case VK_OBJECT_TYPE_SEMAPHORE: return "semaphore";
+		case VK_OBJECT_TYPE_FENCE: return "fence";
+		case VK_OBJECT_TYPE_BUFFER: return "buffer";
+		case VK_OBJECT_TYPE_DEVICE_MEMORY: return "device memory";
+		case VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT: return "descriptor layout";
+		case VK_OBJECT_TYPE_DESCRIPTOR_POOL: return "descriptor pool";
+		case VK_OBJECT_TYPE_SAMPLER: return "sampler";
+		case VK_OBJECT_TYPE_QUERY_POOL: return "query pool";
+		default: return "other";
+		}
+	}
+	#pragma endregion REPORT
+};
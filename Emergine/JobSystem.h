@@ -0,0 +1,394 @@
+#pragma once
+#pragma region --- INCLUDES ---
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+#pragma endregion INCLUDES
+
+// a coroutine returning a value of type T, or nothing for Task<void>.
+// it doesn't start until something co_awaits it, and then hands control straight back to the awaiting coroutine when it's done,
+// so chains of tasks never pile up on the stack and never need a thread of their own.
+// an exception thrown inside comes out of the co_await
+template<typename T = void>
+class Task;
+
+namespace TaskDetail {
+	struct PromiseBase {
+		std::coroutine_handle<> continuation = std::noop_coroutine();
+		std::exception_ptr exception;
+
+		std::suspend_always initial_suspend() noexcept {
+			return {};
+		}
+
+		// resumes whoever awaited the task, on the thread that finished it
+		struct FinalAwaiter {
+			bool await_ready() noexcept {
+				return false;
+			}
+			template<typename Promise>
+			std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+				return handle.promise().continuation;
+			}
+			void await_resume() noexcept {}
+		};
+
+		FinalAwaiter final_suspend() noexcept {
+			return {};
+		}
+
+		void unhandled_exception() noexcept {
+			exception = std::current_exception();
+		}
+	};
+
+	template<typename T>
+	struct Promise : PromiseBase {
+		std::optional<T> value;
+
+		Task<T> get_return_object() noexcept;
+
+		template<typename U>
+		void return_value(U&& result) {
+			value.emplace(std::forward<U>(result));
+		}
+
+		T take() {
+			if (exception)
+			{
+				std::rethrow_exception(exception);
+			}
+			return std::move(*value);
+		}
+	};
+
+	template<>
+	struct Promise<void> : PromiseBase {
+		Task<void> get_return_object() noexcept;
+
+		void return_void() noexcept {}
+
+		void take() {
+			if (exception)
+			{
+				std::rethrow_exception(exception);
+			}
+		}
+	};
+
+	// a coroutine nobody waits for, it cleans up after itself
+	struct Detached {
+		struct promise_type {
+			Detached get_return_object() noexcept {
+				return {};
+			}
+			std::suspend_never initial_suspend() noexcept {
+				return {};
+			}
+			std::suspend_never final_suspend() noexcept {
+				return {};
+			}
+			void return_void() noexcept {}
+			void unhandled_exception() noexcept {
+				std::terminate();
+			}
+		};
+	};
+}
+
+template<typename T>
+class Task {
+public:
+	using promise_type = TaskDetail::Promise<T>;
+
+	Task() = default;
+	explicit Task(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+	Task(Task&& other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+	Task& operator=(Task&& other) noexcept {
+		if (this != &other)
+		{
+			destroy();
+			handle = std::exchange(other.handle, nullptr);
+		}
+		return *this;
+	}
+	Task(const Task&) = delete;
+	Task& operator=(const Task&) = delete;
+	~Task() {
+		destroy();
+	}
+
+	// starts the task and resumes the awaiting coroutine with its result
+	auto operator co_await() && noexcept {
+		struct Awaiter {
+			std::coroutine_handle<promise_type> handle;
+
+			bool await_ready() noexcept {
+				return false;
+			}
+			std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+				handle.promise().continuation = awaiting;
+				return handle;
+			}
+			T await_resume() {
+				return handle.promise().take();
+			}
+		};
+		return Awaiter{ handle };
+	}
+
+	// like co_await, but leaves the result in the task for result() to pick up
+	auto completion() noexcept {
+		struct Awaiter {
+			std::coroutine_handle<promise_type> handle;
+
+			bool await_ready() noexcept {
+				return false;
+			}
+			std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+				handle.promise().continuation = awaiting;
+				return handle;
+			}
+			void await_resume() noexcept {}
+		};
+		return Awaiter{ handle };
+	}
+
+	// only once the task has completed
+	T result() {
+		return handle.promise().take();
+	}
+
+private:
+	void destroy() {
+		if (handle)
+		{
+			handle.destroy();
+			handle = nullptr;
+		}
+	}
+
+	std::coroutine_handle<promise_type> handle;
+};
+
+namespace TaskDetail {
+	template<typename T>
+	Task<T> Promise<T>::get_return_object() noexcept {
+		return Task<T>(std::coroutine_handle<Promise<T>>::from_promise(*this));
+	}
+
+	inline Task<void> Promise<void>::get_return_object() noexcept {
+		return Task<void>(std::coroutine_handle<Promise<void>>::from_promise(*this));
+	}
+}
+
+// coroutines waiting for a thread to continue on, in the order they asked.
+// JobSystem workers take them from here, and so does syncWait() on the thread calling it
+class JobQueue {
+public:
+	// co_await queue.schedule() continues the coroutine on whichever thread takes it off the queue next
+	auto schedule() noexcept {
+		struct Awaiter {
+			JobQueue& queue;
+
+			bool await_ready() noexcept {
+				return false;
+			}
+			void await_suspend(std::coroutine_handle<> handle) {
+				queue.push(handle);
+			}
+			void await_resume() noexcept {}
+		};
+		return Awaiter{ *this };
+	}
+
+	void push(std::coroutine_handle<> job) {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			jobs.push_back(job);
+		}
+		condition.notify_one();
+	}
+
+	// blocks until there's a job, nullptr once the queue got closed and ran dry
+	std::coroutine_handle<> pop() {
+		std::unique_lock<std::mutex> lock(mutex);
+		condition.wait(lock, [this]() {
+			return !jobs.empty() || closed;
+		});
+		if (jobs.empty())
+		{
+			return nullptr;
+		}
+		std::coroutine_handle<> job = jobs.front();
+		jobs.pop_front();
+		return job;
+	}
+
+	void close() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			closed = true;
+		}
+		condition.notify_all();
+	}
+
+private:
+	std::mutex mutex;
+	std::condition_variable condition;
+	std::deque<std::coroutine_handle<>> jobs;
+	bool closed = false;
+};
+
+// a fixed set of worker threads resuming whatever gets scheduled on it.
+// a coroutine waiting on I/O or on other tasks holds no thread, so a few workers are enough for hundreds of loads in flight.
+// without any workers schedule() continues right away on the calling thread, which runs the same code synchronously
+class JobSystem {
+public:
+	explicit JobSystem(size_t threadCount) {
+		for (size_t i = 0; i < threadCount; i++)
+		{
+			workers.emplace_back([this]() {
+				while (std::coroutine_handle<> job = queue.pop())
+				{
+					job.resume();
+				}
+			});
+		}
+	}
+
+	// the workers finish what's queued first
+	~JobSystem() {
+		queue.close();
+		for (std::thread& worker : workers)
+		{
+			worker.join();
+		}
+	}
+
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	auto schedule() noexcept {
+		struct Awaiter {
+			JobSystem& jobs;
+
+			bool await_ready() noexcept {
+				return jobs.workers.empty();
+			}
+			void await_suspend(std::coroutine_handle<> handle) {
+				jobs.queue.push(handle);
+			}
+			void await_resume() noexcept {}
+		};
+		return Awaiter{ *this };
+	}
+
+	size_t threadCount() const {
+		return workers.size();
+	}
+
+private:
+	JobQueue queue;
+	std::vector<std::thread> workers;
+};
+
+namespace TaskDetail {
+	// the awaiting coroutine is resumed by whichever task finishes last, or right away when there were none
+	struct WhenAllCounter {
+		std::atomic<size_t> remaining;
+		std::coroutine_handle<> continuation;
+
+		explicit WhenAllCounter(size_t count) : remaining(count + 1) {}
+
+		void arrive() {
+			if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			{
+				continuation.resume();
+			}
+		}
+	};
+
+	template<typename T>
+	Detached runCounted(Task<T>& task, WhenAllCounter& counter) {
+		co_await task.completion();
+		counter.arrive();
+	}
+
+	template<typename T>
+	struct WhenAllAwaiter {
+		std::vector<Task<T>>& tasks;
+		WhenAllCounter counter;
+
+		bool await_ready() noexcept {
+			return tasks.empty();
+		}
+		bool await_suspend(std::coroutine_handle<> handle) {
+			counter.continuation = handle;
+			for (Task<T>& task : tasks)
+			{
+				runCounted(task, counter);
+			}
+			// the last task might already be done, then there's nobody left to resume us
+			return counter.remaining.fetch_sub(1, std::memory_order_acq_rel) != 1;
+		}
+		void await_resume() noexcept {}
+	};
+}
+
+// starts all of them at once, and continues once every one of them completed, on the thread that completed the last one.
+// results come back in the order of the tasks, the first exception after all of them are done
+template<typename T>
+Task<std::vector<T>> whenAll(std::vector<Task<T>> tasks) {
+	co_await TaskDetail::WhenAllAwaiter<T>{ tasks, TaskDetail::WhenAllCounter(tasks.size()) };
+
+	std::vector<T> results;
+	results.reserve(tasks.size());
+	for (Task<T>& task : tasks)
+	{
+		results.push_back(task.result());
+	}
+	co_return results;
+}
+
+inline Task<void> whenAll(std::vector<Task<void>> tasks) {
+	co_await TaskDetail::WhenAllAwaiter<void>{ tasks, TaskDetail::WhenAllCounter(tasks.size()) };
+
+	for (Task<void>& task : tasks)
+	{
+		task.result();
+	}
+}
+
+namespace TaskDetail {
+	template<typename T>
+	Detached signalWhenDone(Task<T>& task, std::atomic<bool>& done, JobQueue& queue) {
+		co_await task.completion();
+		done.store(true, std::memory_order_release);
+		// wakes up syncWait if it's blocked on an empty queue
+		queue.push(std::noop_coroutine());
+	}
+}
+
+// runs the task to completion from a thread that isn't a coroutine, like the main thread during setup.
+// meanwhile that thread resumes whatever gets scheduled on the given queue,
+// so work that has to stay on it, like submitting to a queue only it uses, can still be awaited from inside the task
+template<typename T>
+T syncWait(Task<T> task, JobQueue& callingThread) {
+	std::atomic<bool> done{ false };
+	TaskDetail::signalWhenDone(task, done, callingThread);
+	while (!done.load(std::memory_order_acquire))
+	{
+		callingThread.pop().resume();
+	}
+	return task.result();
+}
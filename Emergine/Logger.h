@@ -0,0 +1,384 @@
+#pragma once
+#pragma region --- INCLUDES ---
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#pragma endregion INCLUDES
+
+#pragma region --- LOG FLAGS ---
+// bit values match VkDebugUtilsMessageSeverityFlagBitsEXT,
+// so validation layer severities can be passed straight through
+enum LogSeverity : uint32_t {
+	LOG_SEVERITY_VERBOSE = 0x0001,
+	LOG_SEVERITY_INFO = 0x0010,
+	LOG_SEVERITY_WARNING = 0x0100,
+	LOG_SEVERITY_ERROR = 0x1000,
+	LOG_SEVERITY_ALL = LOG_SEVERITY_VERBOSE | LOG_SEVERITY_INFO | LOG_SEVERITY_WARNING | LOG_SEVERITY_ERROR
+};
+
+// the first 3 bit values match VkDebugUtilsMessageTypeFlagBitsEXT
+enum LogType : uint32_t {
+	LOG_TYPE_GENERAL = 0x1,
+	LOG_TYPE_VALIDATION = 0x2,
+	LOG_TYPE_PERFORMANCE = 0x4,
+	// messages coming from the engine itself rather than from the validation layers
+	LOG_TYPE_ENGINE = 0x8,
+	LOG_TYPE_ALL = LOG_TYPE_GENERAL | LOG_TYPE_VALIDATION | LOG_TYPE_PERFORMANCE | LOG_TYPE_ENGINE
+};
+#pragma endregion LOG FLAGS
+
+// asynchronous logger
+// callers copy their message into a lock-free multi-producer single-consumer ring buffer
+// and return right away, a background thread formats and writes the messages.
+// filtering and rate limiting happen on the calling thread, before anything gets copied,
+// so rejected messages cost little more than a couple of atomic loads.
+// when the ring is full messages are dropped rather than blocking the caller.
+class Logger {
+public:
+	// message text longer than this gets truncated
+	static constexpr size_t MAX_MESSAGE_LENGTH = 2048;
+	static constexpr size_t MAX_ID_NAME_LENGTH = 64;
+	// must be a power of 2
+	static constexpr size_t RING_SIZE = 512;
+	// message ids, or message texts, sharing a bucket share a rate limit, must be a power of 2
+	static constexpr size_t RATE_LIMIT_BUCKETS = 256;
+
+	Logger() : ring(new Slot[RING_SIZE]), startTime(std::chrono::steady_clock::now()) {
+		for (size_t i = 0; i < RING_SIZE; i++)
+		{
+			ring[i].sequence.store(i, std::memory_order_relaxed);
+		}
+
+		for (RateLimitBucket& bucket : rateLimitBuckets)
+		{
+			bucket.window.store(0, std::memory_order_relaxed);
+			bucket.suppressed.store(0, std::memory_order_relaxed);
+		}
+
+		writer = std::thread(&Logger::writerLoop, this);
+	}
+
+	~Logger() {
+		running.store(false, std::memory_order_release);
+		wakeWriter();
+		writer.join();
+	}
+
+	Logger(const Logger&) = delete;
+	Logger& operator=(const Logger&) = delete;
+
+	#pragma region --- FILTERS ---
+	// masks of LogSeverity and LogType bits, messages need to match both to be logged
+	void setSeverityMask(uint32_t mask) { severityMask.store(mask, std::memory_order_relaxed); }
+	void setTypeMask(uint32_t mask) { typeMask.store(mask, std::memory_order_relaxed); }
+	uint32_t getSeverityMask() const { return severityMask.load(std::memory_order_relaxed); }
+	uint32_t getTypeMask() const { return typeMask.load(std::memory_order_relaxed); }
+
+	// at most maxMessages per message id every windowMilliseconds
+	// maxMessages = 0 disables rate limiting
+	void setRateLimit(uint32_t maxMessages, uint32_t windowMilliseconds) {
+		rateLimitMessages.store(maxMessages, std::memory_order_relaxed);
+		rateLimitWindow.store(std::max(windowMilliseconds, 1u), std::memory_order_relaxed);
+	}
+
+	bool isEnabled(uint32_t severity, uint32_t type) const {
+		return (severity & severityMask.load(std::memory_order_relaxed)) != 0
+			&& (type & typeMask.load(std::memory_order_relaxed)) != 0;
+	}
+	#pragma endregion FILTERS
+
+	// messages with messageId = 0 are rate limited by their text instead
+	// never blocks, returns false if the message got filtered, rate limited or dropped
+	bool log(uint32_t severity, uint32_t type, int32_t messageId, const char* idName, const char* message) {
+		if (!isEnabled(severity, type))
+		{
+			return false;
+		}
+
+		uint32_t suppressedBefore = 0;
+		uint32_t rateLimitKey = messageId != 0 ? static_cast<uint32_t>(messageId) : hashMessage(message);
+		if (!passesRateLimit(rateLimitKey, suppressedBefore))
+		{
+			return false;
+		}
+
+		#pragma region --- CLAIM SLOT ---
+		// Vyukov's bounded queue: a slot is free for the producer whose position matches its sequence
+		Slot* slot = nullptr;
+		size_t position = enqueuePosition.load(std::memory_order_relaxed);
+		while (true)
+		{
+			slot = &ring[position & (RING_SIZE - 1)];
+			size_t sequence = slot->sequence.load(std::memory_order_acquire);
+			intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+
+			if (difference == 0)
+			{
+				if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+				{
+					break;
+				}
+			}
+			else if (difference < 0)
+			{
+				// ring is full, the writer hasn't caught up
+				dropped.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			}
+			else
+			{
+				position = enqueuePosition.load(std::memory_order_relaxed);
+			}
+		}
+		#pragma endregion CLAIM SLOT
+
+		#pragma region --- FILL SLOT ---
+		slot->severity = severity;
+		slot->type = type;
+		slot->messageId = messageId;
+		slot->suppressedBefore = suppressedBefore;
+		slot->time = std::chrono::steady_clock::now();
+		copyTruncated(slot->idName, MAX_ID_NAME_LENGTH, idName);
+		slot->length = copyTruncated(slot->message, MAX_MESSAGE_LENGTH, message);
+		#pragma endregion FILL SLOT
+
+		// publish to the writer
+		slot->sequence.store(position + 1, std::memory_order_release);
+
+		if (writerSleeping.load(std::memory_order_acquire))
+		{
+			wakeWriter();
+		}
+
+		return true;
+	}
+
+	bool log(uint32_t severity, const std::string& message) {
+		return log(severity, LOG_TYPE_ENGINE, 0, nullptr, message.c_str());
+	}
+
+	// messages lost because the ring was full
+	uint64_t getDroppedCount() const { return dropped.load(std::memory_order_relaxed); }
+	uint64_t getRateLimitedCount() const { return rateLimited.load(std::memory_order_relaxed); }
+
+private:
+	struct Slot {
+		std::atomic<size_t> sequence;
+		uint32_t severity;
+		uint32_t type;
+		int32_t messageId;
+		uint32_t suppressedBefore;
+		std::chrono::steady_clock::time_point time;
+		size_t length;
+		char idName[MAX_ID_NAME_LENGTH];
+		char message[MAX_MESSAGE_LENGTH];
+	};
+
+	struct RateLimitBucket {
+		// upper 32 bits: index of the current window, lower 32 bits: messages let through in it
+		std::atomic<uint64_t> window;
+		// messages rejected since the last one that got through
+		std::atomic<uint32_t> suppressed;
+	};
+
+	std::unique_ptr<Slot[]> ring;
+	// producers and the writer touch these constantly, keep them on separate cache lines
+	alignas(64) std::atomic<size_t> enqueuePosition{ 0 };
+	alignas(64) size_t dequeuePosition = 0;
+
+	alignas(64) std::atomic<uint32_t> severityMask{ LOG_SEVERITY_ALL };
+	std::atomic<uint32_t> typeMask{ LOG_TYPE_ALL };
+	std::atomic<uint32_t> rateLimitMessages{ 10 };
+	std::atomic<uint32_t> rateLimitWindow{ 1000 };
+	std::array<RateLimitBucket, RATE_LIMIT_BUCKETS> rateLimitBuckets;
+
+	std::atomic<uint64_t> dropped{ 0 };
+	std::atomic<uint64_t> rateLimited{ 0 };
+	uint64_t droppedReported = 0;
+
+	std::chrono::steady_clock::time_point startTime;
+
+	#pragma region --- WRITER THREAD ---
+	std::thread writer;
+	std::atomic<bool> running{ true };
+	std::atomic<bool> writerSleeping{ false };
+	std::mutex wakeMutex;
+	std::condition_variable wakeCondition;
+
+	// deliberately not taking the mutex, so producers never block on the writer
+	// a wakeup lost to that race is covered by the timeout in writerLoop
+	void wakeWriter() {
+		wakeCondition.notify_one();
+	}
+
+	void writerLoop() {
+		while (true)
+		{
+			bool wroteAnything = false;
+			while (writeNext())
+			{
+				wroteAnything = true;
+			}
+
+			if (wroteAnything)
+			{
+				// flush once per batch instead of once per message
+				fflush(stdout);
+				fflush(stderr);
+			}
+
+			reportDropped();
+
+			if (!running.load(std::memory_order_acquire))
+			{
+				// drain whatever got logged while shutting down
+				while (writeNext()) {}
+				fflush(stdout);
+				fflush(stderr);
+				return;
+			}
+
+			std::unique_lock<std::mutex> lock(wakeMutex);
+			writerSleeping.store(true, std::memory_order_release);
+			// the timeout covers a producer that published right before we went to sleep
+			wakeCondition.wait_for(lock, std::chrono::milliseconds(10));
+			writerSleeping.store(false, std::memory_order_release);
+		}
+	}
+
+	// returns false if there was nothing to write
+	bool writeNext() {
+		Slot& slot = ring[dequeuePosition & (RING_SIZE - 1)];
+		if (slot.sequence.load(std::memory_order_acquire) != dequeuePosition + 1)
+		{
+			return false;
+		}
+
+		FILE* stream = (slot.severity & (LOG_SEVERITY_WARNING | LOG_SEVERITY_ERROR)) != 0
+			|| (slot.type & LOG_TYPE_VALIDATION) != 0
+			? stderr
+			: stdout;
+
+		double seconds = std::chrono::duration<double>(slot.time - startTime).count();
+		fprintf(stream, "[%9.3f] %s %s", seconds, severityName(slot.severity), typeName(slot.type));
+		if (slot.idName[0] != '\0')
+		{
+			fprintf(stream, " %s", slot.idName);
+		}
+		if (slot.suppressedBefore > 0)
+		{
+			fprintf(stream, " (%u similar suppressed)", slot.suppressedBefore);
+		}
+		fputs(": ", stream);
+		fwrite(slot.message, 1, slot.length, stream);
+		fputc('\n', stream);
+
+		// hand the slot back to the producers, one lap ahead
+		slot.sequence.store(dequeuePosition + RING_SIZE, std::memory_order_release);
+		dequeuePosition++;
+
+		return true;
+	}
+
+	void reportDropped() {
+		uint64_t droppedNow = dropped.load(std::memory_order_relaxed);
+		if (droppedNow != droppedReported)
+		{
+			fprintf(stderr, "logger: %llu messages dropped, ring buffer was full\n",
+				static_cast<unsigned long long>(droppedNow - droppedReported));
+			droppedReported = droppedNow;
+		}
+	}
+	#pragma endregion WRITER THREAD
+
+	// FNV-1a, over the part of the message that would get logged
+	static uint32_t hashMessage(const char* message) {
+		uint32_t hash = 2166136261u;
+		for (size_t i = 0; message != nullptr && message[i] != '\0' && i < MAX_MESSAGE_LENGTH; i++)
+		{
+			hash = (hash ^ static_cast<uint8_t>(message[i])) * 16777619u;
+		}
+		return hash;
+	}
+
+	bool passesRateLimit(uint32_t key, uint32_t& suppressedBefore) {
+		uint32_t maxMessages = rateLimitMessages.load(std::memory_order_relaxed);
+		if (maxMessages == 0)
+		{
+			return true;
+		}
+
+		auto elapsed = std::chrono::steady_clock::now() - startTime;
+		uint64_t windowIndex = static_cast<uint64_t>(
+			std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count() / rateLimitWindow.load(std::memory_order_relaxed));
+
+		// fibonacci hashing spreads neighbouring ids across the buckets
+		size_t bucketIndex = ((key * 2654435769u) >> 24) & (RATE_LIMIT_BUCKETS - 1);
+		RateLimitBucket& bucket = rateLimitBuckets[bucketIndex];
+
+		uint64_t current = bucket.window.load(std::memory_order_relaxed);
+		while (true)
+		{
+			uint64_t next;
+			if ((current >> 32) != (windowIndex & 0xFFFFFFFF))
+			{
+				// first message of a new window
+				next = (windowIndex << 32) | 1;
+			}
+			else if ((current & 0xFFFFFFFF) < maxMessages)
+			{
+				next = current + 1;
+			}
+			else
+			{
+				bucket.suppressed.fetch_add(1, std::memory_order_relaxed);
+				rateLimited.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			}
+
+			if (bucket.window.compare_exchange_weak(current, next, std::memory_order_relaxed))
+			{
+				break;
+			}
+		}
+
+		suppressedBefore = bucket.suppressed.exchange(0, std::memory_order_relaxed);
+		return true;
+	}
+
+	static size_t copyTruncated(char* destination, size_t capacity, const char* source) {
+		if (source == nullptr)
+		{
+			destination[0] = '\0';
+			return 0;
+		}
+
+		size_t length = strnlen(source, capacity - 1);
+		memcpy(destination, source, length);
+		destination[length] = '\0';
+		return length;
+	}
+
+	static const char* severityName(uint32_t severity) {
+		if (severity & LOG_SEVERITY_ERROR) return "ERROR  ";
+		if (severity & LOG_SEVERITY_WARNING) return "WARNING";
+		if (severity & LOG_SEVERITY_INFO) return "INFO   ";
+		return "VERBOSE";
+	}
+
+	static const char* typeName(uint32_t type) {
+		if (type & LOG_TYPE_VALIDATION) return "validation ";
+		if (type & LOG_TYPE_PERFORMANCE) return "performance";
+		if (type & LOG_TYPE_ENGINE) return "engine     ";
+		return "general    ";
+	}
+};
@@ -0,0 +1,1429 @@
+#pragma once
+#pragma region --- INCLUDES ---
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "MeshSimplifier.h"
+#pragma endregion INCLUDES
+
+// matches the vertex input of the mesh pipeline
+struct MeshVertex {
+	float position[3];
+	float normal[3];
+	float uv[2];
+};
+
+// a range of the index buffer, every level of detail uses the same vertices
+struct MeshLod {
+	uint32_t firstIndex;
+	uint32_t indexCount;
+	// how far the surface moved from the full mesh at most, in mesh units
+	float error;
+};
+
+struct MeshData {
+	std::vector<MeshVertex> vertices;
+	// every level of detail after each other, the full mesh first
+	std::vector<uint32_t> indices;
+	std::vector<MeshLod> lods;
+	// axis aligned bounds of the positions
+	float boundsMin[3] = { 0.0f, 0.0f, 0.0f };
+	float boundsMax[3] = { 0.0f, 0.0f, 0.0f };
+};
+
+// post-transform vertex cache efficiency, simulated with a FIFO cache
+// ACMR: cache misses per triangle, 0.5 is the best a regular grid can do, 3 means no reuse at all
+// ATVR: cache misses per vertex, 1 means every vertex gets transformed exactly once
+struct MeshCacheStats {
+	float acmr = 0.0f;
+	float atvr = 0.0f;
+};
+
+struct MeshImportStats {
+	bool fromCache = false;
+	// source vertices before welding, so 3 per triangle for OBJ
+	uint32_t sourceVertexCount = 0;
+	uint32_t vertexCount = 0;
+	uint32_t triangleCount = 0;
+	MeshCacheStats before;
+	MeshCacheStats after;
+	// parsing + optimizing, or reading the cache
+	double loadTimeMs = 0.0;
+	// what the parse + optimize took when the cache was written, so cached loads can report their speedup
+	double importTimeMs = 0.0;
+};
+
+// loads OBJ, glTF and GLB meshes into a single indexed triangle list, ready for the vertex and index buffers.
+// imported meshes get
+//		welded: vertices that are equal up to WELD_EPSILON share an index
+//		reordered for the post-transform vertex cache (Forsyth's linear-speed optimizer)
+//		reordered for overdraw: the triangle order gets split into clusters wherever the vertex cache restarts,
+//			and the clusters get sorted so the ones facing away from the mesh center get drawn first
+//		simplified into a chain of levels of detail, each with about half the triangles of the one before
+//		reordered for vertex fetch: vertices get stored in the order the indices first use them
+// and get written to a binary cache next to the source, which later loads read directly as long as the source didn't change.
+// cache layout, all little endian:
+//		"EMESH\0" magic, uint16 version, uint64 source size, int64 source write time,
+//		uint32 vertex count, uint32 index count, float bounds[6], float ACMR/ATVR before and after, double import time,
+//		uint32 level of detail count, per level of detail uint32 first index, uint32 index count, float error,
+//		vertices, indices
+// throws std::runtime_error on files it can't read
+class MeshImporter {
+public:
+	static constexpr uint16_t CACHE_VERSION = 3;
+	static constexpr const char* CACHE_EXTENSION = ".emesh";
+	// relative to the diagonal of the bounding box
+	static constexpr float WELD_EPSILON = 1e-6f;
+	// cache the optimizer targets, most GPUs have at least this much
+	static constexpr uint32_t OPTIMIZER_CACHE_SIZE = 32;
+	// cache the stats get simulated with, on the conservative side
+	static constexpr uint32_t ANALYZER_CACHE_SIZE = 16;
+	// the full mesh included
+	static constexpr size_t MAX_LODS = 6;
+	// triangles each level of detail aims to keep from the one before
+	static constexpr float LOD_REDUCTION = 0.5f;
+	// meshes this small aren't worth simplifying further
+	static constexpr size_t MIN_LOD_TRIANGLES = 32;
+
+	static MeshData load(const std::string& path, MeshImportStats& stats) {
+		auto start = std::chrono::steady_clock::now();
+		stats = MeshImportStats{};
+
+		MeshData mesh;
+		std::string cachePath = path + CACHE_EXTENSION;
+		if (readCache(cachePath, sourceStamp(path), mesh, stats))
+		{
+			stats.fromCache = true;
+			stats.loadTimeMs = elapsedMs(start);
+			return mesh;
+		}
+
+		std::string extension = std::filesystem::path(path).extension().string();
+		std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return static_cast<char>(tolower(c)); });
+
+		bool hasNormals;
+		if (extension == ".obj")
+		{
+			mesh = loadObj(path, hasNormals);
+		}
+		else if (extension == ".gltf" || extension == ".glb")
+		{
+			mesh = loadGltf(path, extension == ".glb", hasNormals);
+		}
+		else
+		{
+			throw std::runtime_error("unsupported mesh format: " + path);
+		}
+
+		if (mesh.indices.empty())
+		{
+			throw std::runtime_error("mesh has no triangles: " + path);
+		}
+
+		stats.sourceVertexCount = static_cast<uint32_t>(mesh.vertices.size());
+		optimize(mesh, hasNormals, stats);
+
+		stats.loadTimeMs = elapsedMs(start);
+		stats.importTimeMs = stats.loadTimeMs;
+		// a cache that can't be written only costs the next run its speedup
+		writeCache(cachePath, sourceStamp(path), mesh, stats);
+		return mesh;
+	}
+
+	static MeshCacheStats analyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize = ANALYZER_CACHE_SIZE) {
+		std::vector<uint32_t> cachedAt(vertexCount, 0);
+		// timestamps instead of an actual FIFO, a vertex is cached while it was added less than cacheSize misses ago
+		uint32_t misses = 0;
+		std::vector<bool> used(vertexCount, false);
+		uint32_t usedCount = 0;
+
+		for (uint32_t index : indices)
+		{
+			if (cachedAt[index] == 0 || misses - cachedAt[index] + 1 > cacheSize)
+			{
+				misses++;
+				cachedAt[index] = misses;
+			}
+			if (!used[index])
+			{
+				used[index] = true;
+				usedCount++;
+			}
+		}
+
+		MeshCacheStats cacheStats;
+		cacheStats.acmr = indices.empty() ? 0.0f : static_cast<float>(misses) / (indices.size() / 3);
+		cacheStats.atvr = usedCount == 0 ? 0.0f : static_cast<float>(misses) / usedCount;
+		return cacheStats;
+	}
+
+private:
+	struct SourceStamp {
+		uint64_t size = 0;
+		int64_t writeTime = 0;
+	};
+
+	static double elapsedMs(std::chrono::steady_clock::time_point start) {
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	static SourceStamp sourceStamp(const std::string& path) {
+		SourceStamp stamp;
+		stamp.size = static_cast<uint64_t>(std::filesystem::file_size(path));
+		stamp.writeTime = static_cast<int64_t>(std::filesystem::last_write_time(path).time_since_epoch().count());
+		return stamp;
+	}
+
+	#pragma region --- OPTIMIZATION ---
+	static void optimize(MeshData& mesh, bool hasNormals, MeshImportStats& stats) {
+		weld(mesh);
+		if (!hasNormals)
+		{
+			generateNormals(mesh);
+		}
+
+		stats.before = analyzeVertexCache(mesh.indices, mesh.vertices.size());
+		stats.triangleCount = static_cast<uint32_t>(mesh.indices.size() / 3);
+
+		// each level gets simplified from the one before, which is a lot faster than starting from the full mesh every time
+		std::vector<std::vector<uint32_t>> lodIndices = { mesh.indices };
+		std::vector<float> lodErrors = { 0.0f };
+		while (lodIndices.size() < MAX_LODS && lodIndices.back().size() / 3 > MIN_LOD_TRIANGLES)
+		{
+			const std::vector<uint32_t>& previous = lodIndices.back();
+			size_t target = static_cast<size_t>(previous.size() / 3 * LOD_REDUCTION) * 3;
+
+			float error = 0.0f;
+			std::vector<uint32_t> simplified = MeshSimplifier::simplify(mesh.vertices[0].position, sizeof(MeshVertex) / sizeof(float),
+				mesh.vertices.size(), previous, target, error);
+
+			// stuck on locked vertices, another level would barely differ
+			if (simplified.size() > previous.size() * 9 / 10)
+			{
+				break;
+			}
+			lodIndices.push_back(std::move(simplified));
+			lodErrors.push_back(std::max(error, lodErrors.back()));
+		}
+
+		mesh.indices.clear();
+		mesh.lods.clear();
+		for (size_t lod = 0; lod < lodIndices.size(); lod++)
+		{
+			optimizeVertexCache(lodIndices[lod], mesh.vertices.size());
+			optimizeOverdraw(lodIndices[lod], mesh.vertices);
+
+			mesh.lods.push_back({ static_cast<uint32_t>(mesh.indices.size()), static_cast<uint32_t>(lodIndices[lod].size()), lodErrors[lod] });
+			mesh.indices.insert(mesh.indices.end(), lodIndices[lod].begin(), lodIndices[lod].end());
+		}
+
+		// the full mesh comes first in the index buffer, so it decides the vertex order
+		optimizeVertexFetch(mesh);
+		stats.after = analyzeVertexCache(std::vector<uint32_t>(mesh.indices.begin(), mesh.indices.begin() + mesh.lods[0].indexCount), mesh.vertices.size());
+		stats.vertexCount = static_cast<uint32_t>(mesh.vertices.size());
+	}
+
+	static void computeBounds(MeshData& mesh) {
+		for (int axis = 0; axis < 3; axis++)
+		{
+			mesh.boundsMin[axis] = mesh.vertices.empty() ? 0.0f : mesh.vertices[0].position[axis];
+			mesh.boundsMax[axis] = mesh.boundsMin[axis];
+		}
+		for (const MeshVertex& vertex : mesh.vertices)
+		{
+			for (int axis = 0; axis < 3; axis++)
+			{
+				mesh.boundsMin[axis] = std::min(mesh.boundsMin[axis], vertex.position[axis]);
+				mesh.boundsMax[axis] = std::max(mesh.boundsMax[axis], vertex.position[axis]);
+			}
+		}
+	}
+
+	// quantized attributes, equal keys get merged
+	struct WeldKey {
+		std::array<int64_t, 8> values;
+
+		bool operator==(const WeldKey& other) const {
+			return values == other.values;
+		}
+	};
+
+	struct WeldKeyHash {
+		size_t operator()(const WeldKey& key) const {
+			// FNV-1a over the quantized values
+			uint64_t hash = 14695981039346656037ull;
+			for (int64_t value : key.values)
+			{
+				hash ^= static_cast<uint64_t>(value);
+				hash *= 1099511628211ull;
+			}
+			return static_cast<size_t>(hash);
+		}
+	};
+
+	static void weld(MeshData& mesh) {
+		computeBounds(mesh);
+		float dx = mesh.boundsMax[0] - mesh.boundsMin[0];
+		float dy = mesh.boundsMax[1] - mesh.boundsMin[1];
+		float dz = mesh.boundsMax[2] - mesh.boundsMin[2];
+		double positionGrid = std::max(std::sqrt(static_cast<double>(dx * dx + dy * dy + dz * dz)) * WELD_EPSILON, 1e-12);
+
+		// positions relative to the bounds, so the steps stay below 1 / WELD_EPSILON however far the mesh is from the origin.
+		// uvs can tile far past 1, so those still get clamped, rounding anything past the range of int64_t is undefined
+		auto quantize = [](float value, double grid) {
+			double steps = std::clamp(static_cast<double>(value) / grid, -4.0e18, 4.0e18);
+			return static_cast<int64_t>(std::llround(steps));
+		};
+
+		std::unordered_map<WeldKey, uint32_t, WeldKeyHash> unique;
+		unique.reserve(mesh.vertices.size());
+		std::vector<MeshVertex> welded;
+		welded.reserve(mesh.vertices.size());
+
+		for (uint32_t& index : mesh.indices)
+		{
+			const MeshVertex& vertex = mesh.vertices[index];
+			WeldKey key{ {
+				quantize(vertex.position[0] - mesh.boundsMin[0], positionGrid),
+				quantize(vertex.position[1] - mesh.boundsMin[1], positionGrid),
+				quantize(vertex.position[2] - mesh.boundsMin[2], positionGrid),
+				quantize(vertex.normal[0], 1e-3f),
+				quantize(vertex.normal[1], 1e-3f),
+				quantize(vertex.normal[2], 1e-3f),
+				quantize(vertex.uv[0], 1e-5f),
+				quantize(vertex.uv[1], 1e-5f)
+			} };
+
+			auto inserted = unique.emplace(key, static_cast<uint32_t>(welded.size()));
+			if (inserted.second)
+			{
+				welded.push_back(vertex);
+			}
+			index = inserted.first->second;
+		}
+
+		mesh.vertices = std::move(welded);
+	}
+
+	// area weighted, shared between triangles that share a vertex
+	static void generateNormals(MeshData& mesh) {
+		for (MeshVertex& vertex : mesh.vertices)
+		{
+			vertex.normal[0] = vertex.normal[1] = vertex.normal[2] = 0.0f;
+		}
+
+		for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+		{
+			float normal[3];
+			faceNormal(mesh.vertices[mesh.indices[i]], mesh.vertices[mesh.indices[i + 1]], mesh.vertices[mesh.indices[i + 2]], normal);
+			for (size_t corner = 0; corner < 3; corner++)
+			{
+				MeshVertex& vertex = mesh.vertices[mesh.indices[i + corner]];
+				for (int axis = 0; axis < 3; axis++)
+				{
+					vertex.normal[axis] += normal[axis];
+				}
+			}
+		}
+
+		for (MeshVertex& vertex : mesh.vertices)
+		{
+			normalize(vertex.normal);
+		}
+	}
+
+	// not normalized, its length is twice the area of the triangle
+	static void faceNormal(const MeshVertex& a, const MeshVertex& b, const MeshVertex& c, float normal[3]) {
+		float e1[3] = { b.position[0] - a.position[0], b.position[1] - a.position[1], b.position[2] - a.position[2] };
+		float e2[3] = { c.position[0] - a.position[0], c.position[1] - a.position[1], c.position[2] - a.position[2] };
+		normal[0] = e1[1] * e2[2] - e1[2] * e2[1];
+		normal[1] = e1[2] * e2[0] - e1[0] * e2[2];
+		normal[2] = e1[0] * e2[1] - e1[1] * e2[0];
+	}
+
+	static void normalize(float vector[3]) {
+		float length = std::sqrt(vector[0] * vector[0] + vector[1] * vector[1] + vector[2] * vector[2]);
+		if (length > 0.0f)
+		{
+			vector[0] /= length;
+			vector[1] /= length;
+			vector[2] /= length;
+		}
+	}
+
+	#pragma region --- VERTEX CACHE ---
+	// Tom Forsyth, "Linear-Speed Vertex Cache Optimisation"
+	// greedily emits the triangle with the best score, scores favor vertices that are in the cache
+	// and vertices with few triangles left, so they don't end up stranded
+	static float vertexScore(int32_t cachePosition, uint32_t remainingTriangles) {
+		if (remainingTriangles == 0)
+		{
+			return -1.0f;
+		}
+
+		float score = 0.0f;
+		if (cachePosition >= 0)
+		{
+			if (cachePosition < 3)
+			{
+				// the last triangle's vertices, a fixed score so the order within it doesn't matter
+				score = 0.75f;
+			}
+			else
+			{
+				float scale = 1.0f / (OPTIMIZER_CACHE_SIZE - 3);
+				score = std::pow(1.0f - (cachePosition - 3) * scale, 1.5f);
+			}
+		}
+
+		// vertices with only a few triangles left get a boost
+		score += 2.0f / std::sqrt(static_cast<float>(remainingTriangles));
+		return score;
+	}
+
+	static void optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount) {
+		size_t triangleCount = indices.size() / 3;
+
+		#pragma region --- ADJACENCY ---
+		std::vector<uint32_t> remaining(vertexCount, 0);
+		for (uint32_t index : indices)
+		{
+			remaining[index]++;
+		}
+
+		std::vector<uint32_t> offsets(vertexCount + 1, 0);
+		for (size_t vertex = 0; vertex < vertexCount; vertex++)
+		{
+			offsets[vertex + 1] = offsets[vertex] + remaining[vertex];
+		}
+		std::vector<uint32_t> vertexTriangles(indices.size());
+		std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+		for (size_t triangle = 0; triangle < triangleCount; triangle++)
+		{
+			for (size_t corner = 0; corner < 3; corner++)
+			{
+				uint32_t vertex = indices[triangle * 3 + corner];
+				vertexTriangles[fill[vertex]++] = static_cast<uint32_t>(triangle);
+			}
+		}
+		#pragma endregion ADJACENCY
+
+		std::vector<int32_t> cachePositions(vertexCount, -1);
+		std::vector<float> vertexScores(vertexCount);
+		for (size_t vertex = 0; vertex < vertexCount; vertex++)
+		{
+			vertexScores[vertex] = vertexScore(-1, remaining[vertex]);
+		}
+
+		std::vector<float> triangleScores(triangleCount);
+		for (size_t triangle = 0; triangle < triangleCount; triangle++)
+		{
+			triangleScores[triangle] = vertexScores[indices[triangle * 3]]
+				+ vertexScores[indices[triangle * 3 + 1]]
+				+ vertexScores[indices[triangle * 3 + 2]];
+		}
+
+		std::vector<bool> emitted(triangleCount, false);
+		std::vector<uint32_t> output;
+		output.reserve(indices.size());
+
+		// room for the 3 vertices of a new triangle on top of the cache
+		std::vector<uint32_t> cache;
+		cache.reserve(OPTIMIZER_CACHE_SIZE + 3);
+		std::vector<uint32_t> newCache;
+		newCache.reserve(OPTIMIZER_CACHE_SIZE + 3);
+
+		size_t nextUnemitted = 0;
+		int64_t bestTriangle = -1;
+
+		for (size_t emittedCount = 0; emittedCount < triangleCount; emittedCount++)
+		{
+			if (bestTriangle < 0)
+			{
+				// nothing in the cache connects to anything left, start over at the next triangle in the input
+				while (emitted[nextUnemitted])
+				{
+					nextUnemitted++;
+				}
+				bestTriangle = static_cast<int64_t>(nextUnemitted);
+			}
+
+			uint32_t triangle = static_cast<uint32_t>(bestTriangle);
+			emitted[triangle] = true;
+			const uint32_t* triangleIndices = &indices[triangle * 3];
+			output.insert(output.end(), triangleIndices, triangleIndices + 3);
+
+			#pragma region --- UPDATE CACHE ---
+			// the triangle's vertices move to the front, everything else shifts back
+			newCache.assign(triangleIndices, triangleIndices + 3);
+			for (uint32_t vertex : cache)
+			{
+				if (vertex != triangleIndices[0] && vertex != triangleIndices[1] && vertex != triangleIndices[2])
+				{
+					newCache.push_back(vertex);
+				}
+			}
+
+			for (size_t corner = 0; corner < 3; corner++)
+			{
+				uint32_t vertex = triangleIndices[corner];
+				remaining[vertex]--;
+
+				// no need to look at this triangle again
+				uint32_t* first = &vertexTriangles[offsets[vertex]];
+				uint32_t* last = first + remaining[vertex] + 1;
+				std::swap(*std::find(first, last, triangle), *(last - 1));
+			}
+			#pragma endregion UPDATE CACHE
+
+			#pragma region --- UPDATE SCORES ---
+			bestTriangle = -1;
+			float bestScore = -1.0f;
+
+			for (size_t position = 0; position < newCache.size(); position++)
+			{
+				uint32_t vertex = newCache[position];
+				int32_t cachePosition = position < OPTIMIZER_CACHE_SIZE ? static_cast<int32_t>(position) : -1;
+				cachePositions[vertex] = cachePosition;
+
+				float score = vertexScore(cachePosition, remaining[vertex]);
+				float scoreChange = score - vertexScores[vertex];
+				vertexScores[vertex] = score;
+
+				for (uint32_t i = offsets[vertex]; i < offsets[vertex] + remaining[vertex]; i++)
+				{
+					uint32_t neighbour = vertexTriangles[i];
+					triangleScores[neighbour] += scoreChange;
+					if (triangleScores[neighbour] > bestScore)
+					{
+						bestScore = triangleScores[neighbour];
+						bestTriangle = neighbour;
+					}
+				}
+			}
+
+			// vertices pushed out of the cache
+			if (newCache.size() > OPTIMIZER_CACHE_SIZE)
+			{
+				newCache.resize(OPTIMIZER_CACHE_SIZE);
+			}
+			cache.swap(newCache);
+			#pragma endregion UPDATE SCORES
+		}
+
+		indices.swap(output);
+	}
+	#pragma endregion VERTEX CACHE
+
+	#pragma region --- OVERDRAW ---
+	// Sander, Nehab and Barczak, "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw", simplified:
+	// the cache optimized order gets cut where a triangle misses on all 3 vertices, as the cache starts over there anyway,
+	// and the clusters get sorted by how much they face away from the center, so the outside of the mesh tends to go first
+	static void optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<MeshVertex>& vertices) {
+		size_t triangleCount = indices.size() / 3;
+
+		#pragma region --- CLUSTERS ---
+		std::vector<size_t> clusterStarts;
+		std::vector<uint32_t> cachedAt(vertices.size(), 0);
+		uint32_t misses = 0;
+
+		for (size_t triangle = 0; triangle < triangleCount; triangle++)
+		{
+			uint32_t triangleMisses = 0;
+			for (size_t corner = 0; corner < 3; corner++)
+			{
+				uint32_t vertex = indices[triangle * 3 + corner];
+				if (cachedAt[vertex] == 0 || misses - cachedAt[vertex] + 1 > ANALYZER_CACHE_SIZE)
+				{
+					misses++;
+					cachedAt[vertex] = misses;
+					triangleMisses++;
+				}
+			}
+
+			if (triangle == 0 || triangleMisses == 3)
+			{
+				clusterStarts.push_back(triangle);
+			}
+		}
+		#pragma endregion CLUSTERS
+
+		if (clusterStarts.size() < 2)
+		{
+			return;
+		}
+
+		float meshCenter[3] = { 0.0f, 0.0f, 0.0f };
+		for (const MeshVertex& vertex : vertices)
+		{
+			for (int axis = 0; axis < 3; axis++)
+			{
+				meshCenter[axis] += vertex.position[axis] / vertices.size();
+			}
+		}
+
+		#pragma region --- SORT ---
+		std::vector<std::pair<float, size_t>> clusterOrder(clusterStarts.size());
+		for (size_t cluster = 0; cluster < clusterStarts.size(); cluster++)
+		{
+			size_t first = clusterStarts[cluster];
+			size_t last = cluster + 1 < clusterStarts.size() ? clusterStarts[cluster + 1] : triangleCount;
+
+			float centroid[3] = { 0.0f, 0.0f, 0.0f };
+			float normal[3] = { 0.0f, 0.0f, 0.0f };
+			float area = 0.0f;
+			for (size_t triangle = first; triangle < last; triangle++)
+			{
+				const MeshVertex& a = vertices[indices[triangle * 3]];
+				const MeshVertex& b = vertices[indices[triangle * 3 + 1]];
+				const MeshVertex& c = vertices[indices[triangle * 3 + 2]];
+
+				float triangleNormal[3];
+				faceNormal(a, b, c, triangleNormal);
+				float triangleArea = std::sqrt(triangleNormal[0] * triangleNormal[0]
+					+ triangleNormal[1] * triangleNormal[1] + triangleNormal[2] * triangleNormal[2]);
+
+				for (int axis = 0; axis < 3; axis++)
+				{
+					centroid[axis] += (a.position[axis] + b.position[axis] + c.position[axis]) / 3.0f * triangleArea;
+					normal[axis] += triangleNormal[axis];
+				}
+				area += triangleArea;
+			}
+
+			float facing = 0.0f;
+			if (area > 0.0f)
+			{
+				normalize(normal);
+				for (int axis = 0; axis < 3; axis++)
+				{
+					facing += (centroid[axis] / area - meshCenter[axis]) * normal[axis];
+				}
+			}
+			clusterOrder[cluster] = { facing, cluster };
+		}
+
+		// most outward facing first, ties keep the cache optimized order
+		std::stable_sort(clusterOrder.begin(), clusterOrder.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+
+		std::vector<uint32_t> output;
+		output.reserve(indices.size());
+		for (const auto& entry : clusterOrder)
+		{
+			size_t cluster = entry.second;
+			size_t first = clusterStarts[cluster];
+			size_t last = cluster + 1 < clusterStarts.size() ? clusterStarts[cluster + 1] : triangleCount;
+			output.insert(output.end(), indices.begin() + first * 3, indices.begin() + last * 3);
+		}
+		indices.swap(output);
+		#pragma endregion SORT
+	}
+	#pragma endregion OVERDRAW
+
+	// stores vertices in the order they're first used, so fetching them walks through memory,
+	// unused vertices get dropped
+	static void optimizeVertexFetch(MeshData& mesh) {
+		std::vector<uint32_t> remap(mesh.vertices.size(), UINT32_MAX);
+		std::vector<MeshVertex> ordered;
+		ordered.reserve(mesh.vertices.size());
+
+		for (uint32_t& index : mesh.indices)
+		{
+			if (remap[index] == UINT32_MAX)
+			{
+				remap[index] = static_cast<uint32_t>(ordered.size());
+				ordered.push_back(mesh.vertices[index]);
+			}
+			index = remap[index];
+		}
+
+		mesh.vertices = std::move(ordered);
+		computeBounds(mesh);
+	}
+	#pragma endregion OPTIMIZATION
+
+	#pragma region --- OBJ ---
+	// positions, texture coordinates and normals of triangles and polygons, which get fanned into triangles
+	// materials, groups and everything else get ignored
+	static MeshData loadObj(const std::string& path, bool& hasNormals) {
+		std::ifstream file(path);
+		if (!file.is_open())
+		{
+			throw std::runtime_error("failed to open " + path);
+		}
+
+		std::vector<std::array<float, 3>> positions;
+		std::vector<std::array<float, 2>> uvs;
+		std::vector<std::array<float, 3>> normals;
+		MeshData mesh;
+		hasNormals = true;
+
+		std::string line;
+		std::vector<MeshVertex> polygon;
+		while (std::getline(file, line))
+		{
+			std::istringstream stream(line);
+			std::string type;
+			stream >> type;
+
+			if (type == "v")
+			{
+				std::array<float, 3> position{};
+				stream >> position[0] >> position[1] >> position[2];
+				positions.push_back(position);
+			}
+			else if (type == "vt")
+			{
+				std::array<float, 2> uv{};
+				stream >> uv[0] >> uv[1];
+				// OBJ has v pointing up, Vulkan samples with v pointing down
+				uv[1] = 1.0f - uv[1];
+				uvs.push_back(uv);
+			}
+			else if (type == "vn")
+			{
+				std::array<float, 3> normal{};
+				stream >> normal[0] >> normal[1] >> normal[2];
+				normals.push_back(normal);
+			}
+			else if (type == "f")
+			{
+				polygon.clear();
+				std::string corner;
+				while (stream >> corner)
+				{
+					polygon.push_back(objVertex(corner, positions, uvs, normals, hasNormals));
+				}
+
+				for (size_t i = 1; i + 1 < polygon.size(); i++)
+				{
+					for (const MeshVertex* vertex : { &polygon[0], &polygon[i], &polygon[i + 1] })
+					{
+						mesh.indices.push_back(static_cast<uint32_t>(mesh.vertices.size()));
+						mesh.vertices.push_back(*vertex);
+					}
+				}
+			}
+		}
+
+		return mesh;
+	}
+
+	// "position", "position/uv", "position//normal" or "position/uv/normal", 1 based, negative counts from the end
+	static MeshVertex objVertex(const std::string& corner,
+		const std::vector<std::array<float, 3>>& positions,
+		const std::vector<std::array<float, 2>>& uvs,
+		const std::vector<std::array<float, 3>>& normals,
+		bool& hasNormals) {
+		int64_t references[3] = { 0, 0, 0 };
+		size_t start = 0;
+		for (int i = 0; i < 3 && start <= corner.size(); i++)
+		{
+			size_t end = corner.find('/', start);
+			std::string part = corner.substr(start, end == std::string::npos ? std::string::npos : end - start);
+			if (!part.empty())
+			{
+				references[i] = std::stoll(part);
+			}
+			if (end == std::string::npos)
+			{
+				break;
+			}
+			start = end + 1;
+		}
+
+		auto resolve = [](int64_t reference, size_t count) -> int64_t {
+			int64_t index = reference < 0 ? static_cast<int64_t>(count) + reference : reference - 1;
+			return index >= 0 && index < static_cast<int64_t>(count) ? index : -1;
+		};
+
+		MeshVertex vertex{};
+		int64_t position = resolve(references[0], positions.size());
+		if (position < 0)
+		{
+			throw std::runtime_error("OBJ face references a missing position");
+		}
+		std::memcpy(vertex.position, positions[position].data(), sizeof(vertex.position));
+
+		int64_t uv = references[1] != 0 ? resolve(references[1], uvs.size()) : -1;
+		if (uv >= 0)
+		{
+			std::memcpy(vertex.uv, uvs[uv].data(), sizeof(vertex.uv));
+		}
+
+		int64_t normal = references[2] != 0 ? resolve(references[2], normals.size()) : -1;
+		if (normal >= 0)
+		{
+			std::memcpy(vertex.normal, normals[normal].data(), sizeof(vertex.normal));
+		}
+		else
+		{
+			hasNormals = false;
+		}
+
+		return vertex;
+	}
+	#pragma endregion OBJ
+
+	#pragma region --- JSON ---
+	// just enough JSON for glTF
+	struct Json {
+		enum class Type { NONE, BOOLEAN, NUMBER, STRING, ARRAY, OBJECT } type = Type::NONE;
+		double number = 0.0;
+		std::string string;
+		std::vector<Json> array;
+		std::map<std::string, Json> object;
+
+		const Json& operator[](const std::string& key) const {
+			static const Json none;
+			auto found = object.find(key);
+			return found == object.end() ? none : found->second;
+		}
+
+		const Json& operator[](size_t index) const {
+			static const Json none;
+			return index < array.size() ? array[index] : none;
+		}
+
+		bool has(const std::string& key) const {
+			return object.count(key) > 0;
+		}
+
+		double numberOr(double fallback) const {
+			return type == Type::NUMBER ? number : fallback;
+		}
+
+		static Json parse(const char* text, size_t length) {
+			size_t position = 0;
+			Json value = parseValue(text, length, position);
+			return value;
+		}
+
+	private:
+		static void skipWhitespace(const char* text, size_t length, size_t& position) {
+			while (position < length && isspace(static_cast<unsigned char>(text[position])))
+			{
+				position++;
+			}
+		}
+
+		static Json parseValue(const char* text, size_t length, size_t& position) {
+			skipWhitespace(text, length, position);
+			if (position >= length)
+			{
+				throw std::runtime_error("unexpected end of JSON");
+			}
+
+			Json value;
+			char c = text[position];
+			if (c == '{')
+			{
+				value.type = Type::OBJECT;
+				position++;
+				skipWhitespace(text, length, position);
+				if (position < length && text[position] == '}')
+				{
+					position++;
+					return value;
+				}
+				while (true)
+				{
+					skipWhitespace(text, length, position);
+					std::string key = parseString(text, length, position);
+					skipWhitespace(text, length, position);
+					expect(text, length, position, ':');
+					value.object[key] = parseValue(text, length, position);
+					skipWhitespace(text, length, position);
+					if (position < length && text[position] == ',')
+					{
+						position++;
+						continue;
+					}
+					expect(text, length, position, '}');
+					return value;
+				}
+			}
+			if (c == '[')
+			{
+				value.type = Type::ARRAY;
+				position++;
+				skipWhitespace(text, length, position);
+				if (position < length && text[position] == ']')
+				{
+					position++;
+					return value;
+				}
+				while (true)
+				{
+					value.array.push_back(parseValue(text, length, position));
+					skipWhitespace(text, length, position);
+					if (position < length && text[position] == ',')
+					{
+						position++;
+						continue;
+					}
+					expect(text, length, position, ']');
+					return value;
+				}
+			}
+			if (c == '"')
+			{
+				value.type = Type::STRING;
+				value.string = parseString(text, length, position);
+				return value;
+			}
+			if (c == 't' || c == 'f')
+			{
+				value.type = Type::BOOLEAN;
+				value.number = c == 't' ? 1.0 : 0.0;
+				position += c == 't' ? 4 : 5;
+				return value;
+			}
+			if (c == 'n')
+			{
+				position += 4;
+				return value;
+			}
+
+			value.type = Type::NUMBER;
+			char* end;
+			value.number = std::strtod(text + position, &end);
+			if (end == text + position)
+			{
+				throw std::runtime_error("invalid JSON");
+			}
+			position = end - text;
+			return value;
+		}
+
+		// escapes other than \uXXXX are kept, those only show up in names glTF doesn't need
+		static std::string parseString(const char* text, size_t length, size_t& position) {
+			expect(text, length, position, '"');
+			std::string result;
+			while (position < length && text[position] != '"')
+			{
+				if (text[position] == '\\' && position + 1 < length)
+				{
+					position++;
+					switch (text[position])
+					{
+					case 'n': result += '\n'; break;
+					case 't': result += '\t'; break;
+					case 'u': result += '?'; position += 4; break;
+					default: result += text[position]; break;
+					}
+					position++;
+					continue;
+				}
+				result += text[position++];
+			}
+			expect(text, length, position, '"');
+			return result;
+		}
+
+		static void expect(const char* text, size_t length, size_t& position, char c) {
+			if (position >= length || text[position] != c)
+			{
+				throw std::runtime_error(std::string("invalid JSON, expected ") + c);
+			}
+			position++;
+		}
+	};
+	#pragma endregion JSON
+
+	#pragma region --- GLTF ---
+	// column major 4x4
+	using Matrix = std::array<float, 16>;
+
+	static Matrix identity() {
+		return { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+	}
+
+	static Matrix multiply(const Matrix& a, const Matrix& b) {
+		Matrix result{};
+		for (int column = 0; column < 4; column++)
+		{
+			for (int row = 0; row < 4; row++)
+			{
+				for (int k = 0; k < 4; k++)
+				{
+					result[column * 4 + row] += a[k * 4 + row] * b[column * 4 + k];
+				}
+			}
+		}
+		return result;
+	}
+
+	struct GltfFile {
+		Json json;
+		std::vector<std::vector<uint8_t>> buffers;
+	};
+
+	// triangle primitives of every mesh in the default scene, with their node transforms applied
+	// without a scene, every mesh gets loaded as is
+	static MeshData loadGltf(const std::string& path, bool binary, bool& hasNormals) {
+		std::ifstream file(path, std::ios::ate | std::ios::binary);
+		if (!file.is_open())
+		{
+			throw std::runtime_error("failed to open " + path);
+		}
+		std::vector<char> contents(static_cast<size_t>(file.tellg()));
+		file.seekg(0);
+		file.read(contents.data(), contents.size());
+
+		GltfFile gltf;
+		std::vector<uint8_t> binaryChunk;
+
+		if (binary)
+		{
+			#pragma region --- GLB ---
+			// 12 byte header, then chunks of uint32 length, uint32 type, data
+			if (contents.size() < 20 || std::memcmp(contents.data(), "glTF", 4) != 0)
+			{
+				throw std::runtime_error("not a GLB file: " + path);
+			}
+
+			size_t offset = 12;
+			while (offset + 8 <= contents.size())
+			{
+				uint32_t chunkLength;
+				uint32_t chunkType;
+				std::memcpy(&chunkLength, contents.data() + offset, 4);
+				std::memcpy(&chunkType, contents.data() + offset + 4, 4);
+				offset += 8;
+				if (offset + chunkLength > contents.size())
+				{
+					throw std::runtime_error("truncated GLB file: " + path);
+				}
+
+				// "JSON" and "BIN\0" in little endian
+				if (chunkType == 0x4E4F534A)
+				{
+					gltf.json = Json::parse(contents.data() + offset, chunkLength);
+				}
+				else if (chunkType == 0x004E4942)
+				{
+					binaryChunk.assign(contents.begin() + offset, contents.begin() + offset + chunkLength);
+				}
+				offset += chunkLength;
+			}
+			#pragma endregion GLB
+		}
+		else
+		{
+			gltf.json = Json::parse(contents.data(), contents.size());
+		}
+
+		#pragma region --- BUFFERS ---
+		std::filesystem::path directory = std::filesystem::path(path).parent_path();
+		for (const Json& buffer : gltf.json["buffers"].array)
+		{
+			if (!buffer.has("uri"))
+			{
+				// the binary chunk of a GLB file
+				gltf.buffers.push_back(binaryChunk);
+				continue;
+			}
+
+			const std::string& uri = buffer["uri"].string;
+			size_t comma = uri.find(',');
+			if (uri.compare(0, 5, "data:") == 0 && comma != std::string::npos)
+			{
+				gltf.buffers.push_back(decodeBase64(uri.substr(comma + 1)));
+				continue;
+			}
+
+			std::ifstream bufferFile(directory / uri, std::ios::ate | std::ios::binary);
+			if (!bufferFile.is_open())
+			{
+				throw std::runtime_error("failed to open glTF buffer " + uri);
+			}
+			std::vector<uint8_t> data(static_cast<size_t>(bufferFile.tellg()));
+			bufferFile.seekg(0);
+			bufferFile.read(reinterpret_cast<char*>(data.data()), data.size());
+			gltf.buffers.push_back(std::move(data));
+		}
+		#pragma endregion BUFFERS
+
+		MeshData mesh;
+		hasNormals = true;
+
+		const Json& scenes = gltf.json["scenes"];
+		if (scenes.array.empty())
+		{
+			for (size_t i = 0; i < gltf.json["meshes"].array.size(); i++)
+			{
+				appendGltfMesh(gltf, i, identity(), mesh, hasNormals);
+			}
+		}
+		else
+		{
+			const Json& scene = scenes[static_cast<size_t>(gltf.json["scene"].numberOr(0))];
+			for (const Json& node : scene["nodes"].array)
+			{
+				appendGltfNode(gltf, static_cast<size_t>(node.number), identity(), mesh, hasNormals, 0);
+			}
+		}
+
+		return mesh;
+	}
+
+	static void appendGltfNode(const GltfFile& gltf, size_t nodeIndex, const Matrix& parent, MeshData& mesh, bool& hasNormals, int depth) {
+		// malformed files could otherwise recurse forever
+		if (depth > 64)
+		{
+			throw std::runtime_error("glTF node hierarchy too deep");
+		}
+
+		const Json& node = gltf.json["nodes"][nodeIndex];
+		Matrix local = identity();
+		if (node.has("matrix"))
+		{
+			for (size_t i = 0; i < 16; i++)
+			{
+				local[i] = static_cast<float>(node["matrix"][i].number);
+			}
+		}
+		else
+		{
+			// translation * rotation * scale
+			float t[3] = { 0.0f, 0.0f, 0.0f };
+			float r[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+			float s[3] = { 1.0f, 1.0f, 1.0f };
+			for (size_t i = 0; i < 3; i++)
+			{
+				t[i] = static_cast<float>(node["translation"][i].numberOr(t[i]));
+				s[i] = static_cast<float>(node["scale"][i].numberOr(s[i]));
+			}
+			for (size_t i = 0; i < 4; i++)
+			{
+				r[i] = static_cast<float>(node["rotation"][i].numberOr(r[i]));
+			}
+
+			float x = r[0], y = r[1], z = r[2], w = r[3];
+			local = {
+				(1 - 2 * (y * y + z * z)) * s[0], 2 * (x * y + z * w) * s[0], 2 * (x * z - y * w) * s[0], 0,
+				2 * (x * y - z * w) * s[1], (1 - 2 * (x * x + z * z)) * s[1], 2 * (y * z + x * w) * s[1], 0,
+				2 * (x * z + y * w) * s[2], 2 * (y * z - x * w) * s[2], (1 - 2 * (x * x + y * y)) * s[2], 0,
+				t[0], t[1], t[2], 1
+			};
+		}
+
+		Matrix world = multiply(parent, local);
+		if (node.has("mesh"))
+		{
+			appendGltfMesh(gltf, static_cast<size_t>(node["mesh"].number), world, mesh, hasNormals);
+		}
+		for (const Json& child : node["children"].array)
+		{
+			appendGltfNode(gltf, static_cast<size_t>(child.number), world, mesh, hasNormals, depth + 1);
+		}
+	}
+
+	static void appendGltfMesh(const GltfFile& gltf, size_t meshIndex, const Matrix& transform, MeshData& mesh, bool& hasNormals) {
+		for (const Json& primitive : gltf.json["meshes"][meshIndex]["primitives"].array)
+		{
+			// 4 = triangles, everything else gets skipped
+			if (primitive["mode"].numberOr(4) != 4 || !primitive["attributes"].has("POSITION"))
+			{
+				continue;
+			}
+
+			const Json& attributes = primitive["attributes"];
+			std::vector<float> positions = readAccessor<float>(gltf, static_cast<size_t>(attributes["POSITION"].number), 3);
+			size_t vertexCount = positions.size() / 3;
+
+			std::vector<float> normals;
+			if (attributes.has("NORMAL"))
+			{
+				normals = readAccessor<float>(gltf, static_cast<size_t>(attributes["NORMAL"].number), 3);
+			}
+			else
+			{
+				hasNormals = false;
+			}
+
+			std::vector<float> uvs;
+			if (attributes.has("TEXCOORD_0"))
+			{
+				uvs = readAccessor<float>(gltf, static_cast<size_t>(attributes["TEXCOORD_0"].number), 2);
+			}
+
+			uint32_t firstVertex = static_cast<uint32_t>(mesh.vertices.size());
+			for (size_t i = 0; i < vertexCount; i++)
+			{
+				MeshVertex vertex{};
+				for (int row = 0; row < 3; row++)
+				{
+					vertex.position[row] = transform[12 + row];
+					for (int column = 0; column < 3; column++)
+					{
+						vertex.position[row] += transform[column * 4 + row] * positions[i * 3 + column];
+						if (normals.size() >= (i + 1) * 3)
+						{
+							// fine for rotations and uniform scales, which is what nodes almost always use
+							vertex.normal[row] += transform[column * 4 + row] * normals[i * 3 + column];
+						}
+					}
+				}
+				normalize(vertex.normal);
+				if (uvs.size() >= (i + 1) * 2)
+				{
+					vertex.uv[0] = uvs[i * 2];
+					vertex.uv[1] = uvs[i * 2 + 1];
+				}
+				mesh.vertices.push_back(vertex);
+			}
+
+			if (primitive.has("indices"))
+			{
+				std::vector<uint32_t> indices = readAccessor<uint32_t>(gltf, static_cast<size_t>(primitive["indices"].number), 1);
+				for (uint32_t index : indices)
+				{
+					// would have the GPU fetch vertices past the end of the buffer
+					if (index >= vertexCount)
+					{
+						throw std::runtime_error("glTF primitive references a missing vertex");
+					}
+					mesh.indices.push_back(firstVertex + index);
+				}
+			}
+			else
+			{
+				for (uint32_t i = 0; i < vertexCount; i++)
+				{
+					mesh.indices.push_back(firstVertex + i);
+				}
+			}
+		}
+	}
+
+	// every component converted to T, floats for attributes and uint32_t for indices
+	template <typename T>
+	static std::vector<T> readAccessor(const GltfFile& gltf, size_t accessorIndex, size_t components) {
+		const Json& accessor = gltf.json["accessors"][accessorIndex];
+		const Json& view = gltf.json["bufferViews"][static_cast<size_t>(accessor["bufferView"].numberOr(0))];
+		size_t bufferIndex = static_cast<size_t>(view["buffer"].numberOr(0));
+		if (bufferIndex >= gltf.buffers.size())
+		{
+			throw std::runtime_error("glTF accessor references a missing buffer");
+		}
+		const std::vector<uint8_t>& buffer = gltf.buffers[bufferIndex];
+
+		uint32_t componentType = static_cast<uint32_t>(accessor["componentType"].number);
+		size_t componentSize = componentType == 5126 || componentType == 5125 ? 4 : (componentType == 5122 || componentType == 5123 ? 2 : 1);
+		size_t count = static_cast<size_t>(accessor["count"].number);
+		size_t stride = static_cast<size_t>(view["byteStride"].numberOr(static_cast<double>(componentSize * components)));
+		size_t offset = static_cast<size_t>(view["byteOffset"].numberOr(0) + accessor["byteOffset"].numberOr(0));
+		bool normalized = accessor["normalized"].numberOr(0) != 0;
+
+		if (count > 0 && offset + (count - 1) * stride + componentSize * components > buffer.size())
+		{
+			throw std::runtime_error("glTF accessor out of bounds");
+		}
+
+		std::vector<T> values(count * components);
+		for (size_t i = 0; i < count; i++)
+		{
+			const uint8_t* element = buffer.data() + offset + i * stride;
+			for (size_t component = 0; component < components; component++)
+			{
+				const uint8_t* data = element + component * componentSize;
+				// double holds every component type exactly
+				double value = 0.0;
+				switch (componentType)
+				{
+				case 5120: value = *reinterpret_cast<const int8_t*>(data); if (normalized) value = std::max(value / 127.0, -1.0); break;
+				case 5121: value = *data; if (normalized) value /= 255.0; break;
+				case 5122: { int16_t v; std::memcpy(&v, data, 2); value = v; if (normalized) value = std::max(value / 32767.0, -1.0); break; }
+				case 5123: { uint16_t v; std::memcpy(&v, data, 2); value = v; if (normalized) value /= 65535.0; break; }
+				case 5125: { uint32_t v; std::memcpy(&v, data, 4); value = v; break; }
+				case 5126: { float v; std::memcpy(&v, data, 4); value = v; break; }
+				default: throw std::runtime_error("unsupported glTF component type");
+				}
+				values[i * components + component] = static_cast<T>(value);
+			}
+		}
+		return values;
+	}
+
+	static std::vector<uint8_t> decodeBase64(const std::string& text) {
+		std::vector<uint8_t> data;
+		data.reserve(text.size() * 3 / 4);
+		uint32_t bits = 0;
+		int bitCount = 0;
+		for (char c : text)
+		{
+			int value;
+			if (c >= 'A' && c <= 'Z') value = c - 'A';
+			else if (c >= 'a' && c <= 'z') value = c - 'a' + 26;
+			else if (c >= '0' && c <= '9') value = c - '0' + 52;
+			else if (c == '+') value = 62;
+			else if (c == '/') value = 63;
+			else continue;
+
+			bits = (bits << 6) | static_cast<uint32_t>(value);
+			bitCount += 6;
+			if (bitCount >= 8)
+			{
+				bitCount -= 8;
+				data.push_back(static_cast<uint8_t>(bits >> bitCount));
+			}
+		}
+		return data;
+	}
+	#pragma endregion GLTF
+
+	#pragma region --- CACHE ---
+	static bool readCache(const std::string& cachePath, const SourceStamp& stamp, MeshData& mesh, MeshImportStats& stats) {
+		std::ifstream file(cachePath, std::ios::binary);
+		if (!file.is_open())
+		{
+			return false;
+		}
+
+		char magic[6];
+		uint16_t version = 0;
+		SourceStamp cachedStamp;
+		uint32_t vertexCount = 0;
+		uint32_t indexCount = 0;
+		file.read(magic, sizeof(magic));
+		readValue(file, version);
+		readValue(file, cachedStamp.size);
+		readValue(file, cachedStamp.writeTime);
+		if (!file || std::memcmp(magic, "EMESH\0", 6) != 0 || version != CACHE_VERSION
+			|| cachedStamp.size != stamp.size || cachedStamp.writeTime != stamp.writeTime)
+		{
+			return false;
+		}
+
+		readValue(file, vertexCount);
+		readValue(file, indexCount);
+		file.read(reinterpret_cast<char*>(mesh.boundsMin), sizeof(mesh.boundsMin));
+		file.read(reinterpret_cast<char*>(mesh.boundsMax), sizeof(mesh.boundsMax));
+		readValue(file, stats.before.acmr);
+		readValue(file, stats.before.atvr);
+		readValue(file, stats.after.acmr);
+		readValue(file, stats.after.atvr);
+		readValue(file, stats.importTimeMs);
+
+		uint32_t lodCount = 0;
+		readValue(file, lodCount);
+		if (!file || lodCount == 0 || lodCount > MAX_LODS)
+		{
+			return false;
+		}
+		mesh.lods.resize(lodCount);
+		for (MeshLod& lod : mesh.lods)
+		{
+			readValue(file, lod.firstIndex);
+			readValue(file, lod.indexCount);
+			readValue(file, lod.error);
+		}
+
+		// corrupt counts would otherwise allocate far more than the file could ever fill
+		std::streamoff dataStart = file.tellg();
+		file.seekg(0, std::ios::end);
+		std::streamoff dataSize = file.tellg() - dataStart;
+		file.seekg(dataStart);
+		if (!file || static_cast<uint64_t>(dataSize) < sizeof(MeshVertex) * static_cast<uint64_t>(vertexCount) + sizeof(uint32_t) * static_cast<uint64_t>(indexCount))
+		{
+			return false;
+		}
+
+		mesh.vertices.resize(vertexCount);
+		mesh.indices.resize(indexCount);
+		file.read(reinterpret_cast<char*>(mesh.vertices.data()), static_cast<std::streamsize>(sizeof(MeshVertex) * vertexCount));
+		file.read(reinterpret_cast<char*>(mesh.indices.data()), static_cast<std::streamsize>(sizeof(uint32_t) * indexCount));
+		if (!file)
+		{
+			return false;
+		}
+
+		// the draws use the cache as it is, so a corrupt one gets imported again rather than reading past the buffers
+		for (const MeshLod& lod : mesh.lods)
+		{
+			if (lod.indexCount == 0 || lod.firstIndex > indexCount || lod.indexCount > indexCount - lod.firstIndex)
+			{
+				return false;
+			}
+		}
+		for (uint32_t index : mesh.indices)
+		{
+			if (index >= vertexCount)
+			{
+				return false;
+			}
+		}
+
+		stats.vertexCount = vertexCount;
+		stats.triangleCount = mesh.lods[0].indexCount / 3;
+		return true;
+	}
+
+	static void writeCache(const std::string& cachePath, const SourceStamp& stamp, const MeshData& mesh, const MeshImportStats& stats) {
+		// written next to the final path and renamed, so a crash never leaves half a cache behind
+		std::string temporaryPath = cachePath + ".tmp";
+		{
+			std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+			if (!file.is_open())
+			{
+				return;
+			}
+
+			file.write("EMESH\0", 6);
+			writeValue(file, CACHE_VERSION);
+			writeValue(file, stamp.size);
+			writeValue(file, stamp.writeTime);
+			writeValue(file, static_cast<uint32_t>(mesh.vertices.size()));
+			writeValue(file, static_cast<uint32_t>(mesh.indices.size()));
+			file.write(reinterpret_cast<const char*>(mesh.boundsMin), sizeof(mesh.boundsMin));
+			file.write(reinterpret_cast<const char*>(mesh.boundsMax), sizeof(mesh.boundsMax));
+			writeValue(file, stats.before.acmr);
+			writeValue(file, stats.before.atvr);
+			writeValue(file, stats.after.acmr);
+			writeValue(file, stats.after.atvr);
+			writeValue(file, stats.importTimeMs);
+			writeValue(file, static_cast<uint32_t>(mesh.lods.size()));
+			for (const MeshLod& lod : mesh.lods)
+			{
+				writeValue(file, lod.firstIndex);
+				writeValue(file, lod.indexCount);
+				writeValue(file, lod.error);
+			}
+			file.write(reinterpret_cast<const char*>(mesh.vertices.data()), static_cast<std::streamsize>(sizeof(MeshVertex) * mesh.vertices.size()));
+			file.write(reinterpret_cast<const char*>(mesh.indices.data()), static_cast<std::streamsize>(sizeof(uint32_t) * mesh.indices.size()));
+			if (!file)
+			{
+				return;
+			}
+		}
+
+		std::error_code error;
+		std::filesystem::rename(temporaryPath, cachePath, error);
+	}
+
+	template <typename T>
+	static void readValue(std::ifstream& file, T& value) {
+		file.read(reinterpret_cast<char*>(&value), sizeof(T));
+	}
+
+	template <typename T>
+	static void writeValue(std::ofstream& file, const T& value) {
+		file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+	#pragma endregion CACHE
+};
@@ -0,0 +1,409 @@
+#pragma once
+#pragma region --- INCLUDES ---
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <unordered_map>
+#include <vector>
+#pragma endregion INCLUDES
+
+// reduces the triangle count of an indexed mesh with quadric error metrics (Garland and Heckbert)
+// edges collapse onto one of their existing vertices, so every level of detail only needs its own indices
+// and can share the vertex buffer of the full mesh.
+// vertices on open borders only move along the border, vertices that share their position with others
+// (UV seams, hard edges) never move, so the mesh doesn't tear apart
+class MeshSimplifier {
+public:
+	// positions are the first 3 floats of each vertex, stride in floats
+	// returns the new indices, error gets the largest distance a collapse moved the surface by, in mesh units
+	static std::vector<uint32_t> simplify(const float* positions, size_t stride, size_t vertexCount,
+		const std::vector<uint32_t>& indices, size_t targetIndexCount, float& error) {
+		MeshSimplifier simplifier(positions, stride, vertexCount, indices);
+		return simplifier.run(targetIndexCount, error);
+	}
+
+private:
+	// symmetric 4x4 matrix of a plane, or the sum of several, weighted by triangle area
+	struct Quadric {
+		double a2 = 0, b2 = 0, c2 = 0, ab = 0, ac = 0, bc = 0, ad = 0, bd = 0, cd = 0, d2 = 0;
+		double weight = 0;
+
+		static Quadric plane(double a, double b, double c, double d, double weight) {
+			Quadric q;
+			q.a2 = a * a * weight; q.b2 = b * b * weight; q.c2 = c * c * weight;
+			q.ab = a * b * weight; q.ac = a * c * weight; q.bc = b * c * weight;
+			q.ad = a * d * weight; q.bd = b * d * weight; q.cd = c * d * weight;
+			q.d2 = d * d * weight;
+			q.weight = weight;
+			return q;
+		}
+
+		void add(const Quadric& other) {
+			a2 += other.a2; b2 += other.b2; c2 += other.c2;
+			ab += other.ab; ac += other.ac; bc += other.bc;
+			ad += other.ad; bd += other.bd; cd += other.cd;
+			d2 += other.d2;
+			weight += other.weight;
+		}
+
+		// weighted mean of the squared distances to the planes
+		double error(const float* p) const {
+			double x = p[0], y = p[1], z = p[2];
+			double sum = a2 * x * x + b2 * y * y + c2 * z * z
+				+ 2 * (ab * x * y + ac * x * z + bc * y * z)
+				+ 2 * (ad * x + bd * y + cd * z)
+				+ d2;
+			return weight > 0 ? std::fabs(sum) / weight : 0.0;
+		}
+	};
+
+	enum class VertexKind : uint8_t {
+		MANIFOLD,
+		BORDER,
+		LOCKED
+	};
+
+	struct Collapse {
+		uint32_t from;
+		uint32_t to;
+		double cost;
+	};
+
+	const float* positions;
+	size_t stride;
+	size_t vertexCount;
+	std::vector<uint32_t> indices;
+	std::vector<Quadric> quadrics;
+	std::vector<VertexKind> kinds;
+
+	MeshSimplifier(const float* positions, size_t stride, size_t vertexCount, const std::vector<uint32_t>& indices)
+		: positions(positions), stride(stride), vertexCount(vertexCount), indices(indices) {}
+
+	const float* position(uint32_t vertex) const {
+		return positions + vertex * stride;
+	}
+
+	static uint64_t edgeKey(uint32_t a, uint32_t b) {
+		return a < b ? (static_cast<uint64_t>(a) << 32) | b : (static_cast<uint64_t>(b) << 32) | a;
+	}
+
+	static void triangleNormal(const float* a, const float* b, const float* c, double normal[3]) {
+		double e1[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+		double e2[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+		normal[0] = e1[1] * e2[2] - e1[2] * e2[1];
+		normal[1] = e1[2] * e2[0] - e1[0] * e2[2];
+		normal[2] = e1[0] * e2[1] - e1[1] * e2[0];
+	}
+
+	std::vector<uint32_t> run(size_t targetIndexCount, float& error) {
+		classifyVertices();
+		buildQuadrics();
+
+		double maxError = 0.0;
+		while (indices.size() > targetIndexCount)
+		{
+			size_t collapsed = collapsePass((indices.size() - targetIndexCount) / 3, maxError);
+			if (collapsed == 0)
+			{
+				break;
+			}
+		}
+
+		error = static_cast<float>(std::sqrt(maxError));
+		return indices;
+	}
+
+	#pragma region --- SETUP ---
+	void classifyVertices() {
+		kinds.assign(vertexCount, VertexKind::MANIFOLD);
+
+		// open edges are used by a single triangle
+		std::unordered_map<uint64_t, uint32_t> edgeUses;
+		edgeUses.reserve(indices.size());
+		for (size_t i = 0; i < indices.size(); i += 3)
+		{
+			for (size_t corner = 0; corner < 3; corner++)
+			{
+				edgeUses[edgeKey(indices[i + corner], indices[i + (corner + 1) % 3])]++;
+			}
+		}
+		for (const auto& edge : edgeUses)
+		{
+			if (edge.second == 1)
+			{
+				kinds[static_cast<uint32_t>(edge.first >> 32)] = VertexKind::BORDER;
+				kinds[static_cast<uint32_t>(edge.first)] = VertexKind::BORDER;
+			}
+		}
+
+		// vertices that only differ in their other attributes end up next to each other when sorted by position
+		std::vector<uint32_t> byPosition(vertexCount);
+		std::iota(byPosition.begin(), byPosition.end(), 0u);
+		std::sort(byPosition.begin(), byPosition.end(), [this](uint32_t a, uint32_t b) {
+			return std::lexicographical_compare(position(a), position(a) + 3, position(b), position(b) + 3);
+		});
+		for (size_t i = 1; i < byPosition.size(); i++)
+		{
+			if (std::equal(position(byPosition[i - 1]), position(byPosition[i - 1]) + 3, position(byPosition[i])))
+			{
+				kinds[byPosition[i - 1]] = VertexKind::LOCKED;
+				kinds[byPosition[i]] = VertexKind::LOCKED;
+			}
+		}
+	}
+
+	void buildQuadrics() {
+		quadrics.assign(vertexCount, Quadric{});
+
+		std::unordered_map<uint64_t, uint32_t> edgeUses;
+		edgeUses.reserve(indices.size());
+		for (size_t i = 0; i < indices.size(); i += 3)
+		{
+			for (size_t corner = 0; corner < 3; corner++)
+			{
+				edgeUses[edgeKey(indices[i + corner], indices[i + (corner + 1) % 3])]++;
+			}
+		}
+
+		for (size_t i = 0; i < indices.size(); i += 3)
+		{
+			const float* p0 = position(indices[i]);
+			const float* p1 = position(indices[i + 1]);
+			const float* p2 = position(indices[i + 2]);
+
+			double normal[3];
+			triangleNormal(p0, p1, p2, normal);
+			double length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+			if (length <= 0.0)
+			{
+				continue;
+			}
+			for (double& component : normal)
+			{
+				component /= length;
+			}
+
+			// length is twice the area
+			double area = length * 0.5;
+			double d = -(normal[0] * p0[0] + normal[1] * p0[1] + normal[2] * p0[2]);
+			Quadric q = Quadric::plane(normal[0], normal[1], normal[2], d, area);
+			for (size_t corner = 0; corner < 3; corner++)
+			{
+				quadrics[indices[i + corner]].add(q);
+			}
+
+			// open edges get a plane perpendicular to the triangle, so collapses along the border keep its shape
+			for (size_t corner = 0; corner < 3; corner++)
+			{
+				uint32_t a = indices[i + corner];
+				uint32_t b = indices[i + (corner + 1) % 3];
+				if (edgeUses[edgeKey(a, b)] != 1)
+				{
+					continue;
+				}
+
+				const float* pa = position(a);
+				const float* pb = position(b);
+				double edge[3] = { pb[0] - pa[0], pb[1] - pa[1], pb[2] - pa[2] };
+				double borderNormal[3] = {
+					edge[1] * normal[2] - edge[2] * normal[1],
+					edge[2] * normal[0] - edge[0] * normal[2],
+					edge[0] * normal[1] - edge[1] * normal[0]
+				};
+				double borderLength = std::sqrt(borderNormal[0] * borderNormal[0] + borderNormal[1] * borderNormal[1] + borderNormal[2] * borderNormal[2]);
+				if (borderLength <= 0.0)
+				{
+					continue;
+				}
+				for (double& component : borderNormal)
+				{
+					component /= borderLength;
+				}
+
+				double borderD = -(borderNormal[0] * pa[0] + borderNormal[1] * pa[1] + borderNormal[2] * pa[2]);
+				// weighted like a triangle as large as the edge is long
+				Quadric border = Quadric::plane(borderNormal[0], borderNormal[1], borderNormal[2], borderD, borderLength * borderLength);
+				quadrics[a].add(border);
+				quadrics[b].add(border);
+			}
+		}
+	}
+	#pragma endregion SETUP
+
+	#pragma region --- COLLAPSE ---
+	// collapses the cheapest edges that don't touch each other, until about maxRemovedTriangles are gone
+	// returns how many collapsed, 0 once nothing can collapse anymore
+	size_t collapsePass(size_t maxRemovedTriangles, double& maxError) {
+		#pragma region --- ADJACENCY ---
+		std::vector<uint32_t> offsets(vertexCount + 1, 0);
+		for (uint32_t index : indices)
+		{
+			offsets[index + 1]++;
+		}
+		for (size_t vertex = 0; vertex < vertexCount; vertex++)
+		{
+			offsets[vertex + 1] += offsets[vertex];
+		}
+		std::vector<uint32_t> vertexTriangles(indices.size());
+		std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+		for (size_t i = 0; i < indices.size(); i++)
+		{
+			vertexTriangles[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+		}
+
+		std::unordered_map<uint64_t, uint32_t> edgeUses;
+		edgeUses.reserve(indices.size());
+		for (size_t i = 0; i < indices.size(); i += 3)
+		{
+			for (size_t corner = 0; corner < 3; corner++)
+			{
+				edgeUses[edgeKey(indices[i + corner], indices[i + (corner + 1) % 3])]++;
+			}
+		}
+		#pragma endregion ADJACENCY
+
+		#pragma region --- CANDIDATES ---
+		// the cheaper direction of every edge that can collapse at all
+		std::vector<Collapse> collapses;
+		collapses.reserve(edgeUses.size());
+		for (const auto& edge : edgeUses)
+		{
+			uint32_t a = static_cast<uint32_t>(edge.first >> 32);
+			uint32_t b = static_cast<uint32_t>(edge.first);
+			bool borderEdge = edge.second == 1;
+
+			Collapse best{ 0, 0, -1.0 };
+			for (const auto& direction : { std::make_pair(a, b), std::make_pair(b, a) })
+			{
+				if (!canCollapse(direction.first, direction.second, borderEdge))
+				{
+					continue;
+				}
+				double cost = quadrics[direction.first].error(position(direction.second));
+				if (best.cost < 0.0 || cost < best.cost)
+				{
+					best = { direction.first, direction.second, cost };
+				}
+			}
+
+			if (best.cost >= 0.0)
+			{
+				collapses.push_back(best);
+			}
+		}
+
+		std::sort(collapses.begin(), collapses.end(), [](const Collapse& x, const Collapse& y) { return x.cost < y.cost; });
+		#pragma endregion CANDIDATES
+
+		#pragma region --- APPLY ---
+		std::vector<uint32_t> remap(vertexCount);
+		for (uint32_t vertex = 0; vertex < vertexCount; vertex++)
+		{
+			remap[vertex] = vertex;
+		}
+		// vertices whose triangles already changed this pass, their flip checks would be out of date
+		std::vector<bool> touched(vertexCount, false);
+
+		// an interior collapse removes 2 triangles, a border one 1
+		size_t removedTriangles = 0;
+		size_t collapsed = 0;
+		for (const Collapse& collapse : collapses)
+		{
+			if (removedTriangles >= maxRemovedTriangles)
+			{
+				break;
+			}
+			if (touched[collapse.from] || touched[collapse.to] || flips(collapse.from, collapse.to, offsets, vertexTriangles))
+			{
+				continue;
+			}
+
+			remap[collapse.from] = collapse.to;
+			quadrics[collapse.to].add(quadrics[collapse.from]);
+			maxError = std::max(maxError, collapse.cost);
+
+			// everything around the removed vertex changes shape
+			for (uint32_t i = offsets[collapse.from]; i < offsets[collapse.from + 1]; i++)
+			{
+				uint32_t triangle = vertexTriangles[i];
+				for (size_t corner = 0; corner < 3; corner++)
+				{
+					touched[indices[triangle * 3 + corner]] = true;
+				}
+			}
+
+			removedTriangles += edgeUses[edgeKey(collapse.from, collapse.to)];
+			collapsed++;
+		}
+		#pragma endregion APPLY
+
+		#pragma region --- REBUILD ---
+		std::vector<uint32_t> rebuilt;
+		rebuilt.reserve(indices.size());
+		for (size_t i = 0; i < indices.size(); i += 3)
+		{
+			uint32_t a = remap[indices[i]];
+			uint32_t b = remap[indices[i + 1]];
+			uint32_t c = remap[indices[i + 2]];
+			if (a != b && b != c && a != c)
+			{
+				rebuilt.push_back(a);
+				rebuilt.push_back(b);
+				rebuilt.push_back(c);
+			}
+		}
+		indices.swap(rebuilt);
+		#pragma endregion REBUILD
+
+		return collapsed;
+	}
+
+	bool canCollapse(uint32_t from, uint32_t to, bool borderEdge) const {
+		switch (kinds[from])
+		{
+		case VertexKind::MANIFOLD:
+			return true;
+		case VertexKind::BORDER:
+			// sliding along the border keeps the outline
+			return borderEdge && kinds[to] != VertexKind::MANIFOLD;
+		default:
+			return false;
+		}
+	}
+
+	// whether moving from onto to turns any of the triangles around from inside out
+	bool flips(uint32_t from, uint32_t to, const std::vector<uint32_t>& offsets, const std::vector<uint32_t>& vertexTriangles) const {
+		const float* target = position(to);
+
+		for (uint32_t i = offsets[from]; i < offsets[from + 1]; i++)
+		{
+			const uint32_t* triangle = &indices[vertexTriangles[i] * 3];
+			if (triangle[0] == to || triangle[1] == to || triangle[2] == to)
+			{
+				// collapses into a line and gets removed
+				continue;
+			}
+
+			const float* corners[3];
+			const float* moved[3];
+			for (size_t corner = 0; corner < 3; corner++)
+			{
+				corners[corner] = position(triangle[corner]);
+				moved[corner] = triangle[corner] == from ? target : corners[corner];
+			}
+
+			double before[3];
+			double after[3];
+			triangleNormal(corners[0], corners[1], corners[2], before);
+			triangleNormal(moved[0], moved[1], moved[2], after);
+			if (before[0] * after[0] + before[1] * after[1] + before[2] * after[2] <= 0.0)
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+	#pragma endregion COLLAPSE
+};
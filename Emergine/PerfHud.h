@@ -0,0 +1,247 @@
+#pragma once
+#pragma region --- INCLUDES ---
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+#pragma endregion INCLUDES
+
+// one quad of the HUD, every quad is an instance of the same six vertices
+// position and size in swap chain pixels, texture coordinates in the glyph atlas
+struct HudInstance {
+	float x, y;
+	float width, height;
+	float u0, v0;
+	float u1, v1;
+	// RGBA8, tints the atlas
+	uint32_t color;
+};
+
+// lays out a performance overlay as quads on a baked glyph atlas, so all of it ends up in a single instanced draw
+// the atlas is a 5x7 pixel font laid out in ASCII order, lower case letters get drawn as upper case ones.
+// its last cell is solid, the backgrounds and graph bars are made of that one.
+// frame times are kept for the last HISTORY frames, the graph shows all of them and the text their recent average
+class PerfHud {
+public:
+	static constexpr uint32_t GLYPH_WIDTH = 5;
+	static constexpr uint32_t GLYPH_HEIGHT = 7;
+	// a texel of space between the glyphs in the atlas, and between the characters on screen
+	static constexpr uint32_t CELL_WIDTH = GLYPH_WIDTH + 1;
+	static constexpr uint32_t CELL_HEIGHT = GLYPH_HEIGHT + 1;
+	static constexpr uint32_t ATLAS_COLUMNS = 16;
+	// printable ASCII, 32 to 126, with the solid cell in place of 127
+	static constexpr uint32_t ATLAS_ROWS = 6;
+	static constexpr uint32_t ATLAS_WIDTH = ATLAS_COLUMNS * CELL_WIDTH;
+	static constexpr uint32_t ATLAS_HEIGHT = ATLAS_ROWS * CELL_HEIGHT;
+	static constexpr uint32_t HISTORY = 120;
+
+	struct FrameSample {
+		float frameMs = 0.0f;
+		float cpuMs = 0.0f;
+		// 0 when no timestamps were available
+		float gpuMs = 0.0f;
+	};
+
+	// RGBA8, white with the coverage in alpha, ATLAS_WIDTH by ATLAS_HEIGHT
+	static std::vector<uint32_t> bakeAtlas() {
+		std::vector<uint32_t> pixels(ATLAS_WIDTH * ATLAS_HEIGHT, 0x00FFFFFF);
+
+		for (const Glyph& glyph : FONT)
+		{
+			uint32_t cell = static_cast<uint32_t>(glyph.character) - 32;
+			uint32_t left = (cell % ATLAS_COLUMNS) * CELL_WIDTH;
+			uint32_t top = (cell / ATLAS_COLUMNS) * CELL_HEIGHT;
+			for (uint32_t y = 0; y < GLYPH_HEIGHT; y++)
+			{
+				for (uint32_t x = 0; x < GLYPH_WIDTH; x++)
+				{
+					// most significant of the five bits is the leftmost texel
+					if (glyph.rows[y] & (1 << (GLYPH_WIDTH - 1 - x)))
+					{
+						pixels[(top + y) * ATLAS_WIDTH + left + x] = 0xFFFFFFFF;
+					}
+				}
+			}
+		}
+
+		uint32_t left = (SOLID_CELL % ATLAS_COLUMNS) * CELL_WIDTH;
+		uint32_t top = (SOLID_CELL / ATLAS_COLUMNS) * CELL_HEIGHT;
+		for (uint32_t y = 0; y < CELL_HEIGHT; y++)
+		{
+			for (uint32_t x = 0; x < CELL_WIDTH; x++)
+			{
+				pixels[(top + y) * ATLAS_WIDTH + left + x] = 0xFFFFFFFF;
+			}
+		}
+
+		return pixels;
+	}
+
+	void addFrame(float frameMs, float cpuMs, float gpuMs) {
+		history[nextSample] = { frameMs, cpuMs, gpuMs };
+		nextSample = (nextSample + 1) % HISTORY;
+		sampleCount = std::min(sampleCount + 1, HISTORY);
+	}
+
+	// of the last count frames, gpuMs only of the ones that had it
+	FrameSample average(uint32_t count) const {
+		count = std::min(count, sampleCount);
+		FrameSample sum{};
+		uint32_t gpuCount = 0;
+		for (uint32_t i = 0; i < count; i++)
+		{
+			const FrameSample& sample = history[(nextSample + HISTORY - 1 - i) % HISTORY];
+			sum.frameMs += sample.frameMs;
+			sum.cpuMs += sample.cpuMs;
+			if (sample.gpuMs > 0.0f)
+			{
+				sum.gpuMs += sample.gpuMs;
+				gpuCount++;
+			}
+		}
+
+		if (count > 0)
+		{
+			sum.frameMs /= count;
+			sum.cpuMs /= count;
+		}
+		if (gpuCount > 0)
+		{
+			sum.gpuMs /= gpuCount;
+		}
+		return sum;
+	}
+
+	void clear() {
+		instances.clear();
+	}
+
+	// screen pixels per atlas texel
+	void setScale(float scale) {
+		this->scale = scale;
+	}
+
+	float lineHeight() const {
+		return CELL_HEIGHT * scale;
+	}
+
+	void rect(float x, float y, float width, float height, uint32_t color) {
+		float u = ((SOLID_CELL % ATLAS_COLUMNS) * CELL_WIDTH + CELL_WIDTH * 0.5f) / ATLAS_WIDTH;
+		float v = ((SOLID_CELL / ATLAS_COLUMNS) * CELL_HEIGHT + CELL_HEIGHT * 0.5f) / ATLAS_HEIGHT;
+		instances.push_back({ x, y, width, height, u, v, u, v, color });
+	}
+
+	// returns where the next character would go
+	float text(float x, float y, const char* line, uint32_t color) {
+		for (const char* character = line; *character != '\0'; character++)
+		{
+			char upper = (*character >= 'a' && *character <= 'z') ? static_cast<char>(*character - 'a' + 'A') : *character;
+			if (upper > ' ' && upper < 127)
+			{
+				uint32_t cell = static_cast<uint32_t>(upper) - 32;
+				float u0 = static_cast<float>((cell % ATLAS_COLUMNS) * CELL_WIDTH) / ATLAS_WIDTH;
+				float v0 = static_cast<float>((cell / ATLAS_COLUMNS) * CELL_HEIGHT) / ATLAS_HEIGHT;
+				instances.push_back({ x, y, GLYPH_WIDTH * scale, GLYPH_HEIGHT * scale,
+					u0, v0, u0 + static_cast<float>(GLYPH_WIDTH) / ATLAS_WIDTH, v0 + static_cast<float>(GLYPH_HEIGHT) / ATLAS_HEIGHT, color });
+			}
+			x += CELL_WIDTH * scale;
+		}
+		return x;
+	}
+
+	// a bar per frame, oldest on the left, scaled so twice the target frame time fills the height
+	// the frame time in the back, CPU time on the left half of it and GPU time on the right half, a line at the target
+	void graph(float x, float y, float width, float height, float targetMs, uint32_t frameColor, uint32_t cpuColor, uint32_t gpuColor) {
+		float barWidth = width / HISTORY;
+		float msToPixels = height / (targetMs * 2.0f);
+		float bottom = y + height;
+
+		for (uint32_t i = 0; i < sampleCount; i++)
+		{
+			const FrameSample& sample = history[(nextSample + HISTORY - sampleCount + i) % HISTORY];
+			float barX = x + (HISTORY - sampleCount + i) * barWidth;
+
+			float frameHeight = std::min(sample.frameMs * msToPixels, height);
+			rect(barX, bottom - frameHeight, barWidth, frameHeight, frameColor);
+
+			float cpuHeight = std::min(sample.cpuMs * msToPixels, height);
+			rect(barX, bottom - cpuHeight, barWidth * 0.5f, cpuHeight, cpuColor);
+
+			float gpuHeight = std::min(sample.gpuMs * msToPixels, height);
+			rect(barX + barWidth * 0.5f, bottom - gpuHeight, barWidth * 0.5f, gpuHeight, gpuColor);
+		}
+
+		rect(x, bottom - targetMs * msToPixels, width, std::max(scale * 0.5f, 1.0f), 0xFFFFFFFF);
+	}
+
+	const std::vector<HudInstance>& getInstances() const {
+		return instances;
+	}
+
+private:
+	struct Glyph {
+		char character;
+		std::array<uint8_t, GLYPH_HEIGHT> rows;
+	};
+
+	static constexpr uint32_t SOLID_CELL = 127 - 32;
+
+	// only what the HUD needs, everything else stays blank
+	static constexpr std::array<Glyph, 49> FONT = { {
+		{ '0', { 0b01110, 0b10001, 0b10011, 0b10101, 0b11001, 0b10001, 0b01110 } },
+		{ '1', { 0b00100, 0b01100, 0b00100, 0b00100, 0b00100, 0b00100, 0b01110 } },
+		{ '2', { 0b01110, 0b10001, 0b00001, 0b00010, 0b00100, 0b01000, 0b11111 } },
+		{ '3', { 0b11111, 0b00010, 0b00100, 0b00010, 0b00001, 0b10001, 0b01110 } },
+		{ '4', { 0b00010, 0b00110, 0b01010, 0b10010, 0b11111, 0b00010, 0b00010 } },
+		{ '5', { 0b11111, 0b10000, 0b11110, 0b00001, 0b00001, 0b10001, 0b01110 } },
+		{ '6', { 0b00110, 0b01000, 0b10000, 0b11110, 0b10001, 0b10001, 0b01110 } },
+		{ '7', { 0b11111, 0b00001, 0b00010, 0b00100, 0b01000, 0b01000, 0b01000 } },
+		{ '8', { 0b01110, 0b10001, 0b10001, 0b01110, 0b10001, 0b10001, 0b01110 } },
+		{ '9', { 0b01110, 0b10001, 0b10001, 0b01111, 0b00001, 0b00010, 0b01100 } },
+		{ 'A', { 0b01110, 0b10001, 0b10001, 0b10001, 0b11111, 0b10001, 0b10001 } },
+		{ 'B', { 0b11110, 0b10001, 0b10001, 0b11110, 0b10001, 0b10001, 0b11110 } },
+		{ 'C', { 0b01110, 0b10001, 0b10000, 0b10000, 0b10000, 0b10001, 0b01110 } },
+		{ 'D', { 0b11100, 0b10010, 0b10001, 0b10001, 0b10001, 0b10010, 0b11100 } },
+		{ 'E', { 0b11111, 0b10000, 0b10000, 0b11110, 0b10000, 0b10000, 0b11111 } },
+		{ 'F', { 0b11111, 0b10000, 0b10000, 0b11110, 0b10000, 0b10000, 0b10000 } },
+		{ 'G', { 0b01110, 0b10001, 0b10000, 0b10111, 0b10001, 0b10001, 0b01111 } },
+		{ 'H', { 0b10001, 0b10001, 0b10001, 0b11111, 0b10001, 0b10001, 0b10001 } },
+		{ 'I', { 0b01110, 0b00100, 0b00100, 0b00100, 0b00100, 0b00100, 0b01110 } },
+		{ 'J', { 0b00111, 0b00010, 0b00010, 0b00010, 0b00010, 0b10010, 0b01100 } },
+		{ 'K', { 0b10001, 0b10010, 0b10100, 0b11000, 0b10100, 0b10010, 0b10001 } },
+		{ 'L', { 0b10000, 0b10000, 0b10000, 0b10000, 0b10000, 0b10000, 0b11111 } },
+		{ 'M', { 0b10001, 0b11011, 0b10101, 0b10101, 0b10001, 0b10001, 0b10001 } },
+		{ 'N', { 0b10001, 0b10001, 0b11001, 0b10101, 0b10011, 0b10001, 0b10001 } },
+		{ 'O', { 0b01110, 0b10001, 0b10001, 0b10001, 0b10001, 0b10001, 0b01110 } },
+		{ 'P', { 0b11110, 0b10001, 0b10001, 0b11110, 0b10000, 0b10000, 0b10000 } },
+		{ 'Q', { 0b01110, 0b10001, 0b10001, 0b10001, 0b10101, 0b10010, 0b01101 } },
+		{ 'R', { 0b11110, 0b10001, 0b10001, 0b11110, 0b10100, 0b10010, 0b10001 } },
+		{ 'S', { 0b01111, 0b10000, 0b10000, 0b01110, 0b00001, 0b00001, 0b11110 } },
+		{ 'T', { 0b11111, 0b00100, 0b00100, 0b00100, 0b00100, 0b00100, 0b00100 } },
+		{ 'U', { 0b10001, 0b10001, 0b10001, 0b10001, 0b10001, 0b10001, 0b01110 } },
+		{ 'V', { 0b10001, 0b10001, 0b10001, 0b10001, 0b10001, 0b01010, 0b00100 } },
+		{ 'W', { 0b10001, 0b10001, 0b10001, 0b10101, 0b10101, 0b10101, 0b01010 } },
+		{ 'X', { 0b10001, 0b10001, 0b01010, 0b00100, 0b01010, 0b10001, 0b10001 } },
+		{ 'Y', { 0b10001, 0b10001, 0b10001, 0b01010, 0b00100, 0b00100, 0b00100 } },
+		{ 'Z', { 0b11111, 0b00001, 0b00010, 0b00100, 0b01000, 0b10000, 0b11111 } },
+		{ '.', { 0b00000, 0b00000, 0b00000, 0b00000, 0b00000, 0b01100, 0b01100 } },
+		{ ',', { 0b00000, 0b00000, 0b00000, 0b00000, 0b01100, 0b00100, 0b01000 } },
+		{ ':', { 0b00000, 0b01100, 0b01100, 0b00000, 0b01100, 0b01100, 0b00000 } },
+		{ '/', { 0b00000, 0b00001, 0b00010, 0b00100, 0b01000, 0b10000, 0b00000 } },
+		{ '%', { 0b11000, 0b11001, 0b00010, 0b00100, 0b01000, 0b10011, 0b00011 } },
+		{ '(', { 0b00010, 0b00100, 0b01000, 0b01000, 0b01000, 0b00100, 0b00010 } },
+		{ ')', { 0b01000, 0b00100, 0b00010, 0b00010, 0b00010, 0b00100, 0b01000 } },
+		{ '-', { 0b00000, 0b00000, 0b00000, 0b11111, 0b00000, 0b00000, 0b00000 } },
+		{ '+', { 0b00000, 0b00100, 0b00100, 0b11111, 0b00100, 0b00100, 0b00000 } },
+		{ '=', { 0b00000, 0b00000, 0b11111, 0b00000, 0b11111, 0b00000, 0b00000 } },
+		{ '|', { 0b00100, 0b00100, 0b00100, 0b00100, 0b00100, 0b00100, 0b00100 } },
+		{ '<', { 0b00010, 0b00100, 0b01000, 0b10000, 0b01000, 0b00100, 0b00010 } },
+		{ '>', { 0b01000, 0b00100, 0b00010, 0b00001, 0b00010, 0b00100, 0b01000 } }
+	} };
+
+	std::array<FrameSample, HISTORY> history{};
+	uint32_t nextSample = 0;
+	uint32_t sampleCount = 0;
+	float scale = 2.0f;
+	std::vector<HudInstance> instances;
+};
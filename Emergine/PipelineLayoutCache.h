@@ -0,0 +1,211 @@
+#pragma once
+#pragma region --- INCLUDES ---
+#include <vulkan/vulkan.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "ShaderReflection.h"
+#pragma endregion INCLUDES
+
+// pipeline layouts made from what the shaders of a pipeline ask for, rather than written out by hand next to them.
+// every distinct set of bindings gets one descriptor set layout, and every distinct combination of set layouts and
+// push constants one pipeline layout, however many pipelines ask for it, so:
+//		descriptor sets allocated for one pipeline can be bound to any other pipeline with the same bindings in that set
+//		pipelines sharing a layout keep their bound sets and pushed constants when switching between them
+// bindings are visible to every stage the engine uses, which is what lets a compute and a graphics pipeline share a set
+// their shaders only use in one stage each. push constants only go to the stages that declare them,
+// those stages are what vkCmdPushConstants has to be called with.
+// safe to call from the shader hot reload thread, the layouts live until destroy()
+class PipelineLayoutCache {
+public:
+	static constexpr VkShaderStageFlags DESCRIPTOR_STAGES = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT;
+
+	struct Layout {
+		VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+		// one per set up to the highest the shaders use, sets in between without bindings get an empty layout
+		std::vector<VkDescriptorSetLayout> setLayouts;
+		VkShaderStageFlags pushConstantStages = 0;
+		uint32_t pushConstantSize = 0;
+	};
+
+	struct Stats {
+		// calls to get(), against the layouts they actually created
+		uint64_t requests = 0;
+		size_t setLayouts = 0;
+		size_t pipelineLayouts = 0;
+	};
+
+	void init(VkDevice device, const VkAllocationCallbacks* setLayoutAllocator, const VkAllocationCallbacks* pipelineLayoutAllocator) {
+		this->device = device;
+		this->setLayoutAllocator = setLayoutAllocator;
+		this->pipelineLayoutAllocator = pipelineLayoutAllocator;
+	}
+
+	// the layout for a pipeline made of these shaders, created the first time any pipeline asks for it
+	// the reference stays valid until destroy()
+	const Layout& get(const std::vector<ShaderReflection>& shaders) {
+		#pragma region --- MERGE STAGES ---
+		// every stage's bindings, sorted by set and binding, the same binding declared in two stages only once
+		std::vector<ShaderReflection::Binding> bindings;
+		VkShaderStageFlags pushConstantStages = 0;
+		uint32_t pushConstantSize = 0;
+		for (const ShaderReflection& shader : shaders)
+		{
+			for (const ShaderReflection::Binding& binding : shader.bindings)
+			{
+				auto existing = std::find_if(bindings.begin(), bindings.end(), [&](const ShaderReflection::Binding& b) {
+					return b.set == binding.set && b.binding == binding.binding;
+				});
+				if (existing == bindings.end())
+				{
+					bindings.push_back(binding);
+				}
+				else if (existing->type != binding.type || existing->count != binding.count)
+				{
+					throw std::runtime_error("shader stages disagree about set " + std::to_string(binding.set)
+						+ ", binding " + std::to_string(binding.binding));
+				}
+			}
+			if (shader.pushConstantSize > 0)
+			{
+				pushConstantStages |= shader.stage;
+				pushConstantSize = std::max(pushConstantSize, shader.pushConstantSize);
+			}
+		}
+		std::sort(bindings.begin(), bindings.end(), [](const ShaderReflection::Binding& a, const ShaderReflection::Binding& b) {
+			return a.set != b.set ? a.set < b.set : a.binding < b.binding;
+		});
+		#pragma endregion MERGE STAGES
+
+		std::lock_guard<std::mutex> lock(mutex);
+		stats.requests++;
+
+		#pragma region --- SET LAYOUTS ---
+		uint32_t setCount = bindings.empty() ? 0 : bindings.back().set + 1;
+		std::vector<SetKey> setKeys(setCount);
+		for (const ShaderReflection::Binding& binding : bindings)
+		{
+			setKeys[binding.set].emplace_back(binding.binding, binding.type, binding.count);
+		}
+		std::vector<VkDescriptorSetLayout> setLayouts(setCount);
+		for (uint32_t set = 0; set < setCount; set++)
+		{
+			setLayouts[set] = setLayout(std::move(setKeys[set]));
+		}
+		#pragma endregion SET LAYOUTS
+
+		#pragma region --- PIPELINE LAYOUT ---
+		PipelineKey key{ setLayouts, pushConstantStages, pushConstantSize };
+		auto cached = pipelineLayouts.find(key);
+		if (cached != pipelineLayouts.end())
+		{
+			return cached->second;
+		}
+
+		VkPushConstantRange pushConstantRange{};
+		pushConstantRange.stageFlags = pushConstantStages;
+		pushConstantRange.offset = 0;
+		pushConstantRange.size = pushConstantSize;
+
+		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineLayoutInfo.setLayoutCount = setCount;
+		pipelineLayoutInfo.pSetLayouts = setLayouts.data();
+		pipelineLayoutInfo.pushConstantRangeCount = pushConstantSize > 0 ? 1 : 0;
+		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+		Layout layout;
+		if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, pipelineLayoutAllocator, &layout.pipelineLayout) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create pipeline layout!");
+		}
+		layout.setLayouts = setLayouts;
+		layout.pushConstantStages = pushConstantStages;
+		layout.pushConstantSize = pushConstantSize;
+		stats.pipelineLayouts++;
+		return pipelineLayouts.emplace(key, layout).first->second;
+		#pragma endregion PIPELINE LAYOUT
+	}
+
+	Stats getStats() {
+		std::lock_guard<std::mutex> lock(mutex);
+		return stats;
+	}
+
+	void destroy() {
+		for (const auto& entry : pipelineLayouts)
+		{
+			vkDestroyPipelineLayout(device, entry.second.pipelineLayout, pipelineLayoutAllocator);
+		}
+		for (const auto& entry : setLayouts)
+		{
+			vkDestroyDescriptorSetLayout(device, entry.second, setLayoutAllocator);
+		}
+		pipelineLayouts.clear();
+		setLayouts.clear();
+	}
+
+private:
+	// binding, type and count of every binding of one set
+	using SetKey = std::vector<std::tuple<uint32_t, VkDescriptorType, uint32_t>>;
+
+	struct PipelineKey {
+		std::vector<VkDescriptorSetLayout> setLayouts;
+		VkShaderStageFlags pushConstantStages;
+		uint32_t pushConstantSize;
+
+		bool operator<(const PipelineKey& other) const {
+			return std::tie(setLayouts, pushConstantStages, pushConstantSize)
+				< std::tie(other.setLayouts, other.pushConstantStages, other.pushConstantSize);
+		}
+	};
+
+	// called with the mutex held
+	VkDescriptorSetLayout setLayout(SetKey key) {
+		auto cached = setLayouts.find(key);
+		if (cached != setLayouts.end())
+		{
+			return cached->second;
+		}
+
+		std::vector<VkDescriptorSetLayoutBinding> layoutBindings(key.size());
+		for (size_t i = 0; i < key.size(); i++)
+		{
+			layoutBindings[i].binding = std::get<0>(key[i]);
+			layoutBindings[i].descriptorType = std::get<1>(key[i]);
+			layoutBindings[i].descriptorCount = std::get<2>(key[i]);
+			layoutBindings[i].stageFlags = DESCRIPTOR_STAGES;
+			layoutBindings[i].pImmutableSamplers = nullptr;
+		}
+
+		VkDescriptorSetLayoutCreateInfo layoutInfo{};
+		layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		layoutInfo.bindingCount = static_cast<uint32_t>(layoutBindings.size());
+		layoutInfo.pBindings = layoutBindings.data();
+
+		VkDescriptorSetLayout layout;
+		if (vkCreateDescriptorSetLayout(device, &layoutInfo, setLayoutAllocator, &layout) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create descriptor set layout!");
+		}
+		stats.setLayouts++;
+		setLayouts.emplace(std::move(key), layout);
+		return layout;
+	}
+
+	VkDevice device = VK_NULL_HANDLE;
+	const VkAllocationCallbacks* setLayoutAllocator = nullptr;
+	const VkAllocationCallbacks* pipelineLayoutAllocator = nullptr;
+
+	std::mutex mutex;
+	std::map<SetKey, VkDescriptorSetLayout> setLayouts;
+	std::map<PipelineKey, Layout> pipelineLayouts;
+	Stats stats;
+};
@@ -0,0 +1,286 @@
+#pragma once
+#pragma region --- INCLUDES ---
+#include <vulkan/vulkan.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+#pragma endregion INCLUDES
+
+// what a block of device memory is used for, usage gets counted along these per heap
+enum class MemoryCategory : uint8_t {
+	TEXTURES,
+	MESHES,
+	// render targets, rebuilt with the swap chain
+	ATTACHMENTS,
+	// host visible buffers the CPU writes or reads every frame, and upload buffers
+	STAGING,
+	COUNT
+};
+
+// keeps track of how much of each memory heap the engine uses, against the budget the driver gives it.
+// with VK_EXT_memory_budget the budget and usage come from the driver and include whatever else lives on the heap,
+// without it the budget is a fixed share of the heap and only the allocations made through the manager count.
+// resources that can give memory back register two callbacks:
+//		evict frees the resource entirely, the engine recreates it the next time it's needed
+//		degrade drops its most detailed level, returns false once there's nothing left to drop
+// when an allocation would push a heap past PRESSURE of its budget, cold resources get evicted first,
+// least recently used first, and resources still in use get degraded after that, until it fits.
+// memory the callbacks hand to a deletion queue gets retired, so it stops counting before the driver actually frees it
+class ResidencyManager {
+public:
+	static constexpr size_t CATEGORY_COUNT = static_cast<size_t>(MemoryCategory::COUNT);
+	// share of the budget the heap gets filled to before resources have to make room
+	static constexpr double PRESSURE = 0.9;
+	// share of a heap assumed to be available without the extension
+	static constexpr double FALLBACK_BUDGET = 0.8;
+	// resources that haven't been used for this many frames count as cold
+	static constexpr uint64_t COLD_FRAMES = 120;
+
+	using ResourceId = uint32_t;
+
+	struct HeapStats {
+		VkDeviceSize size = 0;
+		VkDeviceSize budget = 0;
+		// the whole heap as far as the driver reported it, other processes included
+		VkDeviceSize usage = 0;
+		// only the allocations made through the manager
+		std::array<VkDeviceSize, CATEGORY_COUNT> categories{};
+		uint64_t evictions = 0;
+		uint64_t degradations = 0;
+		bool deviceLocal = false;
+	};
+
+	void init(const VkPhysicalDeviceMemoryProperties& properties) {
+		heaps.assign(properties.memoryHeapCount, Heap{});
+		for (uint32_t i = 0; i < properties.memoryHeapCount; i++)
+		{
+			heaps[i].stats.size = properties.memoryHeaps[i].size;
+			heaps[i].stats.budget = static_cast<VkDeviceSize>(properties.memoryHeaps[i].size * FALLBACK_BUDGET);
+			heaps[i].stats.deviceLocal = (properties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+		}
+
+		typeHeaps.resize(properties.memoryTypeCount);
+		for (uint32_t i = 0; i < properties.memoryTypeCount; i++)
+		{
+			typeHeaps[i] = properties.memoryTypes[i].heapIndex;
+		}
+	}
+
+	// whatever the driver reports beyond the tracked allocations belongs to someone else,
+	// and stays counted against the budget until the next update
+	void updateBudget(const VkPhysicalDeviceMemoryBudgetPropertiesEXT& budget) {
+		for (uint32_t i = 0; i < heaps.size(); i++)
+		{
+			Heap& heap = heaps[i];
+			heap.stats.budget = budget.heapBudget[i];
+			heap.external = budget.heapUsage[i] > heap.tracked ? budget.heapUsage[i] - heap.tracked : 0;
+		}
+	}
+
+	#pragma region --- ALLOCATIONS ---
+	void add(VkDeviceMemory memory, uint32_t memoryTypeIndex, VkDeviceSize size, MemoryCategory category) {
+		uint32_t heapIndex = typeHeaps[memoryTypeIndex];
+		allocations[memory] = { heapIndex, category, size, false };
+
+		Heap& heap = heaps[heapIndex];
+		heap.tracked += size;
+		heap.stats.categories[static_cast<size_t>(category)] += size;
+	}
+
+	// for memory about to be freed, null and untracked memory are ignored
+	void remove(VkDeviceMemory memory) {
+		auto allocation = allocations.find(memory);
+		if (allocation == allocations.end())
+		{
+			return;
+		}
+
+		Heap& heap = heaps[allocation->second.heap];
+		heap.tracked -= allocation->second.size;
+		heap.stats.categories[static_cast<size_t>(allocation->second.category)] -= allocation->second.size;
+		if (allocation->second.retired)
+		{
+			heap.retired -= allocation->second.size;
+		}
+		allocations.erase(allocation);
+	}
+
+	// for memory waiting in a deletion queue, it still counts as used but no longer against new allocations
+	void retire(VkDeviceMemory memory) {
+		auto allocation = allocations.find(memory);
+		if (allocation == allocations.end() || allocation->second.retired)
+		{
+			return;
+		}
+
+		allocation->second.retired = true;
+		heaps[allocation->second.heap].retired += allocation->second.size;
+	}
+	#pragma endregion ALLOCATIONS
+
+	#pragma region --- RESOURCES ---
+	// degrade can be empty for resources that only come in one size
+	ResourceId addResource(uint32_t memoryTypeIndex, MemoryCategory category, std::function<void()> evict, std::function<bool()> degrade = {}) {
+		resources.push_back({ typeHeaps[memoryTypeIndex], category, 0, UINT64_MAX, true, std::move(evict), std::move(degrade) });
+		return static_cast<ResourceId>(resources.size() - 1);
+	}
+
+	void touch(ResourceId id, uint64_t frame) {
+		resources[id].lastUsed = frame;
+	}
+
+	bool isResident(ResourceId id) const {
+		return resources[id].resident;
+	}
+
+	// after the engine recreated an evicted resource
+	void setResident(ResourceId id) {
+		resources[id].resident = true;
+	}
+	#pragma endregion RESOURCES
+
+	// gets size more bytes to fit under PRESSURE of the budget of the heap memoryTypeIndex lives on
+	// force evicts everything that wasn't used in this very frame, for when the driver already failed an allocation
+	// returns whether they fit now
+	bool makeRoom(uint32_t memoryTypeIndex, VkDeviceSize size, uint64_t frame, bool force = false) {
+		// the callbacks allocate the smaller versions of what they degrade through the same path
+		if (reclaiming)
+		{
+			return true;
+		}
+		return reclaim(typeHeaps[memoryTypeIndex], size, frame, force);
+	}
+
+	// brings every heap back under pressure, for when something outside the engine grew or the budget shrank
+	void trim(uint64_t frame) {
+		if (reclaiming)
+		{
+			return;
+		}
+		for (uint32_t i = 0; i < heaps.size(); i++)
+		{
+			reclaim(i, 0, frame, false);
+		}
+	}
+
+	uint32_t heapCount() const {
+		return static_cast<uint32_t>(heaps.size());
+	}
+
+	HeapStats heapStats(uint32_t heap) const {
+		HeapStats stats = heaps[heap].stats;
+		stats.usage = heaps[heap].tracked + heaps[heap].external;
+		return stats;
+	}
+
+private:
+	struct Heap {
+		HeapStats stats;
+		// allocations made through the manager, retired ones included
+		VkDeviceSize tracked = 0;
+		VkDeviceSize retired = 0;
+		// the rest of the usage the driver reported
+		VkDeviceSize external = 0;
+	};
+
+	struct Allocation {
+		uint32_t heap;
+		MemoryCategory category;
+		VkDeviceSize size;
+		bool retired;
+	};
+
+	struct Resource {
+		uint32_t heap;
+		MemoryCategory category;
+		uint64_t lastUsed;
+		// so a resource gets degraded at most once per frame, the previous version is still in flight
+		uint64_t lastDegraded;
+		bool resident;
+		std::function<void()> evict;
+		std::function<bool()> degrade;
+	};
+
+	std::vector<Heap> heaps;
+	// heap index of every memory type
+	std::vector<uint32_t> typeHeaps;
+	std::unordered_map<VkDeviceMemory, Allocation> allocations;
+	std::vector<Resource> resources;
+	// reused between calls
+	std::vector<ResourceId> candidates;
+	bool reclaiming = false;
+
+	bool fits(uint32_t heapIndex, VkDeviceSize size) const {
+		const Heap& heap = heaps[heapIndex];
+		VkDeviceSize usage = heap.tracked - heap.retired + heap.external;
+		return static_cast<double>(usage + size) <= heap.stats.budget * PRESSURE;
+	}
+
+	bool reclaim(uint32_t heapIndex, VkDeviceSize size, uint64_t frame, bool force) {
+		if (fits(heapIndex, size))
+		{
+			return true;
+		}
+
+		reclaiming = true;
+		Heap& heap = heaps[heapIndex];
+
+		// least recently used first
+		candidates.clear();
+		for (ResourceId id = 0; id < resources.size(); id++)
+		{
+			if (resources[id].heap == heapIndex && resources[id].resident)
+			{
+				candidates.push_back(id);
+			}
+		}
+		std::stable_sort(candidates.begin(), candidates.end(), [this](ResourceId a, ResourceId b) {
+			return resources[a].lastUsed < resources[b].lastUsed;
+		});
+
+		#pragma region --- EVICT ---
+		for (ResourceId id : candidates)
+		{
+			Resource& resource = resources[id];
+			// sorted, so everything after this one is even warmer
+			bool cold = force ? resource.lastUsed < frame : resource.lastUsed + COLD_FRAMES <= frame;
+			if (fits(heapIndex, size) || !cold)
+			{
+				break;
+			}
+
+			resource.resident = false;
+			resource.evict();
+			heap.stats.evictions++;
+		}
+		#pragma endregion EVICT
+
+		#pragma region --- DEGRADE ---
+		for (ResourceId id : candidates)
+		{
+			Resource& resource = resources[id];
+			if (fits(heapIndex, size))
+			{
+				break;
+			}
+			if (!resource.resident || !resource.degrade || resource.lastDegraded == frame)
+			{
+				continue;
+			}
+
+			if (resource.degrade())
+			{
+				resource.lastDegraded = frame;
+				heap.stats.degradations++;
+			}
+		}
+		#pragma endregion DEGRADE
+
+		reclaiming = false;
+		return fits(heapIndex, size);
+	}
+};
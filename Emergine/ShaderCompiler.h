@@ -0,0 +1,186 @@
+#pragma once
+#pragma region --- INCLUDES ---
+#include <cerrno>
+#include <cstdlib>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif // NOMINMAX
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif // WIN32_LEAN_AND_MEAN
+// wingdi.h defines OPAQUE and TRANSPARENT, which the engine uses as names
+#ifndef NOGDI
+#define NOGDI
+#endif // NOGDI
+#include <windows.h>
+#else
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+#endif // _WIN32
+#pragma endregion INCLUDES
+
+// runs glslc, the same compiler compile.bat and the project build use.
+// it gets started directly with its arguments rather than through a shell,
+// so paths with spaces or shell characters in them need no quoting on the caller's side
+class ShaderCompiler {
+public:
+#ifdef _WIN32
+	static constexpr const char* GLSLC_NAME = "glslc.exe";
+	static constexpr const char* SDK_BIN_DIRECTORY = "Bin";
+	static constexpr char PATH_SEPARATOR = ';';
+#else
+	static constexpr const char* GLSLC_NAME = "glslc";
+	static constexpr const char* SDK_BIN_DIRECTORY = "bin";
+	static constexpr char PATH_SEPARATOR = ':';
+#endif // _WIN32
+
+	// the glslc of the Vulkan SDK VULKAN_SDK points at, otherwise the first one on the PATH
+	static std::optional<std::filesystem::path> findGlslc() {
+		std::error_code error;
+		if (std::optional<std::string> sdk = environmentVariable("VULKAN_SDK"))
+		{
+			std::filesystem::path candidate = std::filesystem::path(*sdk) / SDK_BIN_DIRECTORY / GLSLC_NAME;
+			if (std::filesystem::is_regular_file(candidate, error))
+			{
+				return candidate;
+			}
+		}
+
+		std::string searchPath = environmentVariable("PATH").value_or("");
+		size_t start = 0;
+		while (start <= searchPath.size())
+		{
+			size_t end = searchPath.find(PATH_SEPARATOR, start);
+			std::string directory = searchPath.substr(start, end == std::string::npos ? std::string::npos : end - start);
+			if (!directory.empty())
+			{
+				std::filesystem::path candidate = std::filesystem::path(directory) / GLSLC_NAME;
+				if (std::filesystem::is_regular_file(candidate, error))
+				{
+					return candidate;
+				}
+			}
+			if (end == std::string::npos)
+			{
+				break;
+			}
+			start = end + 1;
+		}
+		return std::nullopt;
+	}
+
+	// returns whether glslc exited successfully, its diagnostics go to the console like any other child process
+	static bool compile(const std::filesystem::path& glslc, const std::filesystem::path& source, const std::filesystem::path& output) {
+		return run(glslc, { source.string(), "-o", output.string() });
+	}
+
+private:
+	static std::optional<std::string> environmentVariable(const char* name) {
+#ifdef _WIN32
+		// getenv is deprecated with the SDL checks on
+		DWORD length = GetEnvironmentVariableA(name, nullptr, 0);
+		if (length == 0)
+		{
+			return std::nullopt;
+		}
+		std::string value(length, '\0');
+		length = GetEnvironmentVariableA(name, value.data(), length);
+		value.resize(length);
+		return value;
+#else
+		const char* value = std::getenv(name);
+		if (value == nullptr)
+		{
+			return std::nullopt;
+		}
+		return std::string(value);
+#endif // _WIN32
+	}
+
+#ifdef _WIN32
+	// CreateProcess takes a single command line, which the child splits up again by the rules of CommandLineToArgvW
+	static void appendQuoted(std::wstring& commandLine, const std::wstring& argument) {
+		commandLine += L'"';
+		size_t backslashes = 0;
+		for (wchar_t c : argument)
+		{
+			if (c == L'\\')
+			{
+				backslashes++;
+				continue;
+			}
+			// backslashes only escape when a quote follows them
+			commandLine.append(c == L'"' ? backslashes * 2 + 1 : backslashes, L'\\');
+			backslashes = 0;
+			commandLine += c;
+		}
+		// the closing quote follows, so trailing backslashes have to be doubled as well
+		commandLine.append(backslashes * 2, L'\\');
+		commandLine += L'"';
+	}
+
+	static bool run(const std::filesystem::path& program, const std::vector<std::string>& arguments) {
+		std::wstring commandLine;
+		appendQuoted(commandLine, program.wstring());
+		for (const std::string& argument : arguments)
+		{
+			commandLine += L' ';
+			appendQuoted(commandLine, std::filesystem::path(argument).wstring());
+		}
+
+		STARTUPINFOW startupInfo{};
+		startupInfo.cb = sizeof(startupInfo);
+		PROCESS_INFORMATION processInfo{};
+		// the command line buffer has to be writable
+		if (!CreateProcessW(program.wstring().c_str(), commandLine.data(), nullptr, nullptr, FALSE, 0, nullptr, nullptr, &startupInfo, &processInfo))
+		{
+			return false;
+		}
+
+		WaitForSingleObject(processInfo.hProcess, INFINITE);
+		DWORD exitCode = 1;
+		GetExitCodeProcess(processInfo.hProcess, &exitCode);
+		CloseHandle(processInfo.hThread);
+		CloseHandle(processInfo.hProcess);
+		return exitCode == 0;
+	}
+#else
+	static bool run(const std::filesystem::path& program, const std::vector<std::string>& arguments) {
+		std::string programPath = program.string();
+		std::vector<char*> argv;
+		argv.push_back(programPath.data());
+		// posix_spawn doesn't modify them, it only isn't declared const
+		std::vector<std::string> argumentCopies = arguments;
+		for (std::string& argument : argumentCopies)
+		{
+			argv.push_back(argument.data());
+		}
+		argv.push_back(nullptr);
+
+		pid_t pid;
+		if (posix_spawn(&pid, programPath.c_str(), nullptr, nullptr, argv.data(), environ) != 0)
+		{
+			return false;
+		}
+
+		int status = 0;
+		while (waitpid(pid, &status, 0) < 0)
+		{
+			if (errno != EINTR)
+			{
+				return false;
+			}
+		}
+		return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+	}
+#endif // _WIN32
+};
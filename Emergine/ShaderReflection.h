@@ -0,0 +1,513 @@
+#pragma once
+#pragma region --- INCLUDES ---
+#include <vulkan/vulkan.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#pragma endregion INCLUDES
+
+// what one SPIR-V shader expects from the pipeline around it, read straight from the module:
+//		descriptor bindings, from the variables decorated with DescriptorSet and Binding
+//		the size of its push constant block, from the Offset decorations of the block members
+//		vertex inputs, from the Location decorations of the inputs of a vertex shader
+// only the parts of SPIR-V glslang emits for the engine's shaders get looked at, everything else gets skipped.
+// throws std::runtime_error on modules it can't make sense of
+class ShaderReflection {
+public:
+	struct Binding {
+		uint32_t set;
+		uint32_t binding;
+		VkDescriptorType type;
+		// more than 1 for arrays of descriptors
+		uint32_t count;
+	};
+
+	// how the shader reads a vertex input, the format feeding it has to be of the same kind
+	enum class NumericType : uint8_t {
+		FLOAT,
+		SINT,
+		UINT
+	};
+
+	struct VertexInput {
+		uint32_t location;
+		NumericType type;
+		uint32_t components;
+	};
+
+	VkShaderStageFlagBits stage = VK_SHADER_STAGE_VERTEX_BIT;
+	// sorted by set and binding
+	std::vector<Binding> bindings;
+	// bytes from the start of the block to the end of its last member, 0 without a push constant block
+	uint32_t pushConstantSize = 0;
+	// sorted by location, only for vertex shaders
+	std::vector<VertexInput> vertexInputs;
+
+	static ShaderReflection reflect(const std::vector<char>& code) {
+		if (code.size() < HEADER_WORDS * sizeof(uint32_t) || code.size() % sizeof(uint32_t) != 0)
+		{
+			throw std::runtime_error("SPIR-V module is truncated");
+		}
+		// the code is only byte aligned
+		std::vector<uint32_t> words(code.size() / sizeof(uint32_t));
+		std::memcpy(words.data(), code.data(), code.size());
+		if (words[0] != MAGIC)
+		{
+			throw std::runtime_error("not a SPIR-V module");
+		}
+
+		// every id comes from an instruction of at least two words, glslang leaves few gaps between them.
+		// a bound far past that is a broken module, and resizing to it could ask for gigabytes
+		if (words[3] > words.size() * MAX_BOUND_PER_WORD)
+		{
+			throw std::runtime_error("SPIR-V module claims an id bound of " + std::to_string(words[3]) + " for " + std::to_string(words.size()) + " words");
+		}
+
+		Module module;
+		module.ids.resize(words[3]);
+		module.parse(words);
+
+		ShaderReflection reflection;
+		reflection.stage = module.stage;
+		for (uint32_t id = 0; id < module.ids.size(); id++)
+		{
+			const Id& variable = module.ids[id];
+			if (variable.opcode != OP_VARIABLE)
+			{
+				continue;
+			}
+
+			// the type of a variable is always a pointer, storage class and then what it points to
+			uint32_t storageClass = variable.operands.at(1);
+			uint32_t type = module.at(variable.operands[0]).operands.at(1);
+			switch (storageClass)
+			{
+			case STORAGE_UNIFORM_CONSTANT:
+			case STORAGE_UNIFORM:
+			case STORAGE_STORAGE_BUFFER:
+				reflection.bindings.push_back(module.descriptorBinding(id, storageClass, type));
+				break;
+			case STORAGE_PUSH_CONSTANT:
+				reflection.pushConstantSize = std::max(reflection.pushConstantSize, module.size(type));
+				break;
+			case STORAGE_INPUT:
+				if (module.stage == VK_SHADER_STAGE_VERTEX_BIT && !variable.builtIn)
+				{
+					module.addVertexInputs(variable.location, type, reflection.vertexInputs);
+				}
+				break;
+			}
+		}
+
+		std::sort(reflection.bindings.begin(), reflection.bindings.end(), [](const Binding& a, const Binding& b) {
+			return a.set != b.set ? a.set < b.set : a.binding < b.binding;
+		});
+		std::sort(reflection.vertexInputs.begin(), reflection.vertexInputs.end(), [](const VertexInput& a, const VertexInput& b) {
+			return a.location < b.location;
+		});
+		return reflection;
+	}
+
+	// every input the shader reads needs an attribute of the same numeric type, the component counts may differ
+	// attributes the shader doesn't read are allowed, they just go unused
+	void checkVertexAttributes(const std::vector<VkVertexInputAttributeDescription>& attributes) const {
+		for (const VertexInput& input : vertexInputs)
+		{
+			auto attribute = std::find_if(attributes.begin(), attributes.end(), [&](const VkVertexInputAttributeDescription& a) {
+				return a.location == input.location;
+			});
+			if (attribute == attributes.end())
+			{
+				throw std::runtime_error("vertex shader reads location " + std::to_string(input.location) + ", but no attribute feeds it");
+			}
+			if (numericType(attribute->format) != input.type)
+			{
+				throw std::runtime_error("vertex attribute at location " + std::to_string(input.location)
+					+ " has a different numeric type than the shader reads");
+			}
+		}
+	}
+
+	// float covers the normalized and scaled formats too, they get converted on the way in
+	static NumericType numericType(VkFormat format) {
+		switch (format)
+		{
+		case VK_FORMAT_R8_UINT:
+		case VK_FORMAT_R8G8_UINT:
+		case VK_FORMAT_R8G8B8A8_UINT:
+		case VK_FORMAT_A2B10G10R10_UINT_PACK32:
+		case VK_FORMAT_R16_UINT:
+		case VK_FORMAT_R16G16_UINT:
+		case VK_FORMAT_R16G16B16A16_UINT:
+		case VK_FORMAT_R32_UINT:
+		case VK_FORMAT_R32G32_UINT:
+		case VK_FORMAT_R32G32B32_UINT:
+		case VK_FORMAT_R32G32B32A32_UINT:
+			return NumericType::UINT;
+		case VK_FORMAT_R8_SINT:
+		case VK_FORMAT_R8G8_SINT:
+		case VK_FORMAT_R8G8B8A8_SINT:
+		case VK_FORMAT_R16_SINT:
+		case VK_FORMAT_R16G16_SINT:
+		case VK_FORMAT_R16G16B16A16_SINT:
+		case VK_FORMAT_R32_SINT:
+		case VK_FORMAT_R32G32_SINT:
+		case VK_FORMAT_R32G32B32_SINT:
+		case VK_FORMAT_R32G32B32A32_SINT:
+			return NumericType::SINT;
+		default:
+			return NumericType::FLOAT;
+		}
+	}
+
+private:
+	static constexpr uint32_t MAGIC = 0x07230203;
+	static constexpr size_t HEADER_WORDS = 5;
+	// ids the bound may reach per word of the module
+	static constexpr size_t MAX_BOUND_PER_WORD = 4;
+
+	// opcodes
+	static constexpr uint32_t OP_ENTRY_POINT = 15;
+	static constexpr uint32_t OP_TYPE_INT = 21;
+	static constexpr uint32_t OP_TYPE_FLOAT = 22;
+	static constexpr uint32_t OP_TYPE_VECTOR = 23;
+	static constexpr uint32_t OP_TYPE_MATRIX = 24;
+	static constexpr uint32_t OP_TYPE_IMAGE = 25;
+	static constexpr uint32_t OP_TYPE_SAMPLER = 26;
+	static constexpr uint32_t OP_TYPE_SAMPLED_IMAGE = 27;
+	static constexpr uint32_t OP_TYPE_ARRAY = 28;
+	static constexpr uint32_t OP_TYPE_RUNTIME_ARRAY = 29;
+	static constexpr uint32_t OP_TYPE_STRUCT = 30;
+	static constexpr uint32_t OP_TYPE_POINTER = 32;
+	static constexpr uint32_t OP_CONSTANT = 43;
+	static constexpr uint32_t OP_SPEC_CONSTANT = 50;
+	static constexpr uint32_t OP_VARIABLE = 59;
+	static constexpr uint32_t OP_DECORATE = 71;
+	static constexpr uint32_t OP_MEMBER_DECORATE = 72;
+
+	// decorations
+	static constexpr uint32_t DECORATION_BUFFER_BLOCK = 3;
+	static constexpr uint32_t DECORATION_ARRAY_STRIDE = 6;
+	static constexpr uint32_t DECORATION_MATRIX_STRIDE = 7;
+	static constexpr uint32_t DECORATION_BUILT_IN = 11;
+	static constexpr uint32_t DECORATION_LOCATION = 30;
+	static constexpr uint32_t DECORATION_BINDING = 33;
+	static constexpr uint32_t DECORATION_DESCRIPTOR_SET = 34;
+	static constexpr uint32_t DECORATION_OFFSET = 35;
+
+	// storage classes
+	static constexpr uint32_t STORAGE_UNIFORM_CONSTANT = 0;
+	static constexpr uint32_t STORAGE_INPUT = 1;
+	static constexpr uint32_t STORAGE_UNIFORM = 2;
+	static constexpr uint32_t STORAGE_PUSH_CONSTANT = 9;
+	static constexpr uint32_t STORAGE_STORAGE_BUFFER = 12;
+
+	// execution models
+	static constexpr uint32_t MODEL_VERTEX = 0;
+	static constexpr uint32_t MODEL_FRAGMENT = 4;
+	static constexpr uint32_t MODEL_GL_COMPUTE = 5;
+
+	// image dimensions and whether an image is sampled (1) or a storage image (2)
+	static constexpr uint32_t DIM_BUFFER = 5;
+	static constexpr uint32_t DIM_SUBPASS_DATA = 6;
+	static constexpr uint32_t IMAGE_STORAGE = 2;
+
+	// the instruction defining an id, with the result id left out of the operands, and what it got decorated with
+	struct Id {
+		uint32_t opcode = 0;
+		std::vector<uint32_t> operands;
+		uint32_t set = 0;
+		uint32_t binding = 0;
+		uint32_t location = 0;
+		uint32_t arrayStride = 0;
+		bool builtIn = false;
+		bool bufferBlock = false;
+		// per member of a struct, the stride is only there for matrices
+		std::vector<uint32_t> memberOffsets;
+		std::vector<uint32_t> memberMatrixStrides;
+	};
+
+	struct Module {
+		std::vector<Id> ids;
+		VkShaderStageFlagBits stage = VK_SHADER_STAGE_VERTEX_BIT;
+		bool hasEntryPoint = false;
+
+		const Id& at(uint32_t id) const {
+			if (id >= ids.size())
+			{
+				throw std::runtime_error("SPIR-V id out of bounds");
+			}
+			return ids[id];
+		}
+
+		Id& decorated(uint32_t id) {
+			if (id >= ids.size())
+			{
+				throw std::runtime_error("SPIR-V id out of bounds");
+			}
+			return ids[id];
+		}
+
+		void parse(const std::vector<uint32_t>& words) {
+			size_t position = HEADER_WORDS;
+			while (position < words.size())
+			{
+				uint32_t opcode = words[position] & 0xFFFF;
+				uint32_t wordCount = words[position] >> 16;
+				if (wordCount == 0 || position + wordCount > words.size())
+				{
+					throw std::runtime_error("SPIR-V instruction runs past the end of the module");
+				}
+				const uint32_t* operands = &words[position + 1];
+				uint32_t operandCount = wordCount - 1;
+
+				switch (opcode)
+				{
+				case OP_ENTRY_POINT:
+					// only the first one counts, the engine's shaders have exactly one
+					if (!hasEntryPoint && operandCount > 0)
+					{
+						stage = stageOf(operands[0]);
+						hasEntryPoint = true;
+					}
+					break;
+				case OP_DECORATE:
+					if (operandCount >= 2)
+					{
+						decorate(decorated(operands[0]), operands[1], operandCount >= 3 ? operands[2] : 0);
+					}
+					break;
+				case OP_MEMBER_DECORATE:
+					if (operandCount >= 4 && operands[2] == DECORATION_OFFSET)
+					{
+						setMember(decorated(operands[0]).memberOffsets, operands[1], operands[3]);
+					}
+					else if (operandCount >= 4 && operands[2] == DECORATION_MATRIX_STRIDE)
+					{
+						setMember(decorated(operands[0]).memberMatrixStrides, operands[1], operands[3]);
+					}
+					break;
+				case OP_TYPE_INT:
+				case OP_TYPE_FLOAT:
+				case OP_TYPE_VECTOR:
+				case OP_TYPE_MATRIX:
+				case OP_TYPE_IMAGE:
+				case OP_TYPE_SAMPLER:
+				case OP_TYPE_SAMPLED_IMAGE:
+				case OP_TYPE_ARRAY:
+				case OP_TYPE_RUNTIME_ARRAY:
+				case OP_TYPE_STRUCT:
+				case OP_TYPE_POINTER:
+					if (operandCount >= 1)
+					{
+						define(opcode, operands[0], operands + 1, operandCount - 1);
+					}
+					break;
+				case OP_CONSTANT:
+				case OP_SPEC_CONSTANT:
+				case OP_VARIABLE:
+					// the result type comes first, then the result id
+					if (operandCount >= 2)
+					{
+						std::vector<uint32_t> rest(operands + 2, operands + operandCount);
+						rest.insert(rest.begin(), operands[0]);
+						define(opcode, operands[1], rest.data(), static_cast<uint32_t>(rest.size()));
+					}
+					break;
+				}
+				position += wordCount;
+			}
+
+			if (!hasEntryPoint)
+			{
+				throw std::runtime_error("SPIR-V module has no entry point");
+			}
+		}
+
+		static void setMember(std::vector<uint32_t>& members, uint32_t member, uint32_t value) {
+			members.resize(std::max<size_t>(members.size(), static_cast<size_t>(member) + 1), 0);
+			members[member] = value;
+		}
+
+		void define(uint32_t opcode, uint32_t id, const uint32_t* operands, uint32_t operandCount) {
+			Id& definition = decorated(id);
+			definition.opcode = opcode;
+			definition.operands.assign(operands, operands + operandCount);
+		}
+
+		static void decorate(Id& id, uint32_t decoration, uint32_t value) {
+			switch (decoration)
+			{
+			case DECORATION_BUFFER_BLOCK:
+				id.bufferBlock = true;
+				break;
+			case DECORATION_ARRAY_STRIDE:
+				id.arrayStride = value;
+				break;
+			case DECORATION_BUILT_IN:
+				id.builtIn = true;
+				break;
+			case DECORATION_LOCATION:
+				id.location = value;
+				break;
+			case DECORATION_BINDING:
+				id.binding = value;
+				break;
+			case DECORATION_DESCRIPTOR_SET:
+				id.set = value;
+				break;
+			}
+		}
+
+		static VkShaderStageFlagBits stageOf(uint32_t executionModel) {
+			switch (executionModel)
+			{
+			case MODEL_VERTEX:
+				return VK_SHADER_STAGE_VERTEX_BIT;
+			case MODEL_FRAGMENT:
+				return VK_SHADER_STAGE_FRAGMENT_BIT;
+			case MODEL_GL_COMPUTE:
+				return VK_SHADER_STAGE_COMPUTE_BIT;
+			default:
+				throw std::runtime_error("unsupported shader stage in SPIR-V module");
+			}
+		}
+
+		// the value of an array length, spec constants count with their default
+		uint32_t constant(uint32_t id) const {
+			const Id& definition = at(id);
+			if ((definition.opcode != OP_CONSTANT && definition.opcode != OP_SPEC_CONSTANT) || definition.operands.size() < 2)
+			{
+				throw std::runtime_error("SPIR-V array length isn't a constant");
+			}
+			return definition.operands[1];
+		}
+
+		Binding descriptorBinding(uint32_t variable, uint32_t storageClass, uint32_t type) const {
+			const Id& decorations = at(variable);
+			Binding binding{ decorations.set, decorations.binding, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1 };
+
+			// arrays of descriptors
+			const Id* element = &at(type);
+			while (element->opcode == OP_TYPE_ARRAY || element->opcode == OP_TYPE_RUNTIME_ARRAY)
+			{
+				if (element->opcode == OP_TYPE_RUNTIME_ARRAY)
+				{
+					throw std::runtime_error("unsized descriptor arrays aren't supported");
+				}
+				binding.count *= constant(element->operands[1]);
+				element = &at(element->operands[0]);
+			}
+
+			switch (element->opcode)
+			{
+			case OP_TYPE_SAMPLER:
+				binding.type = VK_DESCRIPTOR_TYPE_SAMPLER;
+				break;
+			case OP_TYPE_SAMPLED_IMAGE:
+				binding.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+				break;
+			case OP_TYPE_IMAGE:
+			{
+				// sampled type, dim, depth, arrayed, multisampled, sampled, format
+				uint32_t dim = element->operands.at(1);
+				bool storage = element->operands.at(5) == IMAGE_STORAGE;
+				if (dim == DIM_SUBPASS_DATA)
+				{
+					binding.type = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+				}
+				else if (dim == DIM_BUFFER)
+				{
+					binding.type = storage ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+				}
+				else
+				{
+					binding.type = storage ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+				}
+				break;
+			}
+			case OP_TYPE_STRUCT:
+				// older compilers mark storage buffers as BufferBlock in the Uniform storage class
+				binding.type = storageClass == STORAGE_STORAGE_BUFFER || element->bufferBlock
+					? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+				break;
+			default:
+				throw std::runtime_error("unsupported descriptor type in SPIR-V module");
+			}
+			return binding;
+		}
+
+		// in bytes, with the layout the Offset and stride decorations give it
+		uint32_t size(uint32_t type) const {
+			const Id& definition = at(type);
+			switch (definition.opcode)
+			{
+			case OP_TYPE_INT:
+			case OP_TYPE_FLOAT:
+				return definition.operands.at(0) / 8;
+			case OP_TYPE_VECTOR:
+				return size(definition.operands.at(0)) * definition.operands.at(1);
+			case OP_TYPE_MATRIX:
+				// tightly packed columns, struct members add their stride on top
+				return size(definition.operands.at(0)) * definition.operands.at(1);
+			case OP_TYPE_ARRAY:
+				return std::max(definition.arrayStride, size(definition.operands.at(0))) * constant(definition.operands.at(1));
+			case OP_TYPE_STRUCT:
+			{
+				uint32_t end = 0;
+				for (size_t member = 0; member < definition.operands.size(); member++)
+				{
+					uint32_t offset = member < definition.memberOffsets.size() ? definition.memberOffsets[member] : 0;
+					uint32_t memberSize = size(definition.operands[member]);
+					// a mat3 with a stride of 16 takes up more than three vec3s
+					const Id& memberType = at(definition.operands[member]);
+					if (memberType.opcode == OP_TYPE_MATRIX && member < definition.memberMatrixStrides.size())
+					{
+						memberSize = std::max(memberSize, definition.memberMatrixStrides[member] * memberType.operands.at(1));
+					}
+					end = std::max(end, offset + memberSize);
+				}
+				return end;
+			}
+			default:
+				throw std::runtime_error("unsupported type in SPIR-V push constant block");
+			}
+		}
+
+		// a matrix takes up one location per column
+		void addVertexInputs(uint32_t location, uint32_t type, std::vector<VertexInput>& inputs) const {
+			const Id& definition = at(type);
+			switch (definition.opcode)
+			{
+			case OP_TYPE_INT:
+			case OP_TYPE_FLOAT:
+				inputs.push_back({ location, numericTypeOf(definition), 1 });
+				break;
+			case OP_TYPE_VECTOR:
+				inputs.push_back({ location, numericTypeOf(at(definition.operands.at(0))), definition.operands.at(1) });
+				break;
+			case OP_TYPE_MATRIX:
+				for (uint32_t column = 0; column < definition.operands.at(1); column++)
+				{
+					addVertexInputs(location + column, definition.operands.at(0), inputs);
+				}
+				break;
+			default:
+				throw std::runtime_error("unsupported vertex input type in SPIR-V module");
+			}
+		}
+
+		static NumericType numericTypeOf(const Id& scalar) {
+			if (scalar.opcode == OP_TYPE_FLOAT)
+			{
+				return NumericType::FLOAT;
+			}
+			// width, signedness
+			return scalar.operands.at(1) != 0 ? NumericType::SINT : NumericType::UINT;
+		}
+	};
+};
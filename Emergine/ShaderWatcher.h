@@ -0,0 +1,162 @@
+#pragma once
+#pragma region --- INCLUDES ---
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <set>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif // __linux__
+#pragma endregion INCLUDES
+
+// watches a set of files in a single directory and reports when they change
+// on linux this blocks on inotify, elsewhere the modification times get compared a few times per second.
+// the callback runs on the watcher thread, so it can take its time without holding up anyone else,
+// changes that come in meanwhile get reported by the next call.
+// editors tend to save in several steps, so changes are only reported once the files have been quiet for a moment
+class ShaderWatcher {
+public:
+	using ChangeCallback = std::function<void(const std::vector<std::string>& changedFiles)>;
+
+	// how long the files need to be left alone before a change gets reported
+	static constexpr std::chrono::milliseconds SETTLE_TIME{ 100 };
+	// how often the thread checks whether it should stop, and the modification times when there's no inotify
+	static constexpr std::chrono::milliseconds POLL_INTERVAL{ 250 };
+
+	ShaderWatcher() = default;
+
+	~ShaderWatcher() {
+		stop();
+	}
+
+	ShaderWatcher(const ShaderWatcher&) = delete;
+	ShaderWatcher& operator=(const ShaderWatcher&) = delete;
+
+	// fileNames are relative to directory
+	void start(const std::string& directory, const std::vector<std::string>& fileNames, ChangeCallback callback) {
+		stop();
+
+		watchedDirectory = directory;
+		watchedFiles = std::set<std::string>(fileNames.begin(), fileNames.end());
+		onChange = std::move(callback);
+
+		running.store(true);
+		watcher = std::thread(&ShaderWatcher::watchLoop, this);
+	}
+
+	// waits for a callback that's still running to finish
+	void stop() {
+		running.store(false);
+		if (watcher.joinable())
+		{
+			watcher.join();
+		}
+	}
+
+private:
+	std::string watchedDirectory;
+	std::set<std::string> watchedFiles;
+	ChangeCallback onChange;
+
+	std::thread watcher;
+	std::atomic<bool> running{ false };
+
+	void watchLoop() {
+		std::set<std::string> changed;
+
+#ifdef __linux__
+		int inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if (inotifyFd >= 0 && inotify_add_watch(inotifyFd, watchedDirectory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) >= 0)
+		{
+			// aligned for struct inotify_event
+			alignas(inotify_event) char buffer[4096];
+
+			while (running.load())
+			{
+				pollfd pollFd{ inotifyFd, POLLIN, 0 };
+				auto timeout = changed.empty() ? POLL_INTERVAL : SETTLE_TIME;
+				int ready = poll(&pollFd, 1, static_cast<int>(timeout.count()));
+
+				if (ready > 0)
+				{
+					ssize_t length;
+					while ((length = read(inotifyFd, buffer, sizeof(buffer))) > 0)
+					{
+						for (char* event = buffer; event < buffer + length;)
+						{
+							const inotify_event* info = reinterpret_cast<const inotify_event*>(event);
+							if (info->len > 0 && watchedFiles.count(info->name) > 0)
+							{
+								changed.insert(info->name);
+							}
+							event += sizeof(inotify_event) + info->len;
+						}
+					}
+				}
+				else if (ready == 0 && !changed.empty())
+				{
+					// nothing happened for SETTLE_TIME
+					report(changed);
+				}
+			}
+
+			close(inotifyFd);
+			return;
+		}
+
+		if (inotifyFd >= 0)
+		{
+			close(inotifyFd);
+		}
+#endif // __linux__
+
+		std::map<std::string, std::filesystem::file_time_type> lastWriteTimes;
+		for (const std::string& file : watchedFiles)
+		{
+			lastWriteTimes[file] = lastWriteTime(file);
+		}
+
+		while (running.load())
+		{
+			std::this_thread::sleep_for(changed.empty() ? POLL_INTERVAL : SETTLE_TIME);
+
+			bool changedSinceLastCheck = false;
+			for (const std::string& file : watchedFiles)
+			{
+				auto writeTime = lastWriteTime(file);
+				if (writeTime != lastWriteTimes[file])
+				{
+					lastWriteTimes[file] = writeTime;
+					changed.insert(file);
+					changedSinceLastCheck = true;
+				}
+			}
+
+			if (!changedSinceLastCheck && !changed.empty())
+			{
+				report(changed);
+			}
+		}
+	}
+
+	void report(std::set<std::string>& changed) {
+		onChange(std::vector<std::string>(changed.begin(), changed.end()));
+		changed.clear();
+	}
+
+	std::filesystem::file_time_type lastWriteTime(const std::string& file) const {
+		// a file that's being replaced might briefly not exist
+		std::error_code error;
+		return std::filesystem::last_write_time(std::filesystem::path(watchedDirectory) / file, error);
+	}
+};
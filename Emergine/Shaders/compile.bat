@@ -1,6 +1,12 @@
-:: path to glslc.exe may differ for each computer
-:: path to glslc.exe will differ for each Vulkan version
-:: TODO: look into libshaderc (included by Vulkan) (to compile at runtime?)
-C:/VulkanSDK/1.2.162.1/Bin32/glslc.exe shader.vert -o vert.spv
-C:/VulkanSDK/1.2.162.1/Bin32/glslc.exe shader.frag -o frag.spv
+:: the same commands the project build runs, for compiling the shaders without building
+:: VULKAN_SDK is set by the Vulkan SDK installer
+"%VULKAN_SDK%\Bin\glslc.exe" shader.vert -o vert.spv
+"%VULKAN_SDK%\Bin\glslc.exe" shader.frag -o frag.spv
+"%VULKAN_SDK%\Bin\glslc.exe" sprite.vert -o sprite_vert.spv
+"%VULKAN_SDK%\Bin\glslc.exe" sprite.frag -o sprite_frag.spv
+"%VULKAN_SDK%\Bin\glslc.exe" mesh.vert -o mesh_vert.spv
+"%VULKAN_SDK%\Bin\glslc.exe" mesh.frag -o mesh_frag.spv
+"%VULKAN_SDK%\Bin\glslc.exe" hiz.comp -o hiz_comp.spv
+"%VULKAN_SDK%\Bin\glslc.exe" hud.vert -o hud_vert.spv
+"%VULKAN_SDK%\Bin\glslc.exe" cluster.comp -o cluster_comp.spv
 pause
@@ -0,0 +1,29 @@
+#version 450
+
+layout(push_constant) uniform PushConstants {
+	// turns pixel coordinates into normalized device coordinates
+	vec2 scale;
+	vec2 offset;
+} pushConstants;
+
+// one quad per instance, in pixels and atlas texture coordinates
+layout(location = 0) in vec4 inRect;
+layout(location = 1) in vec4 inTexRect;
+layout(location = 2) in vec4 inColor;
+
+layout(location = 0) out vec2 fragTexCoord;
+layout(location = 1) out vec4 fragColor;
+
+// two triangles, same winding as the sprite quads
+const vec2 corners[6] = vec2[](
+	vec2(0.0, 0.0), vec2(1.0, 0.0), vec2(1.0, 1.0),
+	vec2(1.0, 1.0), vec2(0.0, 1.0), vec2(0.0, 0.0)
+);
+
+// called for every vertex
+void main() {
+	vec2 corner = corners[gl_VertexIndex];
+	gl_Position = vec4((inRect.xy + corner * inRect.zw) * pushConstants.scale + pushConstants.offset, 0.0, 1.0);
+	fragTexCoord = mix(inTexRect.xy, inTexRect.zw, corner);
+	fragColor = inColor;
+}
@@ -0,0 +1,65 @@
+#version 450
+
+// same as in main.cpp and cluster.comp
+const uvec3 CLUSTER_GRID = uvec3(16, 9, 24);
+const uint MAX_LIGHTS_PER_CLUSTER = 1023;
+
+struct Light {
+	// xyz: position in view space, w: radius
+	vec4 positionRadius;
+	// rgb: color times intensity
+	vec4 color;
+};
+
+layout(std430, set = 0, binding = 0) readonly buffer Lights {
+	uint lightCount;
+	// 0 goes through every light for every fragment, 1 only through the ones binned into its cluster
+	uint clustered;
+	// only for cluster.comp and the CPU
+	uint droppedLights;
+	// xy: clusters per pixel, z: slices per unit of log depth, w: subtracted from that to start at the near plane
+	vec4 clusterScale;
+	Light lights[];
+} lights;
+
+layout(std430, set = 0, binding = 1) readonly buffer Clusters {
+	uint data[];
+} clusters;
+
+layout(location = 0) in vec3 fragNormal;
+layout(location = 1) in vec3 fragLightDirection;
+layout(location = 2) in vec3 fragViewPosition;
+
+layout(location = 0) out vec4 outColor;
+
+// fades out to nothing at the radius
+vec3 pointLight(uint index, vec3 normal) {
+	Light light = lights.lights[index];
+	vec3 toLight = light.positionRadius.xyz - fragViewPosition;
+	float distance = length(toLight);
+	float falloff = clamp(1.0 - distance / light.positionRadius.w, 0.0, 1.0);
+	return light.color.rgb * (falloff * falloff * max(dot(normal, toLight / max(distance, 1e-4)), 0.0));
+}
+
+// called for every fragment
+void main() {
+	vec3 normal = normalize(fragNormal);
+	float diffuse = max(dot(normal, -fragLightDirection), 0.0);
+	vec3 color = vec3(0.15 + 0.85 * diffuse);
+
+	if (lights.clustered != 0) {
+		uvec3 cell = uvec3(gl_FragCoord.xy * lights.clusterScale.xy, max(log(-fragViewPosition.z) * lights.clusterScale.z - lights.clusterScale.w, 0.0));
+		cell = min(cell, CLUSTER_GRID - 1u);
+		uint first = ((cell.z * CLUSTER_GRID.y + cell.y) * CLUSTER_GRID.x + cell.x) * (MAX_LIGHTS_PER_CLUSTER + 1);
+		uint count = clusters.data[first];
+		for (uint i = 0; i < count; i++) {
+			color += pointLight(clusters.data[first + 1 + i], normal);
+		}
+	} else {
+		for (uint i = 0; i < lights.lightCount; i++) {
+			color += pointLight(i, normal);
+		}
+	}
+
+	outColor = vec4(color, 1.0);
+}
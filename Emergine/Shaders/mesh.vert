@@ -0,0 +1,35 @@
+#version 450
+
+layout(push_constant) uniform MeshDraw {
+	mat4 viewProjection;
+	// in world space
+	vec4 lightDirection;
+} draw;
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inNormal;
+layout(location = 2) in vec2 inUV;
+// per instance
+layout(location = 3) in vec3 inInstancePosition;
+layout(location = 4) in vec3 inInstanceScale;
+// cosine and sine of the angle around y
+layout(location = 5) in vec2 inInstanceRotation;
+
+layout(location = 0) out vec3 fragNormal;
+layout(location = 1) out vec3 fragLightDirection;
+layout(location = 2) out vec3 fragViewPosition;
+
+vec3 rotateY(vec3 v) {
+	return vec3(inInstanceRotation.x * v.x + inInstanceRotation.y * v.z, v.y, inInstanceRotation.x * v.z - inInstanceRotation.y * v.x);
+}
+
+// called for every vertex
+void main() {
+	vec3 worldPosition = rotateY(inPosition * inInstanceScale) + inInstancePosition;
+	gl_Position = draw.viewProjection * vec4(worldPosition, 1.0);
+	// dividing by the scale keeps the normals perpendicular to stretched surfaces, the fragment shader normalizes them
+	fragNormal = rotateY(inNormal / inInstanceScale);
+	fragLightDirection = draw.lightDirection.xyz;
+	// the camera sits at the origin, so world space is view space
+	fragViewPosition = worldPosition;
+}
@@ -1,6 +1,13 @@
 #version 450
 
-layout(location = 0) out vec3 fragColor;
+// per draw, the material color gets pushed separately and only when it changes
+layout(push_constant) uniform SceneDraw {
+	// xy: offset, z: scale, w: depth
+	vec4 transform;
+	vec4 color;
+} draw;
+
+layout(location = 0) out vec4 fragColor;
 
 vec2 positions[3] = vec2[](
 	vec2(0.0, -0.5),
@@ -16,6 +23,6 @@ vec3 colors[3] = vec3[](
 
 // called for every vertex
 void main() {
-	gl_Position = vec4(positions[gl_VertexIndex], 0.0, 1.0);
-	fragColor = colors[gl_VertexIndex];
+	gl_Position = vec4(positions[gl_VertexIndex] * draw.transform.z + draw.transform.xy, draw.transform.w, 1.0);
+	fragColor = vec4(colors[gl_VertexIndex] * draw.color.rgb, draw.color.a);
 }
@@ -0,0 +1,21 @@
+#version 450
+
+layout(push_constant) uniform PushConstants {
+	// turns pixel coordinates into normalized device coordinates
+	vec2 scale;
+	vec2 offset;
+} pushConstants;
+
+layout(location = 0) in vec2 inPosition;
+layout(location = 1) in vec2 inTexCoord;
+layout(location = 2) in vec4 inColor;
+
+layout(location = 0) out vec2 fragTexCoord;
+layout(location = 1) out vec4 fragColor;
+
+// called for every vertex
+void main() {
+	gl_Position = vec4(inPosition * pushConstants.scale + pushConstants.offset, 0.0, 1.0);
+	fragTexCoord = inTexCoord;
+	fragColor = inColor;
+}
@@ -0,0 +1,153 @@
+#pragma once
+#pragma region --- INCLUDES ---
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#pragma endregion INCLUDES
+
+// blend state of the sprite pipelines, one pipeline per mode
+enum class SpriteBlend : uint8_t {
+	ALPHA,
+	ADDITIVE,
+	COUNT
+};
+
+// a textured, tinted quad in pixel coordinates, origin in the top left of the window
+struct Sprite {
+	float x = 0.0f;
+	float y = 0.0f;
+	float width = 0.0f;
+	float height = 0.0f;
+	// part of the texture to show
+	float u0 = 0.0f;
+	float v0 = 0.0f;
+	float u1 = 1.0f;
+	float v1 = 1.0f;
+	// RGBA, 8 bits per channel, red in the lowest byte
+	uint32_t color = 0xFFFFFFFF;
+	uint16_t texture = 0;
+	SpriteBlend blend = SpriteBlend::ALPHA;
+	// drawn in increasing order, within a layer sprites get grouped by blend mode and texture
+	uint8_t layer = 0;
+};
+
+// matches the vertex input of the sprite pipelines
+struct SpriteVertex {
+	float x, y;
+	float u, v;
+	uint32_t color;
+};
+
+// a run of quads sharing blend mode and texture, drawn with a single indexed draw
+struct SpriteDraw {
+	SpriteBlend blend;
+	uint16_t texture;
+	uint32_t firstVertex;
+	uint32_t quadCount;
+};
+
+// collects sprites during a frame and turns them into as few draws as possible
+// sprites get sorted by layer, blend mode and texture, ties keep the order they were added in,
+// and then written straight into mapped vertex memory. every draw reuses the same static index buffer,
+// vertexOffset picks out the run of quads it covers.
+class SpriteBatch {
+public:
+	// 16 bit indices reach 65536 vertices, longer runs get split over several draws
+	static constexpr uint32_t MAX_QUADS_PER_DRAW = 65536 / 4;
+
+	void clear() {
+		sprites.clear();
+		draws.clear();
+		dropped = 0;
+	}
+
+	void add(const Sprite& sprite) {
+		sprites.push_back(sprite);
+	}
+
+	// writes up to maxQuads quads in sorted order, sprites beyond that get dropped
+	// vertices usually points into write-combined memory, so it only gets written to, sequentially
+	const std::vector<SpriteDraw>& build(SpriteVertex* vertices, uint32_t maxQuads) {
+		draws.clear();
+
+		// key in the upper half, submission index in the lower half keeps the sort stable
+		sortKeys.resize(sprites.size());
+		for (size_t i = 0; i < sprites.size(); i++)
+		{
+			sortKeys[i] = (static_cast<uint64_t>(stateKey(sprites[i])) << 32) | static_cast<uint32_t>(i);
+		}
+		std::sort(sortKeys.begin(), sortKeys.end());
+
+		uint32_t quadCount = static_cast<uint32_t>(std::min<size_t>(sprites.size(), maxQuads));
+		dropped = static_cast<uint32_t>(sprites.size() - quadCount);
+
+		for (uint32_t quad = 0; quad < quadCount; quad++)
+		{
+			const Sprite& sprite = sprites[static_cast<uint32_t>(sortKeys[quad])];
+			writeQuad(vertices + quad * 4, sprite);
+
+			if (draws.empty()
+				|| draws.back().blend != sprite.blend
+				|| draws.back().texture != sprite.texture
+				|| draws.back().quadCount == MAX_QUADS_PER_DRAW)
+			{
+				draws.push_back({ sprite.blend, sprite.texture, quad * 4, 0 });
+			}
+			draws.back().quadCount++;
+		}
+
+		return draws;
+	}
+
+	size_t size() const {
+		return sprites.size();
+	}
+
+	// in the order they were added, build() hasn't sorted them yet
+	const std::vector<Sprite>& getSprites() const {
+		return sprites;
+	}
+
+	// sprites that didn't fit in the last build
+	uint32_t droppedCount() const {
+		return dropped;
+	}
+
+	// two triangles per quad, enough for the longest draw
+	static std::vector<uint16_t> buildQuadIndices() {
+		std::vector<uint16_t> indices(MAX_QUADS_PER_DRAW * 6);
+		for (uint32_t quad = 0; quad < MAX_QUADS_PER_DRAW; quad++)
+		{
+			uint16_t first = static_cast<uint16_t>(quad * 4);
+			uint16_t* quadIndices = &indices[quad * 6];
+			quadIndices[0] = first;
+			quadIndices[1] = first + 1;
+			quadIndices[2] = first + 2;
+			quadIndices[3] = first + 2;
+			quadIndices[4] = first + 3;
+			quadIndices[5] = first;
+		}
+		return indices;
+	}
+
+private:
+	std::vector<Sprite> sprites;
+	std::vector<uint64_t> sortKeys;
+	std::vector<SpriteDraw> draws;
+	uint32_t dropped = 0;
+
+	static uint32_t stateKey(const Sprite& sprite) {
+		return (static_cast<uint32_t>(sprite.layer) << 24)
+			| (static_cast<uint32_t>(sprite.blend) << 16)
+			| sprite.texture;
+	}
+
+	static void writeQuad(SpriteVertex* quad, const Sprite& sprite) {
+		float x1 = sprite.x + sprite.width;
+		float y1 = sprite.y + sprite.height;
+		quad[0] = { sprite.x, sprite.y, sprite.u0, sprite.v0, sprite.color };
+		quad[1] = { x1, sprite.y, sprite.u1, sprite.v0, sprite.color };
+		quad[2] = { x1, y1, sprite.u1, sprite.v1, sprite.color };
+		quad[3] = { sprite.x, y1, sprite.u0, sprite.v1, sprite.color };
+	}
+};
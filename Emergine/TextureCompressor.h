@@ -0,0 +1,637 @@
+#pragma once
+#pragma region --- INCLUDES ---
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <thread>
+#include <vector>
+
+#include <immintrin.h>
+#pragma endregion INCLUDES
+
+// block compressed formats, every one of them stores 4x4 texels per block
+enum class BlockFormat {
+	// RGB at 4 bits per texel, two 565 endpoints with two colors in between
+	BC1,
+	// BC1's colors with an 8 bit alpha on top, 8 bits per texel
+	BC3,
+	// two independent channels encoded like BC3's alpha, 8 bits per texel
+	BC5,
+	// RGBA at 8 bits per texel, at a better quality than BC3. only mode 6 gets written, a single pair of RGBA endpoints
+	BC7
+};
+
+// encodes RGBA8 pixels into block compressed textures, and decodes them again to measure how much got lost.
+// blocks are independent of each other, so rows of blocks get split across threads,
+// and every block fits its endpoints along the principal axis of its texels,
+// with the texels getting projected onto it four at a time
+class TextureCompressor {
+public:
+	static constexpr uint32_t BLOCK_DIMENSION = 4;
+	// fewer blocks than this aren't worth starting another thread for
+	static constexpr size_t MIN_BLOCKS_PER_THREAD = 1024;
+
+	static size_t blockBytes(BlockFormat format) {
+		return format == BlockFormat::BC1 ? 8 : 16;
+	}
+
+	static size_t compressedSize(uint32_t width, uint32_t height, BlockFormat format) {
+		return static_cast<size_t>(blockCount(width)) * blockCount(height) * blockBytes(format);
+	}
+
+	// pixels with R in the lowest byte, row after row.
+	// the size doesn't have to be a multiple of 4, edge texels get repeated to fill up the last blocks
+	static std::vector<uint8_t> compress(const uint32_t* pixels, uint32_t width, uint32_t height, BlockFormat format, size_t maxThreads) {
+		uint32_t blocksWide = blockCount(width);
+		uint32_t blocksHigh = blockCount(height);
+		size_t bytes = blockBytes(format);
+		std::vector<uint8_t> blocks(compressedSize(width, height, format));
+
+		auto compressRows = [&](uint32_t firstRow, uint32_t endRow) {
+			Block block;
+			for (uint32_t blockY = firstRow; blockY < endRow; blockY++)
+			{
+				for (uint32_t blockX = 0; blockX < blocksWide; blockX++)
+				{
+					loadBlock(pixels, width, height, blockX, blockY, block);
+					uint8_t* output = blocks.data() + (static_cast<size_t>(blockY) * blocksWide + blockX) * bytes;
+					switch (format)
+					{
+					case BlockFormat::BC1:
+						encodeColor(block, output);
+						break;
+					case BlockFormat::BC3:
+						encodeChannel(block, 3, output);
+						encodeColor(block, output + 8);
+						break;
+					case BlockFormat::BC5:
+						encodeChannel(block, 0, output);
+						encodeChannel(block, 1, output + 8);
+						break;
+					case BlockFormat::BC7:
+						encodeMode6(block, output);
+						break;
+					}
+				}
+			}
+		};
+
+		size_t threadCount = std::clamp(static_cast<size_t>(blocksWide) * blocksHigh / MIN_BLOCKS_PER_THREAD, size_t(1), std::max(maxThreads, size_t(1)));
+		threadCount = std::min(threadCount, static_cast<size_t>(blocksHigh));
+		if (threadCount <= 1)
+		{
+			compressRows(0, blocksHigh);
+			return blocks;
+		}
+
+		std::vector<std::thread> threads;
+		for (size_t i = 0; i < threadCount; i++)
+		{
+			uint32_t firstRow = static_cast<uint32_t>(blocksHigh * i / threadCount);
+			uint32_t endRow = static_cast<uint32_t>(blocksHigh * (i + 1) / threadCount);
+			threads.emplace_back(compressRows, firstRow, endRow);
+		}
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+		return blocks;
+	}
+
+	// back to RGBA8 at the original size, channels a format doesn't store come back as they'd be sampled, 0 for color and 255 for alpha
+	static std::vector<uint32_t> decompress(const uint8_t* blocks, uint32_t width, uint32_t height, BlockFormat format) {
+		uint32_t blocksWide = blockCount(width);
+		size_t bytes = blockBytes(format);
+		std::vector<uint32_t> pixels(static_cast<size_t>(width) * height);
+
+		for (uint32_t blockY = 0; blockY < blockCount(height); blockY++)
+		{
+			for (uint32_t blockX = 0; blockX < blocksWide; blockX++)
+			{
+				const uint8_t* input = blocks + (static_cast<size_t>(blockY) * blocksWide + blockX) * bytes;
+				std::array<std::array<uint8_t, 4>, 16> texels{};
+				switch (format)
+				{
+				case BlockFormat::BC1:
+					decodeColor(input, texels, true);
+					break;
+				case BlockFormat::BC3:
+					decodeChannel(input, 3, texels);
+					decodeColor(input + 8, texels, false);
+					break;
+				case BlockFormat::BC5:
+					decodeChannel(input, 0, texels);
+					decodeChannel(input + 8, 1, texels);
+					for (std::array<uint8_t, 4>& texel : texels)
+					{
+						texel[3] = 255;
+					}
+					break;
+				case BlockFormat::BC7:
+					decodeMode6(input, texels);
+					break;
+				}
+
+				for (uint32_t i = 0; i < 16; i++)
+				{
+					uint32_t x = blockX * BLOCK_DIMENSION + i % BLOCK_DIMENSION;
+					uint32_t y = blockY * BLOCK_DIMENSION + i / BLOCK_DIMENSION;
+					if (x < width && y < height)
+					{
+						pixels[static_cast<size_t>(y) * width + x] = texels[i][0] | (texels[i][1] << 8) | (texels[i][2] << 16) | (static_cast<uint32_t>(texels[i][3]) << 24);
+					}
+				}
+			}
+		}
+		return pixels;
+	}
+
+private:
+	// the 16 texels of a block, one channel after the other so four texels fit into one register
+	struct Block {
+		alignas(16) float channels[4][16];
+	};
+
+	// BC7's 4 bit interpolation weights, out of 64
+	static constexpr std::array<uint32_t, 16> MODE_6_WEIGHTS = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	static uint32_t blockCount(uint32_t texels) {
+		return (texels + BLOCK_DIMENSION - 1) / BLOCK_DIMENSION;
+	}
+
+	static void loadBlock(const uint32_t* pixels, uint32_t width, uint32_t height, uint32_t blockX, uint32_t blockY, Block& block) {
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			uint32_t x = std::min(blockX * BLOCK_DIMENSION + i % BLOCK_DIMENSION, width - 1);
+			uint32_t y = std::min(blockY * BLOCK_DIMENSION + i / BLOCK_DIMENSION, height - 1);
+			uint32_t pixel = pixels[static_cast<size_t>(y) * width + x];
+			for (int channel = 0; channel < 4; channel++)
+			{
+				block.channels[channel][i] = static_cast<float>((pixel >> (channel * 8)) & 0xFF);
+			}
+		}
+	}
+
+	#pragma region --- ENDPOINTS ---
+	// the two ends of the line through the texels that loses the least, over the channels in the mask.
+	// the direction is the principal axis of the texels, found by a few rounds of power iteration on their covariance
+	static void fitEndpoints(const Block& block, const std::array<bool, 4>& mask, float start[4], float end[4]) {
+		float mean[4] = {};
+		float minimum[4];
+		float maximum[4];
+		for (int channel = 0; channel < 4; channel++)
+		{
+			minimum[channel] = 255.0f;
+			maximum[channel] = 0.0f;
+			for (int i = 0; i < 16; i++)
+			{
+				float value = block.channels[channel][i];
+				mean[channel] += value;
+				minimum[channel] = std::min(minimum[channel], value);
+				maximum[channel] = std::max(maximum[channel], value);
+			}
+			mean[channel] /= 16.0f;
+		}
+
+		float covariance[4][4] = {};
+		for (int i = 0; i < 16; i++)
+		{
+			for (int a = 0; a < 4; a++)
+			{
+				for (int b = a; b < 4; b++)
+				{
+					if (mask[a] && mask[b])
+					{
+						covariance[a][b] += (block.channels[a][i] - mean[a]) * (block.channels[b][i] - mean[b]);
+					}
+				}
+			}
+		}
+		for (int a = 0; a < 4; a++)
+		{
+			for (int b = 0; b < a; b++)
+			{
+				covariance[a][b] = covariance[b][a];
+			}
+		}
+
+		// the diagonal of the bounding box is usually close already
+		float axis[4];
+		for (int channel = 0; channel < 4; channel++)
+		{
+			axis[channel] = mask[channel] ? maximum[channel] - minimum[channel] : 0.0f;
+		}
+		for (int iteration = 0; iteration < 8; iteration++)
+		{
+			float next[4] = {};
+			float length = 0.0f;
+			for (int a = 0; a < 4; a++)
+			{
+				for (int b = 0; b < 4; b++)
+				{
+					next[a] += covariance[a][b] * axis[b];
+				}
+				length = std::max(length, std::abs(next[a]));
+			}
+			if (length < 1e-6f)
+			{
+				break;
+			}
+			for (int channel = 0; channel < 4; channel++)
+			{
+				axis[channel] = next[channel] / length;
+			}
+		}
+
+		float lowest = 0.0f;
+		float highest = 0.0f;
+		float axisLength = 0.0f;
+		for (int channel = 0; channel < 4; channel++)
+		{
+			axisLength += axis[channel] * axis[channel];
+		}
+		if (axisLength > 1e-12f)
+		{
+			lowest = std::numeric_limits<float>::max();
+			highest = -std::numeric_limits<float>::max();
+			for (int i = 0; i < 16; i++)
+			{
+				float t = 0.0f;
+				for (int channel = 0; channel < 4; channel++)
+				{
+					t += (block.channels[channel][i] - mean[channel]) * axis[channel];
+				}
+				lowest = std::min(lowest, t);
+				highest = std::max(highest, t);
+			}
+			lowest /= axisLength;
+			highest /= axisLength;
+		}
+
+		for (int channel = 0; channel < 4; channel++)
+		{
+			start[channel] = std::clamp(mean[channel] + axis[channel] * lowest, 0.0f, 255.0f);
+			end[channel] = std::clamp(mean[channel] + axis[channel] * highest, 0.0f, 255.0f);
+		}
+	}
+
+	// the position of every texel on the line from start to end, over the channels in the mask, rounded to one of the levels
+	// 0 at start and levels - 1 at end
+	static void fitIndices(const Block& block, const std::array<bool, 4>& mask, const float start[4], const float end[4], uint32_t levels, uint8_t indices[16]) {
+		float lengthSquared = 0.0f;
+		__m128 direction[4];
+		__m128 origin[4];
+		for (int channel = 0; channel < 4; channel++)
+		{
+			float delta = mask[channel] ? end[channel] - start[channel] : 0.0f;
+			lengthSquared += delta * delta;
+			direction[channel] = _mm_set1_ps(delta);
+			origin[channel] = _mm_set1_ps(start[channel]);
+		}
+		if (lengthSquared < 1e-6f)
+		{
+			std::fill(indices, indices + 16, uint8_t(0));
+			return;
+		}
+
+		__m128 scale = _mm_set1_ps((levels - 1) / lengthSquared);
+		__m128 lowest = _mm_setzero_ps();
+		__m128 highest = _mm_set1_ps(static_cast<float>(levels - 1));
+		__m128 half = _mm_set1_ps(0.5f);
+		for (int group = 0; group < 16; group += 4)
+		{
+			__m128 t = _mm_setzero_ps();
+			for (int channel = 0; channel < 4; channel++)
+			{
+				__m128 texels = _mm_load_ps(block.channels[channel] + group);
+				t = _mm_add_ps(t, _mm_mul_ps(_mm_sub_ps(texels, origin[channel]), direction[channel]));
+			}
+			t = _mm_min_ps(_mm_max_ps(_mm_mul_ps(t, scale), lowest), highest);
+
+			alignas(16) int32_t rounded[4];
+			_mm_store_si128(reinterpret_cast<__m128i*>(rounded), _mm_cvttps_epi32(_mm_add_ps(t, half)));
+			for (int i = 0; i < 4; i++)
+			{
+				indices[group + i] = static_cast<uint8_t>(rounded[i]);
+			}
+		}
+	}
+	#pragma endregion ENDPOINTS
+
+	#pragma region --- BC1 ---
+	static uint16_t packColor(const float color[4]) {
+		uint32_t r = static_cast<uint32_t>(color[0] * 31.0f / 255.0f + 0.5f);
+		uint32_t g = static_cast<uint32_t>(color[1] * 63.0f / 255.0f + 0.5f);
+		uint32_t b = static_cast<uint32_t>(color[2] * 31.0f / 255.0f + 0.5f);
+		return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+	}
+
+	static void unpackColor(uint16_t packed, float color[4]) {
+		uint32_t r = (packed >> 11) & 0x1F;
+		uint32_t g = (packed >> 5) & 0x3F;
+		uint32_t b = packed & 0x1F;
+		color[0] = static_cast<float>((r << 3) | (r >> 2));
+		color[1] = static_cast<float>((g << 2) | (g >> 4));
+		color[2] = static_cast<float>((b << 3) | (b >> 2));
+		color[3] = 255.0f;
+	}
+
+	// always in the four color mode, which is the only one BC3 knows
+	static void encodeColor(const Block& block, uint8_t* output) {
+		const std::array<bool, 4> mask = { true, true, true, false };
+		float start[4];
+		float end[4];
+		fitEndpoints(block, mask, start, end);
+
+		uint16_t color0 = packColor(end);
+		uint16_t color1 = packColor(start);
+		if (color0 < color1)
+		{
+			std::swap(color0, color1);
+		}
+
+		uint32_t bits = 0;
+		if (color0 != color1)
+		{
+			// the indices get fitted to the colors as they come out of the decoder
+			float decoded0[4];
+			float decoded1[4];
+			unpackColor(color0, decoded0);
+			unpackColor(color1, decoded1);
+
+			uint8_t levels[16];
+			fitIndices(block, mask, decoded0, decoded1, 4, levels);
+			// color0, color1, 2/3 color0 + 1/3 color1, 1/3 color0 + 2/3 color1
+			const uint32_t order[4] = { 0, 2, 3, 1 };
+			for (int i = 0; i < 16; i++)
+			{
+				bits |= order[levels[i]] << (i * 2);
+			}
+		}
+
+		output[0] = static_cast<uint8_t>(color0);
+		output[1] = static_cast<uint8_t>(color0 >> 8);
+		output[2] = static_cast<uint8_t>(color1);
+		output[3] = static_cast<uint8_t>(color1 >> 8);
+		for (int i = 0; i < 4; i++)
+		{
+			output[4 + i] = static_cast<uint8_t>(bits >> (i * 8));
+		}
+	}
+
+	static void decodeColor(const uint8_t* input, std::array<std::array<uint8_t, 4>, 16>& texels, bool allowThreeColors) {
+		uint16_t color0 = static_cast<uint16_t>(input[0] | (input[1] << 8));
+		uint16_t color1 = static_cast<uint16_t>(input[2] | (input[3] << 8));
+		float endpoints[2][4];
+		unpackColor(color0, endpoints[0]);
+		unpackColor(color1, endpoints[1]);
+
+		float palette[4][4];
+		bool threeColors = allowThreeColors && color0 <= color1;
+		for (int channel = 0; channel < 4; channel++)
+		{
+			palette[0][channel] = endpoints[0][channel];
+			palette[1][channel] = endpoints[1][channel];
+			if (threeColors)
+			{
+				palette[2][channel] = (endpoints[0][channel] + endpoints[1][channel]) / 2.0f;
+				// transparent black
+				palette[3][channel] = 0.0f;
+			}
+			else
+			{
+				palette[2][channel] = (endpoints[0][channel] * 2.0f + endpoints[1][channel]) / 3.0f;
+				palette[3][channel] = (endpoints[0][channel] + endpoints[1][channel] * 2.0f) / 3.0f;
+			}
+		}
+
+		uint32_t bits = input[4] | (input[5] << 8) | (input[6] << 16) | (static_cast<uint32_t>(input[7]) << 24);
+		for (int i = 0; i < 16; i++)
+		{
+			uint32_t index = (bits >> (i * 2)) & 0x3;
+			for (int channel = 0; channel < 3; channel++)
+			{
+				texels[i][channel] = static_cast<uint8_t>(palette[index][channel] + 0.5f);
+			}
+			if (allowThreeColors)
+			{
+				texels[i][3] = static_cast<uint8_t>(palette[index][3]);
+			}
+		}
+	}
+	#pragma endregion BC1
+
+	#pragma region --- BC4 ---
+	// a single channel, like BC3's alpha and each of BC5's two channels, always in the eight value mode
+	static void encodeChannel(const Block& block, int channel, uint8_t* output) {
+		std::array<bool, 4> mask = {};
+		mask[channel] = true;
+
+		float lowest = 255.0f;
+		float highest = 0.0f;
+		for (int i = 0; i < 16; i++)
+		{
+			lowest = std::min(lowest, block.channels[channel][i]);
+			highest = std::max(highest, block.channels[channel][i]);
+		}
+		uint8_t value0 = static_cast<uint8_t>(highest + 0.5f);
+		uint8_t value1 = static_cast<uint8_t>(lowest + 0.5f);
+
+		uint64_t bits = 0;
+		if (value0 != value1)
+		{
+			float start[4] = {};
+			float end[4] = {};
+			start[channel] = value0;
+			end[channel] = value1;
+
+			uint8_t levels[16];
+			fitIndices(block, mask, start, end, 8, levels);
+			// value0, value1, then the six in between from value0 to value1
+			for (int i = 0; i < 16; i++)
+			{
+				uint64_t index = levels[i] == 0 ? 0 : levels[i] == 7 ? 1 : levels[i] + 1;
+				bits |= index << (i * 3);
+			}
+		}
+
+		output[0] = value0;
+		output[1] = value1;
+		for (int i = 0; i < 6; i++)
+		{
+			output[2 + i] = static_cast<uint8_t>(bits >> (i * 8));
+		}
+	}
+
+	static void decodeChannel(const uint8_t* input, int channel, std::array<std::array<uint8_t, 4>, 16>& texels) {
+		uint32_t value0 = input[0];
+		uint32_t value1 = input[1];
+		uint32_t palette[8] = { value0, value1 };
+		if (value0 > value1)
+		{
+			for (uint32_t i = 1; i < 7; i++)
+			{
+				palette[i + 1] = ((7 - i) * value0 + i * value1 + 3) / 7;
+			}
+		}
+		else
+		{
+			for (uint32_t i = 1; i < 5; i++)
+			{
+				palette[i + 1] = ((5 - i) * value0 + i * value1 + 2) / 5;
+			}
+			palette[6] = 0;
+			palette[7] = 255;
+		}
+
+		uint64_t bits = 0;
+		for (int i = 0; i < 6; i++)
+		{
+			bits |= static_cast<uint64_t>(input[2 + i]) << (i * 8);
+		}
+		for (int i = 0; i < 16; i++)
+		{
+			texels[i][channel] = static_cast<uint8_t>(palette[(bits >> (i * 3)) & 0x7]);
+		}
+	}
+	#pragma endregion BC4
+
+	#pragma region --- BC7 ---
+	// writes the bits of a block from the lowest one up
+	struct BitWriter {
+		uint8_t* output;
+		uint32_t position = 0;
+
+		void write(uint32_t value, uint32_t bits) {
+			for (uint32_t i = 0; i < bits; i++, position++)
+			{
+				output[position / 8] |= static_cast<uint8_t>(((value >> i) & 1) << (position % 8));
+			}
+		}
+	};
+
+	struct BitReader {
+		const uint8_t* input;
+		uint32_t position = 0;
+
+		uint32_t read(uint32_t bits) {
+			uint32_t value = 0;
+			for (uint32_t i = 0; i < bits; i++, position++)
+			{
+				value |= ((input[position / 8] >> (position % 8)) & 1u) << i;
+			}
+			return value;
+		}
+	};
+
+	// 7 bits per channel plus a shared lowest bit per endpoint, picked for whichever of the two gets closer
+	static void quantizeMode6(const float endpoint[4], uint32_t quantized[4], uint32_t& pBit) {
+		float bestError = std::numeric_limits<float>::max();
+		for (uint32_t p = 0; p < 2; p++)
+		{
+			uint32_t candidate[4];
+			float error = 0.0f;
+			for (int channel = 0; channel < 4; channel++)
+			{
+				candidate[channel] = static_cast<uint32_t>(std::clamp((endpoint[channel] - p) / 2.0f + 0.5f, 0.0f, 127.0f));
+				float difference = static_cast<float>((candidate[channel] << 1) | p) - endpoint[channel];
+				error += difference * difference;
+			}
+			if (error < bestError)
+			{
+				bestError = error;
+				pBit = p;
+				std::copy(candidate, candidate + 4, quantized);
+			}
+		}
+	}
+
+	static void encodeMode6(const Block& block, uint8_t* output) {
+		const std::array<bool, 4> mask = { true, true, true, true };
+		float start[4];
+		float end[4];
+		fitEndpoints(block, mask, start, end);
+
+		uint32_t quantized[2][4];
+		uint32_t pBits[2] = {};
+		quantizeMode6(start, quantized[0], pBits[0]);
+		quantizeMode6(end, quantized[1], pBits[1]);
+
+		float decoded[2][4];
+		for (int endpoint = 0; endpoint < 2; endpoint++)
+		{
+			for (int channel = 0; channel < 4; channel++)
+			{
+				decoded[endpoint][channel] = static_cast<float>((quantized[endpoint][channel] << 1) | pBits[endpoint]);
+			}
+		}
+
+		uint8_t indices[16];
+		fitIndices(block, mask, decoded[0], decoded[1], 16, indices);
+
+		// the first index only has room for 3 bits, so its highest one has to be 0
+		if (indices[0] & 0x8)
+		{
+			std::swap(quantized[0], quantized[1]);
+			std::swap(pBits[0], pBits[1]);
+			for (uint8_t& index : indices)
+			{
+				index = static_cast<uint8_t>(15 - index);
+			}
+		}
+
+		std::fill(output, output + 16, uint8_t(0));
+		BitWriter writer{ output };
+		// mode 6 is a 1 after six 0s
+		writer.write(1 << 6, 7);
+		for (int channel = 0; channel < 4; channel++)
+		{
+			writer.write(quantized[0][channel], 7);
+			writer.write(quantized[1][channel], 7);
+		}
+		writer.write(pBits[0], 1);
+		writer.write(pBits[1], 1);
+		writer.write(indices[0], 3);
+		for (int i = 1; i < 16; i++)
+		{
+			writer.write(indices[i], 4);
+		}
+	}
+
+	// blocks in any other mode come out black, encodeMode6 doesn't write them
+	static void decodeMode6(const uint8_t* input, std::array<std::array<uint8_t, 4>, 16>& texels) {
+		BitReader reader{ input };
+		if (reader.read(7) != (1 << 6))
+		{
+			texels = {};
+			return;
+		}
+
+		uint32_t endpoints[2][4];
+		for (int channel = 0; channel < 4; channel++)
+		{
+			endpoints[0][channel] = reader.read(7) << 1;
+			endpoints[1][channel] = reader.read(7) << 1;
+		}
+		uint32_t pBit0 = reader.read(1);
+		uint32_t pBit1 = reader.read(1);
+		for (int channel = 0; channel < 4; channel++)
+		{
+			endpoints[0][channel] |= pBit0;
+			endpoints[1][channel] |= pBit1;
+		}
+
+		for (int i = 0; i < 16; i++)
+		{
+			uint32_t weight = MODE_6_WEIGHTS[reader.read(i == 0 ? 3 : 4)];
+			for (int channel = 0; channel < 4; channel++)
+			{
+				texels[i][channel] = static_cast<uint8_t>(((64 - weight) * endpoints[0][channel] + weight * endpoints[1][channel] + 32) >> 6);
+			}
+		}
+	}
+	#pragma endregion BC7
+};
@@ -0,0 +1,53 @@
+#pragma once
+#pragma region --- INCLUDES ---
+#include <array>
+#include <atomic>
+#include <cstdint>
+#pragma endregion INCLUDES
+
+// hands the latest of a stream of values from one writer thread to one reader thread, without either of them ever waiting.
+// of the three slots the writer owns one, the reader owns one, and the middle one is up for grabs:
+//		the writer fills its slot and swaps it with the middle one
+//		the reader swaps its slot with the middle one, but only when the middle one holds something it hasn't seen yet
+// the middle index and whether it's fresh share one atomic, so a swap is a single exchange.
+// values the writer skips over get overwritten, the reader always ends up with the newest one.
+// slots get reused rather than cleared, so a slot holding a vector keeps its capacity
+template<typename T>
+class TripleBuffer {
+public:
+	// writer only, the slot to fill, still holding whatever was in it three publishes ago
+	T& back() {
+		return slots[backIndex];
+	}
+
+	// writer only, makes back() visible to the reader and hands the writer a slot the reader is done with
+	void publish() {
+		uint8_t previous = middle.exchange(static_cast<uint8_t>(backIndex | FRESH), std::memory_order_acq_rel);
+		backIndex = previous & INDEX_MASK;
+	}
+
+	// reader only, takes the newest published value if there is one, returns whether front() changed
+	bool update() {
+		if ((middle.load(std::memory_order_relaxed) & FRESH) == 0)
+		{
+			return false;
+		}
+		uint8_t previous = middle.exchange(frontIndex, std::memory_order_acq_rel);
+		frontIndex = previous & INDEX_MASK;
+		return true;
+	}
+
+	// reader only, a default constructed T until the first update() that returned true
+	const T& front() const {
+		return slots[frontIndex];
+	}
+
+private:
+	static constexpr uint8_t INDEX_MASK = 0x3;
+	static constexpr uint8_t FRESH = 0x4;
+
+	std::array<T, 3> slots{};
+	uint8_t backIndex = 0;
+	std::atomic<uint8_t> middle{ 1 };
+	uint8_t frontIndex = 2;
+};
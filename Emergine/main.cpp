@@ -3,17 +3,51 @@
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
 
+// engine imports
+#include "BoundingVolumeHierarchy.h"
+#include "CommandTrace.h"
+#include "DeviceDispatch.h"
+#include "DrawQueue.h"
+#include "FrameCapture.h"
+#include "HostAllocator.h"
+#include "JobSystem.h"
+#include "Logger.h"
+#include "MeshImporter.h"
+#include "PerfHud.h"
+#include "PipelineLayoutCache.h"
+#include "ResidencyManager.h"
+#include "ShaderCompiler.h"
+#include "ShaderReflection.h"
+#include "ShaderWatcher.h"
+#include "SpriteBatch.h"
+#include "TextureCompressor.h"
+#include "TripleBuffer.h"
+
 // std imports
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cfloat>
 #include <cstdint>
+#include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <ctime>
+#include <deque>
+#include <filesystem>
 #include <fstream>
+#include <functional>
 #include <iostream>
 #include <map>
+#include <numeric>
 #include <optional>
+#include <random>
 #include <set>
+#include <sstream>
 #include <stdexcept>
+#include <thread>
 #include <vector>
 #pragma endregion INCLUDES
 
@@ -72,6 +106,230 @@ const vector<const char*> deviceExtensions = {
 
 const string VERT_SHADER_PATH = "shaders/vert.spv";
 const string FRAG_SHADER_PATH = "shaders/frag.spv";
+const string SPRITE_VERT_SHADER_PATH = "shaders/sprite_vert.spv";
+const string SPRITE_FRAG_SHADER_PATH = "shaders/sprite_frag.spv";
+const string MESH_VERT_SHADER_PATH = "shaders/mesh_vert.spv";
+const string MESH_FRAG_SHADER_PATH = "shaders/mesh_frag.spv";
+const string HI_Z_COMP_SHADER_PATH = "shaders/hiz_comp.spv";
+const string CLUSTER_COMP_SHADER_PATH = "shaders/cluster_comp.spv";
+// the HUD shares sprite.frag
+const string HUD_VERT_SHADER_PATH = "shaders/hud_vert.spv";
+
+#pragma region --- SHADER HOT RELOAD ---
+#ifdef NDEBUG
+const bool enableShaderHotReload = false;
+#else
+const bool enableShaderHotReload = true;
+#endif // NDEBUG
+
+// glsl sources next to the compiled shaders, and the file each of them compiles to
+const string SHADER_SOURCE_DIRECTORY = "shaders";
+const vector<pair<string, string>> SHADER_SOURCES = {
+	{ "shader.vert", VERT_SHADER_PATH },
+	{ "shader.frag", FRAG_SHADER_PATH },
+	{ "sprite.vert", SPRITE_VERT_SHADER_PATH },
+	{ "sprite.frag", SPRITE_FRAG_SHADER_PATH },
+	{ "mesh.vert", MESH_VERT_SHADER_PATH },
+	{ "mesh.frag", MESH_FRAG_SHADER_PATH },
+	{ "hiz.comp", HI_Z_COMP_SHADER_PATH },
+	{ "cluster.comp", CLUSTER_COMP_SHADER_PATH },
+	{ "hud.vert", HUD_VERT_SHADER_PATH }
+};
+// only used when the device supports what they're for, which isn't known yet when the shaders get preloaded,
+// so they're only read when they're there
+const set<string> OPTIONAL_SHADER_PATHS = { HI_Z_COMP_SHADER_PATH };
+#pragma endregion SHADER HOT RELOAD
+
+// amount of frames the CPU may record ahead of the GPU
+const int MAX_FRAMES_IN_FLIGHT = 2;
+
+#pragma region --- FRAME PACING ---
+// used when the monitor doesn't report a refresh rate
+const int FALLBACK_REFRESH_RATE = 60;
+// initial target of the FIXED_CAP present policy
+const int DEFAULT_FRAME_CAP = 60;
+const int MIN_FRAME_CAP = 10;
+const int MAX_FRAME_CAP = 500;
+// how often the frame statistics get reported, in seconds
+const double STATS_REPORT_INTERVAL = 1.0;
+#pragma endregion FRAME PACING
+
+#pragma region --- DYNAMIC RESOLUTION ---
+// render scale per axis, as a fraction of the swap chain extent
+const float MIN_RENDER_SCALE = 0.5f;
+const float MAX_RENDER_SCALE = 1.0f;
+// biggest change of the render scale in a single adjustment
+const float MAX_RENDER_SCALE_STEP = 0.1f;
+// share of the frame time the GPU may use, leaves room for spikes and the presentation engine
+const double GPU_BUDGET_HEADROOM = 0.9;
+// frames between adjustments, so the effect of the previous one shows up in the measurements first
+const uint32_t RENDER_SCALE_ADJUST_INTERVAL = 30;
+#pragma endregion DYNAMIC RESOLUTION
+
+#pragma region --- FRAME CAPTURE ---
+// readback buffers the presented frames get copied into
+// a frame only reaches the writer once its fence got signaled, so at least MAX_FRAMES_IN_FLIGHT are needed to not drop frames
+const size_t CAPTURE_RING_SIZE = MAX_FRAMES_IN_FLIGHT + 2;
+const string CAPTURE_DIRECTORY = "captures";
+// run-length encode frames on the writer thread, trades writer time for disk bandwidth
+const bool CAPTURE_COMPRESS = true;
+#pragma endregion FRAME CAPTURE
+
+#pragma region --- DEVICE DISPATCH ---
+// calls of each vkCmd* per round of the dispatch benchmark, the fastest of the rounds counts
+const uint32_t DISPATCH_BENCHMARK_CALLS = 100000;
+const uint32_t DISPATCH_BENCHMARK_ROUNDS = 5;
+#pragma endregion DEVICE DISPATCH
+
+#pragma region --- TEXTURE COMPRESSION ---
+// width and height of the texture B encodes in every block compressed format
+const uint32_t TEXTURE_BENCHMARK_SIZE = 1024;
+#pragma endregion TEXTURE COMPRESSION
+
+#pragma region --- COMMAND TRACE ---
+const string TRACE_DIRECTORY = "traces";
+// how often --replay plays the trace when --loops isn't given
+const uint32_t DEFAULT_REPLAY_LOOPS = 1;
+#pragma endregion COMMAND TRACE
+
+#pragma region --- SPRITES ---
+// quads the vertex ring of each frame in flight has room for, sprites beyond that get dropped
+const uint32_t MAX_SPRITES = 100000;
+// procedurally generated textures the sprites can pick from
+const uint32_t SPRITE_TEXTURE_COUNT = 4;
+const uint32_t SPRITE_TEXTURE_SIZE = 64;
+// textures under memory pressure get halved down to this size
+const uint32_t MIN_SPRITE_TEXTURE_SIZE = 8;
+// amounts of moving sprites F8 cycles through, to benchmark the batching
+const array<uint32_t, 5> SPRITE_BENCHMARK_COUNTS = { 0, 1000, 10000, 50000, 100000 };
+#pragma endregion SPRITES
+
+#pragma region --- SIMULATION ---
+// steps per second of the simulation thread, whatever the frame rate
+const double SIMULATION_RATE = 120.0;
+// a simulation that fell behind runs up to this many steps back to back to catch up, the time beyond that gets skipped
+const uint32_t MAX_SIMULATION_CATCH_UP_STEPS = 8;
+#pragma endregion SIMULATION
+
+#pragma region --- ASSET LOADING ---
+// workers reading and importing assets during setup, a load waiting on others doesn't hold one
+const size_t ASSET_LOADER_THREADS = 4;
+#pragma endregion ASSET LOADING
+
+#pragma region --- SCENE ---
+// colors the scene draws get tinted with, pushed only when the material changes
+// material 0 leaves the vertex colors as they are
+const array<array<float, 4>, 8> SCENE_MATERIALS = { {
+	{ 1.0f, 1.0f, 1.0f, 1.0f },
+	{ 1.0f, 0.3f, 0.3f, 1.0f },
+	{ 0.3f, 1.0f, 0.3f, 1.0f },
+	{ 0.3f, 0.3f, 1.0f, 1.0f },
+	{ 1.0f, 1.0f, 0.3f, 1.0f },
+	{ 0.3f, 1.0f, 1.0f, 0.5f },
+	{ 1.0f, 0.3f, 1.0f, 0.5f },
+	{ 0.6f, 0.6f, 0.6f, 0.5f }
+} };
+// first material with alpha below 1, draws using these go through the transparent pipeline
+const uint32_t FIRST_TRANSPARENT_MATERIAL = 5;
+// amounts of overlapping triangles F9 cycles through, to benchmark the draw sorting
+const array<uint32_t, 4> SCENE_BENCHMARK_COUNTS = { 0, 500, 2000, 8000 };
+#pragma endregion SCENE
+
+#pragma region --- MESHES ---
+// every .obj, .gltf and .glb in here gets imported at startup, the optimized results get cached next to them
+const string MESH_DIRECTORY = "models";
+const float MESH_FIELD_OF_VIEW = 45.0f;
+// radians per second
+const float MESH_ROTATION_SPEED = 0.5f;
+// size of the per frame instance rings
+const uint32_t MAX_MESH_INSTANCES = 65536;
+// amounts of mesh instances F11 cycles through, laid out in a grid going into the distance, followed by the city
+// 0 shows every imported mesh once, in a row in front of the camera
+const array<uint32_t, 4> MESH_BENCHMARK_COUNTS = { 0, 1000, 10000, 50000 };
+// blocks of the synthetic city along each side, with four buildings each
+const uint32_t CITY_BLOCKS = 48;
+// a block and the street next to it
+const float CITY_BLOCK_SIZE = 12.0f;
+const float CITY_STREET_WIDTH = 4.0f;
+// between the centers of neighbouring instances, every mesh gets scaled to a radius of 1
+const float MESH_GRID_SPACING = 3.0f;
+// the coarsest level of detail that moves the surface less than this many pixels gets drawn
+const float LOD_ERROR_PIXELS = 1.0f;
+// how far past LOD_ERROR_PIXELS the error has to get before an instance switches,
+// so instances sitting right at the threshold don't flicker between two levels
+const float LOD_HYSTERESIS = 0.25f;
+// threads helping the render thread cull mesh instances, on top of the render thread itself
+const size_t MAX_CULL_WORKERS = 3;
+#pragma endregion MESHES
+
+#pragma region --- OCCLUSION CULLING ---
+// the coarse end of the depth pyramid gets read back for the CPU to test mesh instances against,
+// starting at the first level that's at most this wide
+const uint32_t HI_Z_READBACK_WIDTH = 256;
+// local size of hiz.comp in both directions
+const uint32_t HI_Z_GROUP_SIZE = 8;
+#pragma endregion OCCLUSION CULLING
+
+#pragma region --- LIGHTING ---
+// size of the light ring of each frame in flight
+const uint32_t MAX_LIGHTS = 8192;
+// amounts of point lights lighting the meshes L cycles through, J measures every one of them with and without clusters
+const array<uint32_t, 5> LIGHT_BENCHMARK_COUNTS = { 0, 256, 1024, 4096, 8192 };
+// clusters across, down and into the distance, same as in cluster.comp and mesh.frag
+const uint32_t CLUSTER_GRID_X = 16;
+const uint32_t CLUSTER_GRID_Y = 9;
+const uint32_t CLUSTER_GRID_Z = 24;
+// lights past this many in one cluster get dropped from it, cluster.comp counts them in LightHeader::droppedLights.
+// the densest clusters get a bit over 500 of the 8192 lights on a 32:9 screen, so the largest benchmark drops none
+const uint32_t MAX_LIGHTS_PER_CLUSTER = 1023;
+// local size of cluster.comp
+const uint32_t CLUSTER_GROUP_SIZE = 64;
+// the slices get spread out between these, in view space,
+// fragments in front of the near plane use the first slice and fragments past the far plane the last one
+const float CLUSTER_NEAR_PLANE = 1.0f;
+const float CLUSTER_FAR_PLANE = 300.0f;
+// the lights drift around a box in front of the camera, covering the row of meshes and the nearer part of the grid and the city
+const float LIGHT_FIELD_WIDTH = 200.0f;
+const float LIGHT_FIELD_BOTTOM = -1.5f;
+const float LIGHT_FIELD_TOP = 6.0f;
+const float LIGHT_FIELD_NEAR = 2.0f;
+const float LIGHT_FIELD_FAR = 290.0f;
+// how far a light strays from its spot
+const float LIGHT_DRIFT = 3.0f;
+const float LIGHT_MIN_RADIUS = 2.0f;
+const float LIGHT_MAX_RADIUS = 6.0f;
+// frames J gives every combination to settle, and then averages the GPU time over
+const uint32_t LIGHT_SWEEP_WARMUP_FRAMES = 30;
+const uint32_t LIGHT_SWEEP_FRAMES = 120;
+#pragma endregion LIGHTING
+
+#pragma region --- HUD ---
+// quads the instance ring of each frame in flight has room for, the HUD needs well under a thousand
+const uint32_t MAX_HUD_QUADS = 2048;
+// screen pixels per texel of the glyph atlas
+const float HUD_SCALE = 2.0f;
+// frames the numbers on the HUD get averaged over, so they can be read
+const uint32_t HUD_AVERAGE_FRAMES = 30;
+#pragma endregion HUD
+
+#pragma region --- LOGGING ---
+// severity masks F4 cycles through
+const array<uint32_t, 3> LOG_SEVERITY_PRESETS = {
+	LOG_SEVERITY_ALL,
+	LOG_SEVERITY_WARNING | LOG_SEVERITY_ERROR,
+	LOG_SEVERITY_ERROR
+};
+// messages with the same id beyond this amount per window get suppressed
+const uint32_t LOG_RATE_LIMIT_MESSAGES = 10;
+// in milliseconds
+const uint32_t LOG_RATE_LIMIT_WINDOW = 1000;
+#pragma endregion LOGGING
+
+#pragma region --- HOST MEMORY ---
+// frames to render before the host memory usage counts as the steady state
+// the first frames still make one-off allocations in the driver
+const uint32_t HOST_MEMORY_WARMUP_FRAMES = 120;
+#pragma endregion HOST MEMORY
 #pragma endregion CONSTANTS
 
 #pragma region --- STRUCTS ---
@@ -91,27 +349,386 @@ struct SwapChainSupportDetails {
 	vector<VkSurfaceFormatKHR> formats;
 	vector<VkPresentModeKHR> presentModes;
 };
+
+enum class BlendMode {
+	NONE,
+	ALPHA,
+	ADDITIVE
+};
+
+// what differs between the graphics pipelines, all of them share the render pass and the rest of the fixed functions
+struct PipelineDescription {
+	vector<char> vertShaderCode;
+	vector<char> fragShaderCode;
+	VkPipelineLayout layout;
+	vector<VkVertexInputBindingDescription> vertexBindings;
+	vector<VkVertexInputAttributeDescription> vertexAttributes;
+	BlendMode blendMode = BlendMode::NONE;
+	bool depthTest = false;
+	bool depthWrite = false;
+};
+
+enum class ScenePipeline : uint8_t {
+	// depth tested and written
+	OPAQUE,
+	// depth tested, blended on top without writing depth
+	TRANSPARENT,
+	COUNT
+};
+
+// one triangle of the scene, in normalized device coordinates
+struct SceneDraw {
+	float x, y;
+	float scale;
+	// 0 is closest to the camera
+	float depth;
+	uint32_t material;
+	ScenePipeline pipeline;
+};
+
+// what main() made of the command line
+struct LaunchOptions {
+	// plays a recorded command trace back instead of running the simulation
+	optional<string> replayPath;
+	uint32_t replayLoops = DEFAULT_REPLAY_LOOPS;
+	// no window, renders to a headless surface instead, only together with a replay
+	bool headless = false;
+	// loads the assets one after the other on the main thread, to compare against loading them all at once
+	bool synchronousAssets = false;
+};
+
+// destroys objects once the frames that might still use them have finished on the GPU
+// frames are numbered in submission order and finish in that order on the queue,
+// so an object retired after frame N was submitted is safe to destroy once frame N's fence got signaled
+struct DeletionQueue {
+	void push(uint64_t lastUsedFrame, function<void()>&& destroy) {
+		pending.push_back({ lastUsedFrame, move(destroy) });
+	}
+
+	// destroys everything that was retired no later than the given frame
+	void flush(uint64_t completedFrame) {
+		while (!pending.empty() && pending.front().lastUsedFrame <= completedFrame)
+		{
+			pending.front().destroy();
+			pending.pop_front();
+		}
+	}
+
+	// only for when the device is idle
+	void flushAll() {
+		flush(UINT64_MAX);
+	}
+
+	size_t size() const {
+		return pending.size();
+	}
+
+private:
+	struct Entry {
+		uint64_t lastUsedFrame;
+		function<void()> destroy;
+	};
+
+	deque<Entry> pending;
+};
+
+#pragma region --- FRAME PACING ---
+// see PresentationModes.md for which present mode each policy ends up using
+enum class PresentPolicy {
+	// MAILBOX (or IMMEDIATE), paced to the refresh rate of the display
+	LOWEST_LATENCY,
+	// FIFO, the presentation engine blocks us on vertical blank
+	POWER_SAVING,
+	// MAILBOX (or IMMEDIATE), paced to a user chosen frame cap
+	FIXED_CAP
+};
+
+const char* presentPolicyName(PresentPolicy policy) {
+	switch (policy)
+	{
+	case PresentPolicy::LOWEST_LATENCY:
+		return "lowest latency";
+	case PresentPolicy::POWER_SAVING:
+		return "power saving";
+	case PresentPolicy::FIXED_CAP:
+		return "fixed cap";
+	}
+
+	return "unknown";
+}
+
+const char* presentModeName(VkPresentModeKHR presentMode) {
+	switch (presentMode)
+	{
+	case VK_PRESENT_MODE_IMMEDIATE_KHR:
+		return "IMMEDIATE";
+	case VK_PRESENT_MODE_MAILBOX_KHR:
+		return "MAILBOX";
+	case VK_PRESENT_MODE_FIFO_KHR:
+		return "FIFO";
+	case VK_PRESENT_MODE_FIFO_RELAXED_KHR:
+		return "FIFO_RELAXED";
+	default:
+		return "OTHER";
+	}
+}
+
+// paces the CPU to a target frame rate instead of letting it busy-render
+// sleeps for the bulk of the remaining frame time and spins for the last bit,
+// as sleep granularity of most OSes is too coarse to hit a deadline on its own
+class FrameLimiter {
+public:
+	void setTargetFps(double fps) {
+		period = fps > 0.0
+			? chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(1.0 / fps))
+			: chrono::steady_clock::duration::zero();
+		nextDeadline = chrono::steady_clock::now();
+	}
+
+	// blocks until the next frame is allowed to start
+	// returns the time spent waiting
+	chrono::steady_clock::duration wait() {
+		auto start = chrono::steady_clock::now();
+
+		if (period == chrono::steady_clock::duration::zero())
+		{
+			return chrono::steady_clock::duration::zero();
+		}
+
+		nextDeadline += period;
+
+		// we fell behind by more than a frame, don't try to catch up by rushing frames
+		if (start > nextDeadline + period)
+		{
+			nextDeadline = start;
+			return chrono::steady_clock::duration::zero();
+		}
+
+		if (nextDeadline - start > SPIN_MARGIN)
+		{
+			this_thread::sleep_until(nextDeadline - SPIN_MARGIN);
+		}
+
+		while (chrono::steady_clock::now() < nextDeadline)
+		{
+			this_thread::yield();
+		}
+
+		return chrono::steady_clock::now() - start;
+	}
+
+private:
+	static constexpr chrono::microseconds SPIN_MARGIN{ 1500 };
+
+	chrono::steady_clock::duration period = chrono::steady_clock::duration::zero();
+	chrono::steady_clock::time_point nextDeadline = chrono::steady_clock::now();
+};
+
+// frame timings accumulated over one reporting interval
+struct FrameStats {
+	uint32_t frameCount = 0;
+	double frameTimeSum = 0.0;
+	double frameTimeMin = 0.0;
+	double frameTimeMax = 0.0;
+	// time spent recording and submitting, without the pacing wait
+	double cpuTimeSum = 0.0;
+	double pacingWaitSum = 0.0;
+
+	// input-to-present latency of frames that consumed new input
+	uint32_t latencyCount = 0;
+	double latencySum = 0.0;
+	double latencyMax = 0.0;
+
+	// GPU time of the frames that had timestamps available
+	uint32_t gpuTimeCount = 0;
+	double gpuTimeSum = 0.0;
+	// frames that ran their compute work on the compute queue, and how long that took of the ones with timestamps
+	uint32_t asyncComputeFrames = 0;
+	uint32_t computeTimeCount = 0;
+	double computeTimeSum = 0.0;
+
+	// time the render thread spent recording capture copies and handing finished ones to the writer
+	double captureTimeSum = 0.0;
+	uint32_t capturedFrames = 0;
+	// frames that weren't captured because every readback buffer was still busy
+	uint32_t droppedCaptures = 0;
+
+	uint64_t sceneDrawSum = 0;
+	uint64_t pipelineBindSum = 0;
+	uint64_t materialBindSum = 0;
+	// pipeline and material binds the same draws would have needed in submission order
+	uint64_t unsortedBindSum = 0;
+	// building the keys and sorting them
+	double drawSortTimeSum = 0.0;
+	// fragment shader invocations of the scene per rendered pixel, of the frames that had statistics available
+	uint32_t overdrawCount = 0;
+	double overdrawSum = 0.0;
+
+	uint64_t spriteSum = 0;
+	uint64_t spriteDrawSum = 0;
+	// sorting the sprites, writing their vertices and recording the draws
+	double spriteTimeSum = 0.0;
+
+	uint64_t meshInstanceSum = 0;
+	// instances left after frustum culling
+	uint64_t meshVisibleSum = 0;
+	// instances of those hidden behind the depth of an earlier frame
+	uint64_t meshOccludedSum = 0;
+	// refitting or rebuilding the hierarchy and culling it
+	double cullTimeSum = 0.0;
+	uint64_t meshDrawSum = 0;
+	uint64_t meshTriangleSum = 0;
+	// triangles the same instances would have needed at full detail
+	uint64_t meshFullTriangleSum = 0;
+	uint64_t lodSwitchSum = 0;
+	// picking levels of detail, writing the instances and recording the draws
+	double meshTimeSum = 0.0;
+
+	uint64_t lightSum = 0;
+	// moving the lights and recording their binning
+	double lightTimeSum = 0.0;
+
+	// laying out the HUD, streaming its instances and recording its draw
+	double hudTimeSum = 0.0;
+
+	// what a replayed trace issued in place of the scene, the meshes and the sprites
+	uint64_t replayedDrawSum = 0;
+	uint64_t replayedTriangleSum = 0;
+	// decoding the trace and recording its commands
+	double replayTimeSum = 0.0;
+
+	// frames that executed the scene as it was recorded before, and frames that had to record it again
+	uint32_t staticSceneReuses = 0;
+	uint32_t staticSceneRecords = 0;
+	// what recording the reused scenes took back when they were recorded, which is what reusing them saved
+	double staticSceneSavedSum = 0.0;
+
+	void addFrame(double frameTimeMs, double cpuTimeMs, double pacingWaitMs) {
+		frameTimeMin = frameCount == 0 ? frameTimeMs : min(frameTimeMin, frameTimeMs);
+		frameTimeMax = max(frameTimeMax, frameTimeMs);
+		frameTimeSum += frameTimeMs;
+		cpuTimeSum += cpuTimeMs;
+		pacingWaitSum += pacingWaitMs;
+		frameCount++;
+	}
+
+	void addLatency(double latencyMs) {
+		latencySum += latencyMs;
+		latencyMax = max(latencyMax, latencyMs);
+		latencyCount++;
+	}
+
+	void addGpuTime(double gpuTimeMs) {
+		gpuTimeSum += gpuTimeMs;
+		gpuTimeCount++;
+	}
+};
+#pragma endregion FRAME PACING
+
+#pragma region --- DYNAMIC RESOLUTION ---
+// picks the render scale that keeps the GPU time of a frame within the budget
+// GPU time scales roughly with the amount of pixels, so the scale per axis follows the square root of budget / GPU time
+struct ResolutionScaler {
+	bool enabled = true;
+
+	// returns true when the scale changed
+	bool addGpuTime(double gpuTimeMs, double budgetMs) {
+		// smoothed, a single slow frame shouldn't drop the resolution
+		smoothedGpuTime = sampleCount == 0 ? gpuTimeMs : smoothedGpuTime + (gpuTimeMs - smoothedGpuTime) * SMOOTHING;
+		sampleCount++;
+
+		if (!enabled || ++framesSinceAdjustment < RENDER_SCALE_ADJUST_INTERVAL || smoothedGpuTime <= 0.0)
+		{
+			return false;
+		}
+		framesSinceAdjustment = 0;
+
+		double ratio = budgetMs / smoothedGpuTime;
+		// only go up when there's clearly room for it, otherwise it keeps bouncing around the budget
+		if (ratio >= 1.0 && ratio < RAISE_THRESHOLD)
+		{
+			return false;
+		}
+
+		float target = scale * static_cast<float>(sqrt(ratio));
+		target = clamp(target, scale - MAX_RENDER_SCALE_STEP, scale + MAX_RENDER_SCALE_STEP);
+		return setScale(target);
+	}
+
+	bool setScale(float newScale) {
+		newScale = clamp(newScale, MIN_RENDER_SCALE, MAX_RENDER_SCALE);
+		if (newScale == scale)
+		{
+			return false;
+		}
+
+		scale = newScale;
+		return true;
+	}
+
+	float getScale() const {
+		return scale;
+	}
+
+private:
+	static constexpr double SMOOTHING = 0.1;
+	static constexpr double RAISE_THRESHOLD = 1.2;
+
+	float scale = MAX_RENDER_SCALE;
+	double smoothedGpuTime = 0.0;
+	uint64_t sampleCount = 0;
+	uint32_t framesSinceAdjustment = 0;
+};
+#pragma endregion DYNAMIC RESOLUTION
 #pragma endregion STRUCTS
 
 
 
 class EmergineApp {
 public:
+	explicit EmergineApp(const LaunchOptions& options) : options(options) {}
+
+	// an exception out of the main loop skips past stopSimulation(), and a joinable thread would terminate on destruction
+	~EmergineApp() {
+		stopSimulation();
+	}
+
 	void run() {
+		initLogger();
 		initWindow();
 		initVulkan();
+		if (options.replayPath.has_value())
+		{
+			startReplay(options.replayPath.value());
+		}
 		mainLoop();
 		cleanup();
 	}
 
 private:
 	#pragma region --- CLASS MEMBERS ---
-	// the window holding the application
-	GLFWwindow* window;
+	// declared first so it's destroyed last,
+	// the validation layers can still report messages while everything else gets destroyed
+	Logger logger;
+	// handed to every vulkan call that takes allocation callbacks
+	// declared right after the logger, so it outlives every vulkan object
+	HostAllocator hostAllocator;
+	// hostAllocator.allocationCount() at the previous stats report
+	uint64_t hostAllocationsReported = 0;
+	// frames rendered so far, used to mark the steady state of the host memory
+	uint64_t framesRendered = 0;
+	// index into LOG_SEVERITY_PRESETS, warnings and errors until F4 asks for more
+	size_t logSeverityPreset = 1;
+	LaunchOptions options;
+
+	// the window holding the application, stays null when running headless
+	GLFWwindow* window = nullptr;
 
 	#pragma region --- VULKAN CLASS MEMBERS ---
 	// the vulkan instance
 	VkInstance instance;
+	// 1.2 when the loader supports it, for timeline semaphores, 1.0 otherwise
+	uint32_t apiVersion = VK_API_VERSION_1_0;
 	// vulkan debug messenger
 	VkDebugUtilsMessengerEXT debugMessenger;
 	// window surface (aka the canvas of the window on which things get drawn)
@@ -123,58 +740,838 @@ private:
 	VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
 	// logical device
 	VkDevice device;
+	// what the frame loop calls on the device, loaded right after creating it
+	DeviceDispatch dispatch;
+	// set by the key callback, run at the start of the next frame
+	bool dispatchBenchmarkRequested = false;
 	#pragma endregion DEVICES
+
+	#pragma region --- DEVICE MEMORY ---
+	// usage and budget of every memory heap, all device memory gets allocated through it
+	ResidencyManager residency;
+	// the driver reports budget and usage of the whole heap, otherwise only the engine's own allocations count
+	bool memoryBudgetSupported = false;
+	#pragma endregion DEVICE MEMORY
 	
 	#pragma region --- QUEUES ---
 	VkQueue graphicsQueue;
 	// presentation queue
 	VkQueue presentQueue;
+	// a second queue for compute work to overlap the graphics queue with
+	// stays null without timeline semaphores or a queue to spare
+	VkQueue computeQueue = VK_NULL_HANDLE;
+	// graphics and compute family, resources both queues use are shared between them
+	array<uint32_t, 2> sharedQueueFamilies{};
 	#pragma endregion QUEUES
 
 	#pragma region --- SWAP CHAIN ---
-	VkSwapchainKHR swapChain;
+	VkSwapchainKHR swapChain = VK_NULL_HANDLE;
 	vector<VkImage> swapChainImages;
 	VkFormat swapChainImageFormat;
 	VkExtent2D swapChainExtent;
 	#pragma endregion SWAP CHAIN
 
 	vector<VkImageView> swapChainImageViews;
+	VkPresentModeKHR swapChainPresentMode;
+	VkImageUsageFlags swapChainImageUsage = 0;
+	// set on window resizes and when acquiring or presenting reports the swap chain no longer matches the surface
+	bool swapChainOutdated = false;
+	// swap chains and everything built on them wait here until the frames using them are done
+	DeletionQueue deletionQueue;
+
+	#pragma region --- SCENE TARGET ---
+	// the scene gets rendered into this image at the render scale and then upscaled into the swap chain image
+	// it's sized for the maximum scale and lower scales only use its top left corner,
+	// so changing the scale doesn't need any new images, framebuffers or pipelines
+	struct SceneTarget {
+		VkImage image = VK_NULL_HANDLE;
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		VkImageView imageView = VK_NULL_HANDLE;
+		VkFramebuffer framebuffer = VK_NULL_HANDLE;
+		// only needed during the render pass, so it's never stored
+		VkImage depthImage = VK_NULL_HANDLE;
+		VkDeviceMemory depthMemory = VK_NULL_HANDLE;
+		VkImageView depthImageView = VK_NULL_HANDLE;
+		// full size of the image
+		VkExtent2D extent{};
+		// farthest depth of every 2x2 texels of the depth buffer, then of every 2x2 texels of the level before
+		// stays null when the device can't build it
+		VkImage hiZImage = VK_NULL_HANDLE;
+		VkDeviceMemory hiZMemory = VK_NULL_HANDLE;
+		// one per level
+		vector<VkImageView> hiZViews;
+		VkDescriptorPool hiZDescriptorPool = VK_NULL_HANDLE;
+		vector<VkDescriptorSet> hiZDescriptorSets;
+		// of the first level
+		VkExtent2D hiZExtent{};
+		// the coarse levels get copied into these, one per frame in flight, mapped for as long as they exist
+		array<VkBuffer, MAX_FRAMES_IN_FLIGHT> hiZReadbackBuffers{};
+		array<VkDeviceMemory, MAX_FRAMES_IN_FLIGHT> hiZReadbackMemory{};
+		array<const float*, MAX_FRAMES_IN_FLIGHT> hiZReadbackData{};
+		// in floats
+		size_t hiZReadbackCapacity = 0;
+	};
+	SceneTarget sceneTarget;
+	// part of the scene target that's currently rendered to
+	VkExtent2D renderExtent{};
+	// linear when the format supports it
+	VkFilter upscaleFilter = VK_FILTER_NEAREST;
+	ResolutionScaler resolutionScaler;
+	#pragma endregion SCENE TARGET
+
+	#pragma region --- GPU TIMING ---
+	// a begin and an end timestamp per frame in flight, around the scene pass and the compute work before it
+	VkQueryPool timestampQueryPool = VK_NULL_HANDLE;
+	// nanoseconds per timestamp tick
+	double timestampPeriod = 0.0;
+	// the graphics queue may only support fewer than 64 bits
+	uint64_t timestampMask = 0;
+	// whether the queries of each frame in flight have been written since they were created
+	array<bool, MAX_FRAMES_IN_FLIGHT> timestampsWritten{};
+	// fragment shader invocations of the scene, one query per frame in flight
+	// stays null when the device doesn't support pipeline statistics
+	VkQueryPool statisticsQueryPool = VK_NULL_HANDLE;
+	array<bool, MAX_FRAMES_IN_FLIGHT> statisticsWritten{};
+	// render area of the frame each query was written for
+	array<VkExtent2D, MAX_FRAMES_IN_FLIGHT> statisticsExtents{};
+	#pragma endregion GPU TIMING
+
+	#pragma region --- FRAME CAPTURE ---
+	struct CaptureSlot {
+		VkBuffer buffer = VK_NULL_HANDLE;
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		// mapped for as long as the buffer exists
+		uint8_t* mapped = nullptr;
+		// set from recording the copy until the writer is done with it
+		atomic<bool> busy{ false };
+		// frame the copy was submitted with, 0 once it has been handed to the writer
+		uint64_t frameNumber = 0;
+		VkExtent2D extent{};
+	};
+	array<CaptureSlot, CAPTURE_RING_SIZE> captureSlots;
+	// size of each readback buffer, enough for the swap chain extent they were created for
+	VkDeviceSize captureSlotSize = 0;
+	// readback memory isn't always host coherent, then it has to be invalidated before reading
+	bool captureMemoryCoherent = true;
+	size_t nextCaptureSlot = 0;
+	// toggled by the key callback, applied at the start of the next frame
+	bool captureRequested = false;
+	bool captureActive = false;
+	FrameCaptureWriter captureWriter;
+	// writer stats at the previous stats report
+	uint64_t captureFramesReported = 0;
+	double captureWriteTimeReported = 0.0;
+	#pragma endregion FRAME CAPTURE
+
+	#pragma region --- COMMAND TRACE ---
+	// toggled by the key callback, applied at the start of the next frame
+	bool traceRequested = false;
+	CommandTraceWriter traceWriter;
+	// a replay takes the place of the simulation for the whole run
+	CommandTraceReader traceReader;
+	bool replaying = false;
+	// set once the last loop is done
+	bool replayFinished = false;
+	size_t replayFrame = 0;
+	uint32_t replayLoop = 0;
+	// whether the frame being replayed built the depth pyramid
+	bool replayHiZ = false;
+	// over the whole replay for the summary at the end, frameStats get reset with every report
+	FrameStats replayStats;
+	#pragma endregion COMMAND TRACE
 
 	#pragma region --- GFX PIPELINE ---
 	VkRenderPass renderPass;
+	VkFormat depthFormat;
+	// every pipeline layout and descriptor set layout, made from the SPIR-V of the shaders using them
+	PipelineLayoutCache layoutCache;
 	VkPipelineLayout pipelineLayout;
-	VkPipeline graphicsPipeline;
+	// one per ScenePipeline
+	array<VkPipeline, static_cast<size_t>(ScenePipeline::COUNT)> scenePipelines{};
 	#pragma endregion GFX PIPELINE
+
+	#pragma region --- SCENE ---
+	// the original triangle, plus whatever the benchmark added
+	vector<SceneDraw> sceneDraws = { { 0.0f, 0.0f, 1.0f, 0.5f, 0, ScenePipeline::OPAQUE } };
+	DrawQueue drawQueue;
+	// F10 turns the sorting off, to compare against submission order
+	bool sortSceneDraws = true;
+	// index into SCENE_BENCHMARK_COUNTS
+	size_t sceneBenchmark = 0;
+	bool sceneBenchmarkChanged = false;
+	mt19937 sceneRandom{ 4321 };
+	#pragma endregion SCENE
+
+	#pragma region --- MESHES ---
+	// a part of the shared vertex and index buffers
+	struct LoadedMesh {
+		string name;
+		// full detail first, firstIndex already points into the shared index buffer
+		vector<MeshLod> lods;
+		int32_t vertexOffset;
+		// bounding sphere, to fit every mesh into the same space
+		array<float, 3> center;
+		float radius;
+		array<float, 3> halfExtent;
+	};
+	vector<LoadedMesh> meshes;
+	VkPipelineLayout meshPipelineLayout;
+	VkPipeline meshPipeline;
+	// every mesh in one buffer each
+	VkBuffer meshVertexBuffer;
+	VkDeviceMemory meshVertexBufferMemory;
+	VkBuffer meshIndexBuffer;
+	VkDeviceMemory meshIndexBufferMemory;
+	// to read them back into a command trace
+	VkDeviceSize meshVertexBufferSize = 0;
+	VkDeviceSize meshIndexBufferSize = 0;
+	chrono::steady_clock::time_point meshStartTime;
+	// the city is built from it, it comes after the imported meshes
+	uint32_t cubeMesh = 0;
+
+	struct MeshInstance {
+		uint32_t mesh;
+		array<float, 3> position;
+		// per axis, 1 fits the mesh in a sphere with a radius of 1
+		array<float, 3> size;
+		// added to the rotation angle, so a grid of them doesn't spin in lockstep
+		float phase;
+		// multiplies MESH_ROTATION_SPEED, 0 keeps it standing still at its phase
+		float spin;
+		// level of detail it got drawn with last frame, to apply hysteresis to
+		uint8_t lod;
+		uint32_t cullObject;
+	};
+	vector<MeshInstance> meshInstances;
+	// payloads are indices into meshInstances
+	BoundingVolumeHierarchy meshBvh{ min<size_t>(max(thread::hardware_concurrency(), 2u) - 1, MAX_CULL_WORKERS) };
+	vector<uint32_t> visibleMeshInstances;
+	// matches the per instance vertex input of the mesh pipeline
+	struct MeshInstanceData {
+		// already moved so the mesh spins around its own center
+		array<float, 3> position;
+		array<float, 3> scale;
+		// cosine and sine of the angle around y
+		array<float, 2> rotation;
+	};
+	// one instance ring per frame in flight, mapped for as long as they exist
+	array<VkBuffer, MAX_FRAMES_IN_FLIGHT> meshInstanceBuffers{};
+	array<VkDeviceMemory, MAX_FRAMES_IN_FLIGHT> meshInstanceBufferMemory{};
+	array<MeshInstanceData*, MAX_FRAMES_IN_FLIGHT> meshInstanceData{};
+	// instances per mesh and level of detail, turned into offsets into the instance ring
+	vector<uint32_t> meshDrawOffsets;
+	// index into MESH_BENCHMARK_COUNTS, one past the end is the city
+	size_t meshBenchmark = 0;
+	bool meshBenchmarkChanged = false;
+	// F12 turns it off, to compare against drawing everything at full detail
+	bool meshLodEnabled = true;
+	mt19937 meshRandom{ 5678 };
+	#pragma endregion MESHES
+
+	#pragma region --- LIGHTING ---
+	// matches the start of the Lights buffer in cluster.comp and mesh.frag, the lights follow right after it
+	struct LightHeader {
+		uint32_t lightCount;
+		uint32_t clustered;
+		// added up by cluster.comp, read back and cleared by the CPU the next time the ring gets written
+		uint32_t droppedLights;
+		uint32_t padding;
+		array<float, 4> clusterScale;
+	};
+	// matches Light in cluster.comp and mesh.frag
+	struct LightData {
+		array<float, 4> positionRadius;
+		array<float, 4> color;
+	};
+	struct PointLight {
+		// the spot it drifts around, in view space
+		array<float, 3> center;
+		float radius;
+		array<float, 3> color;
+		// of the drift
+		float phase;
+		float speed;
+	};
+	// the first LIGHT_BENCHMARK_COUNTS[lightBenchmark] of them get drawn
+	vector<PointLight> pointLights;
+	// set 0 of the mesh pipeline and of the binning, the lights and the clusters of one frame in flight
+	VkDescriptorSetLayout lightingDescriptorSetLayout = VK_NULL_HANDLE;
+	VkDescriptorPool lightingDescriptorPool = VK_NULL_HANDLE;
+	array<VkDescriptorSet, MAX_FRAMES_IN_FLIGHT> lightingDescriptorSets{};
+	// one light ring per frame in flight, mapped for as long as they exist
+	array<VkBuffer, MAX_FRAMES_IN_FLIGHT> lightBuffers{};
+	array<VkDeviceMemory, MAX_FRAMES_IN_FLIGHT> lightBufferMemory{};
+	array<LightHeader*, MAX_FRAMES_IN_FLIGHT> lightHeaders{};
+	// only ever touched by cluster.comp and mesh.frag
+	array<VkBuffer, MAX_FRAMES_IN_FLIGHT> clusterBuffers{};
+	array<VkDeviceMemory, MAX_FRAMES_IN_FLIGHT> clusterBufferMemory{};
+	VkPipelineLayout lightBinningPipelineLayout = VK_NULL_HANDLE;
+	VkPipeline lightBinningPipeline = VK_NULL_HANDLE;
+	// index into LIGHT_BENCHMARK_COUNTS
+	size_t lightBenchmark = 0;
+	// K turns it off, every fragment goes through every light then
+	bool clusteredLighting = true;
+	mt19937 lightRandom{ 9012 };
+	// J steps through every light count, clustered and then not, one after the other
+	struct LightSweep {
+		bool active = false;
+		// light count times two, plus one when not clustered
+		size_t step = 0;
+		uint32_t frame = 0;
+		uint32_t gpuTimeCount = 0;
+		double gpuTimeSum = 0.0;
+		// average GPU time of every step so far
+		vector<double> results;
+		// most lights the clusters dropped in a single frame, of the step and of every step so far
+		uint32_t droppedLights = 0;
+		vector<uint32_t> droppedResults;
+		// what L, K and F6 had picked before
+		size_t previousBenchmark = 0;
+		bool previousClustered = true;
+		bool previousScalerEnabled = false;
+		float previousScale = MAX_RENDER_SCALE;
+	};
+	LightSweep lightSweep;
+	#pragma endregion LIGHTING
+
+	#pragma region --- OCCLUSION CULLING ---
+	// the depth format has to be sampled from a compute shader on the graphics queue
+	bool hiZSupported = false;
+	// O turns it off, to compare against frustum culling alone
+	bool hiZEnabled = true;
+	VkDescriptorSetLayout hiZDescriptorSetLayout = VK_NULL_HANDLE;
+	VkPipelineLayout hiZPipelineLayout = VK_NULL_HANDLE;
+	VkPipeline hiZPipeline = VK_NULL_HANDLE;
+	VkSampler hiZSampler = VK_NULL_HANDLE;
+	// what the depth pyramid of each frame in flight was built from, the readback buffers hold the levels from firstLevel on
+	struct HiZReadback {
+		bool written = false;
+		array<float, 16> viewProjection{};
+		// the render scale can change without a new scene target, so only corners of the depth buffer and every level are used
+		VkExtent2D renderExtent{};
+		vector<VkExtent2D> levels;
+		uint32_t firstLevel = 0;
+		// in floats, per level from firstLevel on
+		vector<size_t> offsets;
+	};
+	array<HiZReadback, MAX_FRAMES_IN_FLIGHT> hiZReadbacks;
+	// kept around so recording doesn't allocate
+	vector<VkBufferImageCopy> hiZCopyRegions;
+	// camera the meshes of the frame being recorded got drawn with
+	array<float, 16> meshViewProjection{};
+	#pragma endregion OCCLUSION CULLING
+
+	#pragma region --- SPRITES ---
+	SpriteBatch spriteBatch;
+	VkDescriptorSetLayout spriteDescriptorSetLayout;
+	VkPipelineLayout spritePipelineLayout;
+	// one per SpriteBlend
+	array<VkPipeline, static_cast<size_t>(SpriteBlend::COUNT)> spritePipelines{};
+
+	// static, shared by every sprite draw
+	VkBuffer spriteIndexBuffer;
+	VkDeviceMemory spriteIndexBufferMemory;
+	// one vertex ring per frame in flight, mapped for as long as they exist
+	array<VkBuffer, MAX_FRAMES_IN_FLIGHT> spriteVertexBuffers{};
+	array<VkDeviceMemory, MAX_FRAMES_IN_FLIGHT> spriteVertexBufferMemory{};
+	array<SpriteVertex*, MAX_FRAMES_IN_FLIGHT> spriteVertices{};
+
+	// null handles while evicted
+	struct SpriteTexture {
+		VkImage image = VK_NULL_HANDLE;
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		VkImageView imageView = VK_NULL_HANDLE;
+		// implicitly freed with the descriptor pool, or given back to it when the texture gets replaced
+		VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+		// width and height, halved every time the texture gets degraded
+		uint32_t size = SPRITE_TEXTURE_SIZE;
+		ResidencyManager::ResourceId residencyId = 0;
+	};
+	vector<SpriteTexture> spriteTextures;
+	VkSampler spriteSampler;
+	VkDescriptorPool spriteDescriptorPool;
+	// block compressed when the device can sample any of the formats TextureCompressor writes, RGBA8 otherwise
+	VkFormat spriteTextureFormat = VK_FORMAT_R8G8B8A8_UNORM;
+	optional<BlockFormat> spriteBlockFormat;
+	// the ones with linear filtering and optimal tiling, empty without the textureCompressionBC feature
+	set<BlockFormat> supportedBlockFormats;
+	// over every sprite texture uploaded so far, degraded ones included
+	uint64_t spriteTextureBytes = 0;
+	uint64_t spriteTextureUncompressedBytes = 0;
+	double spriteTextureEncodeTime = 0.0;
+	// set by the key callback, run at the start of the next frame
+	bool textureBenchmarkRequested = false;
+
+	// moving sprites for benchmarking, F8 changes the amount
+	// owned by the simulation thread
+	struct SpriteAgent {
+		float x, y;
+		// where the previous step left it
+		float previousX, previousY;
+		float velocityX, velocityY;
+		float size;
+		uint32_t color;
+		uint16_t texture;
+		SpriteBlend blend;
+	};
+	vector<SpriteAgent> spriteAgents;
+	// index into SPRITE_BENCHMARK_COUNTS
+	size_t spriteBenchmark = 0;
+	bool spriteBenchmarkChanged = false;
+	mt19937 spriteRandom{ 1234 };
+	#pragma endregion SPRITES
+
+	#pragma region --- ASSET LOADING ---
+	// coroutines that have to continue on the main thread, because they submit to the graphics queue or use the command pool,
+	// get resumed from here while the main thread waits in syncWait
+	JobQueue mainThreadJobs;
+	// by path, read by loadAssets and used up by the pipelines created during setup
+	map<string, vector<char>> preloadedShaderCode;
+	// counted by the asset workers
+	atomic<size_t> assetsLoaded{ 0 };
+	atomic<uint64_t> assetBytesLoaded{ 0 };
+	#pragma endregion ASSET LOADING
+
+	#pragma region --- SIMULATION ---
+	// what the render thread gets to see of the agents after a step
+	struct SpriteAgentState {
+		float previousX, previousY;
+		float x, y;
+		float size;
+		uint32_t color;
+		uint16_t texture;
+		SpriteBlend blend;
+	};
+	struct WorldSnapshot {
+		// when the step was due, the positions are where the agents are at that moment
+		chrono::steady_clock::time_point time;
+		uint64_t step = 0;
+		vector<SpriteAgentState> agents;
+	};
+	// steps at SIMULATION_RATE on its own, publishing a snapshot after every step
+	// the render thread only ever takes the newest one, so neither waits for the other
+	thread simulationThread;
+	atomic<bool> simulationRunning{ false };
+	TripleBuffer<WorldSnapshot> worldSnapshots;
+	// set by the render thread, picked up by the simulation thread at its next step
+	atomic<uint32_t> requestedSpriteAgents{ 0 };
+	// the agents bounce off the edges of the swap chain, which the render thread recreates whenever it likes
+	atomic<VkExtent2D> simulationBounds{ VkExtent2D{ WIDTH, HEIGHT } };
+	// counted by the simulation thread, read by the stats report
+	atomic<uint64_t> simulationSteps{ 0 };
+	atomic<uint64_t> simulationSkippedSteps{ 0 };
+	atomic<uint64_t> simulationTimeNs{ 0 };
+	// their values at the previous stats report
+	uint64_t simulationStepsReported = 0;
+	uint64_t simulationSkippedStepsReported = 0;
+	uint64_t simulationTimeNsReported = 0;
+	#pragma endregion SIMULATION
+
+	#pragma region --- HUD ---
+	// H toggles it
+	bool hudEnabled = true;
+	PerfHud hud;
+	// uses the sprite pipeline layout, it's a single texture and the same pixel transform
+	VkPipeline hudPipeline;
+	VkImage hudAtlasImage;
+	VkDeviceMemory hudAtlasMemory;
+	VkImageView hudAtlasView;
+	// the glyphs are pixel art, so nearest
+	VkSampler hudSampler;
+	VkDescriptorPool hudDescriptorPool;
+	// implicitly freed with the descriptor pool
+	VkDescriptorSet hudDescriptorSet;
+	// one instance ring per frame in flight, mapped for as long as they exist
+	array<VkBuffer, MAX_FRAMES_IN_FLIGHT> hudInstanceBuffers{};
+	array<VkDeviceMemory, MAX_FRAMES_IN_FLIGHT> hudInstanceBufferMemory{};
+	array<HudInstance*, MAX_FRAMES_IN_FLIGHT> hudInstances{};
+	// of the latest frame with timestamps, for the graph
+	double lastGpuTime = 0.0;
+	// what the HUD itself cost the CPU last frame, shown on the HUD
+	double lastHudTime = 0.0;
+	#pragma endregion HUD
+
+	#pragma region --- SHADER HOT RELOAD ---
+	// recompiles and rebuilds on its own thread whenever a shader source changes
+	ShaderWatcher shaderWatcher;
+	// found when hot reload starts, it doesn't start without one
+	filesystem::path glslcPath;
+	// built by the watcher thread, swapped in by the render loop at the start of a frame
+	array<atomic<VkPipeline>, static_cast<size_t>(ScenePipeline::COUNT)> reloadedScenePipelines{};
+	array<atomic<VkPipeline>, static_cast<size_t>(SpriteBlend::COUNT)> reloadedSpritePipelines{};
+	atomic<VkPipeline> reloadedMeshPipeline{ VK_NULL_HANDLE };
+	atomic<VkPipeline> reloadedHiZPipeline{ VK_NULL_HANDLE };
+	atomic<VkPipeline> reloadedLightBinningPipeline{ VK_NULL_HANDLE };
+	atomic<VkPipeline> reloadedHudPipeline{ VK_NULL_HANDLE };
+	#pragma endregion SHADER HOT RELOAD
+
+	#pragma region --- COMMANDS ---
+	VkCommandPool commandPool;
+	// one per frame in flight
+	// implicitly destroyed with the command pool
+	vector<VkCommandBuffer> commandBuffers;
+
+	// with a static scene the scene pass is made of secondary command buffers, as a pass can't mix them with inline commands
+	// S turns it off, to compare against recording everything every frame
+	bool staticSceneEnabled = true;
+	// the meshes and the overlay (sprites and HUD) change every frame, so they get recorded fresh, one of each per frame in flight
+	vector<VkCommandBuffer> meshCommandBuffers;
+	vector<VkCommandBuffer> overlayCommandBuffers;
+	// the scene only gets recorded again when something it depends on changed since, one per frame in flight,
+	// as it can't be re-recorded while an earlier frame might still be executing it
+	struct StaticScene {
+		VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+		// sceneVersion and extents it was recorded with
+		uint64_t version = 0;
+		VkExtent2D swapChainExtent{};
+		VkExtent2D renderExtent{};
+		// the stats recordScene added, added again every time it gets reused
+		uint64_t pipelineBinds = 0;
+		uint64_t materialBinds = 0;
+		uint64_t unsortedBinds = 0;
+		double recordTime = 0.0;
+	};
+	array<StaticScene, MAX_FRAMES_IN_FLIGHT> staticScenes{};
+	// bumped whenever the scene draws, their order or their pipelines change,
+	// and whenever the scene target gets created again, its framebuffer is part of the inheritance info
+	uint64_t sceneVersion = 1;
+	// secondary command buffers can only be executed while a query is running with this feature
+	bool inheritedQueriesSupported = false;
+	#pragma endregion COMMANDS
+
+	#pragma region --- SYNCHRONIZATION ---
+	// one per frame in flight
+	vector<VkSemaphore> imageAvailableSemaphores;
+	// one per swap chain image, as the presentation engine may still be waiting on it
+	// when the same frame in flight comes around again
+	vector<VkSemaphore> renderFinishedSemaphores;
+	// one per frame in flight, only without timeline semaphores
+	vector<VkFence> inFlightFences;
+	// number of the frame last rendering to each swap chain image
+	vector<uint64_t> imageFrameNumbers;
+	// with Vulkan 1.2 every frame is a value on these instead, there's no fence per frame in flight to keep track of
+	bool timelineSemaphores = false;
+	// the graphics queue signals these with the frame number, once the scene is done and once the whole frame is
+	VkSemaphore sceneTimeline = VK_NULL_HANDLE;
+	VkSemaphore frameTimeline = VK_NULL_HANDLE;
+	// the compute queue signals this with the number of the frame its work belonged to
+	VkSemaphore computeTimeline = VK_NULL_HANDLE;
+	size_t currentFrame = 0;
+	// number of frames submitted so far, the last one submitted has this number
+	uint64_t submittedFrames = 0;
+	// number of the frame last submitted from each frame in flight
+	array<uint64_t, MAX_FRAMES_IN_FLIGHT> frameNumbers{};
+	// every frame up to this number has finished on the GPU
+	uint64_t completedFrames = 0;
+	// last frame that had compute work on the compute queue, 0 if none had
+	uint64_t lastComputeFrame = 0;
+	// lastComputeFrame as it was when each frame in flight got submitted
+	array<uint64_t, MAX_FRAMES_IN_FLIGHT> computeFrameNumbers{};
+	#pragma endregion SYNCHRONIZATION
+
+	#pragma region --- ASYNC COMPUTE ---
+	// the depth pyramid gets built on the compute queue, while the graphics queue upscales and presents,
+	// and the next frame starts on its vertices
+	bool asyncComputeSupported = false;
+	// C turns it off, to compare against building it on the graphics queue
+	bool asyncComputeEnabled = true;
+	VkCommandPool computeCommandPool = VK_NULL_HANDLE;
+	// one per frame in flight
+	vector<VkCommandBuffer> computeCommandBuffers;
+	// with async compute a frame gets submitted in two parts, the scene goes into commandBuffers and the rest into these,
+	// so the compute queue can start as soon as the scene is done
+	vector<VkCommandBuffer> upscaleCommandBuffers;
+	// a begin and an end timestamp per frame in flight, on the compute queue
+	VkQueryPool computeTimestampQueryPool = VK_NULL_HANDLE;
+	uint64_t computeTimestampMask = 0;
+	array<bool, MAX_FRAMES_IN_FLIGHT> computeTimestampsWritten{};
+	#pragma endregion ASYNC COMPUTE
 	#pragma endregion VULKAN CLASS MEMBERS
+
+	#pragma region --- FRAME PACING ---
+	PresentPolicy presentPolicy = PresentPolicy::LOWEST_LATENCY;
+	// set by the key callback, applied at the start of the next frame
+	PresentPolicy requestedPresentPolicy = PresentPolicy::LOWEST_LATENCY;
+	int frameCap = DEFAULT_FRAME_CAP;
+	int displayRefreshRate = FALLBACK_REFRESH_RATE;
+	FrameLimiter frameLimiter;
+
+	FrameStats frameStats;
+	chrono::steady_clock::time_point lastFrameStart;
+	chrono::steady_clock::time_point lastStatsReport;
+
+	// time of the oldest input event that no frame has picked up yet
+	optional<chrono::steady_clock::time_point> pendingInputTime;
+	#pragma endregion FRAME PACING
 	#pragma endregion CLASS MEMBERS
 
 	#pragma region --- INIT WINDOW ---
 	void initWindow() {
+		// renders to a headless surface instead
+		if (options.headless)
+		{
+			return;
+		}
+
 		// initialize glfw
 		glfwInit();
 
 		// tell glfw to not use OpenGL
 		glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-		// tell glfw to disable resizing windows (for now)
-		// TODO: enable resizing windows
-		glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
 
 		window = glfwCreateWindow(WIDTH, HEIGHT, TITLE, nullptr, nullptr);
+
+		// lets the static glfw callbacks find their way back to this instance
+		glfwSetWindowUserPointer(window, this);
+		glfwSetFramebufferSizeCallback(window, framebufferResizeCallback);
+		glfwSetKeyCallback(window, keyCallback);
+		glfwSetMouseButtonCallback(window, mouseButtonCallback);
+		glfwSetCursorPosCallback(window, cursorPosCallback);
+
+		const GLFWvidmode* videoMode = glfwGetVideoMode(glfwGetPrimaryMonitor());
+		if (videoMode != nullptr && videoMode->refreshRate > 0)
+		{
+			displayRefreshRate = videoMode->refreshRate;
+		}
+	}
+
+	// not every driver reports VK_ERROR_OUT_OF_DATE_KHR after a resize, so keep track of it ourselves
+	static void framebufferResizeCallback(GLFWwindow* window, int width, int height) {
+		reinterpret_cast<EmergineApp*>(glfwGetWindowUserPointer(window))->swapChainOutdated = true;
+	}
+
+	#pragma region --- INPUT ---
+	static void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods) {
+		auto app = reinterpret_cast<EmergineApp*>(glfwGetWindowUserPointer(window));
+		app->registerInput();
+
+		if (action != GLFW_PRESS)
+		{
+			return;
+		}
+
+		switch (key)
+		{
+		case GLFW_KEY_F1:
+			app->requestedPresentPolicy = PresentPolicy::LOWEST_LATENCY;
+			break;
+		case GLFW_KEY_F2:
+			app->requestedPresentPolicy = PresentPolicy::POWER_SAVING;
+			break;
+		case GLFW_KEY_F3:
+			app->requestedPresentPolicy = PresentPolicy::FIXED_CAP;
+			break;
+		case GLFW_KEY_EQUAL:
+			app->setFrameCap(app->frameCap + 10);
+			break;
+		case GLFW_KEY_MINUS:
+			app->setFrameCap(app->frameCap - 10);
+			break;
+		case GLFW_KEY_F4:
+			app->cycleLogSeverity();
+			break;
+		case GLFW_KEY_F5:
+			app->toggleLogType(LOG_TYPE_GENERAL);
+			break;
+		case GLFW_KEY_F6:
+			app->toggleDynamicResolution();
+			break;
+		case GLFW_KEY_F7:
+			app->captureRequested = !app->captureRequested;
+			break;
+		case GLFW_KEY_F8:
+			app->spriteBenchmark = (app->spriteBenchmark + 1) % SPRITE_BENCHMARK_COUNTS.size();
+			app->spriteBenchmarkChanged = true;
+			break;
+		case GLFW_KEY_F9:
+			app->sceneBenchmark = (app->sceneBenchmark + 1) % SCENE_BENCHMARK_COUNTS.size();
+			app->sceneBenchmarkChanged = true;
+			break;
+		case GLFW_KEY_F10:
+			app->sortSceneDraws = !app->sortSceneDraws;
+			app->sceneVersion++;
+			app->logger.log(LOG_SEVERITY_INFO, string("scene draw sorting ") + (app->sortSceneDraws ? "on" : "off"));
+			break;
+		case GLFW_KEY_F11:
+			app->meshBenchmark = (app->meshBenchmark + 1) % (MESH_BENCHMARK_COUNTS.size() + 1);
+			app->meshBenchmarkChanged = true;
+			break;
+		case GLFW_KEY_F12:
+			app->meshLodEnabled = !app->meshLodEnabled;
+			app->logger.log(LOG_SEVERITY_INFO, string("mesh levels of detail ") + (app->meshLodEnabled ? "on" : "off"));
+			break;
+		case GLFW_KEY_O:
+			app->hiZEnabled = !app->hiZEnabled;
+			app->logger.log(LOG_SEVERITY_INFO, string("occlusion culling ") + (app->hiZEnabled ? "on" : "off"));
+			break;
+		case GLFW_KEY_C:
+			app->asyncComputeEnabled = !app->asyncComputeEnabled;
+			app->logger.log(LOG_SEVERITY_INFO, string("async compute ") + (app->asyncComputeEnabled ? "on" : "off")
+				+ (app->asyncComputeSupported ? "" : ", but not supported by this device"));
+			break;
+		case GLFW_KEY_H:
+			app->hudEnabled = !app->hudEnabled;
+			break;
+		case GLFW_KEY_T:
+			app->traceRequested = !app->traceRequested;
+			break;
+		case GLFW_KEY_D:
+			app->dispatchBenchmarkRequested = true;
+			break;
+		case GLFW_KEY_B:
+			app->textureBenchmarkRequested = true;
+			break;
+		case GLFW_KEY_L:
+			app->lightBenchmark = (app->lightBenchmark + 1) % LIGHT_BENCHMARK_COUNTS.size();
+			app->logger.log(LOG_SEVERITY_INFO, to_string(LIGHT_BENCHMARK_COUNTS[app->lightBenchmark]) + " point lights");
+			break;
+		case GLFW_KEY_K:
+			app->clusteredLighting = !app->clusteredLighting;
+			app->logger.log(LOG_SEVERITY_INFO, string("clustered lighting ") + (app->clusteredLighting ? "on" : "off"));
+			break;
+		case GLFW_KEY_J:
+			app->startLightSweep();
+			break;
+		case GLFW_KEY_S:
+			app->staticSceneEnabled = !app->staticSceneEnabled;
+			app->logger.log(LOG_SEVERITY_INFO, string("static scene command buffers ") + (app->staticSceneEnabled ? "on" : "off"));
+			break;
+		}
+	}
+
+	static void mouseButtonCallback(GLFWwindow* window, int button, int action, int mods) {
+		reinterpret_cast<EmergineApp*>(glfwGetWindowUserPointer(window))->registerInput();
+	}
+
+	static void cursorPosCallback(GLFWwindow* window, double x, double y) {
+		reinterpret_cast<EmergineApp*>(glfwGetWindowUserPointer(window))->registerInput();
+	}
+
+	// only the oldest unhandled event counts, as that one waited the longest to be shown
+	void registerInput() {
+		if (!pendingInputTime.has_value())
+		{
+			pendingInputTime = chrono::steady_clock::now();
+		}
 	}
+	#pragma endregion INPUT
 	#pragma endregion INIT WINDOW
 
+	#pragma region --- INIT LOGGER ---
+	void initLogger() {
+		logger.setSeverityMask(LOG_SEVERITY_PRESETS[logSeverityPreset]);
+		logger.setTypeMask(LOG_TYPE_ALL);
+		logger.setRateLimit(LOG_RATE_LIMIT_MESSAGES, LOG_RATE_LIMIT_WINDOW);
+	}
+
+	void cycleLogSeverity() {
+		logSeverityPreset = (logSeverityPreset + 1) % LOG_SEVERITY_PRESETS.size();
+		logger.setSeverityMask(LOG_SEVERITY_PRESETS[logSeverityPreset]);
+		logger.log(LOG_SEVERITY_INFO, "log severity mask set to " + to_string(LOG_SEVERITY_PRESETS[logSeverityPreset]));
+	}
+
+	void toggleLogType(LogType type) {
+		logger.setTypeMask(logger.getTypeMask() ^ type);
+		logger.log(LOG_SEVERITY_INFO, "log type mask set to " + to_string(logger.getTypeMask()));
+	}
+	#pragma endregion INIT LOGGER
+
 	#pragma region --- INIT VULKAN ---
 	void initVulkan() {
+		HostAllocator::ArenaScope arenaScope(HostArena::DEVICE);
+
 		createInstance();
 		setupDebugMessenger();
 		createSurface();
 		pickPhysicalDevice();
 		createLogicalDevice();
-		createSwapChain();
-		createImageViews();
+		// the mesh uploads need it
+		createCommandPool();
+		loadAssets();
+		{
+			HostAllocator::ArenaScope swapChainScope(HostArena::SWAPCHAIN);
+			createSwapChain();
+			createImageViews();
+		}
 		createRenderPass();
 		createGraphicsPipeline();
+		createHiZPipeline();
+		{
+			HostAllocator::ArenaScope swapChainScope(HostArena::SWAPCHAIN);
+			createSceneTarget();
+		}
+		createCommandBuffers();
+		createSyncObjects();
+		createTimestampQueries();
+		createStatisticsQueries();
+		createSpriteResources();
+		// the mesh pipeline layout needs its descriptor set layout
+		createLightingResources();
+		createMeshResources();
+		createHudResources();
+		// from here on the shader files only change through hot reload, which has to read them again
+		preloadedShaderCode.clear();
+
+		PipelineLayoutCache::Stats layoutStats = layoutCache.getStats();
+		logger.log(LOG_SEVERITY_INFO, to_string(layoutStats.requests) + " pipeline layout requests shared "
+			+ to_string(layoutStats.pipelineLayouts) + " pipeline layouts and " + to_string(layoutStats.setLayouts) + " descriptor set layouts");
+	}
+
+	#pragma region --- ASSET LOADING ---
+	// everything setup reads from disk, the shaders and the meshes, all of it in flight at once.
+	// with --sync-assets the same loads run one after the other on the main thread instead
+	void loadAssets() {
+		auto start = chrono::steady_clock::now();
+
+		size_t threads = options.synchronousAssets ? 0 : ASSET_LOADER_THREADS;
+		{
+			JobSystem jobs(threads);
+			syncWait(loadAssetsAsync(jobs), mainThreadJobs);
+		}
+
+		double milliseconds = toMilliseconds(chrono::steady_clock::now() - start);
+		ostringstream report;
+		report << "loaded " << assetsLoaded.load() << " assets (" << toMegabytes(assetBytesLoaded.load()) << " MB) in " << milliseconds << " ms, "
+			<< (threads > 0 ? "all at once on " + to_string(threads) + " threads" : string("one after the other"));
+		logger.log(LOG_SEVERITY_INFO, report.str());
+	}
+
+	Task<void> loadAssetsAsync(JobSystem& jobs) {
+		vector<Task<void>> loads;
+		// every entry exists before whenAll starts any of the loads, each load only fills in its own
+		for (const auto& source : SHADER_SOURCES)
+		{
+			loads.push_back(loadShaderCode(jobs, source.second, preloadedShaderCode[source.second]));
+		}
+		loads.push_back(loadMeshes(jobs));
+
+		co_await whenAll(move(loads));
+
+		// optional shaders that weren't there, shaderCode reads them when a feature turns out to need them after all
+		erase_if(preloadedShaderCode, [](const auto& entry) {
+			return entry.second.empty();
+		});
+	}
+
+	Task<void> loadShaderCode(JobSystem& jobs, string path, vector<char>& code) {
+		co_await jobs.schedule();
+
+		if (OPTIONAL_SHADER_PATHS.count(path) > 0 && !filesystem::exists(path))
+		{
+			co_return;
+		}
+		code = readShaderFile(path);
+		countLoadedAsset(path);
+	}
+
+	// from any thread
+	void countLoadedAsset(const string& path) {
+		error_code error;
+		uintmax_t size = filesystem::file_size(path, error);
+		assetsLoaded.fetch_add(1, memory_order_relaxed);
+		assetBytesLoaded.fetch_add(error ? 0 : static_cast<uint64_t>(size), memory_order_relaxed);
 	}
+	#pragma endregion ASSET LOADING
 
 	#pragma region --- CREATE INSTANCE ---
 	void createInstance() {
@@ -192,7 +1589,9 @@ private:
 		appInfo.engineVersion = VERSION;
 		// minimum api version
 		// see VkVersions.md
-		appInfo.apiVersion = VK_API_VERSION_1_0;
+		// 1.2 only adds timeline semaphores here, everything else keeps working on 1.0
+		apiVersion = supportedApiVersion();
+		appInfo.apiVersion = apiVersion;
 		#pragma endregion APP INFO
 		
 		#pragma region --- CREATE INFO ---
@@ -223,7 +1622,7 @@ private:
 		}
 		#pragma endregion VALIDATION LAYERS
 		
-		if (vkCreateInstance(&createInfo, nullptr, &instance) != VK_SUCCESS) {
+		if (vkCreateInstance(&createInfo, allocator(VK_OBJECT_TYPE_INSTANCE), &instance) != VK_SUCCESS) {
 			yeet broken_shoe("failed to create instance!");
 		}
 		#pragma endregion CREATE INFO
@@ -258,12 +1657,34 @@ private:
 		return true;
 	}
 
-	vector<const char*> getRequiredExtensions() {
-		uint32_t glfwExtensionCount = 0;
-		const char** glfwExtensions;
-		glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+	// 1.0 loaders don't have vkEnumerateInstanceVersion
+	static uint32_t supportedApiVersion() {
+		auto enumerateInstanceVersion = (PFN_vkEnumerateInstanceVersion)vkGetInstanceProcAddr(nullptr, "vkEnumerateInstanceVersion");
+		uint32_t version = VK_API_VERSION_1_0;
+		if (enumerateInstanceVersion != nullptr && enumerateInstanceVersion(&version) != VK_SUCCESS)
+		{
+			version = VK_API_VERSION_1_0;
+		}
+		if (version >= VK_API_VERSION_1_2)
+		{
+			return VK_API_VERSION_1_2;
+		}
+		return version >= VK_API_VERSION_1_1 ? VK_API_VERSION_1_1 : VK_API_VERSION_1_0;
+	}
 
-		vector<const char*> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+	vector<const char*> getRequiredExtensions() {
+		vector<const char*> extensions;
+		if (options.headless)
+		{
+			extensions = { VK_KHR_SURFACE_EXTENSION_NAME, VK_EXT_HEADLESS_SURFACE_EXTENSION_NAME };
+		}
+		else
+		{
+			uint32_t glfwExtensionCount = 0;
+			const char** glfwExtensions;
+			glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+			extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+		}
 
 		if (enableValidationLayers)
 		{
@@ -293,7 +1714,19 @@ private:
 
 	#pragma region --- CREATE SURFACE ---
 	void createSurface() {
-		if (glfwCreateWindowSurface(instance, window, nullptr, &surface) != VK_SUCCESS)
+		if (options.headless)
+		{
+			// presents to nowhere, CPU drivers like lavapipe and SwiftShader support it
+			VkHeadlessSurfaceCreateInfoEXT createInfo{};
+			createInfo.sType = VK_STRUCTURE_TYPE_HEADLESS_SURFACE_CREATE_INFO_EXT;
+			if (CreateHeadlessSurfaceEXT(instance, &createInfo, allocator(VK_OBJECT_TYPE_SURFACE_KHR), &surface) != VK_SUCCESS)
+			{
+				yeet broken_shoe("failed to create headless surface!");
+			}
+			return;
+		}
+
+		if (glfwCreateWindowSurface(instance, window, allocator(VK_OBJECT_TYPE_SURFACE_KHR), &surface) != VK_SUCCESS)
 		{
 			yeet broken_shoe("failed to create window surface!");
 		}
@@ -342,6 +1775,29 @@ private:
 			yeet broken_shoe("failed to find a suitable GPU!");
 		}
 		#pragma endregion SUITABILITY CHECKs
+
+		#pragma region --- MEMORY HEAPS ---
+		VkPhysicalDeviceMemoryProperties memoryProperties;
+		vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+		residency.init(memoryProperties);
+
+		for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++)
+		{
+			const VkMemoryHeap& heap = memoryProperties.memoryHeaps[i];
+			print << "\theap " << i << '\t' << heap.size / (1024 * 1024) << " MB"
+				<< ((heap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) ? " device local" : "") << endl;
+		}
+
+		// the budget gets queried through vkGetPhysicalDeviceMemoryProperties2, core since 1.1 on both the instance and the device
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+		memoryBudgetSupported = apiVersion >= VK_API_VERSION_1_1 && properties.apiVersion >= VK_API_VERSION_1_1
+			&& isDeviceExtensionAvailable(physicalDevice, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+		if (!memoryBudgetSupported)
+		{
+			logger.log(LOG_SEVERITY_WARNING, "no memory budget from the driver, assuming " + to_string(static_cast<int>(ResidencyManager::FALLBACK_BUDGET * 100.0)) + "% of every heap is available");
+		}
+		#pragma endregion MEMORY HEAPS
 	}
 
 	bool isDeviceSuitable(VkPhysicalDevice device) {
@@ -462,6 +1918,24 @@ private:
 		return requiredExtensions.empty();
 	}
 
+	// for extensions the engine can do without
+	bool isDeviceExtensionAvailable(VkPhysicalDevice device, const char* extensionName) {
+		uint32_t extensionCount;
+		vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+
+		vector<VkExtensionProperties> availableExtensions(extensionCount);
+		vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, availableExtensions.data());
+
+		for (const VkExtensionProperties& extension : availableExtensions)
+		{
+			if (strcmp(extension.extensionName, extensionName) == 0)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
 	SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device) {
 		SwapChainSupportDetails details;
 
@@ -499,6 +1973,27 @@ private:
 		// TODO? store indices as class member?
 		QueueFamilyIndices indices = findQueueFamilies(physicalDevice);
 
+		#pragma region --- TIMELINE SEMAPHORES ---
+		// both the instance and the device have to be on 1.2
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+		VkPhysicalDeviceVulkan12Features supportedFeatures12{};
+		supportedFeatures12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+		if (apiVersion >= VK_API_VERSION_1_2 && properties.apiVersion >= VK_API_VERSION_1_2)
+		{
+			VkPhysicalDeviceFeatures2 supportedFeatures2{};
+			supportedFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+			supportedFeatures2.pNext = &supportedFeatures12;
+			vkGetPhysicalDeviceFeatures2(physicalDevice, &supportedFeatures2);
+		}
+		timelineSemaphores = supportedFeatures12.timelineSemaphore == VK_TRUE;
+		if (!timelineSemaphores)
+		{
+			logger.log(LOG_SEVERITY_WARNING, "no timeline semaphores, falling back to fences and building the depth pyramid on the graphics queue");
+		}
+		#pragma endregion TIMELINE SEMAPHORES
+
 		#pragma region --- QUEUE CREATE INFO ---
 		vector<VkDeviceQueueCreateInfo> queueCreateInfos;
 		set<uint32_t> uniqueQueueFamilies = {
@@ -506,15 +2001,27 @@ private:
 			indices.presentFamily.value()
 		};
 
-		float queuePriority = 1.0f;
+		// family and index within it
+		optional<pair<uint32_t, uint32_t>> computeQueueSlot;
+		if (timelineSemaphores)
+		{
+			computeQueueSlot = findComputeQueue(indices.graphicsFamily.value());
+		}
+		if (computeQueueSlot.has_value())
+		{
+			uniqueQueueFamilies.insert(computeQueueSlot->first);
+		}
+
+		// the compute queue can be the second one of the graphics family
+		array<float, 2> queuePriorities = { 1.0f, 1.0f };
 		for (uint32_t queueFamily : uniqueQueueFamilies)
 		{
 			// create new queue
 			VkDeviceQueueCreateInfo queueCreateInfo{};
 			queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
 			queueCreateInfo.queueFamilyIndex = queueFamily;
-			queueCreateInfo.queueCount = 1;
-			queueCreateInfo.pQueuePriorities = &queuePriority;
+			queueCreateInfo.queueCount = computeQueueSlot.has_value() && computeQueueSlot->first == queueFamily ? computeQueueSlot->second + 1 : 1;
+			queueCreateInfo.pQueuePriorities = queuePriorities.data();
 
 			// add new queue to list of queues
 			queueCreateInfos.push_back(queueCreateInfo);
@@ -522,7 +2029,18 @@ private:
 
 		#pragma endregion QUEUE CREATE INFO
 
+		VkPhysicalDeviceFeatures supportedFeatures;
+		vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
+
 		VkPhysicalDeviceFeatures deviceFeatures{};
+		// optional, only used to measure overdraw
+		deviceFeatures.pipelineStatisticsQuery = supportedFeatures.pipelineStatisticsQuery;
+		// optional as well, without it overdraw isn't measured while the scene is static
+		deviceFeatures.inheritedQueries = supportedFeatures.inheritedQueries;
+		inheritedQueriesSupported = supportedFeatures.inheritedQueries == VK_TRUE;
+		// optional, sprite textures stay RGBA8 without it
+		deviceFeatures.textureCompressionBC = supportedFeatures.textureCompressionBC;
+		checkTextureCompressionSupport(supportedFeatures.textureCompressionBC == VK_TRUE);
 		
 		#pragma region --- DEVICE CREATE INFO ---
 		VkDeviceCreateInfo createInfo{};
@@ -532,8 +2050,21 @@ private:
 
 		createInfo.pEnabledFeatures = &deviceFeatures;
 
-		createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-		createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+		VkPhysicalDeviceVulkan12Features deviceFeatures12{};
+		deviceFeatures12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+		deviceFeatures12.timelineSemaphore = VK_TRUE;
+		if (timelineSemaphores)
+		{
+			createInfo.pNext = &deviceFeatures12;
+		}
+
+		vector<const char*> enabledExtensions = deviceExtensions;
+		if (memoryBudgetSupported)
+		{
+			enabledExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+		}
+		createInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size());
+		createInfo.ppEnabledExtensionNames = enabledExtensions.data();
 
 		// ignored by up-to-date implementations,
 		// but assigned for more backwards compatibility
@@ -548,13 +2079,72 @@ private:
 		}
 		#pragma endregion DEVICE CREATE INFO
 
-		if (vkCreateDevice(physicalDevice, &createInfo, nullptr, &device) != VK_SUCCESS)
+		if (vkCreateDevice(physicalDevice, &createInfo, allocator(VK_OBJECT_TYPE_DEVICE), &device) != VK_SUCCESS)
 		{
 			yeet broken_shoe("failed to create logical device!");
 		}
 
 		vkGetDeviceQueue(device, indices.graphicsFamily.value(), 0, &graphicsQueue);
 		vkGetDeviceQueue(device, indices.presentFamily.value(), 0, &presentQueue);
+
+		sharedQueueFamilies = { indices.graphicsFamily.value(), indices.graphicsFamily.value() };
+		if (computeQueueSlot.has_value())
+		{
+			vkGetDeviceQueue(device, computeQueueSlot->first, computeQueueSlot->second, &computeQueue);
+			sharedQueueFamilies[1] = computeQueueSlot->first;
+			asyncComputeSupported = true;
+			logger.log(LOG_SEVERITY_INFO, "async compute on queue " + to_string(computeQueueSlot->second) + " of family " + to_string(computeQueueSlot->first));
+		}
+		else if (timelineSemaphores)
+		{
+			logger.log(LOG_SEVERITY_WARNING, "no second queue for compute work, building the depth pyramid on the graphics queue");
+		}
+
+		const char* missingFunction = dispatch.load(device);
+		if (missingFunction != nullptr)
+		{
+			yeet broken_shoe(string("failed to load ") + missingFunction + "!");
+		}
+
+		layoutCache.init(device, allocator(VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT), allocator(VK_OBJECT_TYPE_PIPELINE_LAYOUT));
+
+		updateMemoryBudget();
+	}
+
+	// a family without graphics is usually a separate engine on the GPU, which can really run next to the graphics queue
+	// otherwise a second queue of the graphics family at least lets the driver interleave both
+	optional<pair<uint32_t, uint32_t>> findComputeQueue(uint32_t graphicsFamily) {
+		uint32_t queueFamilyCount = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+		vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+		vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilies.data());
+
+		for (uint32_t i = 0; i < queueFamilyCount; i++)
+		{
+			if ((queueFamilies[i].queueFlags & VK_QUEUE_COMPUTE_BIT) && !(queueFamilies[i].queueFlags & VK_QUEUE_GRAPHICS_BIT))
+			{
+				return make_pair(i, 0u);
+			}
+		}
+
+		const VkQueueFamilyProperties& graphics = queueFamilies[graphicsFamily];
+		if ((graphics.queueFlags & VK_QUEUE_COMPUTE_BIT) && graphics.queueCount > 1)
+		{
+			return make_pair(graphicsFamily, 1u);
+		}
+
+		return nullopt;
+	}
+
+	// concurrent sharing spares transferring ownership between the queues every frame
+	template <typename CreateInfo>
+	void shareWithComputeQueue(CreateInfo& createInfo) {
+		if (asyncComputeSupported && sharedQueueFamilies[0] != sharedQueueFamilies[1])
+		{
+			createInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+			createInfo.queueFamilyIndexCount = static_cast<uint32_t>(sharedQueueFamilies.size());
+			createInfo.pQueueFamilyIndices = sharedQueueFamilies.data();
+		}
 	}
 	#pragma endregion CREATE LOGICAL DEVICE
 
@@ -594,9 +2184,19 @@ private:
 		createInfo.imageArrayLayers = 1;
 
 		// specifies the kind of operations the images will be used for
-		// here: render directly to them --> VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT
+		// render directly to them --> VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT
 		// render to other image first (e.g. for post-processing) --> something like VK_IMAGE_USAGE_TRANSFER_DST_BIT
-		createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+		// here: the scene target gets upscaled into them with a blit
+		if (!(swapChainSupport.capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_DST_BIT))
+		{
+			yeet broken_shoe("swap chain images can't be used as transfer destination!");
+		}
+		createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+		// frame capture copies the presented images out
+		if (captureRequested && (swapChainSupport.capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_SRC_BIT))
+		{
+			createInfo.imageUsage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+		}
 		#pragma endregion IMAGE DETAILS
 
 		#pragma region --- QUEUE FAMILIES ---
@@ -637,11 +2237,12 @@ private:
 		// VK_TRUE --> don't care about color of obscured pixels, but higher performance
 		createInfo.clipped = VK_TRUE;
 
-		// TODO: needed for window resizing
-		createInfo.oldSwapchain = VK_NULL_HANDLE;
+		// when recreating, the driver can hand over resources from the previous swap chain,
+		// and images already acquired from it can still be presented
+		createInfo.oldSwapchain = swapChain;
 		#pragma endregion SWAP CHAIN CREATE INFO
 
-		if (vkCreateSwapchainKHR(device, &createInfo, nullptr, &swapChain) != VK_SUCCESS)
+		if (vkCreateSwapchainKHR(device, &createInfo, allocator(VK_OBJECT_TYPE_SWAPCHAIN_KHR), &swapChain) != VK_SUCCESS)
 		{
 			yeet broken_shoe("failed to create swap chain!");
 		}
@@ -652,6 +2253,8 @@ private:
 
 		swapChainImageFormat = surfaceFormat.format;
 		swapChainExtent = extent;
+		swapChainPresentMode = presentMode;
+		swapChainImageUsage = createInfo.imageUsage;
 	}
 
 	VkSurfaceFormatKHR chooseSwapSurfaceFormat(const vector<VkSurfaceFormatKHR>& availableFormats) {
@@ -671,6 +2274,13 @@ private:
 
 	VkPresentModeKHR chooseSwapPresentMode(const vector<VkPresentModeKHR>& availablePresentModes) {
 		// see PresentationModes.md for explanation
+		// FIFO is the only mode that is guaranteed to be available
+		if (presentPolicy == PresentPolicy::POWER_SAVING)
+		{
+			return VK_PRESENT_MODE_FIFO_KHR;
+		}
+
+		// never blocks on vertical blank and never tears
 		for (const VkPresentModeKHR& availablePresentMode : availablePresentModes) {
 			if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR)
 			{
@@ -678,6 +2288,14 @@ private:
 			}
 		}
 
+		// never blocks on vertical blank, but may tear
+		for (const VkPresentModeKHR& availablePresentMode : availablePresentModes) {
+			if (availablePresentMode == VK_PRESENT_MODE_IMMEDIATE_KHR)
+			{
+				return availablePresentMode;
+			}
+		}
+
 		return VK_PRESENT_MODE_FIFO_KHR;
 	}
 
@@ -690,8 +2308,13 @@ private:
 		}
 		else // TODO: redundant else due to always returning in if?
 		{
-			int width, height;
-			glfwGetFramebufferSize(window, &width, &height);
+			// a headless surface has no size of its own
+			int width = WIDTH;
+			int height = HEIGHT;
+			if (window != nullptr)
+			{
+				glfwGetFramebufferSize(window, &width, &height);
+			}
 
 			VkExtent2D actualExtent = {
 				static_cast<uint32_t>(width),
@@ -739,7 +2362,7 @@ private:
 			createInfo.subresourceRange.layerCount = 1;
 			#pragma endregion CREATE INFO
 
-			if (vkCreateImageView(device, &createInfo, nullptr, &swapChainImageViews[i]) != VK_SUCCESS)
+			if (vkCreateImageView(device, &createInfo, allocator(VK_OBJECT_TYPE_IMAGE_VIEW), &swapChainImageViews[i]) != VK_SUCCESS)
 			{
 				yeet broken_shoe("failed to create image views!");
 			}
@@ -774,10 +2397,27 @@ private:
 		//		VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL: Images used as color attachment
 		//		VK_IMAGE_LAYOUT_PRESENT_SRC_KHR: Images to be presented in the swap chain
 		//		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL: Images to be used as destination for a memory copy operation
+		// the scene target gets blitted into the swap chain image right after the render pass
 		colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-		colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+		colorAttachment.finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
 		#pragma endregion COLOR ATTACHMENT
 		
+		#pragma region --- DEPTH ATTACHMENT ---
+		depthFormat = findDepthFormat();
+		hiZSupported = checkHiZSupport();
+
+		VkAttachmentDescription depthAttachment{};
+		depthAttachment.format = depthFormat;
+		depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+		depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		// the depth pyramid gets built from it after drawing has finished, otherwise it's not used anymore
+		depthAttachment.storeOp = hiZSupported ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+		#pragma endregion DEPTH ATTACHMENT
+
 		#pragma region --- COLOR ATTACHMENT REFERENCE ---
 		VkAttachmentReference colorAttachmentRef{};
 		// index of attachment
@@ -785,39 +2425,272 @@ private:
 		colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 		#pragma endregion COLOR ATTACHMENT REFERENCE
 
+		#pragma region --- DEPTH ATTACHMENT REFERENCE ---
+		VkAttachmentReference depthAttachmentRef{};
+		depthAttachmentRef.attachment = 1;
+		depthAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+		#pragma endregion DEPTH ATTACHMENT REFERENCE
+
 		#pragma region --- SUBPASS ---
 		VkSubpassDescription subpass{};
 		subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
 		subpass.colorAttachmentCount = 1;
 		subpass.pColorAttachments = &colorAttachmentRef;
+		// a subpass can only use a single depth (+ stencil) attachment
+		subpass.pDepthStencilAttachment = &depthAttachmentRef;
 		#pragma endregion SUBPASS
 
+		#pragma region --- SUBPASS DEPENDENCIES ---
+		array<VkSubpassDependency, 2> dependencies{};
+		// the scene target is shared by all frames in flight,
+		// so don't overwrite it while the previous frame is still rendering to it or upscaling from it
+		// the same goes for the depth buffer, which the previous frame might still be testing against or building its depth pyramid from
+		dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+		dependencies[0].dstSubpass = 0;
+		dependencies[0].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT
+			| VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		dependencies[0].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+		dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+		// the upscale blit has to see everything the render pass wrote
+		dependencies[1].srcSubpass = 0;
+		dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+		dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		dependencies[1].dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+		dependencies[1].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		#pragma endregion SUBPASS DEPENDENCIES
+
 		#pragma region --- RENDER PASS ---
 		VkRenderPassCreateInfo renderPassInfo{};
 		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-		renderPassInfo.attachmentCount = 1;
-		renderPassInfo.pAttachments = &colorAttachment;
+		array<VkAttachmentDescription, 2> attachments = { colorAttachment, depthAttachment };
+		renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+		renderPassInfo.pAttachments = attachments.data();
 		renderPassInfo.subpassCount = 1;
 		renderPassInfo.pSubpasses = &subpass;
+		renderPassInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
+		renderPassInfo.pDependencies = dependencies.data();
 		#pragma endregion RENDER PASS
 
-		if (vkCreateRenderPass(device, &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS)
+		if (vkCreateRenderPass(device, &renderPassInfo, allocator(VK_OBJECT_TYPE_RENDER_PASS), &renderPass) != VK_SUCCESS)
 		{
 			yeet broken_shoe("failed to create render pass!");
 		}
 	}
+
+	// the depth pyramid gets built by a compute shader sampling the depth buffer, recorded on the graphics queue
+	bool checkHiZSupport() {
+		VkFormatProperties formatProperties;
+		vkGetPhysicalDeviceFormatProperties(physicalDevice, depthFormat, &formatProperties);
+		if (!(formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT))
+		{
+			logger.log(LOG_SEVERITY_WARNING, "depth format can't be sampled, occlusion culling is off");
+			return false;
+		}
+
+		uint32_t queueFamilyCount = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+		vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+		vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilies.data());
+		if (!(queueFamilies[findQueueFamilies(physicalDevice).graphicsFamily.value()].queueFlags & VK_QUEUE_COMPUTE_BIT))
+		{
+			logger.log(LOG_SEVERITY_WARNING, "graphics queue can't run compute shaders, occlusion culling is off");
+			return false;
+		}
+
+		return true;
+	}
+
+	// the sprite textures are white with their shape in alpha, BC7 keeps its gradients best, BC3 comes close
+	void checkTextureCompressionSupport(bool featureSupported) {
+		if (featureSupported)
+		{
+			for (BlockFormat format : { BlockFormat::BC1, BlockFormat::BC3, BlockFormat::BC5, BlockFormat::BC7 })
+			{
+				VkFormatProperties formatProperties;
+				vkGetPhysicalDeviceFormatProperties(physicalDevice, toVkFormat(format), &formatProperties);
+				VkFormatFeatureFlags required = VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+				if ((formatProperties.optimalTilingFeatures & required) == required)
+				{
+					supportedBlockFormats.insert(format);
+				}
+			}
+		}
+
+		for (BlockFormat format : { BlockFormat::BC7, BlockFormat::BC3 })
+		{
+			if (supportedBlockFormats.count(format) > 0)
+			{
+				spriteBlockFormat = format;
+				spriteTextureFormat = toVkFormat(format);
+				return;
+			}
+		}
+		logger.log(LOG_SEVERITY_WARNING, "no block compressed texture formats, sprite textures stay RGBA8");
+	}
+
+	static VkFormat toVkFormat(BlockFormat format) {
+		switch (format)
+		{
+		case BlockFormat::BC1:
+			return VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+		case BlockFormat::BC3:
+			return VK_FORMAT_BC3_UNORM_BLOCK;
+		case BlockFormat::BC5:
+			return VK_FORMAT_BC5_UNORM_BLOCK;
+		case BlockFormat::BC7:
+			return VK_FORMAT_BC7_UNORM_BLOCK;
+		}
+		return VK_FORMAT_UNDEFINED;
+	}
+
+	static const char* blockFormatName(BlockFormat format) {
+		switch (format)
+		{
+		case BlockFormat::BC1:
+			return "BC1";
+		case BlockFormat::BC3:
+			return "BC3";
+		case BlockFormat::BC5:
+			return "BC5";
+		case BlockFormat::BC7:
+			return "BC7";
+		}
+		return "?";
+	}
+
+	// first of the candidates that can be a depth attachment with optimal tiling
+	VkFormat findDepthFormat() {
+		const array<VkFormat, 3> candidates = {
+			VK_FORMAT_D32_SFLOAT,
+			VK_FORMAT_D32_SFLOAT_S8_UINT,
+			VK_FORMAT_D24_UNORM_S8_UINT
+		};
+
+		for (VkFormat format : candidates)
+		{
+			VkFormatProperties properties;
+			vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &properties);
+			if (properties.optimalTilingFeatures & VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT)
+			{
+				return format;
+			}
+		}
+
+		yeet broken_shoe("failed to find a supported depth format!");
+	}
 	#pragma endregion CREATE RENDER PASSES
 
 	#pragma region --- CREATE GRAPHICS PIPELINE ---
 	void createGraphicsPipeline() {
-		#pragma region --- SHADER STAGES ---
+		createPipelineLayout();
+		for (size_t i = 0; i < scenePipelines.size(); i++)
+		{
+			scenePipelines[i] = buildGraphicsPipeline(scenePipelineDescription(static_cast<ScenePipeline>(i)));
+		}
+	}
+
+	PipelineDescription scenePipelineDescription(ScenePipeline pipeline) {
+		PipelineDescription description{};
 		// readFile returns vector<char>
-		auto vertShaderCode = readFile(VERT_SHADER_PATH);
-		auto fragShaderCode = readFile(FRAG_SHADER_PATH);
+		description.vertShaderCode = shaderCode(VERT_SHADER_PATH);
+		description.fragShaderCode = shaderCode(FRAG_SHADER_PATH);
+		description.layout = pipelineLayout;
+		description.depthTest = true;
+		description.depthWrite = pipeline == ScenePipeline::OPAQUE;
+		description.blendMode = pipeline == ScenePipeline::OPAQUE ? BlendMode::NONE : BlendMode::ALPHA;
+		return description;
+	}
+
+	void createPipelineLayout() {
+		HostAllocator::ArenaScope arenaScope(HostArena::PIPELINE_BUILD);
+
+		// vec4 transform, vec4 color, no descriptor sets
+		// both pipelines of the scene share this layout, so the pushed values survive switching between them
+		pipelineLayout = shaderLayout({ shaderCode(VERT_SHADER_PATH), shaderCode(FRAG_SHADER_PATH) }).pipelineLayout;
+	}
+
+	void createHiZPipeline() {
+		if (!hiZSupported)
+		{
+			return;
+		}
+
+		#pragma region --- PIPELINE LAYOUT ---
+		// the level before, or the depth buffer, and the level being written
+		// ivec2 sourceSize, ivec2 destinationSize
+		const PipelineLayoutCache::Layout& layout = shaderLayout({ shaderCode(HI_Z_COMP_SHADER_PATH) });
+		hiZPipelineLayout = layout.pipelineLayout;
+		hiZDescriptorSetLayout = layout.setLayouts.at(0);
+		#pragma endregion PIPELINE LAYOUT
+
+		#pragma region --- SAMPLER ---
+		// hiz.comp only uses texelFetch, but a combined image sampler needs one anyway
+		VkSamplerCreateInfo samplerInfo{};
+		samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+		samplerInfo.magFilter = VK_FILTER_NEAREST;
+		samplerInfo.minFilter = VK_FILTER_NEAREST;
+		samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.maxAnisotropy = 1.0f;
+		samplerInfo.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+		samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
+		samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+
+		if (vkCreateSampler(device, &samplerInfo, allocator(VK_OBJECT_TYPE_SAMPLER), &hiZSampler) != VK_SUCCESS)
+		{
+			yeet broken_shoe("failed to create depth pyramid sampler!");
+		}
+		#pragma endregion SAMPLER
+
+		hiZPipeline = buildComputePipeline(shaderCode(HI_Z_COMP_SHADER_PATH), hiZPipelineLayout);
+	}
+
+	// like buildGraphicsPipeline, safe to call from the shader hot reload thread
+	VkPipeline buildComputePipeline(const vector<char>& shaderCode, VkPipelineLayout layout) {
+		HostAllocator::ArenaScope arenaScope(HostArena::PIPELINE_BUILD);
+
+		checkShaderLayout(shaderLayout({ shaderCode }), layout);
+		VkShaderModule shaderModule = createShaderModule(shaderCode);
+
+		VkComputePipelineCreateInfo pipelineInfo{};
+		pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+		pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+		pipelineInfo.stage.module = shaderModule;
+		pipelineInfo.stage.pName = "main";
+		pipelineInfo.layout = layout;
+
+		VkPipeline pipeline;
+		VkResult result = vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, allocator(VK_OBJECT_TYPE_PIPELINE), &pipeline);
+		vkDestroyShaderModule(device, shaderModule, allocator(VK_OBJECT_TYPE_SHADER_MODULE));
+		if (result != VK_SUCCESS)
+		{
+			yeet broken_shoe("failed to create compute pipeline!");
+		}
+
+		return pipeline;
+	}
 
+	// only depends on the render pass and pipeline layouts, which live until shutdown,
+	// so the shader hot reload can call this from its own thread
+	VkPipeline buildGraphicsPipeline(const PipelineDescription& description) {
+		HostAllocator::ArenaScope arenaScope(HostArena::PIPELINE_BUILD);
+
+		#pragma region --- REFLECTION ---
+		// the attributes come from the C++ structs the vertices are written with, the shader only says how it reads them
+		ShaderReflection vertReflection = ShaderReflection::reflect(description.vertShaderCode);
+		vertReflection.checkVertexAttributes(description.vertexAttributes);
+		checkShaderLayout(layoutCache.get({ vertReflection, ShaderReflection::reflect(description.fragShaderCode) }), description.layout);
+		#pragma endregion REFLECTION
+
+		#pragma region --- SHADER STAGES ---
 		// shader modules only required fore pipeline creation, so only required locally
-		VkShaderModule vertShaderModule = createShaderModule(vertShaderCode);
-		VkShaderModule fragShaderModule = createShaderModule(fragShaderCode);
+		VkShaderModule vertShaderModule = createShaderModule(description.vertShaderCode);
+		VkShaderModule fragShaderModule = createShaderModule(description.fragShaderCode);
 
 		#pragma region --- VERT SHADER STAGE CREATE INFO ---
 		VkPipelineShaderStageCreateInfo vertShaderStageInfo{};
@@ -832,7 +2705,7 @@ private:
 		#pragma region --- FRAG SHADER STAGE CREATE INFO ---
 		VkPipelineShaderStageCreateInfo fragShaderStageInfo{};
 		fragShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-		fragShaderStageInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
+		fragShaderStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
 		fragShaderStageInfo.module = fragShaderModule;
 		fragShaderStageInfo.pName = "main";
 		// optional, used to specify contstants defined at pipeline creation
@@ -846,10 +2719,10 @@ private:
 		#pragma region --- VERTEX INPUT ---
 		VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
 		vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-		vertexInputInfo.vertexBindingDescriptionCount = 0;
-		vertexInputInfo.pVertexBindingDescriptions = nullptr;
-		vertexInputInfo.vertexAttributeDescriptionCount = 0;
-		vertexInputInfo.pVertexAttributeDescriptions = nullptr;
+		vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(description.vertexBindings.size());
+		vertexInputInfo.pVertexBindingDescriptions = description.vertexBindings.data();
+		vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(description.vertexAttributes.size());
+		vertexInputInfo.pVertexAttributeDescriptions = description.vertexAttributes.data();
 		#pragma endregion VERTEX INPUT
 		
 		#pragma region --- INPUT ASSEMBLY ---
@@ -868,29 +2741,15 @@ private:
 		#pragma endregion INPUT ASSEMBLY
 		
 		#pragma region --- VIEWPORT STATE ---
-		#pragma region --- VIEWPORT ---
-		VkViewport viewport{};
-		viewport.x = 0;
-		viewport.y = 0;
-		viewport.width = (float)swapChainExtent.width;
-		viewport.height = (float)swapChainExtent.height;
-		viewport.minDepth = 0.0f;
-		viewport.maxDepth = 1.0f;
-		#pragma endregion VIEWPORT
-
-		#pragma region --- SCISSOR ---
-		VkRect2D scissor{};
-		scissor.offset = { 0, 0 };
-		scissor.extent = swapChainExtent;
-		#pragma endregion SCISSOR
-
+		// viewport and scissor are dynamic state and get set while recording,
+		// so the pipeline doesn't depend on the swap chain extent and survives resizes
 		VkPipelineViewportStateCreateInfo viewportState{};
 		viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
 		// TODO: possibly required to change to 2 viewports (and scissors?) for VR? would require GPU feature
 		viewportState.viewportCount = 1;
-		viewportState.pViewports = &viewport;
+		viewportState.pViewports = nullptr;
 		viewportState.scissorCount = 1;
-		viewportState.pScissors = &scissor;
+		viewportState.pScissors = nullptr;
 		#pragma endregion VIEWPORT STATE
 		
 		#pragma region --- RASTERIZER ---
@@ -943,8 +2802,19 @@ private:
 		
 		#pragma region --- DEPTH AND STENCIL TESTING ---
 		// required when using depth and/or stencil buffer
-		// will be revisited
-		// uses VkPipelineDepthStencilStateCreateInfo
+		// the render pass has a depth attachment, so every pipeline needs this even when it doesn't test
+		VkPipelineDepthStencilStateCreateInfo depthStencil{};
+		depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+		depthStencil.depthTestEnable = description.depthTest ? VK_TRUE : VK_FALSE;
+		depthStencil.depthWriteEnable = description.depthWrite ? VK_TRUE : VK_FALSE;
+		// lower depth = closer
+		depthStencil.depthCompareOp = VK_COMPARE_OP_LESS;
+		depthStencil.depthBoundsTestEnable = VK_FALSE;
+		depthStencil.minDepthBounds = 0.0f;	// optional
+		depthStencil.maxDepthBounds = 1.0f;	// optional
+		depthStencil.stencilTestEnable = VK_FALSE;
+		depthStencil.front = {};			// optional
+		depthStencil.back = {};				// optional
 		#pragma endregion DEPTH AND STENCIL TESTING
 		
 		#pragma region --- COLOR BLENDING ---
@@ -962,6 +2832,18 @@ private:
 		colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;		// optional
 		colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;	// optional
 		colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;				// optional
+
+		if (description.blendMode != BlendMode::NONE)
+		{
+			// finalColor.rgb = newAlpha * newColor + (1 - newAlpha) * oldColor, or + oldColor when additive
+			colorBlendAttachment.blendEnable = VK_TRUE;
+			colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+			colorBlendAttachment.dstColorBlendFactor = description.blendMode == BlendMode::ADDITIVE
+				? VK_BLEND_FACTOR_ONE
+				: VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+			colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+			colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+		}
 		#pragma endregion COLOR BLEND ATTACHMENT
 		
 		#pragma region --- COLOR BLEND STATE ---
@@ -980,11 +2862,11 @@ private:
 		#pragma endregion COLOR BLENDING
 		
 		#pragma region --- DYNAMIC STATE ---
-		// will be revisited
 		// dynamicStates can besubstituted by nullptr if there are none
+		// every dynamic state has to be set in the command buffer before drawing
 		vector<VkDynamicState> dynamicStates = {
 			VK_DYNAMIC_STATE_VIEWPORT,
-			VK_DYNAMIC_STATE_LINE_WIDTH
+			VK_DYNAMIC_STATE_SCISSOR
 		};
 
 		VkPipelineDynamicStateCreateInfo dynamicState{};
@@ -992,21 +2874,6 @@ private:
 		dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
 		dynamicState.pDynamicStates = dynamicStates.data();
 		#pragma endregion DYNAMIC STATE
-		
-		#pragma region --- PIPELINE LAYOUT ---
-		// may be revisited
-		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
-		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-		pipelineLayoutInfo.setLayoutCount = 0;				// optional
-		pipelineLayoutInfo.pSetLayouts = nullptr;			// optional
-		pipelineLayoutInfo.pushConstantRangeCount = 0;		// optional
-		pipelineLayoutInfo.pPushConstantRanges = nullptr;	// optional
-
-		if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
-		{
-			yeet broken_shoe("failed to create pipeline layout!");
-		}
-		#pragma endregion PIPELINE LAYOUT
 		#pragma endregion FIXED FUNCTIONS
 
 		#pragma region --- GRAPHICS PIPELINE ---
@@ -1021,12 +2888,12 @@ private:
 		pipelineInfo.pViewportState = &viewportState;
 		pipelineInfo.pRasterizationState = &rasterizer;
 		pipelineInfo.pMultisampleState = &multisampling;
-		pipelineInfo.pDepthStencilState = nullptr;	// optional
+		pipelineInfo.pDepthStencilState = &depthStencil;
 		pipelineInfo.pColorBlendState = &colorBlending;
-		pipelineInfo.pDynamicState = nullptr;		// optional
+		pipelineInfo.pDynamicState = &dynamicState;
 
 		// pipeline layout
-		pipelineInfo.layout = pipelineLayout;
+		pipelineInfo.layout = description.layout;
 
 		// render pass or other compatible thing
 		pipelineInfo.renderPass = renderPass;
@@ -1038,13 +2905,37 @@ private:
 		pipelineInfo.basePipelineIndex = -1;
 		#pragma endregion GRAPHICS PIPELINE
 
-		if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &graphicsPipeline) != VK_SUCCESS)
+		VkPipeline pipeline;
+		VkResult result = vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, allocator(VK_OBJECT_TYPE_PIPELINE), &pipeline);
+
+		vkDestroyShaderModule(device, fragShaderModule, allocator(VK_OBJECT_TYPE_SHADER_MODULE));
+		vkDestroyShaderModule(device, vertShaderModule, allocator(VK_OBJECT_TYPE_SHADER_MODULE));
+
+		if (result != VK_SUCCESS)
 		{
 			yeet broken_shoe("failed to create graphics pipeline!");
 		}
 
-		vkDestroyShaderModule(device, fragShaderModule, nullptr);
-		vkDestroyShaderModule(device, vertShaderModule, nullptr);
+		return pipeline;
+	}
+
+	// what loadAssets read during setup, straight from the file otherwise
+	vector<char> shaderCode(const string& path) {
+		auto preloaded = preloadedShaderCode.find(path);
+		if (preloaded != preloadedShaderCode.end())
+		{
+			return preloaded->second;
+		}
+		return readShaderFile(path);
+	}
+
+	static vector<char> readShaderFile(const string& path) {
+		// the SPIR-V isn't part of the repository, building the project compiles it from the sources next to it
+		if (!filesystem::exists(path))
+		{
+			yeet broken_shoe(path + " is missing, build the project or run shaders/compile.bat first!");
+		}
+		return readFile(path);
 	}
 
 	static vector<char> readFile(const string& filename) {
@@ -1081,135 +2972,5198 @@ private:
 		#pragma endregion SHADER MODULE CREATE INFO
 
 		VkShaderModule shaderModule;
-		if (vkCreateShaderModule(device, &createInfo, nullptr, &shaderModule) != VK_SUCCESS)
+		if (vkCreateShaderModule(device, &createInfo, allocator(VK_OBJECT_TYPE_SHADER_MODULE), &shaderModule) != VK_SUCCESS)
 		{
 			yeet broken_shoe("failed to create shader module!");
 		}
 
 		return shaderModule;
 	}
+
+	// the layout a pipeline made of these shaders needs, the same one every other pipeline asking for the same bindings
+	// and push constants gets, so descriptor sets allocated with its set layouts fit all of them
+	const PipelineLayoutCache::Layout& shaderLayout(const vector<vector<char>>& stages) {
+		vector<ShaderReflection> shaders;
+		for (const vector<char>& code : stages)
+		{
+			shaders.push_back(ShaderReflection::reflect(code));
+		}
+		return layoutCache.get(shaders);
+	}
+
+	// the engine binds and pushes through the layout it got at startup, a reloaded shader asking for another one can't be used
+	static void checkShaderLayout(const PipelineLayoutCache::Layout& reflected, VkPipelineLayout layout) {
+		if (reflected.pipelineLayout != layout)
+		{
+			yeet broken_shoe("the shaders changed their descriptor bindings or push constants, restart to pick that up!");
+		}
+	}
 	#pragma endregion CREATE GRAPHICS PIPELINE
-	#pragma endregion INIT VULKAN
 
-	#pragma region --- DEBUG ---
-	void setupDebugMessenger() {
-		if (!enableValidationLayers)
+	#pragma region --- CREATE SCENE TARGET ---
+	void createSceneTarget() {
+		// a scene recorded at another size still names the old framebuffer, even once the size comes back to what it was
+		sceneVersion++;
+
+		sceneTarget.extent = {
+			max(1u, static_cast<uint32_t>(swapChainExtent.width * MAX_RENDER_SCALE)),
+			max(1u, static_cast<uint32_t>(swapChainExtent.height * MAX_RENDER_SCALE))
+		};
+
+		#pragma region --- IMAGE ---
+		// same format as the swap chain, so the upscale is a plain blit
+		VkFormatProperties formatProperties;
+		vkGetPhysicalDeviceFormatProperties(physicalDevice, swapChainImageFormat, &formatProperties);
+		VkFormatFeatureFlags blitFeatures = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT;
+		if ((formatProperties.optimalTilingFeatures & blitFeatures) != blitFeatures)
 		{
-			return;
+			yeet broken_shoe("swap chain format doesn't support blitting!");
+		}
+		upscaleFilter = (formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT)
+			? VK_FILTER_LINEAR
+			: VK_FILTER_NEAREST;
+
+		VkImageCreateInfo imageInfo{};
+		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageInfo.imageType = VK_IMAGE_TYPE_2D;
+		imageInfo.format = swapChainImageFormat;
+		imageInfo.extent = { sceneTarget.extent.width, sceneTarget.extent.height, 1 };
+		imageInfo.mipLevels = 1;
+		imageInfo.arrayLayers = 1;
+		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+		imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+		if (vkCreateImage(device, &imageInfo, allocator(VK_OBJECT_TYPE_IMAGE), &sceneTarget.image) != VK_SUCCESS)
+		{
+			yeet broken_shoe("failed to create scene target image!");
 		}
 
-		VkDebugUtilsMessengerCreateInfoEXT createInfo;
-		populateDebugMessengerCreateInfo(createInfo);
+		VkMemoryRequirements memoryRequirements;
+		vkGetImageMemoryRequirements(device, sceneTarget.image, &memoryRequirements);
+
+		VkMemoryAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocInfo.allocationSize = memoryRequirements.size;
+		allocInfo.memoryTypeIndex = findMemoryType(memoryRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
-		if (CreateDebugUtilsMessengerEXT(instance, &createInfo, nullptr, &debugMessenger) != VK_SUCCESS)
+		if (allocateDeviceMemory(allocInfo, MemoryCategory::ATTACHMENTS, sceneTarget.memory) != VK_SUCCESS)
 		{
-			yeet broken_shoe("failed to set up debug messenger!");
+			yeet broken_shoe("failed to allocate scene target memory!");
+		}
+		vkBindImageMemory(device, sceneTarget.image, sceneTarget.memory, 0);
+		#pragma endregion IMAGE
+
+		#pragma region --- IMAGE VIEW ---
+		VkImageViewCreateInfo viewInfo{};
+		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		viewInfo.image = sceneTarget.image;
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format = swapChainImageFormat;
+		viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		viewInfo.subresourceRange.baseMipLevel = 0;
+		viewInfo.subresourceRange.levelCount = 1;
+		viewInfo.subresourceRange.baseArrayLayer = 0;
+		viewInfo.subresourceRange.layerCount = 1;
+
+		if (vkCreateImageView(device, &viewInfo, allocator(VK_OBJECT_TYPE_IMAGE_VIEW), &sceneTarget.imageView) != VK_SUCCESS)
+		{
+			yeet broken_shoe("failed to create scene target image view!");
+		}
+		#pragma endregion IMAGE VIEW
+
+		#pragma region --- DEPTH IMAGE ---
+		// same size as the color image, lower scales use the same corner of it
+		VkImageCreateInfo depthImageInfo = imageInfo;
+		depthImageInfo.format = depthFormat;
+		depthImageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+		if (hiZSupported)
+		{
+			depthImageInfo.usage |= VK_IMAGE_USAGE_SAMPLED_BIT;
+			shareWithComputeQueue(depthImageInfo);
 		}
-	}
 
-	void populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT& createInfo) {
-		createInfo = {};
-		createInfo.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT;
-		// default severities = VK_DEBUG_VERBOSE | VK_DEBUG_WARNING | VK_DEBUG_ERROR;
-		createInfo.messageSeverity = VK_DEBUG_VERBOSE | VK_DEBUG_WARNING | VK_DEBUG_ERROR;
-		// default types = VK_DEBUG_TYPE_GENERAL | VK_DEBUG_TYPE_VALIDATION | VK_DEBUG_TYPE_PERFORMANCE;
-		createInfo.messageType = VK_DEBUG_TYPE_GENERAL | VK_DEBUG_TYPE_VALIDATION | VK_DEBUG_TYPE_PERFORMANCE;
-		createInfo.pfnUserCallback = debugCallback;
-		// optional
-		createInfo.pUserData = nullptr;
-	}
+		if (vkCreateImage(device, &depthImageInfo, allocator(VK_OBJECT_TYPE_IMAGE), &sceneTarget.depthImage) != VK_SUCCESS)
+		{
+			yeet broken_shoe("failed to create depth image!");
+		}
 
-	static VKAPI_ATTR VkBool32 VKAPI_CALL debugCallback(
-		VkDebugUtilsMessageSeverityFlagBitsEXT msgSeverity,
-		VkDebugUtilsMessageTypeFlagsEXT msgType,
-		const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData,
-		void* pUserData) {
-		printError << "validation layer: " << pCallbackData->pMessage << endl;
+		vkGetImageMemoryRequirements(device, sceneTarget.depthImage, &memoryRequirements);
+		allocInfo.allocationSize = memoryRequirements.size;
+		allocInfo.memoryTypeIndex = findMemoryType(memoryRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
-		return VK_FALSE;
+		if (allocateDeviceMemory(allocInfo, MemoryCategory::ATTACHMENTS, sceneTarget.depthMemory) != VK_SUCCESS)
+		{
+			yeet broken_shoe("failed to allocate depth image memory!");
+		}
+		vkBindImageMemory(device, sceneTarget.depthImage, sceneTarget.depthMemory, 0);
+
+		VkImageViewCreateInfo depthViewInfo = viewInfo;
+		depthViewInfo.image = sceneTarget.depthImage;
+		depthViewInfo.format = depthFormat;
+		depthViewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+
+		if (vkCreateImageView(device, &depthViewInfo, allocator(VK_OBJECT_TYPE_IMAGE_VIEW), &sceneTarget.depthImageView) != VK_SUCCESS)
+		{
+			yeet broken_shoe("failed to create depth image view!");
+		}
+		#pragma endregion DEPTH IMAGE
+
+		#pragma region --- FRAMEBUFFER ---
+		// same order as the attachments of the render pass
+		array<VkImageView, 2> attachments = { sceneTarget.imageView, sceneTarget.depthImageView };
+
+		VkFramebufferCreateInfo framebufferInfo{};
+		framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+		// framebuffer can only be used with compatible render passes
+		framebufferInfo.renderPass = renderPass;
+		framebufferInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+		framebufferInfo.pAttachments = attachments.data();
+		framebufferInfo.width = sceneTarget.extent.width;
+		framebufferInfo.height = sceneTarget.extent.height;
+		framebufferInfo.layers = 1;
+
+		if (vkCreateFramebuffer(device, &framebufferInfo, allocator(VK_OBJECT_TYPE_FRAMEBUFFER), &sceneTarget.framebuffer) != VK_SUCCESS)
+		{
+			yeet broken_shoe("failed to create scene target framebuffer!");
+		}
+		#pragma endregion FRAMEBUFFER
+
+		if (hiZSupported)
+		{
+			createHiZPyramid();
+		}
+
+		updateRenderExtent();
 	}
 
-	static VkResult CreateDebugUtilsMessengerEXT(
-		VkInstance instance,
-		const VkDebugUtilsMessengerCreateInfoEXT* pCreateInfo,
-		VkAllocationCallbacks* pAllocator, // heh, Pal-Locator
-		VkDebugUtilsMessengerEXT* pDebugMessenger)
-	{
-		auto func = (PFN_vkCreateDebugUtilsMessengerEXT)vkGetInstanceProcAddr(instance, "vkCreateDebugUtilsMessengerEXT");
+	// every level gets written each frame before anything reads it, so its layout only gets set while recording
+	void createHiZPyramid() {
+		sceneTarget.hiZExtent = { max(1u, sceneTarget.extent.width / 2), max(1u, sceneTarget.extent.height / 2) };
+		uint32_t levelCount = static_cast<uint32_t>(floor(log2(max(sceneTarget.hiZExtent.width, sceneTarget.hiZExtent.height)))) + 1;
+
+		#pragma region --- IMAGE ---
+		VkImageCreateInfo imageInfo{};
+		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageInfo.imageType = VK_IMAGE_TYPE_2D;
+		imageInfo.format = VK_FORMAT_R32_SFLOAT;
+		imageInfo.extent = { sceneTarget.hiZExtent.width, sceneTarget.hiZExtent.height, 1 };
+		imageInfo.mipLevels = levelCount;
+		imageInfo.arrayLayers = 1;
+		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+		imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		imageInfo.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		shareWithComputeQueue(imageInfo);
+
+		if (vkCreateImage(device, &imageInfo, allocator(VK_OBJECT_TYPE_IMAGE), &sceneTarget.hiZImage) != VK_SUCCESS)
+		{
+			yeet broken_shoe("failed to create depth pyramid image!");
+		}
 
-		if (func != nullptr)
+		VkMemoryRequirements memoryRequirements;
+		vkGetImageMemoryRequirements(device, sceneTarget.hiZImage, &memoryRequirements);
+
+		VkMemoryAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocInfo.allocationSize = memoryRequirements.size;
+		allocInfo.memoryTypeIndex = findMemoryType(memoryRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+		if (allocateDeviceMemory(allocInfo, MemoryCategory::ATTACHMENTS, sceneTarget.hiZMemory) != VK_SUCCESS)
 		{
-			return func(instance, pCreateInfo, pAllocator, pDebugMessenger);
+			yeet broken_shoe("failed to allocate depth pyramid memory!");
 		}
-		else {
-			return VK_ERROR_EXTENSION_NOT_PRESENT;
+		vkBindImageMemory(device, sceneTarget.hiZImage, sceneTarget.hiZMemory, 0);
+		#pragma endregion IMAGE
+
+		#pragma region --- IMAGE VIEWS ---
+		sceneTarget.hiZViews.resize(levelCount);
+		for (uint32_t level = 0; level < levelCount; level++)
+		{
+			VkImageViewCreateInfo viewInfo{};
+			viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+			viewInfo.image = sceneTarget.hiZImage;
+			viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+			viewInfo.format = VK_FORMAT_R32_SFLOAT;
+			viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			viewInfo.subresourceRange.baseMipLevel = level;
+			viewInfo.subresourceRange.levelCount = 1;
+			viewInfo.subresourceRange.baseArrayLayer = 0;
+			viewInfo.subresourceRange.layerCount = 1;
+
+			if (vkCreateImageView(device, &viewInfo, allocator(VK_OBJECT_TYPE_IMAGE_VIEW), &sceneTarget.hiZViews[level]) != VK_SUCCESS)
+			{
+				yeet broken_shoe("failed to create depth pyramid image view!");
+			}
+		}
+		#pragma endregion IMAGE VIEWS
+
+		#pragma region --- DESCRIPTOR SETS ---
+		array<VkDescriptorPoolSize, 2> poolSizes{};
+		poolSizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		poolSizes[0].descriptorCount = levelCount;
+		poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+		poolSizes[1].descriptorCount = levelCount;
+
+		VkDescriptorPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+		poolInfo.pPoolSizes = poolSizes.data();
+		poolInfo.maxSets = levelCount;
+
+		if (vkCreateDescriptorPool(device, &poolInfo, allocator(VK_OBJECT_TYPE_DESCRIPTOR_POOL), &sceneTarget.hiZDescriptorPool) != VK_SUCCESS)
+		{
+			yeet broken_shoe("failed to create depth pyramid descriptor pool!");
+		}
+
+		vector<VkDescriptorSetLayout> setLayouts(levelCount, hiZDescriptorSetLayout);
+		VkDescriptorSetAllocateInfo setInfo{};
+		setInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		setInfo.descriptorPool = sceneTarget.hiZDescriptorPool;
+		setInfo.descriptorSetCount = levelCount;
+		setInfo.pSetLayouts = setLayouts.data();
+
+		sceneTarget.hiZDescriptorSets.resize(levelCount);
+		if (vkAllocateDescriptorSets(device, &setInfo, sceneTarget.hiZDescriptorSets.data()) != VK_SUCCESS)
+		{
+			yeet broken_shoe("failed to allocate depth pyramid descriptor sets!");
+		}
+
+		for (uint32_t level = 0; level < levelCount; level++)
+		{
+			// the first level reads the depth buffer, the others the level before them
+			VkDescriptorImageInfo sourceInfo{};
+			sourceInfo.sampler = hiZSampler;
+			sourceInfo.imageView = level == 0 ? sceneTarget.depthImageView : sceneTarget.hiZViews[level - 1];
+			sourceInfo.imageLayout = level == 0 ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_GENERAL;
+
+			VkDescriptorImageInfo destinationInfo{};
+			destinationInfo.imageView = sceneTarget.hiZViews[level];
+			destinationInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+			array<VkWriteDescriptorSet, 2> descriptorWrites{};
+			descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			descriptorWrites[0].dstSet = sceneTarget.hiZDescriptorSets[level];
+			descriptorWrites[0].dstBinding = 0;
+			descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+			descriptorWrites[0].descriptorCount = 1;
+			descriptorWrites[0].pImageInfo = &sourceInfo;
+			descriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			descriptorWrites[1].dstSet = sceneTarget.hiZDescriptorSets[level];
+			descriptorWrites[1].dstBinding = 1;
+			descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+			descriptorWrites[1].descriptorCount = 1;
+			descriptorWrites[1].pImageInfo = &destinationInfo;
+
+			vkUpdateDescriptorSets(device, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+		}
+		#pragma endregion DESCRIPTOR SETS
+
+		#pragma region --- READBACK BUFFERS ---
+		// the first level read back is at most HI_Z_READBACK_WIDTH wide and keeps the shape of the scene target,
+		// every coarser one adds up to less than another one of those, plus a texel of rounding per row and column of each level
+		size_t readbackHeight = static_cast<size_t>(HI_Z_READBACK_WIDTH) * sceneTarget.extent.height / sceneTarget.extent.width + 2;
+		sceneTarget.hiZReadbackCapacity = 2 * HI_Z_READBACK_WIDTH * readbackHeight + levelCount * (HI_Z_READBACK_WIDTH + readbackHeight);
+		VkDeviceSize readbackSize = sceneTarget.hiZReadbackCapacity * sizeof(float);
+
+		for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+		{
+			// only ever read by the CPU, which is much faster from cached memory
+			createBuffer(readbackSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, MemoryCategory::STAGING,
+				sceneTarget.hiZReadbackBuffers[i], sceneTarget.hiZReadbackMemory[i], VK_MEMORY_PROPERTY_HOST_CACHED_BIT, true);
+
+			void* mapped;
+			vkMapMemory(device, sceneTarget.hiZReadbackMemory[i], 0, readbackSize, 0, &mapped);
+			sceneTarget.hiZReadbackData[i] = static_cast<const float*>(mapped);
+		}
+		#pragma endregion READBACK BUFFERS
+
+		// whatever got read back so far belongs to the previous scene target
+		for (HiZReadback& readback : hiZReadbacks)
+		{
+			readback.written = false;
 		}
 	}
 
-	static void DestroyDebugUtilsMessengerEXT(
-		VkInstance instance,
-		VkDebugUtilsMessengerEXT debugMessenger,
-		const VkAllocationCallbacks* pAllocator)
-	{
-		auto func = (PFN_vkDestroyDebugUtilsMessengerEXT)vkGetInstanceProcAddr(instance, "vkDestroyDebugUtilsMessengerEXT");
+	void destroySceneTarget(const SceneTarget& target) {
+		if (target.hiZImage != VK_NULL_HANDLE)
+		{
+			for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+			{
+				vkDestroyBuffer(device, target.hiZReadbackBuffers[i], allocator(VK_OBJECT_TYPE_BUFFER));
+				freeDeviceMemory(target.hiZReadbackMemory[i]);
+			}
+			// the descriptor sets get freed along with their pool
+			vkDestroyDescriptorPool(device, target.hiZDescriptorPool, allocator(VK_OBJECT_TYPE_DESCRIPTOR_POOL));
+			for (VkImageView view : target.hiZViews)
+			{
+				vkDestroyImageView(device, view, allocator(VK_OBJECT_TYPE_IMAGE_VIEW));
+			}
+			vkDestroyImage(device, target.hiZImage, allocator(VK_OBJECT_TYPE_IMAGE));
+			freeDeviceMemory(target.hiZMemory);
+		}
+		vkDestroyFramebuffer(device, target.framebuffer, allocator(VK_OBJECT_TYPE_FRAMEBUFFER));
+		vkDestroyImageView(device, target.depthImageView, allocator(VK_OBJECT_TYPE_IMAGE_VIEW));
+		vkDestroyImage(device, target.depthImage, allocator(VK_OBJECT_TYPE_IMAGE));
+		freeDeviceMemory(target.depthMemory);
+		vkDestroyImageView(device, target.imageView, allocator(VK_OBJECT_TYPE_IMAGE_VIEW));
+		vkDestroyImage(device, target.image, allocator(VK_OBJECT_TYPE_IMAGE));
+		freeDeviceMemory(target.memory);
+	}
 
-		if (func != nullptr)
+	uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) {
+		optional<uint32_t> memoryType = findOptionalMemoryType(typeFilter, properties);
+		if (!memoryType.has_value())
 		{
-			func(instance, debugMessenger, pAllocator);
+			yeet broken_shoe("failed to find suitable memory type!");
 		}
+
+		return memoryType.value();
 	}
-	#pragma endregion DEBUG
-	
-	#pragma region --- MAIN LOOP ---
-	void mainLoop() {
-		while (!glfwWindowShouldClose(window))
+
+	// for memory properties that are nice to have, so a fallback can be tried
+	optional<uint32_t> findOptionalMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) {
+		VkPhysicalDeviceMemoryProperties memoryProperties;
+		vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+		for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
 		{
-			glfwPollEvents();
+			if ((typeFilter & (1 << i)) && (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties)
+			{
+				return i;
+			}
 		}
+
+		return nullopt;
 	}
-	#pragma endregion MAIN LOOP
-	
-	#pragma region --- CLEANUP ---
-	void cleanup() {
-		// destroy the pipeline
-		vkDestroyPipeline(device, graphicsPipeline, nullptr);
-		// destroy the pipeline layout
-		vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
-		// destroy the render pass
-		vkDestroyRenderPass(device, renderPass, nullptr);
+	#pragma endregion CREATE SCENE TARGET
 
-		// destroy the image views
-		for (VkImageView imageView : swapChainImageViews) {
-			vkDestroyImageView(device, imageView, nullptr);
+	#pragma region --- CREATE COMMAND BUFFERS ---
+	void createCommandPool() {
+		// TODO? store indices as class member?
+		QueueFamilyIndices indices = findQueueFamilies(physicalDevice);
+
+		VkCommandPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		// command buffers get re-recorded every frame, so allow resetting them individually
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+		poolInfo.queueFamilyIndex = indices.graphicsFamily.value();
+
+		if (vkCreateCommandPool(device, &poolInfo, allocator(VK_OBJECT_TYPE_COMMAND_POOL), &commandPool) != VK_SUCCESS)
+		{
+			yeet broken_shoe("failed to create command pool!");
 		}
 
-		// destroy the swap chain
-		vkDestroySwapchainKHR(device, swapChain, nullptr);
-		// destroy the logical device
-		vkDestroyDevice(device, nullptr);
+		if (asyncComputeSupported)
+		{
+			poolInfo.queueFamilyIndex = sharedQueueFamilies[1];
+			if (vkCreateCommandPool(device, &poolInfo, allocator(VK_OBJECT_TYPE_COMMAND_POOL), &computeCommandPool) != VK_SUCCESS)
+			{
+				yeet broken_shoe("failed to create compute command pool!");
+			}
+		}
+	}
 
-		// destroy the debugger
-		if (enableValidationLayers)
+	void createCommandBuffers() {
+		commandBuffers.resize(MAX_FRAMES_IN_FLIGHT);
+
+		VkCommandBufferAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.commandPool = commandPool;
+		// primary: can be submitted to a queue, but can't be called from other command buffers
+		// secondary: can't be submitted directly, but can be called from primary command buffers
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocInfo.commandBufferCount = static_cast<uint32_t>(commandBuffers.size());
+
+		if (vkAllocateCommandBuffers(device, &allocInfo, commandBuffers.data()) != VK_SUCCESS)
 		{
-			DestroyDebugUtilsMessengerEXT(instance, debugMessenger, nullptr);
+			yeet broken_shoe("failed to allocate command buffers!");
 		}
 
-		// destroy the surface of the window
-		vkDestroySurfaceKHR(instance, surface, nullptr);
-		// destroy the vulkan instance
-		vkDestroyInstance(instance, nullptr);
+		// executed from the primary ones inside the scene pass
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+		meshCommandBuffers.resize(MAX_FRAMES_IN_FLIGHT);
+		overlayCommandBuffers.resize(MAX_FRAMES_IN_FLIGHT);
+		array<VkCommandBuffer, MAX_FRAMES_IN_FLIGHT> staticSceneCommandBuffers{};
+		if (vkAllocateCommandBuffers(device, &allocInfo, meshCommandBuffers.data()) != VK_SUCCESS
+			|| vkAllocateCommandBuffers(device, &allocInfo, overlayCommandBuffers.data()) != VK_SUCCESS
+			|| vkAllocateCommandBuffers(device, &allocInfo, staticSceneCommandBuffers.data()) != VK_SUCCESS)
+		{
+			yeet broken_shoe("failed to allocate secondary command buffers!");
+		}
+		for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+		{
+			staticScenes[i].commandBuffer = staticSceneCommandBuffers[i];
+		}
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
 
-		// destroy the window
-		glfwDestroyWindow(window);
+		if (asyncComputeSupported)
+		{
+			upscaleCommandBuffers.resize(MAX_FRAMES_IN_FLIGHT);
+			if (vkAllocateCommandBuffers(device, &allocInfo, upscaleCommandBuffers.data()) != VK_SUCCESS)
+			{
+				yeet broken_shoe("failed to allocate upscale command buffers!");
+			}
 
-		// terminate glfw
-		glfwTerminate();
+			computeCommandBuffers.resize(MAX_FRAMES_IN_FLIGHT);
+			allocInfo.commandPool = computeCommandPool;
+			if (vkAllocateCommandBuffers(device, &allocInfo, computeCommandBuffers.data()) != VK_SUCCESS)
+			{
+				yeet broken_shoe("failed to allocate compute command buffers!");
+			}
+		}
+	}
+
+	// with asyncCompute the depth pyramid is left to the compute queue, and everything after the scene goes into the upscale command buffer
+	void recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex, bool asyncCompute) {
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		beginInfo.pInheritanceInfo = nullptr; // only relevant for secondary command buffers
+
+		if (dispatch.vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+		{
+			yeet broken_shoe("failed to begin recording command buffer!");
+		}
+
+		// for the HUD, it shows the numbers of this frame
+		uint64_t drawsBefore = frameStats.sceneDrawSum + frameStats.meshDrawSum + frameStats.spriteDrawSum + frameStats.replayedDrawSum;
+		uint64_t trianglesBefore = frameStats.sceneDrawSum + frameStats.meshTriangleSum + frameStats.spriteSum * 2
+			+ frameStats.replayedTriangleSum;
+
+		// barriers, the depth pyramid and the upscale follow from the pass structure, so only the extent and whether
+		// the pyramid gets built are recorded, together with what goes on inside the scene pass
+		traceWriter.beginFrame(renderExtent.width, renderExtent.height, hiZActive() ? TRACE_FRAME_HI_Z : 0);
+
+		uint32_t firstQuery = static_cast<uint32_t>(currentFrame) * 2;
+		if (timestampQueryPool != VK_NULL_HANDLE)
+		{
+			dispatch.vkCmdResetQueryPool(commandBuffer, timestampQueryPool, firstQuery, 2);
+			dispatch.vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, timestampQueryPool, firstQuery);
+		}
+		if (statisticsQueryPool != VK_NULL_HANDLE)
+		{
+			// can't be reset inside the render pass
+			dispatch.vkCmdResetQueryPool(commandBuffer, statisticsQueryPool, static_cast<uint32_t>(currentFrame), 1);
+		}
+
+		// compute, so it has to happen before the scene pass
+		recordLightBinning(commandBuffer);
+
+		#pragma region --- RENDER PASS ---
+		VkRenderPassBeginInfo renderPassInfo{};
+		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+		renderPassInfo.renderPass = renderPass;
+		renderPassInfo.framebuffer = sceneTarget.framebuffer;
+		renderPassInfo.renderArea.offset = { 0, 0 };
+		renderPassInfo.renderArea.extent = renderExtent;
+
+		// same order as the attachments
+		array<VkClearValue, 2> clearValues{};
+		clearValues[0].color = { { 0.0f, 0.0f, 0.0f, 1.0f } };
+		// far plane
+		clearValues[1].depthStencil = { 1.0f, 0 };
+		renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+		renderPassInfo.pClearValues = clearValues.data();
+
+		// a trace has to see every command of the frame, so the scene gets recorded inline while tracing
+		bool staticScene = staticSceneEnabled && !replaying && !traceWriter.isOpen();
+		dispatch.vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, staticScene ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE);
+		if (!staticScene)
+		{
+			setRenderViewport(commandBuffer);
+		}
+
+		bool measureOverdraw = statisticsQueryPool != VK_NULL_HANDLE && (!staticScene || inheritedQueriesSupported);
+		if (measureOverdraw)
+		{
+			dispatch.vkCmdBeginQuery(commandBuffer, statisticsQueryPool, static_cast<uint32_t>(currentFrame), 0);
+		}
+		if (replaying)
+		{
+			// the sprites are part of the replayed frame, so they end up in the overdraw statistics as well
+			replayTraceFrame(commandBuffer);
+		}
+		else if (staticScene)
+		{
+			VkCommandBuffer meshCommandBuffer = meshCommandBuffers[currentFrame];
+			dispatch.vkResetCommandBuffer(meshCommandBuffer, 0);
+			beginSceneSecondary(meshCommandBuffer, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+			recordMeshes(meshCommandBuffer);
+			endSceneSecondary(meshCommandBuffer);
+
+			array<VkCommandBuffer, 2> secondaries = { meshCommandBuffer, updateStaticScene() };
+			dispatch.vkCmdExecuteCommands(commandBuffer, static_cast<uint32_t>(secondaries.size()), secondaries.data());
+		}
+		else
+		{
+			recordMeshes(commandBuffer);
+			recordScene(commandBuffer);
+		}
+		if (measureOverdraw)
+		{
+			dispatch.vkCmdEndQuery(commandBuffer, statisticsQueryPool, static_cast<uint32_t>(currentFrame));
+			statisticsWritten[currentFrame] = true;
+			statisticsExtents[currentFrame] = renderExtent;
+		}
+
+		VkCommandBuffer overlayCommandBuffer = commandBuffer;
+		if (staticScene)
+		{
+			overlayCommandBuffer = overlayCommandBuffers[currentFrame];
+			dispatch.vkResetCommandBuffer(overlayCommandBuffer, 0);
+			beginSceneSecondary(overlayCommandBuffer, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+		}
+		if (!replaying)
+		{
+			recordSprites(overlayCommandBuffer);
+		}
+		traceWriter.endFrame();
+		// on top of everything, but still inside the scene pass, so it doesn't need one of its own
+		recordHud(overlayCommandBuffer,
+			frameStats.sceneDrawSum + frameStats.meshDrawSum + frameStats.spriteDrawSum + frameStats.replayedDrawSum - drawsBefore,
+			frameStats.sceneDrawSum + frameStats.meshTriangleSum + frameStats.spriteSum * 2 + frameStats.replayedTriangleSum - trianglesBefore);
+		if (staticScene)
+		{
+			endSceneSecondary(overlayCommandBuffer);
+			dispatch.vkCmdExecuteCommands(commandBuffer, 1, &overlayCommandBuffer);
+		}
+		dispatch.vkCmdEndRenderPass(commandBuffer);
+		#pragma endregion RENDER PASS
+
+		// only the scene work the render scale changes, the upscale blit after it waits for the swap chain image,
+		// which under vsync is waiting for the presentation engine rather than rendering
+		if (timestampQueryPool != VK_NULL_HANDLE)
+		{
+			dispatch.vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timestampQueryPool, firstQuery + 1);
+			timestampsWritten[currentFrame] = true;
+		}
+
+		if (asyncCompute)
+		{
+			// the semaphore the scene submission signals makes it visible to the compute queue
+			// only the layout changes here, bottom of pipe can't access anything
+			VkImageMemoryBarrier depthBarrier = hiZDepthBarrier(0);
+			dispatch.vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+				0, 0, nullptr, 0, nullptr, 1, &depthBarrier);
+
+			if (dispatch.vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+			{
+				yeet broken_shoe("failed to record command buffer!");
+			}
+
+			commandBuffer = upscaleCommandBuffers[currentFrame];
+			dispatch.vkResetCommandBuffer(commandBuffer, 0);
+			if (dispatch.vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+			{
+				yeet broken_shoe("failed to begin recording command buffer!");
+			}
+		}
+		else
+		{
+			recordHiZ(commandBuffer, true);
+		}
+
+		recordUpscale(commandBuffer, swapChainImages[imageIndex]);
+
+		VkImageLayout swapChainImageLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		if (captureActive)
+		{
+			auto captureStart = chrono::steady_clock::now();
+			if (recordCapture(commandBuffer, swapChainImages[imageIndex]))
+			{
+				swapChainImageLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+			}
+			frameStats.captureTimeSum += toMilliseconds(chrono::steady_clock::now() - captureStart);
+		}
+		recordPresentTransition(commandBuffer, swapChainImages[imageIndex], swapChainImageLayout);
+
+		if (dispatch.vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+		{
+			yeet broken_shoe("failed to record command buffer!");
+		}
+	}
+
+	// viewport and scissor are dynamic state, which secondary command buffers don't inherit from the primary one
+	void setRenderViewport(VkCommandBuffer commandBuffer) {
+		VkViewport viewport{};
+		viewport.x = 0;
+		viewport.y = 0;
+		viewport.width = (float)renderExtent.width;
+		viewport.height = (float)renderExtent.height;
+		viewport.minDepth = 0.0f;
+		viewport.maxDepth = 1.0f;
+		dispatch.vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+
+		VkRect2D scissor{};
+		scissor.offset = { 0, 0 };
+		scissor.extent = renderExtent;
+		dispatch.vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+	}
+
+	// for content of the scene pass that gets executed from the primary command buffer
+	void beginSceneSecondary(VkCommandBuffer commandBuffer, VkCommandBufferUsageFlags flags) {
+		VkCommandBufferInheritanceInfo inheritanceInfo{};
+		inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+		inheritanceInfo.renderPass = renderPass;
+		inheritanceInfo.subpass = 0;
+		// optional, but lets the driver know exactly what it renders to
+		inheritanceInfo.framebuffer = sceneTarget.framebuffer;
+		// has to cover the overdraw query it might get executed in
+		if (statisticsQueryPool != VK_NULL_HANDLE && inheritedQueriesSupported)
+		{
+			inheritanceInfo.pipelineStatistics = VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+		}
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = flags | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+		beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+		if (dispatch.vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+		{
+			yeet broken_shoe("failed to begin recording secondary command buffer!");
+		}
+		setRenderViewport(commandBuffer);
+	}
+
+	void endSceneSecondary(VkCommandBuffer commandBuffer) {
+		if (dispatch.vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+		{
+			yeet broken_shoe("failed to record secondary command buffer!");
+		}
+	}
+
+	// the scene as recorded for this frame in flight, recorded again first if anything it depends on changed since
+	// the frame in flight's fence has been waited on, so no earlier frame is still executing it
+	VkCommandBuffer updateStaticScene() {
+		StaticScene& scene = staticScenes[currentFrame];
+		bool current = scene.version == sceneVersion
+			&& scene.swapChainExtent.width == swapChainExtent.width && scene.swapChainExtent.height == swapChainExtent.height
+			&& scene.renderExtent.width == renderExtent.width && scene.renderExtent.height == renderExtent.height;
+
+		if (current)
+		{
+			// the draws still happen, only recording them is skipped
+			frameStats.sceneDrawSum += sceneDraws.size();
+			frameStats.pipelineBindSum += scene.pipelineBinds;
+			frameStats.materialBindSum += scene.materialBinds;
+			frameStats.unsortedBindSum += scene.unsortedBinds;
+			frameStats.staticSceneReuses++;
+			frameStats.staticSceneSavedSum += scene.recordTime;
+			return scene.commandBuffer;
+		}
+
+		auto start = chrono::steady_clock::now();
+		uint64_t pipelineBindsBefore = frameStats.pipelineBindSum;
+		uint64_t materialBindsBefore = frameStats.materialBindSum;
+		uint64_t unsortedBindsBefore = frameStats.unsortedBindSum;
+
+		dispatch.vkResetCommandBuffer(scene.commandBuffer, 0);
+		// not one time submit, it's meant to be executed again and again
+		beginSceneSecondary(scene.commandBuffer, 0);
+		recordScene(scene.commandBuffer);
+		endSceneSecondary(scene.commandBuffer);
+
+		scene.version = sceneVersion;
+		scene.swapChainExtent = swapChainExtent;
+		scene.renderExtent = renderExtent;
+		scene.pipelineBinds = frameStats.pipelineBindSum - pipelineBindsBefore;
+		scene.materialBinds = frameStats.materialBindSum - materialBindsBefore;
+		scene.unsortedBinds = frameStats.unsortedBindSum - unsortedBindsBefore;
+		scene.recordTime = toMilliseconds(chrono::steady_clock::now() - start);
+		frameStats.staticSceneRecords++;
+		return scene.commandBuffer;
+	}
+
+	// moves the lights into the ring of this frame and bins them into the clusters of the mesh camera, mesh.frag then only goes
+	// through the lights of the cluster a fragment falls into, rather than through all of them.
+	// the clusters are slices of the view frustum, CLUSTER_GRID_X by CLUSTER_GRID_Y tiles of the screen each,
+	// exponentially thicker with the distance so they stay roughly as deep as they are wide
+	void recordLightBinning(VkCommandBuffer commandBuffer) {
+		// a replayed trace has meshes but no lights
+		uint32_t lightCount = replaying || meshInstances.empty() ? 0 : LIGHT_BENCHMARK_COUNTS[lightBenchmark];
+		bool clustered = clusteredLighting && lightCount > 0;
+		auto start = chrono::steady_clock::now();
+
+		#pragma region --- LIGHTS ---
+		float time = static_cast<float>(toMilliseconds(chrono::steady_clock::now() - meshStartTime) / 1000.0);
+		LightHeader* header = lightHeaders[currentFrame];
+		// the fence of this frame in flight has been waited on, so the binning that last used the ring is done
+		if (lightSweep.active)
+		{
+			lightSweep.droppedLights = max(lightSweep.droppedLights, header->droppedLights);
+		}
+		header->droppedLights = 0;
+		// right behind the header, written sequentially like the instance rings
+		LightData* lights = reinterpret_cast<LightData*>(header + 1);
+		for (uint32_t i = 0; i < lightCount; i++)
+		{
+			const PointLight& light = pointLights[i];
+			float angle = time * light.speed + light.phase;
+			lights[i].positionRadius = {
+				light.center[0] + cos(angle) * LIGHT_DRIFT,
+				light.center[1] + sin(angle * 2.0f) * LIGHT_DRIFT * 0.25f,
+				light.center[2] + sin(angle) * LIGHT_DRIFT,
+				light.radius
+			};
+			lights[i].color = { light.color[0], light.color[1], light.color[2], 0.0f };
+		}
+
+		// cluster = log(depth) * z - w, so log(near) maps to 0 and log(far) to the last slice
+		float sliceScale = CLUSTER_GRID_Z / log(CLUSTER_FAR_PLANE / CLUSTER_NEAR_PLANE);
+		header->lightCount = lightCount;
+		header->clustered = clustered ? 1 : 0;
+		header->clusterScale = {
+			static_cast<float>(CLUSTER_GRID_X) / renderExtent.width,
+			static_cast<float>(CLUSTER_GRID_Y) / renderExtent.height,
+			sliceScale,
+			log(CLUSTER_NEAR_PLANE) * sliceScale
+		};
+		#pragma endregion LIGHTS
+
+		#pragma region --- BINNING ---
+		if (clustered)
+		{
+			// the same camera as meshProjection
+			float aspect = static_cast<float>(renderExtent.width) / renderExtent.height;
+			float focal = 1.0f / tan(MESH_FIELD_OF_VIEW * 3.14159265f / 360.0f);
+			array<float, 4> inverseProjection = { aspect / focal, 1.0f / focal, CLUSTER_NEAR_PLANE, CLUSTER_FAR_PLANE };
+
+			dispatch.vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, lightBinningPipeline);
+			dispatch.vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, lightBinningPipelineLayout, 0, 1,
+				&lightingDescriptorSets[currentFrame], 0, nullptr);
+			dispatch.vkCmdPushConstants(commandBuffer, lightBinningPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(inverseProjection), inverseProjection.data());
+			uint32_t clusterCount = CLUSTER_GRID_X * CLUSTER_GRID_Y * CLUSTER_GRID_Z;
+			dispatch.vkCmdDispatch(commandBuffer, (clusterCount + CLUSTER_GROUP_SIZE - 1) / CLUSTER_GROUP_SIZE, 1, 1);
+
+			// the frame that used the clusters before is done by now, only this frame's fragments have to wait,
+			// and the count of dropped lights has to reach the host before the next frame on this ring reads it
+			array<VkBufferMemoryBarrier, 2> binningBarriers{};
+			for (VkBufferMemoryBarrier& barrier : binningBarriers)
+			{
+				barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+				barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+				barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			}
+			binningBarriers[0].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+			binningBarriers[0].buffer = clusterBuffers[currentFrame];
+			binningBarriers[0].size = VK_WHOLE_SIZE;
+			binningBarriers[1].dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+			binningBarriers[1].buffer = lightBuffers[currentFrame];
+			binningBarriers[1].size = sizeof(LightHeader);
+			dispatch.vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+				VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_HOST_BIT,
+				0, 0, nullptr, static_cast<uint32_t>(binningBarriers.size()), binningBarriers.data(), 0, nullptr);
+		}
+		#pragma endregion BINNING
+
+		frameStats.lightSum += lightCount;
+		frameStats.lightTimeSum += toMilliseconds(chrono::steady_clock::now() - start);
+	}
+
+	void startLightSweep() {
+		if (lightSweep.active)
+		{
+			return;
+		}
+		if (timestampQueryPool == VK_NULL_HANDLE)
+		{
+			logger.log(LOG_SEVERITY_WARNING, "can't measure the lighting without GPU timestamps");
+			return;
+		}
+		if (replaying || meshInstances.empty())
+		{
+			logger.log(LOG_SEVERITY_WARNING, "there are no meshes for the lights to light");
+			return;
+		}
+
+		lightSweep = LightSweep{};
+		lightSweep.active = true;
+		lightSweep.previousBenchmark = lightBenchmark;
+		lightSweep.previousClustered = clusteredLighting;
+		// every step at the full render extent, or the scaler would trade resolution for the light count
+		lightSweep.previousScalerEnabled = resolutionScaler.enabled;
+		lightSweep.previousScale = resolutionScaler.getScale();
+		resolutionScaler.enabled = false;
+		resolutionScaler.setScale(MAX_RENDER_SCALE);
+		updateRenderExtent();
+		logger.log(LOG_SEVERITY_INFO, "measuring " + to_string(LIGHT_BENCHMARK_COUNTS.size()) + " light counts, with and without clusters");
+	}
+
+	// called once per frame, picks the light count and mode of the step the sweep is at
+	void updateLightSweep() {
+		if (!lightSweep.active)
+		{
+			return;
+		}
+
+		// the first few frames of a step might still have been recorded with the previous one
+		if (lightSweep.frame == LIGHT_SWEEP_WARMUP_FRAMES)
+		{
+			lightSweep.gpuTimeSum = 0.0;
+			lightSweep.gpuTimeCount = 0;
+			lightSweep.droppedLights = 0;
+		}
+		if (lightSweep.frame == LIGHT_SWEEP_WARMUP_FRAMES + LIGHT_SWEEP_FRAMES)
+		{
+			lightSweep.results.push_back(lightSweep.gpuTimeCount > 0 ? lightSweep.gpuTimeSum / lightSweep.gpuTimeCount : 0.0);
+			lightSweep.droppedResults.push_back(lightSweep.droppedLights);
+			lightSweep.step++;
+			lightSweep.frame = 0;
+			if (lightSweep.step == LIGHT_BENCHMARK_COUNTS.size() * 2)
+			{
+				finishLightSweep();
+				return;
+			}
+		}
+
+		lightBenchmark = lightSweep.step / 2;
+		clusteredLighting = lightSweep.step % 2 == 0;
+		lightSweep.frame++;
+	}
+
+	void finishLightSweep() {
+		lightSweep.active = false;
+		lightBenchmark = lightSweep.previousBenchmark;
+		clusteredLighting = lightSweep.previousClustered;
+		// the message below still reports the extent everything was measured at
+		VkExtent2D measuredExtent = renderExtent;
+		resolutionScaler.enabled = lightSweep.previousScalerEnabled;
+		resolutionScaler.setScale(lightSweep.previousScale);
+		updateRenderExtent();
+
+		// the whole frame, not just the lighting, so the 0 lights row is what everything else costs
+		ostringstream message;
+		message << "gpu time against point lights at " << measuredExtent.width << "x" << measuredExtent.height
+			<< ", " << meshInstances.size() << " mesh instances";
+		for (size_t i = 0; i < LIGHT_BENCHMARK_COUNTS.size(); i++)
+		{
+			double clustered = lightSweep.results[i * 2];
+			double unclustered = lightSweep.results[i * 2 + 1];
+			message << " | " << LIGHT_BENCHMARK_COUNTS[i] << " lights: clustered " << clustered << " ms, unclustered " << unclustered << " ms"
+				<< " (" << (clustered > 0.0 ? unclustered / clustered : 0.0) << "x)";
+			// the clustered numbers are too low when lights went missing
+			if (lightSweep.droppedResults[i * 2] > 0)
+			{
+				message << ", up to " << lightSweep.droppedResults[i * 2] << " lights dropped from full clusters per frame";
+			}
+		}
+		logger.log(LOG_SEVERITY_INFO, message.str());
+	}
+
+	// every mesh instance in view and not hidden behind earlier frames, each at the coarsest level of detail that still looks the same
+	// instances get counted per mesh and level of detail first, so every combination is a single instanced draw
+	void recordMeshes(VkCommandBuffer commandBuffer) {
+		if (meshInstances.empty())
+		{
+			return;
+		}
+		auto start = chrono::steady_clock::now();
+
+		#pragma region --- CAMERA ---
+		float aspect = static_cast<float>(renderExtent.width) / renderExtent.height;
+		float focal = 1.0f / tan(MESH_FIELD_OF_VIEW * 3.14159265f / 360.0f);
+		float nearPlane = 0.1f;
+		array<float, 16> projection = meshProjection();
+		// pixels a length of 1 covers at a distance of 1
+		float pixelsPerUnit = focal * renderExtent.height * 0.5f;
+
+		// the row has to stay in view when the window changes shape
+		if (meshBenchmark == 0)
+		{
+			layOutMeshRow(aspect, focal);
+		}
+		#pragma endregion CAMERA
+
+		#pragma region --- CULLING ---
+		auto cullStart = chrono::steady_clock::now();
+		meshBvh.update();
+		meshBvh.cull(Frustum::fromMatrix(projection), visibleMeshInstances);
+		frameStats.meshVisibleSum += visibleMeshInstances.size();
+
+		// against the depth pyramid this frame in flight read back the last time around, a couple of frames old,
+		// which holds up as long as the camera stays where it is
+		const HiZReadback& readback = hiZReadbacks[currentFrame];
+		if (hiZEnabled && readback.written)
+		{
+			const float* depths = sceneTarget.hiZReadbackData[currentFrame];
+			size_t kept = 0;
+			for (uint32_t index : visibleMeshInstances)
+			{
+				if (!isOccluded(readback, depths, meshInstanceBounds(meshInstances[index])))
+				{
+					visibleMeshInstances[kept++] = index;
+				}
+			}
+			frameStats.meshOccludedSum += visibleMeshInstances.size() - kept;
+			visibleMeshInstances.resize(kept);
+		}
+		frameStats.cullTimeSum += toMilliseconds(chrono::steady_clock::now() - cullStart);
+		// the depth pyramid of this frame gets tested with it a couple of frames from now
+		meshViewProjection = projection;
+		#pragma endregion CULLING
+
+		float angle = static_cast<float>(toMilliseconds(chrono::steady_clock::now() - meshStartTime) / 1000.0) * MESH_ROTATION_SPEED;
+
+		#pragma region --- LEVEL OF DETAIL ---
+		meshDrawOffsets.assign(meshes.size() * MeshImporter::MAX_LODS, 0);
+		uint64_t lodSwitches = 0;
+		uint64_t fullTriangles = 0;
+		for (uint32_t index : visibleMeshInstances)
+		{
+			MeshInstance& instance = meshInstances[index];
+			const LoadedMesh& mesh = meshes[instance.mesh];
+			uint8_t lod = 0;
+			if (meshLodEnabled)
+			{
+				// to the closest point of its bounding sphere, the largest size is its radius
+				const array<float, 3>& p = instance.position;
+				float size = max({ instance.size[0], instance.size[1], instance.size[2] });
+				float distance = max(sqrt(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]) - size, nearPlane);
+				lod = selectMeshLod(mesh, instance.lod, pixelsPerUnit * size / (distance * mesh.radius));
+			}
+			lodSwitches += lod != instance.lod;
+			instance.lod = lod;
+			meshDrawOffsets[instance.mesh * MeshImporter::MAX_LODS + lod]++;
+			fullTriangles += mesh.lods[0].indexCount / 3;
+		}
+
+		// counts to offsets
+		uint32_t offset = 0;
+		for (uint32_t& drawOffset : meshDrawOffsets)
+		{
+			uint32_t count = drawOffset;
+			drawOffset = offset;
+			offset += count;
+		}
+		#pragma endregion LEVEL OF DETAIL
+
+		#pragma region --- INSTANCES ---
+		// instance memory usually is write-combined, so it only gets written to, sequentially within every draw
+		MeshInstanceData* instances = meshInstanceData[currentFrame];
+		for (uint32_t index : visibleMeshInstances)
+		{
+			const MeshInstance& instance = meshInstances[index];
+			const LoadedMesh& mesh = meshes[instance.mesh];
+			array<float, 3> scale;
+			array<float, 3> center;
+			for (int axis = 0; axis < 3; axis++)
+			{
+				scale[axis] = instance.size[axis] / mesh.radius;
+				center[axis] = mesh.center[axis] * scale[axis];
+			}
+			float cosAngle = cos(angle * instance.spin + instance.phase);
+			float sinAngle = sin(angle * instance.spin + instance.phase);
+
+			// rotating and scaling the center as well keeps it in place
+			MeshInstanceData& data = instances[meshDrawOffsets[instance.mesh * MeshImporter::MAX_LODS + instance.lod]++];
+			data.position = {
+				instance.position[0] - (cosAngle * center[0] + sinAngle * center[2]),
+				instance.position[1] - center[1],
+				instance.position[2] - (cosAngle * center[2] - sinAngle * center[0])
+			};
+			data.scale = scale;
+			data.rotation = { cosAngle, sinAngle };
+		}
+		// reads the write-combined ring back, which is slow, but only while recording a trace
+		traceWriter.stream(TraceRing::MESH_INSTANCES, instances, static_cast<uint32_t>(sizeof(MeshInstanceData) * visibleMeshInstances.size()));
+		#pragma endregion INSTANCES
+
+		#pragma region --- DRAWS ---
+		dispatch.vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, meshPipeline);
+		dispatch.vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, meshPipelineLayout, 0, 1, &lightingDescriptorSets[currentFrame], 0, nullptr);
+		array<VkBuffer, 2> vertexBuffers = { meshVertexBuffer, meshInstanceBuffers[currentFrame] };
+		array<VkDeviceSize, 2> offsets = { 0, 0 };
+		dispatch.vkCmdBindVertexBuffers(commandBuffer, 0, 2, vertexBuffers.data(), offsets.data());
+		dispatch.vkCmdBindIndexBuffer(commandBuffer, meshIndexBuffer, 0, VK_INDEX_TYPE_UINT32);
+
+		struct {
+			array<float, 16> viewProjection;
+			array<float, 4> lightDirection;
+		} pushConstants;
+		// the camera doesn't move, so the projection is the whole transform
+		pushConstants.viewProjection = projection;
+		// from the top left front
+		pushConstants.lightDirection = { 0.4f, -0.7f, -0.6f, 0.0f };
+		dispatch.vkCmdPushConstants(commandBuffer, meshPipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(pushConstants), &pushConstants);
+		traceWriter.bindPipeline(TraceGroup::MESH, 0);
+		traceWriter.bindGeometry(TraceGroup::MESH);
+		traceWriter.pushConstants(TraceGroup::MESH, 0, sizeof(pushConstants), &pushConstants);
+
+		// after writing the instances, every offset points at the end of its run
+		uint32_t firstInstance = 0;
+		uint64_t draws = 0;
+		uint64_t triangles = 0;
+		for (size_t i = 0; i < meshDrawOffsets.size(); i++)
+		{
+			uint32_t instanceCount = meshDrawOffsets[i] - firstInstance;
+			if (instanceCount > 0)
+			{
+				const LoadedMesh& mesh = meshes[i / MeshImporter::MAX_LODS];
+				const MeshLod& lod = mesh.lods[i % MeshImporter::MAX_LODS];
+				// indexCount, instanceCount, firstIndex, vertexOffset, firstInstance
+				dispatch.vkCmdDrawIndexed(commandBuffer, lod.indexCount, instanceCount, lod.firstIndex, mesh.vertexOffset, firstInstance);
+				traceWriter.drawIndexed(lod.indexCount, instanceCount, lod.firstIndex, mesh.vertexOffset, firstInstance);
+				draws++;
+				triangles += static_cast<uint64_t>(lod.indexCount / 3) * instanceCount;
+			}
+			firstInstance = meshDrawOffsets[i];
+		}
+		#pragma endregion DRAWS
+
+		frameStats.meshInstanceSum += meshInstances.size();
+		frameStats.meshDrawSum += draws;
+		frameStats.meshTriangleSum += triangles;
+		frameStats.meshFullTriangleSum += fullTriangles;
+		frameStats.lodSwitchSum += lodSwitches;
+		frameStats.meshTimeSum += toMilliseconds(chrono::steady_clock::now() - start);
+	}
+
+	// at the origin, looking down -z, far enough to see the end of the largest benchmark grid
+	// Vulkan clip space: y points down, depth goes from 0 to 1
+	array<float, 16> meshProjection() const {
+		float aspect = static_cast<float>(renderExtent.width) / renderExtent.height;
+		float focal = 1.0f / tan(MESH_FIELD_OF_VIEW * 3.14159265f / 360.0f);
+		float nearPlane = 0.1f;
+		float farPlane = 1000.0f;
+		return {
+			focal / aspect, 0, 0, 0,
+			0, -focal, 0, 0,
+			0, 0, farPlane / (nearPlane - farPlane), -1,
+			0, 0, nearPlane * farPlane / (nearPlane - farPlane), 0
+		};
+	}
+
+	// the coarsest level whose error stays under LOD_ERROR_PIXELS, with a dead zone around it
+	// pixelsPerMeshUnit is how many pixels a length of 1 in the mesh's own units covers on screen
+	static uint8_t selectMeshLod(const LoadedMesh& mesh, uint8_t current, float pixelsPerMeshUnit) {
+		size_t lod = min<size_t>(current, mesh.lods.size() - 1);
+		while (lod > 0 && mesh.lods[lod].error * pixelsPerMeshUnit > LOD_ERROR_PIXELS * (1.0f + LOD_HYSTERESIS))
+		{
+			lod--;
+		}
+		while (lod + 1 < mesh.lods.size() && mesh.lods[lod + 1].error * pixelsPerMeshUnit < LOD_ERROR_PIXELS * (1.0f - LOD_HYSTERESIS))
+		{
+			lod++;
+		}
+		return static_cast<uint8_t>(lod);
+	}
+
+	bool hiZActive() const {
+		if (replaying)
+		{
+			return hiZSupported && replayHiZ;
+		}
+		return hiZSupported && hiZEnabled && !meshInstances.empty();
+	}
+
+	// reduces the depth buffer into the depth pyramid one level at a time and copies the coarse levels into this frame's readback buffer,
+	// recordMeshes tests against them once this frame in flight comes around again
+	// on the compute queue the graphics queue already moved the depth buffer out of the attachment layout
+	void recordHiZ(VkCommandBuffer commandBuffer, bool transitionDepth) {
+		HiZReadback& readback = hiZReadbacks[currentFrame];
+		readback.written = false;
+		if (!hiZActive())
+		{
+			return;
+		}
+
+		#pragma region --- LEVELS ---
+		// only the corner of every level below the render extent gets built
+		readback.levels.clear();
+		VkExtent2D level = { max(1u, renderExtent.width / 2), max(1u, renderExtent.height / 2) };
+		while (true)
+		{
+			readback.levels.push_back(level);
+			if ((level.width == 1 && level.height == 1) || readback.levels.size() == sceneTarget.hiZViews.size())
+			{
+				break;
+			}
+			level = { max(1u, level.width / 2), max(1u, level.height / 2) };
+		}
+
+		readback.firstLevel = 0;
+		while (readback.levels[readback.firstLevel].width > HI_Z_READBACK_WIDTH && readback.firstLevel + 1 < readback.levels.size())
+		{
+			readback.firstLevel++;
+		}
+
+		readback.offsets.clear();
+		size_t readbackSize = 0;
+		for (size_t i = readback.firstLevel; i < readback.levels.size(); i++)
+		{
+			readback.offsets.push_back(readbackSize);
+			readbackSize += static_cast<size_t>(readback.levels[i].width) * readback.levels[i].height;
+		}
+		// very narrow windows, the culling just stays off for them
+		if (readbackSize > sceneTarget.hiZReadbackCapacity)
+		{
+			return;
+		}
+		#pragma endregion LEVELS
+
+		#pragma region --- BARRIERS ---
+		// the previous frame might still be building or copying the pyramid, its contents get thrown away
+		VkImageMemoryBarrier pyramidBarrier{};
+		pyramidBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		pyramidBarrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		pyramidBarrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+		pyramidBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		pyramidBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		pyramidBarrier.image = sceneTarget.hiZImage;
+		pyramidBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		pyramidBarrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+		pyramidBarrier.subresourceRange.layerCount = 1;
+		pyramidBarrier.srcAccessMask = 0;
+		pyramidBarrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+
+		array<VkImageMemoryBarrier, 2> barriers = { pyramidBarrier, hiZDepthBarrier(VK_ACCESS_SHADER_READ_BIT) };
+		VkPipelineStageFlags sourceStages = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT;
+		if (transitionDepth)
+		{
+			sourceStages |= VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+		}
+		dispatch.vkCmdPipelineBarrier(commandBuffer, sourceStages, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr,
+			transitionDepth ? 2 : 1, barriers.data());
+		#pragma endregion BARRIERS
+
+		#pragma region --- REDUCTION ---
+		dispatch.vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, hiZPipeline);
+		for (uint32_t i = 0; i < readback.levels.size(); i++)
+		{
+			VkExtent2D source = i == 0 ? renderExtent : readback.levels[i - 1];
+			VkExtent2D destination = readback.levels[i];
+			array<int32_t, 4> sizes = {
+				static_cast<int32_t>(source.width), static_cast<int32_t>(source.height),
+				static_cast<int32_t>(destination.width), static_cast<int32_t>(destination.height)
+			};
+			dispatch.vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, hiZPipelineLayout, 0, 1, &sceneTarget.hiZDescriptorSets[i], 0, nullptr);
+			dispatch.vkCmdPushConstants(commandBuffer, hiZPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(sizes), sizes.data());
+			dispatch.vkCmdDispatch(commandBuffer, (destination.width + HI_Z_GROUP_SIZE - 1) / HI_Z_GROUP_SIZE, (destination.height + HI_Z_GROUP_SIZE - 1) / HI_Z_GROUP_SIZE, 1);
+
+			// the next level reads this one, and so might the copy
+			VkImageMemoryBarrier levelBarrier = pyramidBarrier;
+			levelBarrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+			levelBarrier.subresourceRange.baseMipLevel = i;
+			levelBarrier.subresourceRange.levelCount = 1;
+			levelBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+			levelBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+			dispatch.vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+				VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &levelBarrier);
+		}
+		#pragma endregion REDUCTION
+
+		#pragma region --- READBACK ---
+		vector<VkBufferImageCopy>& regions = hiZCopyRegions;
+		regions.assign(readback.offsets.size(), {});
+		for (size_t i = 0; i < regions.size(); i++)
+		{
+			VkExtent2D size = readback.levels[readback.firstLevel + i];
+			regions[i].bufferOffset = readback.offsets[i] * sizeof(float);
+			// tightly packed
+			regions[i].bufferRowLength = 0;
+			regions[i].bufferImageHeight = 0;
+			regions[i].imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			regions[i].imageSubresource.mipLevel = static_cast<uint32_t>(readback.firstLevel + i);
+			regions[i].imageSubresource.layerCount = 1;
+			regions[i].imageExtent = { size.width, size.height, 1 };
+		}
+		dispatch.vkCmdCopyImageToBuffer(commandBuffer, sceneTarget.hiZImage, VK_IMAGE_LAYOUT_GENERAL, sceneTarget.hiZReadbackBuffers[currentFrame],
+			static_cast<uint32_t>(regions.size()), regions.data());
+
+		VkBufferMemoryBarrier readbackBarrier{};
+		readbackBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		readbackBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		readbackBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+		readbackBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		readbackBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		readbackBarrier.buffer = sceneTarget.hiZReadbackBuffers[currentFrame];
+		readbackBarrier.size = VK_WHOLE_SIZE;
+		dispatch.vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &readbackBarrier, 0, nullptr);
+		#pragma endregion READBACK
+
+		readback.viewProjection = meshViewProjection;
+		readback.renderExtent = renderExtent;
+		readback.written = true;
+	}
+
+	// the render pass leaves the depth buffer as an attachment, its layout covers the stencil aspect too, when there is one
+	// dstAccessMask has to be supported by the stage the barrier waits in
+	VkImageMemoryBarrier hiZDepthBarrier(VkAccessFlags dstAccessMask) const {
+		VkImageMemoryBarrier depthBarrier{};
+		depthBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		depthBarrier.oldLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+		depthBarrier.newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+		depthBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		depthBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		depthBarrier.image = sceneTarget.depthImage;
+		depthBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+		if (depthFormat == VK_FORMAT_D32_SFLOAT_S8_UINT || depthFormat == VK_FORMAT_D24_UNORM_S8_UINT)
+		{
+			depthBarrier.subresourceRange.aspectMask |= VK_IMAGE_ASPECT_STENCIL_BIT;
+		}
+		depthBarrier.subresourceRange.levelCount = 1;
+		depthBarrier.subresourceRange.layerCount = 1;
+		depthBarrier.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		depthBarrier.dstAccessMask = dstAccessMask;
+		return depthBarrier;
+	}
+
+	// the depth pyramid of the frame being submitted, timed with the compute queue's own timestamps
+	void recordComputeCommandBuffer(VkCommandBuffer commandBuffer) {
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+		if (dispatch.vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+		{
+			yeet broken_shoe("failed to begin recording compute command buffer!");
+		}
+
+		uint32_t firstQuery = static_cast<uint32_t>(currentFrame) * 2;
+		if (computeTimestampQueryPool != VK_NULL_HANDLE)
+		{
+			dispatch.vkCmdResetQueryPool(commandBuffer, computeTimestampQueryPool, firstQuery, 2);
+			dispatch.vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, computeTimestampQueryPool, firstQuery);
+		}
+
+		recordHiZ(commandBuffer, false);
+
+		if (computeTimestampQueryPool != VK_NULL_HANDLE)
+		{
+			dispatch.vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, computeTimestampQueryPool, firstQuery + 1);
+			computeTimestampsWritten[currentFrame] = true;
+		}
+
+		if (dispatch.vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+		{
+			yeet broken_shoe("failed to record compute command buffer!");
+		}
+	}
+
+	// whether the box is behind the depth the readback was built from, seen through the camera it was built with
+	// the box gets projected to a rectangle of pixels, which is looked up at the level where it covers at most 2x2 texels
+	static bool isOccluded(const HiZReadback& readback, const float* depths, const Aabb& box) {
+		const array<float, 16>& m = readback.viewProjection;
+		VkExtent2D renderSize = readback.renderExtent;
+		float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX;
+		float nearestDepth = FLT_MAX;
+		for (int corner = 0; corner < 8; corner++)
+		{
+			float x = (corner & 1) ? box.max[0] : box.min[0];
+			float y = (corner & 2) ? box.max[1] : box.min[1];
+			float z = (corner & 4) ? box.max[2] : box.min[2];
+			float clipX = m[0] * x + m[4] * y + m[8] * z + m[12];
+			float clipY = m[1] * x + m[5] * y + m[9] * z + m[13];
+			float clipZ = m[2] * x + m[6] * y + m[10] * z + m[14];
+			float clipW = m[3] * x + m[7] * y + m[11] * z + m[15];
+			// reaches behind the camera, the projection doesn't say anything useful about it
+			if (clipW <= 1e-4f)
+			{
+				return false;
+			}
+			float pixelX = (clipX / clipW * 0.5f + 0.5f) * renderSize.width;
+			float pixelY = (clipY / clipW * 0.5f + 0.5f) * renderSize.height;
+			minX = min(minX, pixelX);
+			minY = min(minY, pixelY);
+			maxX = max(maxX, pixelX);
+			maxY = max(maxY, pixelY);
+			nearestDepth = min(nearestDepth, clipZ / clipW);
+		}
+
+		// pixel rectangle, texel x of level i covers pixels x << (i + 1) and up
+		auto toPixel = [](float value, uint32_t size) {
+			return static_cast<uint32_t>(clamp(value, 0.0f, static_cast<float>(size - 1)));
+		};
+		uint32_t left = toPixel(minX, renderSize.width);
+		uint32_t top = toPixel(minY, renderSize.height);
+		uint32_t right = toPixel(maxX, renderSize.width);
+		uint32_t bottom = toPixel(maxY, renderSize.height);
+
+		uint32_t level = readback.firstLevel;
+		while (level + 1 < readback.levels.size() && ((right >> (level + 1)) - (left >> (level + 1)) > 1 || (bottom >> (level + 1)) - (top >> (level + 1)) > 1))
+		{
+			level++;
+		}
+
+		// the last texel of a level also covers what an odd size leaves over
+		VkExtent2D size = readback.levels[level];
+		uint32_t firstX = min(left >> (level + 1), size.width - 1);
+		uint32_t firstY = min(top >> (level + 1), size.height - 1);
+		uint32_t lastX = min(right >> (level + 1), size.width - 1);
+		uint32_t lastY = min(bottom >> (level + 1), size.height - 1);
+
+		const float* texels = depths + readback.offsets[level - readback.firstLevel];
+		float farthestDepth = 0.0f;
+		for (uint32_t y = firstY; y <= lastY; y++)
+		{
+			for (uint32_t x = firstX; x <= lastX; x++)
+			{
+				farthestDepth = max(farthestDepth, texels[y * size.width + x]);
+			}
+		}
+		return nearestDepth > farthestDepth;
+	}
+
+	// column major, like glsl
+	static array<float, 16> multiplyMatrices(const array<float, 16>& a, const array<float, 16>& b) {
+		array<float, 16> result{};
+		for (int column = 0; column < 4; column++)
+		{
+			for (int row = 0; row < 4; row++)
+			{
+				for (int k = 0; k < 4; k++)
+				{
+					result[column * 4 + row] += a[k * 4 + row] * b[column * 4 + k];
+				}
+			}
+		}
+		return result;
+	}
+
+	// draws the scene in the order of its sort keys, only binding what changed since the previous draw
+	void recordScene(VkCommandBuffer commandBuffer) {
+		auto sortStart = chrono::steady_clock::now();
+
+		const vector<uint32_t>* order;
+		vector<uint32_t> submissionOrder;
+		if (sortSceneDraws)
+		{
+			drawQueue.clear();
+			for (uint32_t i = 0; i < sceneDraws.size(); i++)
+			{
+				const SceneDraw& draw = sceneDraws[i];
+				uint32_t pipeline = static_cast<uint32_t>(draw.pipeline);
+				drawQueue.push(draw.pipeline == ScenePipeline::OPAQUE
+					? DrawQueue::opaqueKey(pipeline, draw.material, draw.depth)
+					: DrawQueue::transparentKey(pipeline, draw.material, draw.depth), i);
+			}
+			order = &drawQueue.sort();
+		}
+		else
+		{
+			// submission order still keeps transparent draws after opaque ones, otherwise they'd blend with nothing
+			submissionOrder.reserve(sceneDraws.size());
+			for (ScenePipeline pass : { ScenePipeline::OPAQUE, ScenePipeline::TRANSPARENT })
+			{
+				for (uint32_t i = 0; i < sceneDraws.size(); i++)
+				{
+					if (sceneDraws[i].pipeline == pass)
+					{
+						submissionOrder.push_back(i);
+					}
+				}
+			}
+			order = &submissionOrder;
+		}
+		frameStats.drawSortTimeSum += toMilliseconds(chrono::steady_clock::now() - sortStart);
+
+		ScenePipeline boundPipeline = ScenePipeline::COUNT;
+		uint32_t boundMaterial = UINT32_MAX;
+		for (uint32_t index : *order)
+		{
+			const SceneDraw& draw = sceneDraws[index];
+			if (draw.pipeline != boundPipeline)
+			{
+				dispatch.vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, scenePipelines[static_cast<size_t>(draw.pipeline)]);
+				traceWriter.bindPipeline(TraceGroup::SCENE, static_cast<uint8_t>(draw.pipeline));
+				boundPipeline = draw.pipeline;
+				frameStats.pipelineBindSum++;
+			}
+			if (draw.material != boundMaterial)
+			{
+				const array<float, 4>& color = SCENE_MATERIALS[draw.material % SCENE_MATERIALS.size()];
+				dispatch.vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, sizeof(float) * 4, sizeof(color), color.data());
+				traceWriter.pushConstants(TraceGroup::SCENE, sizeof(float) * 4, sizeof(color), color.data());
+				boundMaterial = draw.material;
+				frameStats.materialBindSum++;
+			}
+
+			float transform[4] = { draw.x, draw.y, draw.scale, draw.depth };
+			dispatch.vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(transform), transform);
+			traceWriter.pushConstants(TraceGroup::SCENE, 0, sizeof(transform), transform);
+
+			// vertexCount, instanceCount, firstVertex, firstInstance
+			dispatch.vkCmdDraw(commandBuffer, 3, 1, 0, 0);
+			traceWriter.draw(3, 1, 0, 0);
+		}
+
+		frameStats.sceneDrawSum += sceneDraws.size();
+		frameStats.unsortedBindSum += countUnsortedBinds();
+	}
+
+	// what the binds would have been in plain submission order, opaque draws first
+	uint32_t countUnsortedBinds() const {
+		uint32_t binds = 0;
+		for (ScenePipeline pass : { ScenePipeline::OPAQUE, ScenePipeline::TRANSPARENT })
+		{
+			bool pipelineBound = false;
+			uint32_t boundMaterial = UINT32_MAX;
+			for (const SceneDraw& draw : sceneDraws)
+			{
+				if (draw.pipeline != pass)
+				{
+					continue;
+				}
+				if (!pipelineBound)
+				{
+					pipelineBound = true;
+					binds++;
+				}
+				if (draw.material != boundMaterial)
+				{
+					boundMaterial = draw.material;
+					binds++;
+				}
+			}
+		}
+		return binds;
+	}
+
+	// draws everything added to the sprite batch this frame, on top of the scene
+	void recordSprites(VkCommandBuffer commandBuffer) {
+		auto start = chrono::steady_clock::now();
+
+		const vector<SpriteDraw>& draws = spriteBatch.build(spriteVertices[currentFrame], MAX_SPRITES);
+
+		if (!draws.empty())
+		{
+			// a texture past the generated ones is a bug in whoever added the sprite,
+			// those draws get skipped rather than quietly showing another texture
+			if (any_of(draws.begin(), draws.end(), [](const SpriteDraw& draw) { return draw.texture >= SPRITE_TEXTURE_COUNT; }))
+			{
+				logger.log(LOG_SEVERITY_WARNING, "skipped sprites with a texture that doesn't exist");
+			}
+
+			// draws come in vertex order, so the last one ends the written part of the ring
+			const SpriteDraw& lastDraw = draws.back();
+			traceWriter.stream(TraceRing::SPRITE_VERTICES, spriteVertices[currentFrame],
+				static_cast<uint32_t>(sizeof(SpriteVertex) * (lastDraw.firstVertex + lastDraw.quadCount * 4)));
+
+			VkDeviceSize offset = 0;
+			dispatch.vkCmdBindVertexBuffers(commandBuffer, 0, 1, &spriteVertexBuffers[currentFrame], &offset);
+			dispatch.vkCmdBindIndexBuffer(commandBuffer, spriteIndexBuffer, 0, VK_INDEX_TYPE_UINT16);
+			traceWriter.bindGeometry(TraceGroup::SPRITE);
+
+			// sprites are placed in swap chain pixels, the viewport takes care of the render scale
+			float transform[4] = {
+				2.0f / swapChainExtent.width, 2.0f / swapChainExtent.height,
+				-1.0f, -1.0f
+			};
+			dispatch.vkCmdPushConstants(commandBuffer, spritePipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(transform), transform);
+			traceWriter.pushConstants(TraceGroup::SPRITE, 0, sizeof(transform), transform);
+
+			// draws come sorted, so these only change when they have to
+			SpriteBlend boundBlend = SpriteBlend::COUNT;
+			uint16_t boundTexture = UINT16_MAX;
+			for (const SpriteDraw& draw : draws)
+			{
+				if (draw.texture >= SPRITE_TEXTURE_COUNT)
+				{
+					continue;
+				}
+				if (draw.blend != boundBlend)
+				{
+					dispatch.vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, spritePipelines[static_cast<size_t>(draw.blend)]);
+					traceWriter.bindPipeline(TraceGroup::SPRITE, static_cast<uint8_t>(draw.blend));
+					boundBlend = draw.blend;
+				}
+				if (draw.texture != boundTexture)
+				{
+					dispatch.vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, spritePipelineLayout,
+						0, 1, &spriteTextures[draw.texture].descriptorSet, 0, nullptr);
+					traceWriter.bindTexture(draw.texture);
+					boundTexture = draw.texture;
+				}
+
+				// indexCount, instanceCount, firstIndex, vertexOffset, firstInstance
+				dispatch.vkCmdDrawIndexed(commandBuffer, draw.quadCount * 6, 1, 0, static_cast<int32_t>(draw.firstVertex), 0);
+				traceWriter.drawIndexed(draw.quadCount * 6, 1, 0, static_cast<int32_t>(draw.firstVertex), 0);
+			}
+		}
+
+		frameStats.spriteSum += spriteBatch.size() - spriteBatch.droppedCount();
+		frameStats.spriteDrawSum += draws.size();
+		frameStats.spriteTimeSum += toMilliseconds(chrono::steady_clock::now() - start);
+		spriteBatch.clear();
+	}
+
+	// before the frame's command buffer starts recording, since bringing a texture back uploads it,
+	// and waits for the device when memory runs out
+	void prepareSpriteTextures() {
+		array<bool, SPRITE_TEXTURE_COUNT> used{};
+		if (replaying)
+		{
+			// the trace only gets read while recording, any of them could come up in it
+			used.fill(true);
+		}
+		else
+		{
+			for (const Sprite& sprite : spriteBatch.getSprites())
+			{
+				if (sprite.texture < SPRITE_TEXTURE_COUNT)
+				{
+					used[sprite.texture] = true;
+				}
+			}
+		}
+
+		// every texture of the frame counts as used before any of them comes back from eviction,
+		// so making room for one can't take away another
+		for (uint32_t i = 0; i < SPRITE_TEXTURE_COUNT; i++)
+		{
+			if (used[i])
+			{
+				residency.touch(spriteTextures[i].residencyId, submittedFrames);
+			}
+		}
+		for (uint32_t i = 0; i < SPRITE_TEXTURE_COUNT; i++)
+		{
+			if (used[i])
+			{
+				makeSpriteTextureResident(i);
+			}
+		}
+	}
+
+	// comes back from eviction, has to be touched for this frame first so making room for it can't evict what the frame already uses
+	void makeSpriteTextureResident(size_t index) {
+		SpriteTexture& texture = spriteTextures[index];
+		if (!residency.isResident(texture.residencyId))
+		{
+			uploadSpriteTexture(index);
+			residency.setResident(texture.residencyId);
+		}
+	}
+
+	// lays the HUD out, streams it into this frame's instance ring and draws all of it at once
+	void recordHud(VkCommandBuffer commandBuffer, uint64_t draws, uint64_t triangles) {
+		if (!hudEnabled)
+		{
+			return;
+		}
+
+		auto start = chrono::steady_clock::now();
+
+		buildHud(draws, triangles);
+		const vector<HudInstance>& instances = hud.getInstances();
+		uint32_t instanceCount = min(static_cast<uint32_t>(instances.size()), MAX_HUD_QUADS);
+		memcpy(hudInstances[currentFrame], instances.data(), sizeof(HudInstance) * instanceCount);
+
+		dispatch.vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, hudPipeline);
+		dispatch.vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, spritePipelineLayout, 0, 1, &hudDescriptorSet, 0, nullptr);
+
+		VkDeviceSize offset = 0;
+		dispatch.vkCmdBindVertexBuffers(commandBuffer, 0, 1, &hudInstanceBuffers[currentFrame], &offset);
+
+		// placed in swap chain pixels like the sprites
+		float transform[4] = {
+			2.0f / swapChainExtent.width, 2.0f / swapChainExtent.height,
+			-1.0f, -1.0f
+		};
+		dispatch.vkCmdPushConstants(commandBuffer, spritePipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(transform), transform);
+
+		// vertexCount, instanceCount, firstVertex, firstInstance
+		dispatch.vkCmdDraw(commandBuffer, 6, instanceCount, 0, 0);
+
+		lastHudTime = toMilliseconds(chrono::steady_clock::now() - start);
+		frameStats.hudTimeSum += lastHudTime;
+	}
+
+	// formats into a fixed buffer, so the HUD doesn't allocate once its instance list has grown
+	void buildHud(uint64_t draws, uint64_t triangles) {
+		const uint32_t textColor = 0xFFFFFFFF;
+		const uint32_t dimColor = 0xFFB0B0B0;
+		const uint32_t frameColor = 0xC0606060;
+		const uint32_t cpuColor = 0xE03090FF;
+		const uint32_t gpuColor = 0xE060E060;
+
+		hud.clear();
+		hud.setScale(HUD_SCALE);
+
+		float margin = 4.0f * HUD_SCALE;
+		float lineHeight = hud.lineHeight();
+		float width = PerfHud::HISTORY * HUD_SCALE * 2.0f;
+		float graphHeight = 24.0f * HUD_SCALE;
+		float x = margin * 2.0f;
+		float y = margin * 2.0f;
+
+		// drawn first, so it's behind everything else of the same draw
+		hud.rect(margin, margin, width + margin * 2.0f, lineHeight * 5.0f + graphHeight + margin * 3.0f, 0xB0000000);
+
+		PerfHud::FrameSample average = hud.average(HUD_AVERAGE_FRAMES);
+		array<char, 96> line;
+
+		snprintf(line.data(), line.size(), "FRAME %5.2f MS %5.0f FPS", average.frameMs, average.frameMs > 0.0f ? 1000.0f / average.frameMs : 0.0f);
+		hud.text(x, y, line.data(), textColor);
+		y += lineHeight;
+
+		float cpuEnd = hud.text(x, y, "CPU", cpuColor);
+		snprintf(line.data(), line.size(), " %5.2f MS ", average.cpuMs);
+		float gpuStart = hud.text(cpuEnd, y, line.data(), textColor);
+		float gpuEnd = hud.text(gpuStart, y, "GPU", gpuColor);
+		if (average.gpuMs > 0.0f)
+		{
+			snprintf(line.data(), line.size(), " %5.2f MS", average.gpuMs);
+		}
+		else
+		{
+			snprintf(line.data(), line.size(), " -");
+		}
+		hud.text(gpuEnd, y, line.data(), textColor);
+		y += lineHeight;
+
+		snprintf(line.data(), line.size(), "DRAWS %llu TRIS %llu", static_cast<unsigned long long>(draws), static_cast<unsigned long long>(triangles));
+		hud.text(x, y, line.data(), textColor);
+		y += lineHeight;
+
+		// device local heaps only, that's where running out hurts
+		VkDeviceSize usage = 0;
+		VkDeviceSize budget = 0;
+		for (uint32_t i = 0; i < residency.heapCount(); i++)
+		{
+			ResidencyManager::HeapStats heap = residency.heapStats(i);
+			if (heap.deviceLocal)
+			{
+				usage += heap.usage;
+				budget += heap.budget;
+			}
+		}
+		snprintf(line.data(), line.size(), "VRAM %.0f/%.0f MB", toMegabytes(usage), toMegabytes(budget));
+		hud.text(x, y, line.data(), textColor);
+		y += lineHeight;
+
+		// the previous frame's, this one's isn't done yet
+		snprintf(line.data(), line.size(), "HUD %.3f MS %u QUADS", lastHudTime, static_cast<unsigned>(hud.getInstances().size()));
+		hud.text(x, y, line.data(), dimColor);
+		y += lineHeight + margin;
+
+		hud.graph(x, y, width, graphHeight, 1000.0f / targetFrameRate(), frameColor, cpuColor, gpuColor);
+	}
+
+	// stretches the rendered part of the scene target over the whole swap chain image
+	// leaves the swap chain image in TRANSFER_DST_OPTIMAL
+	void recordUpscale(VkCommandBuffer commandBuffer, VkImage swapChainImage) {
+		VkImageMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = swapChainImage;
+		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		barrier.subresourceRange.baseMipLevel = 0;
+		barrier.subresourceRange.levelCount = 1;
+		barrier.subresourceRange.baseArrayLayer = 0;
+		barrier.subresourceRange.layerCount = 1;
+
+		// the old contents get overwritten completely
+		// the submit waits for the image to be acquired at the transfer stage, this barrier chains onto that wait
+		barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		dispatch.vkCmdPipelineBarrier(commandBuffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+			0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+		VkImageBlit blit{};
+		blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		blit.srcSubresource.mipLevel = 0;
+		blit.srcSubresource.baseArrayLayer = 0;
+		blit.srcSubresource.layerCount = 1;
+		blit.srcOffsets[0] = { 0, 0, 0 };
+		blit.srcOffsets[1] = { static_cast<int32_t>(renderExtent.width), static_cast<int32_t>(renderExtent.height), 1 };
+		blit.dstSubresource = blit.srcSubresource;
+		blit.dstOffsets[0] = { 0, 0, 0 };
+		blit.dstOffsets[1] = { static_cast<int32_t>(swapChainExtent.width), static_cast<int32_t>(swapChainExtent.height), 1 };
+
+		dispatch.vkCmdBlitImage(commandBuffer,
+			sceneTarget.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			swapChainImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			1, &blit, upscaleFilter);
+	}
+
+	void recordPresentTransition(VkCommandBuffer commandBuffer, VkImage swapChainImage, VkImageLayout oldLayout) {
+		VkImageMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = swapChainImage;
+		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		barrier.subresourceRange.baseMipLevel = 0;
+		barrier.subresourceRange.levelCount = 1;
+		barrier.subresourceRange.baseArrayLayer = 0;
+		barrier.subresourceRange.layerCount = 1;
+
+		// presenting happens after the semaphore signal, which already makes the writes available
+		barrier.oldLayout = oldLayout;
+		barrier.newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+		barrier.srcAccessMask = oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL ? VK_ACCESS_TRANSFER_WRITE_BIT : 0;
+		barrier.dstAccessMask = 0;
+		dispatch.vkCmdPipelineBarrier(commandBuffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+			0, 0, nullptr, 0, nullptr, 1, &barrier);
+	}
+	#pragma endregion CREATE COMMAND BUFFERS
+
+	#pragma region --- CREATE SYNC OBJECTS ---
+	void createSyncObjects() {
+		imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
+
+		VkSemaphoreCreateInfo semaphoreInfo{};
+		semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+		for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+		{
+			if (vkCreateSemaphore(device, &semaphoreInfo, allocator(VK_OBJECT_TYPE_SEMAPHORE), &imageAvailableSemaphores[i]) != VK_SUCCESS)
+			{
+				yeet broken_shoe("failed to create synchronization objects for a frame!");
+			}
+		}
+
+		if (timelineSemaphores)
+		{
+			// frame 0 never gets submitted, so waiting for it never blocks
+			VkSemaphoreTypeCreateInfo typeInfo{};
+			typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+			typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+			typeInfo.initialValue = 0;
+
+			VkSemaphoreCreateInfo timelineInfo{};
+			timelineInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+			timelineInfo.pNext = &typeInfo;
+
+			if (vkCreateSemaphore(device, &timelineInfo, allocator(VK_OBJECT_TYPE_SEMAPHORE), &sceneTimeline) != VK_SUCCESS
+				|| vkCreateSemaphore(device, &timelineInfo, allocator(VK_OBJECT_TYPE_SEMAPHORE), &frameTimeline) != VK_SUCCESS
+				|| vkCreateSemaphore(device, &timelineInfo, allocator(VK_OBJECT_TYPE_SEMAPHORE), &computeTimeline) != VK_SUCCESS)
+			{
+				yeet broken_shoe("failed to create timeline semaphores!");
+			}
+		}
+		else
+		{
+			inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
+
+			VkFenceCreateInfo fenceInfo{};
+			fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+			// start signaled, so the first wait on each frame in flight doesn't block forever
+			fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+			for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+			{
+				if (vkCreateFence(device, &fenceInfo, allocator(VK_OBJECT_TYPE_FENCE), &inFlightFences[i]) != VK_SUCCESS)
+				{
+					yeet broken_shoe("failed to create synchronization objects for a frame!");
+				}
+			}
+		}
+
+		createSwapChainSyncObjects();
+	}
+
+	// blocks until the graphics work of the frame with this number has finished, and the compute work up to computeFrame
+	void waitForFrame(uint64_t frame, uint64_t computeFrame = 0) {
+		if (timelineSemaphores)
+		{
+			array<VkSemaphore, 2> semaphores = { frameTimeline, computeTimeline };
+			array<uint64_t, 2> values = { frame, computeFrame };
+
+			VkSemaphoreWaitInfo waitInfo{};
+			waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+			waitInfo.semaphoreCount = computeFrame > 0 ? 2 : 1;
+			waitInfo.pSemaphores = semaphores.data();
+			waitInfo.pValues = values.data();
+			dispatch.vkWaitSemaphores(device, &waitInfo, UINT64_MAX);
+			return;
+		}
+
+		// frames finish in submission order, so the fence of the first frame in flight submitted at or after it will do
+		// without timeline semaphores nothing runs on the compute queue
+		optional<size_t> slot;
+		for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+		{
+			if (frameNumbers[i] >= frame && (!slot.has_value() || frameNumbers[i] < frameNumbers[slot.value()]))
+			{
+				slot = i;
+			}
+		}
+		if (slot.has_value())
+		{
+			dispatch.vkWaitForFences(device, 1, &inFlightFences[slot.value()], VK_TRUE, UINT64_MAX);
+		}
+	}
+
+	// synchronization objects that live as long as the swap chain images they belong to
+	void createSwapChainSyncObjects() {
+		renderFinishedSemaphores.resize(swapChainImages.size());
+		imageFrameNumbers.assign(swapChainImages.size(), 0);
+
+		VkSemaphoreCreateInfo semaphoreInfo{};
+		semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+		for (size_t i = 0; i < swapChainImages.size(); i++)
+		{
+			if (vkCreateSemaphore(device, &semaphoreInfo, allocator(VK_OBJECT_TYPE_SEMAPHORE), &renderFinishedSemaphores[i]) != VK_SUCCESS)
+			{
+				yeet broken_shoe("failed to create synchronization objects for a swap chain image!");
+			}
+		}
+	}
+	#pragma endregion CREATE SYNC OBJECTS
+
+	#pragma region --- CREATE TIMESTAMP QUERIES ---
+	// measures how long the GPU spends on each frame, which drives the render scale
+	void createTimestampQueries() {
+		QueueFamilyIndices indices = findQueueFamilies(physicalDevice);
+
+		uint32_t queueFamilyCount = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+		vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+		vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilies.data());
+
+		uint32_t validBits = queueFamilies[indices.graphicsFamily.value()].timestampValidBits;
+		if (validBits == 0)
+		{
+			logger.log(LOG_SEVERITY_WARNING, "graphics queue doesn't support timestamps, dynamic resolution disabled");
+			resolutionScaler.enabled = false;
+			return;
+		}
+		timestampMask = validBits >= 64 ? UINT64_MAX : (1ull << validBits) - 1;
+
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+		timestampPeriod = properties.limits.timestampPeriod;
+
+		VkQueryPoolCreateInfo queryPoolInfo{};
+		queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		queryPoolInfo.queryCount = MAX_FRAMES_IN_FLIGHT * 2;
+
+		if (vkCreateQueryPool(device, &queryPoolInfo, allocator(VK_OBJECT_TYPE_QUERY_POOL), &timestampQueryPool) != VK_SUCCESS)
+		{
+			yeet broken_shoe("failed to create timestamp query pool!");
+		}
+
+		// timestamps are only comparable within a queue, so the compute queue gets a pool of its own
+		uint32_t computeValidBits = asyncComputeSupported ? queueFamilies[sharedQueueFamilies[1]].timestampValidBits : 0;
+		if (computeValidBits > 0)
+		{
+			computeTimestampMask = computeValidBits >= 64 ? UINT64_MAX : (1ull << computeValidBits) - 1;
+			if (vkCreateQueryPool(device, &queryPoolInfo, allocator(VK_OBJECT_TYPE_QUERY_POOL), &computeTimestampQueryPool) != VK_SUCCESS)
+			{
+				yeet broken_shoe("failed to create compute timestamp query pool!");
+			}
+		}
+	}
+
+	// counts fragment shader invocations of the scene, which shows how much overdraw the depth test saves
+	void createStatisticsQueries() {
+		VkPhysicalDeviceFeatures features;
+		vkGetPhysicalDeviceFeatures(physicalDevice, &features);
+		if (!features.pipelineStatisticsQuery)
+		{
+			logger.log(LOG_SEVERITY_WARNING, "device doesn't support pipeline statistics, overdraw won't be measured");
+			return;
+		}
+
+		VkQueryPoolCreateInfo queryPoolInfo{};
+		queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		queryPoolInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+		queryPoolInfo.queryCount = MAX_FRAMES_IN_FLIGHT;
+		queryPoolInfo.pipelineStatistics = VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+
+		if (vkCreateQueryPool(device, &queryPoolInfo, allocator(VK_OBJECT_TYPE_QUERY_POOL), &statisticsQueryPool) != VK_SUCCESS)
+		{
+			yeet broken_shoe("failed to create pipeline statistics query pool!");
+		}
+	}
+	#pragma endregion CREATE TIMESTAMP QUERIES
+
+	#pragma region --- CREATE SPRITE RESOURCES ---
+	void createSpriteResources() {
+		#pragma region --- PIPELINES ---
+		// the texture, vec2 scale, vec2 offset
+		// the HUD asks for the same, so it ends up with this layout as well
+		const PipelineLayoutCache::Layout& layout = shaderLayout({ shaderCode(SPRITE_VERT_SHADER_PATH), shaderCode(SPRITE_FRAG_SHADER_PATH) });
+		spritePipelineLayout = layout.pipelineLayout;
+		spriteDescriptorSetLayout = layout.setLayouts.at(0);
+
+		for (size_t i = 0; i < spritePipelines.size(); i++)
+		{
+			spritePipelines[i] = buildGraphicsPipeline(spritePipelineDescription(static_cast<SpriteBlend>(i)));
+		}
+		#pragma endregion PIPELINES
+
+		#pragma region --- INDEX BUFFER ---
+		// written once through a staging buffer, then only ever read by the GPU
+		vector<uint16_t> indices = SpriteBatch::buildQuadIndices();
+		uploadDeviceLocalBuffer(indices.data(), sizeof(uint16_t) * indices.size(), VK_BUFFER_USAGE_INDEX_BUFFER_BIT, MemoryCategory::MESHES,
+			spriteIndexBuffer, spriteIndexBufferMemory);
+		#pragma endregion INDEX BUFFER
+
+		#pragma region --- VERTEX RINGS ---
+		// written by the CPU every frame and read once by the GPU, so they stay in host visible memory
+		// device local on top of that where the GPU allows it (resizable BAR, integrated GPUs)
+		VkDeviceSize vertexBufferSize = sizeof(SpriteVertex) * 4 * MAX_SPRITES;
+		for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+		{
+			createBuffer(vertexBufferSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, MemoryCategory::STAGING,
+				spriteVertexBuffers[i], spriteVertexBufferMemory[i], VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+			void* mapped;
+			vkMapMemory(device, spriteVertexBufferMemory[i], 0, vertexBufferSize, 0, &mapped);
+			spriteVertices[i] = static_cast<SpriteVertex*>(mapped);
+		}
+		#pragma endregion VERTEX RINGS
+
+		createSpriteTextures();
+	}
+
+	PipelineDescription spritePipelineDescription(SpriteBlend blend) {
+		PipelineDescription description{};
+		description.vertShaderCode = shaderCode(SPRITE_VERT_SHADER_PATH);
+		description.fragShaderCode = shaderCode(SPRITE_FRAG_SHADER_PATH);
+		description.layout = spritePipelineLayout;
+		description.blendMode = blend == SpriteBlend::ADDITIVE ? BlendMode::ADDITIVE : BlendMode::ALPHA;
+
+		VkVertexInputBindingDescription binding{};
+		binding.binding = 0;
+		binding.stride = sizeof(SpriteVertex);
+		binding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+		description.vertexBindings = { binding };
+
+		description.vertexAttributes = {
+			{ 0, 0, VK_FORMAT_R32G32_SFLOAT, static_cast<uint32_t>(offsetof(SpriteVertex, x)) },
+			{ 1, 0, VK_FORMAT_R32G32_SFLOAT, static_cast<uint32_t>(offsetof(SpriteVertex, u)) },
+			{ 2, 0, VK_FORMAT_R8G8B8A8_UNORM, static_cast<uint32_t>(offsetof(SpriteVertex, color)) }
+		};
+
+		return description;
+	}
+
+	// a few simple shapes, until there's a texture loader
+	void createSpriteTextures() {
+		#pragma region --- SAMPLER ---
+		VkSamplerCreateInfo samplerInfo{};
+		samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+		samplerInfo.magFilter = VK_FILTER_LINEAR;
+		samplerInfo.minFilter = VK_FILTER_LINEAR;
+		samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.anisotropyEnable = VK_FALSE;
+		samplerInfo.maxAnisotropy = 1.0f;
+		samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+		samplerInfo.unnormalizedCoordinates = VK_FALSE;
+		samplerInfo.compareEnable = VK_FALSE;
+		samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
+		samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+
+		if (vkCreateSampler(device, &samplerInfo, allocator(VK_OBJECT_TYPE_SAMPLER), &spriteSampler) != VK_SUCCESS)
+		{
+			yeet broken_shoe("failed to create sprite sampler!");
+		}
+		#pragma endregion SAMPLER
+
+		#pragma region --- DESCRIPTOR POOL ---
+		// a replaced texture keeps its set until the frames in flight are done with it,
+		// and every texture gets replaced at most once per frame
+		uint32_t maxSets = SPRITE_TEXTURE_COUNT * (MAX_FRAMES_IN_FLIGHT + 2);
+
+		VkDescriptorPoolSize poolSize{};
+		poolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		poolSize.descriptorCount = maxSets;
+
+		VkDescriptorPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+		poolInfo.poolSizeCount = 1;
+		poolInfo.pPoolSizes = &poolSize;
+		poolInfo.maxSets = maxSets;
+
+		if (vkCreateDescriptorPool(device, &poolInfo, allocator(VK_OBJECT_TYPE_DESCRIPTOR_POOL), &spriteDescriptorPool) != VK_SUCCESS)
+		{
+			yeet broken_shoe("failed to create sprite descriptor pool!");
+		}
+		#pragma endregion DESCRIPTOR POOL
+
+		spriteTextures.resize(SPRITE_TEXTURE_COUNT);
+		for (uint32_t i = 0; i < SPRITE_TEXTURE_COUNT; i++)
+		{
+			uint32_t memoryType = uploadSpriteTexture(i);
+
+			// cold textures get evicted and come back the next time a sprite uses them,
+			// the ones still in use get halved until they're down to MIN_SPRITE_TEXTURE_SIZE
+			spriteTextures[i].residencyId = residency.addResource(memoryType, MemoryCategory::TEXTURES,
+				[this, i]() {
+					retireSpriteTexture(i);
+				},
+				[this, i]() {
+					if (spriteTextures[i].size <= MIN_SPRITE_TEXTURE_SIZE)
+					{
+						return false;
+					}
+					retireSpriteTexture(i);
+					spriteTextures[i].size /= 2;
+					uploadSpriteTexture(i);
+					return true;
+				});
+		}
+
+		if (spriteBlockFormat.has_value())
+		{
+			ostringstream message;
+			message << "sprite textures in " << blockFormatName(spriteBlockFormat.value()) << ": "
+				<< spriteTextureBytes / 1024 << " KB instead of " << spriteTextureUncompressedBytes / 1024 << " KB as RGBA8"
+				<< ", encoded in " << spriteTextureEncodeTime << " ms";
+			logger.log(LOG_SEVERITY_INFO, message.str());
+		}
+	}
+
+	// generated at the current size of the texture, the patterns stay the same at every size
+	// returns the memory type it ended up in
+	uint32_t uploadSpriteTexture(uint32_t index) {
+		SpriteTexture& texture = spriteTextures[index];
+		uint32_t size = texture.size;
+		vector<uint32_t> pixels(size * size);
+
+		#pragma region --- PIXELS ---
+		for (uint32_t y = 0; y < size; y++)
+		{
+			for (uint32_t x = 0; x < size; x++)
+			{
+				// distance from the center, 1 at the edge
+				float dx = (x + 0.5f) / size * 2.0f - 1.0f;
+				float dy = (y + 0.5f) / size * 2.0f - 1.0f;
+				float distance = sqrt(dx * dx + dy * dy);
+
+				float alpha = 1.0f;
+				switch (index)
+				{
+				case 1: // soft disc
+					alpha = clamp(1.0f - distance, 0.0f, 1.0f);
+					break;
+				case 2: // ring
+					alpha = clamp(1.0f - abs(distance - 0.75f) * 8.0f, 0.0f, 1.0f);
+					break;
+				case 3: // checkerboard, 8 texels per square at full size
+				{
+					uint32_t square = max(size * 8 / SPRITE_TEXTURE_SIZE, 1u);
+					alpha = ((x / square + y / square) % 2 == 0) ? 1.0f : 0.25f;
+					break;
+				}
+				}
+
+				// white, the sprite color tints it
+				pixels[y * size + x] = 0x00FFFFFF | (static_cast<uint32_t>(alpha * 255.0f + 0.5f) << 24);
+			}
+		}
+		#pragma endregion PIXELS
+
+		VkDeviceSize pixelBytes = sizeof(uint32_t) * pixels.size();
+		spriteTextureUncompressedBytes += pixelBytes;
+
+		uint32_t memoryType;
+		if (spriteBlockFormat.has_value())
+		{
+			auto start = chrono::steady_clock::now();
+			vector<uint8_t> blocks = TextureCompressor::compress(pixels.data(), size, size, spriteBlockFormat.value(), thread::hardware_concurrency());
+			spriteTextureEncodeTime += toMilliseconds(chrono::steady_clock::now() - start);
+			spriteTextureBytes += blocks.size();
+
+			memoryType = createTextureImage(blocks.data(), blocks.size(), spriteTextureFormat, size, size, texture.image, texture.memory, texture.imageView);
+		}
+		else
+		{
+			spriteTextureBytes += pixelBytes;
+			memoryType = createTextureImage(pixels.data(), pixelBytes, VK_FORMAT_R8G8B8A8_UNORM, size, size, texture.image, texture.memory, texture.imageView);
+		}
+
+		#pragma region --- DESCRIPTOR SET ---
+		// a new set every time, the old one might still be bound in a frame in flight
+		VkDescriptorSetAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocInfo.descriptorPool = spriteDescriptorPool;
+		allocInfo.descriptorSetCount = 1;
+		allocInfo.pSetLayouts = &spriteDescriptorSetLayout;
+
+		if (vkAllocateDescriptorSets(device, &allocInfo, &texture.descriptorSet) != VK_SUCCESS)
+		{
+			yeet broken_shoe("failed to allocate sprite descriptor set!");
+		}
+
+		VkDescriptorImageInfo imageInfo{};
+		imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		imageInfo.imageView = texture.imageView;
+		imageInfo.sampler = spriteSampler;
+
+		VkWriteDescriptorSet descriptorWrite{};
+		descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		descriptorWrite.dstSet = texture.descriptorSet;
+		descriptorWrite.dstBinding = 0;
+		descriptorWrite.dstArrayElement = 0;
+		descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		descriptorWrite.descriptorCount = 1;
+		descriptorWrite.pImageInfo = &imageInfo;
+
+		vkUpdateDescriptorSets(device, 1, &descriptorWrite, 0, nullptr);
+		#pragma endregion DESCRIPTOR SET
+
+		return memoryType;
+	}
+
+	// hands the texture to the deletion queue, the frames in flight might still sample it
+	void retireSpriteTexture(uint32_t index) {
+		SpriteTexture& texture = spriteTextures[index];
+		residency.retire(texture.memory);
+
+		deletionQueue.push(submittedFrames, [this, oldTexture = texture]() {
+			vkDestroyImageView(device, oldTexture.imageView, allocator(VK_OBJECT_TYPE_IMAGE_VIEW));
+			vkDestroyImage(device, oldTexture.image, allocator(VK_OBJECT_TYPE_IMAGE));
+			freeDeviceMemory(oldTexture.memory);
+			vkFreeDescriptorSets(device, spriteDescriptorPool, 1, &oldTexture.descriptorSet);
+		});
+
+		texture.image = VK_NULL_HANDLE;
+		texture.memory = VK_NULL_HANDLE;
+		texture.imageView = VK_NULL_HANDLE;
+		texture.descriptorSet = VK_NULL_HANDLE;
+	}
+	#pragma endregion CREATE SPRITE RESOURCES
+
+	#pragma region --- CREATE LIGHTING RESOURCES ---
+	void createLightingResources() {
+		#pragma region --- PIPELINE LAYOUT ---
+		// the lights and the clusters, written by the CPU and by cluster.comp, read by mesh.frag
+		// vec4 inverseProjection
+		const PipelineLayoutCache::Layout& layout = shaderLayout({ shaderCode(CLUSTER_COMP_SHADER_PATH) });
+		lightBinningPipelineLayout = layout.pipelineLayout;
+		lightingDescriptorSetLayout = layout.setLayouts.at(0);
+		lightBinningPipeline = buildComputePipeline(shaderCode(CLUSTER_COMP_SHADER_PATH), lightBinningPipelineLayout);
+		#pragma endregion PIPELINE LAYOUT
+
+		#pragma region --- BUFFERS ---
+		// the light rings get written by the CPU every frame, like the instance rings
+		VkDeviceSize lightBufferSize = sizeof(LightHeader) + sizeof(LightData) * MAX_LIGHTS;
+		// a count and room for MAX_LIGHTS_PER_CLUSTER indices per cluster
+		VkDeviceSize clusterBufferSize = sizeof(uint32_t) * (MAX_LIGHTS_PER_CLUSTER + 1) * CLUSTER_GRID_X * CLUSTER_GRID_Y * CLUSTER_GRID_Z;
+		for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+		{
+			createBuffer(lightBufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, MemoryCategory::STAGING,
+				lightBuffers[i], lightBufferMemory[i], VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+			void* mapped;
+			vkMapMemory(device, lightBufferMemory[i], 0, lightBufferSize, 0, &mapped);
+			lightHeaders[i] = static_cast<LightHeader*>(mapped);
+			// mesh.frag reads the header before the first frame writes it when replaying a trace
+			*lightHeaders[i] = {};
+
+			// rebuilt by the GPU every frame, like the depth pyramid
+			createBuffer(clusterBufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryCategory::ATTACHMENTS,
+				clusterBuffers[i], clusterBufferMemory[i]);
+		}
+		#pragma endregion BUFFERS
+
+		#pragma region --- DESCRIPTOR SETS ---
+		VkDescriptorPoolSize poolSize{};
+		poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		// the lights and the clusters
+		poolSize.descriptorCount = 2 * MAX_FRAMES_IN_FLIGHT;
+
+		VkDescriptorPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		poolInfo.poolSizeCount = 1;
+		poolInfo.pPoolSizes = &poolSize;
+		poolInfo.maxSets = MAX_FRAMES_IN_FLIGHT;
+
+		if (vkCreateDescriptorPool(device, &poolInfo, allocator(VK_OBJECT_TYPE_DESCRIPTOR_POOL), &lightingDescriptorPool) != VK_SUCCESS)
+		{
+			yeet broken_shoe("failed to create lighting descriptor pool!");
+		}
+
+		array<VkDescriptorSetLayout, MAX_FRAMES_IN_FLIGHT> setLayouts;
+		setLayouts.fill(lightingDescriptorSetLayout);
+		VkDescriptorSetAllocateInfo setInfo{};
+		setInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		setInfo.descriptorPool = lightingDescriptorPool;
+		setInfo.descriptorSetCount = MAX_FRAMES_IN_FLIGHT;
+		setInfo.pSetLayouts = setLayouts.data();
+
+		if (vkAllocateDescriptorSets(device, &setInfo, lightingDescriptorSets.data()) != VK_SUCCESS)
+		{
+			yeet broken_shoe("failed to allocate lighting descriptor sets!");
+		}
+
+		for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+		{
+			array<VkDescriptorBufferInfo, 2> bufferInfos{};
+			bufferInfos[0].buffer = lightBuffers[i];
+			bufferInfos[0].range = VK_WHOLE_SIZE;
+			bufferInfos[1].buffer = clusterBuffers[i];
+			bufferInfos[1].range = VK_WHOLE_SIZE;
+
+			array<VkWriteDescriptorSet, 2> descriptorWrites{};
+			for (uint32_t binding = 0; binding < descriptorWrites.size(); binding++)
+			{
+				descriptorWrites[binding].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+				descriptorWrites[binding].dstSet = lightingDescriptorSets[i];
+				descriptorWrites[binding].dstBinding = binding;
+				descriptorWrites[binding].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+				descriptorWrites[binding].descriptorCount = 1;
+				descriptorWrites[binding].pBufferInfo = &bufferInfos[binding];
+			}
+			vkUpdateDescriptorSets(device, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+		}
+		#pragma endregion DESCRIPTOR SETS
+
+		#pragma region --- LIGHTS ---
+		// all of them up front, so every count shows the same lights
+		uniform_real_distribution<float> unit(0.0f, 1.0f);
+		pointLights.resize(MAX_LIGHTS);
+		for (PointLight& light : pointLights)
+		{
+			light.center = {
+				(unit(lightRandom) - 0.5f) * LIGHT_FIELD_WIDTH,
+				LIGHT_FIELD_BOTTOM + unit(lightRandom) * (LIGHT_FIELD_TOP - LIGHT_FIELD_BOTTOM),
+				-(LIGHT_FIELD_NEAR + unit(lightRandom) * (LIGHT_FIELD_FAR - LIGHT_FIELD_NEAR))
+			};
+			light.radius = LIGHT_MIN_RADIUS + unit(lightRandom) * (LIGHT_MAX_RADIUS - LIGHT_MIN_RADIUS);
+			// dim enough that a few of them overlapping doesn't wash everything out
+			light.color = { 0.1f + 0.4f * unit(lightRandom), 0.1f + 0.4f * unit(lightRandom), 0.1f + 0.4f * unit(lightRandom) };
+			light.phase = unit(lightRandom) * 6.2831853f;
+			light.speed = 0.5f + unit(lightRandom);
+		}
+		#pragma endregion LIGHTS
+	}
+	#pragma endregion CREATE LIGHTING RESOURCES
+
+	#pragma region --- CREATE MESH RESOURCES ---
+	void createMeshResources() {
+		// the lighting set, mat4 view projection, vec4 light direction
+		const PipelineLayoutCache::Layout& layout = shaderLayout({ shaderCode(MESH_VERT_SHADER_PATH), shaderCode(MESH_FRAG_SHADER_PATH) });
+		// the lighting descriptor sets got allocated with the set layout of cluster.comp
+		if (layout.setLayouts.at(0) != lightingDescriptorSetLayout)
+		{
+			yeet broken_shoe("mesh.frag and cluster.comp disagree about the lighting buffers!");
+		}
+		meshPipelineLayout = layout.pipelineLayout;
+		meshPipeline = buildGraphicsPipeline(meshPipelineDescription());
+
+		#pragma region --- INSTANCE RINGS ---
+		// written by the CPU every frame, like the sprite vertex rings
+		VkDeviceSize instanceBufferSize = sizeof(MeshInstanceData) * MAX_MESH_INSTANCES;
+		for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+		{
+			createBuffer(instanceBufferSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, MemoryCategory::STAGING,
+				meshInstanceBuffers[i], meshInstanceBufferMemory[i], VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+			void* mapped;
+			vkMapMemory(device, meshInstanceBufferMemory[i], 0, instanceBufferSize, 0, &mapped);
+			meshInstanceData[i] = static_cast<MeshInstanceData*>(mapped);
+		}
+		#pragma endregion INSTANCE RINGS
+
+		// the meshes themselves came in with loadAssets
+		setMeshBenchmark(meshBenchmark);
+	}
+
+	PipelineDescription meshPipelineDescription() {
+		PipelineDescription description{};
+		description.vertShaderCode = shaderCode(MESH_VERT_SHADER_PATH);
+		description.fragShaderCode = shaderCode(MESH_FRAG_SHADER_PATH);
+		description.layout = meshPipelineLayout;
+		description.depthTest = true;
+		description.depthWrite = true;
+
+		VkVertexInputBindingDescription vertexBinding{};
+		vertexBinding.binding = 0;
+		vertexBinding.stride = sizeof(MeshVertex);
+		vertexBinding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+		VkVertexInputBindingDescription instanceBinding{};
+		instanceBinding.binding = 1;
+		instanceBinding.stride = sizeof(MeshInstanceData);
+		instanceBinding.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+		description.vertexBindings = { vertexBinding, instanceBinding };
+
+		description.vertexAttributes = {
+			{ 0, 0, VK_FORMAT_R32G32B32_SFLOAT, static_cast<uint32_t>(offsetof(MeshVertex, position)) },
+			{ 1, 0, VK_FORMAT_R32G32B32_SFLOAT, static_cast<uint32_t>(offsetof(MeshVertex, normal)) },
+			{ 2, 0, VK_FORMAT_R32G32_SFLOAT, static_cast<uint32_t>(offsetof(MeshVertex, uv)) },
+			{ 3, 1, VK_FORMAT_R32G32B32_SFLOAT, static_cast<uint32_t>(offsetof(MeshInstanceData, position)) },
+			{ 4, 1, VK_FORMAT_R32G32B32_SFLOAT, static_cast<uint32_t>(offsetof(MeshInstanceData, scale)) },
+			{ 5, 1, VK_FORMAT_R32G32_SFLOAT, static_cast<uint32_t>(offsetof(MeshInstanceData, rotation)) }
+		};
+
+		return description;
+	}
+
+	struct ImportedMesh {
+		MeshData mesh;
+		MeshImportStats stats;
+		// empty when the import worked
+		string error;
+	};
+
+	// imports every mesh in MESH_DIRECTORY into one vertex and one index buffer, followed by the cube the city is built from
+	// all of them get imported at once on the asset workers, the upload waits for the last one and happens on the main thread
+	Task<void> loadMeshes(JobSystem& jobs) {
+		meshStartTime = chrono::steady_clock::now();
+
+		error_code error;
+		vector<string> paths;
+		if (filesystem::is_directory(MESH_DIRECTORY, error))
+		{
+			for (const auto& entry : filesystem::directory_iterator(MESH_DIRECTORY, error))
+			{
+				string extension = entry.path().extension().string();
+				transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return static_cast<char>(tolower(c)); });
+				if (extension == ".obj" || extension == ".gltf" || extension == ".glb")
+				{
+					paths.push_back(entry.path().string());
+				}
+			}
+			sort(paths.begin(), paths.end());
+		}
+
+		vector<Task<ImportedMesh>> imports;
+		for (const string& path : paths)
+		{
+			imports.push_back(importMesh(jobs, path));
+		}
+		vector<ImportedMesh> imported = co_await whenAll(move(imports));
+
+		co_await mainThreadJobs.schedule();
+
+		vector<MeshVertex> vertices;
+		vector<uint32_t> indices;
+		for (size_t i = 0; i < paths.size(); i++)
+		{
+			if (!imported[i].error.empty())
+			{
+				logger.log(LOG_SEVERITY_ERROR, "failed to import " + paths[i] + ": " + imported[i].error);
+				continue;
+			}
+
+			addLoadedMesh(filesystem::path(paths[i]).filename().string(), imported[i].mesh, vertices, indices);
+			logMeshImport(meshes.back(), imported[i].stats);
+		}
+
+		cubeMesh = static_cast<uint32_t>(meshes.size());
+		addLoadedMesh("cube", buildCubeMesh(), vertices, indices);
+
+		meshVertexBufferSize = sizeof(MeshVertex) * vertices.size();
+		meshIndexBufferSize = sizeof(uint32_t) * indices.size();
+		// transfer source so they can be read back into a command trace
+		uploadDeviceLocalBuffer(vertices.data(), meshVertexBufferSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			MemoryCategory::MESHES, meshVertexBuffer, meshVertexBufferMemory);
+		uploadDeviceLocalBuffer(indices.data(), meshIndexBufferSize, VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			MemoryCategory::MESHES, meshIndexBuffer, meshIndexBufferMemory);
+	}
+
+	// a mesh that fails to import gets skipped, it doesn't take the others down with it
+	Task<ImportedMesh> importMesh(JobSystem& jobs, string path) {
+		co_await jobs.schedule();
+
+		ImportedMesh imported;
+		try
+		{
+			imported.mesh = MeshImporter::load(path, imported.stats);
+		}
+		catch (const exception& e)
+		{
+			imported.error = e.what();
+		}
+		countLoadedAsset(path);
+		co_return imported;
+	}
+
+	void addLoadedMesh(const string& name, const MeshData& mesh, vector<MeshVertex>& vertices, vector<uint32_t>& indices) {
+		LoadedMesh loaded;
+		loaded.name = name;
+		loaded.lods = mesh.lods;
+		for (MeshLod& lod : loaded.lods)
+		{
+			lod.firstIndex += static_cast<uint32_t>(indices.size());
+		}
+		loaded.vertexOffset = static_cast<int32_t>(vertices.size());
+		float radiusSquared = 0.0f;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			loaded.center[axis] = (mesh.boundsMin[axis] + mesh.boundsMax[axis]) * 0.5f;
+			loaded.halfExtent[axis] = (mesh.boundsMax[axis] - mesh.boundsMin[axis]) * 0.5f;
+			radiusSquared += loaded.halfExtent[axis] * loaded.halfExtent[axis];
+		}
+		loaded.radius = max(sqrt(radiusSquared), 1e-6f);
+		meshes.push_back(loaded);
+
+		vertices.insert(vertices.end(), mesh.vertices.begin(), mesh.vertices.end());
+		indices.insert(indices.end(), mesh.indices.begin(), mesh.indices.end());
+	}
+
+	// from -1 to 1 on every axis, with a flat normal per face
+	static MeshData buildCubeMesh() {
+		MeshData cube;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			for (float sign : { 1.0f, -1.0f })
+			{
+				// u x v points along the normal, so the corners go counterclockwise seen from outside
+				int u = (axis + (sign > 0.0f ? 1 : 2)) % 3;
+				int v = (axis + (sign > 0.0f ? 2 : 1)) % 3;
+				uint32_t first = static_cast<uint32_t>(cube.vertices.size());
+				const array<array<float, 2>, 4> corners = { { { -1.0f, -1.0f }, { 1.0f, -1.0f }, { 1.0f, 1.0f }, { -1.0f, 1.0f } } };
+				for (const array<float, 2>& corner : corners)
+				{
+					MeshVertex vertex{};
+					vertex.position[axis] = sign;
+					vertex.position[u] = corner[0];
+					vertex.position[v] = corner[1];
+					vertex.normal[axis] = sign;
+					vertex.uv[0] = corner[0] * 0.5f + 0.5f;
+					vertex.uv[1] = corner[1] * 0.5f + 0.5f;
+					cube.vertices.push_back(vertex);
+				}
+				cube.indices.insert(cube.indices.end(), { first, first + 1, first + 2, first + 2, first + 3, first });
+			}
+		}
+		for (int axis = 0; axis < 3; axis++)
+		{
+			cube.boundsMin[axis] = -1.0f;
+			cube.boundsMax[axis] = 1.0f;
+		}
+		cube.lods = { { 0, static_cast<uint32_t>(cube.indices.size()), 0.0f } };
+		return cube;
+	}
+
+	void logMeshImport(const LoadedMesh& mesh, const MeshImportStats& stats) {
+		ostringstream message;
+		message << "mesh " << mesh.name << ": " << stats.vertexCount << " vertices, " << stats.triangleCount << " triangles"
+			<< " | LODs";
+		for (size_t lod = 1; lod < mesh.lods.size(); lod++)
+		{
+			message << (lod > 1 ? ", " : " ") << mesh.lods[lod].indexCount / 3 << " (error " << mesh.lods[lod].error / mesh.radius << ")";
+		}
+		message << " | ACMR " << stats.before.acmr << " -> " << stats.after.acmr
+			<< " | ATVR " << stats.before.atvr << " -> " << stats.after.atvr;
+		if (stats.fromCache)
+		{
+			message << " | " << stats.loadTimeMs << " ms from cache, "
+				<< stats.importTimeMs / max(stats.loadTimeMs, 0.001) << "x faster than importing (" << stats.importTimeMs << " ms)";
+		}
+		else
+		{
+			message << " | imported in " << stats.loadTimeMs << " ms, welded from " << stats.sourceVertexCount << " vertices";
+		}
+		logger.log(LOG_SEVERITY_INFO, message.str());
+	}
+	#pragma endregion CREATE MESH RESOURCES
+
+	#pragma region --- CREATE HUD RESOURCES ---
+	void createHudResources() {
+		hudPipeline = buildGraphicsPipeline(hudPipelineDescription());
+
+		#pragma region --- INSTANCE RINGS ---
+		// written by the CPU every frame like the sprite vertices
+		VkDeviceSize instanceBufferSize = sizeof(HudInstance) * MAX_HUD_QUADS;
+		for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+		{
+			createBuffer(instanceBufferSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, MemoryCategory::STAGING,
+				hudInstanceBuffers[i], hudInstanceBufferMemory[i], VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+			void* mapped;
+			vkMapMemory(device, hudInstanceBufferMemory[i], 0, instanceBufferSize, 0, &mapped);
+			hudInstances[i] = static_cast<HudInstance*>(mapped);
+		}
+		#pragma endregion INSTANCE RINGS
+
+		#pragma region --- GLYPH ATLAS ---
+		vector<uint32_t> pixels = PerfHud::bakeAtlas();
+		// sampled with nearest filtering, block compression would smear the glyph edges
+		createTextureImage(pixels.data(), sizeof(uint32_t) * pixels.size(), VK_FORMAT_R8G8B8A8_UNORM, PerfHud::ATLAS_WIDTH, PerfHud::ATLAS_HEIGHT,
+			hudAtlasImage, hudAtlasMemory, hudAtlasView);
+
+		VkSamplerCreateInfo samplerInfo{};
+		samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+		samplerInfo.magFilter = VK_FILTER_NEAREST;
+		samplerInfo.minFilter = VK_FILTER_NEAREST;
+		samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.anisotropyEnable = VK_FALSE;
+		samplerInfo.maxAnisotropy = 1.0f;
+		samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+		samplerInfo.unnormalizedCoordinates = VK_FALSE;
+		samplerInfo.compareEnable = VK_FALSE;
+		samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
+		samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+
+		if (vkCreateSampler(device, &samplerInfo, allocator(VK_OBJECT_TYPE_SAMPLER), &hudSampler) != VK_SUCCESS)
+		{
+			yeet broken_shoe("failed to create HUD sampler!");
+		}
+		#pragma endregion GLYPH ATLAS
+
+		#pragma region --- DESCRIPTOR SET ---
+		VkDescriptorPoolSize poolSize{};
+		poolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		poolSize.descriptorCount = 1;
+
+		VkDescriptorPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		poolInfo.poolSizeCount = 1;
+		poolInfo.pPoolSizes = &poolSize;
+		poolInfo.maxSets = 1;
+
+		if (vkCreateDescriptorPool(device, &poolInfo, allocator(VK_OBJECT_TYPE_DESCRIPTOR_POOL), &hudDescriptorPool) != VK_SUCCESS)
+		{
+			yeet broken_shoe("failed to create HUD descriptor pool!");
+		}
+
+		VkDescriptorSetAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocInfo.descriptorPool = hudDescriptorPool;
+		allocInfo.descriptorSetCount = 1;
+		allocInfo.pSetLayouts = &spriteDescriptorSetLayout;
+
+		if (vkAllocateDescriptorSets(device, &allocInfo, &hudDescriptorSet) != VK_SUCCESS)
+		{
+			yeet broken_shoe("failed to allocate HUD descriptor set!");
+		}
+
+		VkDescriptorImageInfo imageInfo{};
+		imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		imageInfo.imageView = hudAtlasView;
+		imageInfo.sampler = hudSampler;
+
+		VkWriteDescriptorSet descriptorWrite{};
+		descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		descriptorWrite.dstSet = hudDescriptorSet;
+		descriptorWrite.dstBinding = 0;
+		descriptorWrite.dstArrayElement = 0;
+		descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		descriptorWrite.descriptorCount = 1;
+		descriptorWrite.pImageInfo = &imageInfo;
+
+		vkUpdateDescriptorSets(device, 1, &descriptorWrite, 0, nullptr);
+		#pragma endregion DESCRIPTOR SET
+	}
+
+	// no vertex buffer for the corners, hud.vert picks them by vertex index
+	PipelineDescription hudPipelineDescription() {
+		PipelineDescription description{};
+		description.vertShaderCode = shaderCode(HUD_VERT_SHADER_PATH);
+		description.fragShaderCode = shaderCode(SPRITE_FRAG_SHADER_PATH);
+		description.layout = spritePipelineLayout;
+		description.blendMode = BlendMode::ALPHA;
+
+		VkVertexInputBindingDescription binding{};
+		binding.binding = 0;
+		binding.stride = sizeof(HudInstance);
+		binding.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+		description.vertexBindings = { binding };
+
+		description.vertexAttributes = {
+			{ 0, 0, VK_FORMAT_R32G32B32A32_SFLOAT, static_cast<uint32_t>(offsetof(HudInstance, x)) },
+			{ 1, 0, VK_FORMAT_R32G32B32A32_SFLOAT, static_cast<uint32_t>(offsetof(HudInstance, u0)) },
+			{ 2, 0, VK_FORMAT_R8G8B8A8_UNORM, static_cast<uint32_t>(offsetof(HudInstance, color)) }
+		};
+
+		return description;
+	}
+	#pragma endregion CREATE HUD RESOURCES
+
+	#pragma region --- DEVICE MEMORY ---
+	// all device memory gets allocated through here, so the residency manager can count it and make room for it first
+	// only fails when the driver still can't allocate after everything evictable is gone
+	VkResult allocateDeviceMemory(const VkMemoryAllocateInfo& allocInfo, MemoryCategory category, VkDeviceMemory& memory) {
+		if (!residency.makeRoom(allocInfo.memoryTypeIndex, allocInfo.allocationSize, submittedFrames))
+		{
+			logger.log(LOG_SEVERITY_WARNING, "allocating " + to_string(allocInfo.allocationSize / 1024) + " KB past the memory budget");
+		}
+
+		VkResult result = vkAllocateMemory(device, &allocInfo, allocator(VK_OBJECT_TYPE_DEVICE_MEMORY), &memory);
+		if (result == VK_ERROR_OUT_OF_DEVICE_MEMORY)
+		{
+			// the budget was off, so everything that isn't needed for this frame goes,
+			// and the deletion queue has to actually free it before trying again
+			logger.log(LOG_SEVERITY_WARNING, "out of device memory, evicting everything that isn't in use");
+			updateMemoryBudget();
+			residency.makeRoom(allocInfo.memoryTypeIndex, allocInfo.allocationSize, submittedFrames, true);
+			vkDeviceWaitIdle(device);
+			deletionQueue.flushAll();
+
+			result = vkAllocateMemory(device, &allocInfo, allocator(VK_OBJECT_TYPE_DEVICE_MEMORY), &memory);
+		}
+
+		if (result == VK_SUCCESS)
+		{
+			residency.add(memory, allocInfo.memoryTypeIndex, allocInfo.allocationSize, category);
+		}
+		return result;
+	}
+
+	void freeDeviceMemory(VkDeviceMemory memory) {
+		residency.remove(memory);
+		vkFreeMemory(device, memory, allocator(VK_OBJECT_TYPE_DEVICE_MEMORY));
+	}
+
+	// cheap enough to do once per stats report, without the extension the fallback budgets from pickPhysicalDevice stay
+	void updateMemoryBudget() {
+		if (!memoryBudgetSupported)
+		{
+			return;
+		}
+
+		VkPhysicalDeviceMemoryBudgetPropertiesEXT budget{};
+		budget.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+
+		VkPhysicalDeviceMemoryProperties2 memoryProperties{};
+		memoryProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+		memoryProperties.pNext = &budget;
+		vkGetPhysicalDeviceMemoryProperties2(physicalDevice, &memoryProperties);
+
+		residency.updateBudget(budget);
+	}
+	#pragma endregion DEVICE MEMORY
+
+	#pragma region --- BUFFER HELPERS ---
+	// preferredProperties get tried on top of the required ones first
+	// sharedWithCompute for buffers the compute queue uses as well
+	void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, MemoryCategory category,
+		VkBuffer& buffer, VkDeviceMemory& bufferMemory, VkMemoryPropertyFlags preferredProperties = 0, bool sharedWithCompute = false) {
+		VkBufferCreateInfo bufferInfo{};
+		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferInfo.size = size;
+		bufferInfo.usage = usage;
+		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		if (sharedWithCompute)
+		{
+			shareWithComputeQueue(bufferInfo);
+		}
+
+		if (vkCreateBuffer(device, &bufferInfo, allocator(VK_OBJECT_TYPE_BUFFER), &buffer) != VK_SUCCESS)
+		{
+			yeet broken_shoe("failed to create buffer!");
+		}
+
+		VkMemoryRequirements memoryRequirements;
+		vkGetBufferMemoryRequirements(device, buffer, &memoryRequirements);
+
+		optional<uint32_t> memoryType;
+		if (preferredProperties != 0)
+		{
+			memoryType = findOptionalMemoryType(memoryRequirements.memoryTypeBits, properties | preferredProperties);
+		}
+
+		VkMemoryAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocInfo.allocationSize = memoryRequirements.size;
+		allocInfo.memoryTypeIndex = memoryType.has_value()
+			? memoryType.value()
+			: findMemoryType(memoryRequirements.memoryTypeBits, properties);
+
+		if (allocateDeviceMemory(allocInfo, category, bufferMemory) != VK_SUCCESS)
+		{
+			yeet broken_shoe("failed to allocate buffer memory!");
+		}
+
+		vkBindBufferMemory(device, buffer, bufferMemory, 0);
+	}
+
+	// sampled image, uploaded through a staging buffer
+	// the data is tightly packed texels or blocks of the format, imageSize bytes of it
+	// returns the memory type it ended up in
+	uint32_t createTextureImage(const void* pixels, VkDeviceSize imageSize, VkFormat format, uint32_t width, uint32_t height,
+		VkImage& image, VkDeviceMemory& imageMemory, VkImageView& imageView) {
+
+		VkBuffer stagingBuffer;
+		VkDeviceMemory stagingBufferMemory;
+		createBuffer(imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, MemoryCategory::STAGING, stagingBuffer, stagingBufferMemory);
+
+		void* data;
+		vkMapMemory(device, stagingBufferMemory, 0, imageSize, 0, &data);
+		memcpy(data, pixels, static_cast<size_t>(imageSize));
+		vkUnmapMemory(device, stagingBufferMemory);
+
+		VkImageCreateInfo imageInfo{};
+		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageInfo.imageType = VK_IMAGE_TYPE_2D;
+		imageInfo.extent = { width, height, 1 };
+		imageInfo.mipLevels = 1;
+		imageInfo.arrayLayers = 1;
+		imageInfo.format = format;
+		imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+
+		if (vkCreateImage(device, &imageInfo, allocator(VK_OBJECT_TYPE_IMAGE), &image) != VK_SUCCESS)
+		{
+			yeet broken_shoe("failed to create texture image!");
+		}
+
+		VkMemoryRequirements memoryRequirements;
+		vkGetImageMemoryRequirements(device, image, &memoryRequirements);
+
+		VkMemoryAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocInfo.allocationSize = memoryRequirements.size;
+		allocInfo.memoryTypeIndex = findMemoryType(memoryRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+		if (allocateDeviceMemory(allocInfo, MemoryCategory::TEXTURES, imageMemory) != VK_SUCCESS)
+		{
+			yeet broken_shoe("failed to allocate texture image memory!");
+		}
+		vkBindImageMemory(device, image, imageMemory, 0);
+
+		VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+		recordImageTransition(commandBuffer, image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+
+		VkBufferImageCopy region{};
+		region.bufferOffset = 0;
+		region.bufferRowLength = 0;
+		region.bufferImageHeight = 0;
+		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.mipLevel = 0;
+		region.imageSubresource.baseArrayLayer = 0;
+		region.imageSubresource.layerCount = 1;
+		region.imageOffset = { 0, 0, 0 };
+		region.imageExtent = { width, height, 1 };
+		dispatch.vkCmdCopyBufferToImage(commandBuffer, stagingBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+		recordImageTransition(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		endSingleTimeCommands(commandBuffer);
+
+		vkDestroyBuffer(device, stagingBuffer, allocator(VK_OBJECT_TYPE_BUFFER));
+		freeDeviceMemory(stagingBufferMemory);
+
+		VkImageViewCreateInfo viewInfo{};
+		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		viewInfo.image = image;
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format = format;
+		viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		viewInfo.subresourceRange.baseMipLevel = 0;
+		viewInfo.subresourceRange.levelCount = 1;
+		viewInfo.subresourceRange.baseArrayLayer = 0;
+		viewInfo.subresourceRange.layerCount = 1;
+
+		if (vkCreateImageView(device, &viewInfo, allocator(VK_OBJECT_TYPE_IMAGE_VIEW), &imageView) != VK_SUCCESS)
+		{
+			yeet broken_shoe("failed to create texture image view!");
+		}
+
+		return allocInfo.memoryTypeIndex;
+	}
+
+	// only for the two transitions of an upload
+	void recordImageTransition(VkCommandBuffer commandBuffer, VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout) {
+		VkImageMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.oldLayout = oldLayout;
+		barrier.newLayout = newLayout;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = image;
+		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		barrier.subresourceRange.baseMipLevel = 0;
+		barrier.subresourceRange.levelCount = 1;
+		barrier.subresourceRange.baseArrayLayer = 0;
+		barrier.subresourceRange.layerCount = 1;
+
+		VkPipelineStageFlags sourceStage;
+		VkPipelineStageFlags destinationStage;
+
+		if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED)
+		{
+			barrier.srcAccessMask = 0;
+			barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+			destinationStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+		}
+		else
+		{
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+			sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+			destinationStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+		}
+
+		dispatch.vkCmdPipelineBarrier(commandBuffer, sourceStage, destinationStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+	}
+
+	// for data the GPU only reads, goes through a staging buffer
+	void uploadDeviceLocalBuffer(const void* contents, VkDeviceSize size, VkBufferUsageFlags usage, MemoryCategory category, VkBuffer& buffer, VkDeviceMemory& bufferMemory) {
+		VkBuffer stagingBuffer;
+		VkDeviceMemory stagingBufferMemory;
+		createBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, MemoryCategory::STAGING, stagingBuffer, stagingBufferMemory);
+
+		void* data;
+		vkMapMemory(device, stagingBufferMemory, 0, size, 0, &data);
+		memcpy(data, contents, static_cast<size_t>(size));
+		vkUnmapMemory(device, stagingBufferMemory);
+
+		createBuffer(size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, category, buffer, bufferMemory);
+		copyBuffer(stagingBuffer, buffer, size);
+
+		vkDestroyBuffer(device, stagingBuffer, allocator(VK_OBJECT_TYPE_BUFFER));
+		freeDeviceMemory(stagingBufferMemory);
+	}
+
+	void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size) {
+		VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+
+		VkBufferCopy copyRegion{};
+		copyRegion.srcOffset = 0;
+		copyRegion.dstOffset = 0;
+		copyRegion.size = size;
+		dispatch.vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
+
+		endSingleTimeCommands(commandBuffer);
+	}
+
+	// the other way around, waits for the graphics queue like the uploads
+	vector<uint8_t> readBackBuffer(VkBuffer buffer, VkDeviceSize size) {
+		VkBuffer stagingBuffer;
+		VkDeviceMemory stagingBufferMemory;
+		createBuffer(size, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, MemoryCategory::STAGING, stagingBuffer, stagingBufferMemory);
+		copyBuffer(buffer, stagingBuffer, size);
+
+		void* data;
+		vkMapMemory(device, stagingBufferMemory, 0, size, 0, &data);
+		vector<uint8_t> contents(static_cast<const uint8_t*>(data), static_cast<const uint8_t*>(data) + size);
+		vkUnmapMemory(device, stagingBufferMemory);
+
+		vkDestroyBuffer(device, stagingBuffer, allocator(VK_OBJECT_TYPE_BUFFER));
+		freeDeviceMemory(stagingBufferMemory);
+		return contents;
+	}
+
+	// for uploads at startup, waits for the graphics queue to finish
+	VkCommandBuffer beginSingleTimeCommands() {
+		VkCommandBufferAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocInfo.commandPool = commandPool;
+		allocInfo.commandBufferCount = 1;
+
+		VkCommandBuffer commandBuffer;
+		vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer);
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		dispatch.vkBeginCommandBuffer(commandBuffer, &beginInfo);
+
+		return commandBuffer;
+	}
+
+	void endSingleTimeCommands(VkCommandBuffer commandBuffer) {
+		dispatch.vkEndCommandBuffer(commandBuffer);
+
+		VkSubmitInfo submitInfo{};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &commandBuffer;
+
+		dispatch.vkQueueSubmit(graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
+		vkQueueWaitIdle(graphicsQueue);
+
+		vkFreeCommandBuffers(device, commandPool, 1, &commandBuffer);
+	}
+	#pragma endregion BUFFER HELPERS
+	#pragma endregion INIT VULKAN
+
+	#pragma region --- RECREATE SWAP CHAIN ---
+	// used for window resizes, out of date swap chains and present mode switches
+	// the render pass and pipeline don't depend on the extent, only the swap chain and what's built on its images gets rebuilt.
+	// the old objects are handed to the deletion queue instead of waiting for the device to go idle,
+	// so frames already in flight keep running while the new swap chain gets built
+	void recreateSwapChain() {
+		auto start = chrono::steady_clock::now();
+
+		HostAllocator::ArenaScope arenaScope(HostArena::SWAPCHAIN);
+		uint64_t allocationsBefore = hostAllocator.allocationCount();
+		uint64_t mallocsBefore = hostAllocator.systemAllocationCount();
+
+		VkSwapchainKHR oldSwapChain = swapChain;
+		vector<VkImageView> oldImageViews = move(swapChainImageViews);
+		vector<VkSemaphore> oldRenderFinishedSemaphores = move(renderFinishedSemaphores);
+		VkExtent2D oldExtent = swapChainExtent;
+
+		// chains oldSwapChain through swapChain
+		createSwapChain();
+		createImageViews();
+		createSwapChainSyncObjects();
+		swapChainOutdated = false;
+
+		// the presentation engine has no fence to tell when it's done with an image,
+		// by the time the frames submitted so far have finished, their presents have been queued behind them
+		deletionQueue.push(submittedFrames, [this, oldSwapChain, oldImageViews, oldRenderFinishedSemaphores]() {
+			destroySwapChain(oldSwapChain, oldImageViews, oldRenderFinishedSemaphores);
+		});
+
+		// a present mode switch keeps the extent, and with it the scene target
+		if (swapChainExtent.width != oldExtent.width || swapChainExtent.height != oldExtent.height)
+		{
+			SceneTarget oldSceneTarget = sceneTarget;
+			createSceneTarget();
+			deletionQueue.push(submittedFrames, [this, oldSceneTarget]() {
+				destroySceneTarget(oldSceneTarget);
+			});
+
+			if (captureActive)
+			{
+				// copies still in flight have the old size, let them finish rather than dropping them
+				drainCaptures();
+				destroyCaptureBuffers();
+				createCaptureBuffers();
+			}
+		}
+		else
+		{
+			updateRenderExtent();
+		}
+
+		// after the first recreation the pools should cover nearly all of it
+		ostringstream message;
+		message << "swap chain recreated at " << swapChainExtent.width << "x" << swapChainExtent.height
+			<< " in " << toMilliseconds(chrono::steady_clock::now() - start) << " ms: "
+			<< hostAllocator.allocationCount() - allocationsBefore << " host allocations, "
+			<< hostAllocator.systemAllocationCount() - mallocsBefore << " of them from malloc";
+		logger.log(LOG_SEVERITY_INFO, message.str());
+	}
+
+	void cleanupSwapChain() {
+		destroySceneTarget(sceneTarget);
+		destroySwapChain(swapChain, swapChainImageViews, renderFinishedSemaphores);
+	}
+
+	void destroySwapChain(VkSwapchainKHR oldSwapChain, const vector<VkImageView>& imageViews, const vector<VkSemaphore>& semaphores) {
+		for (VkSemaphore semaphore : semaphores)
+		{
+			vkDestroySemaphore(device, semaphore, allocator(VK_OBJECT_TYPE_SEMAPHORE));
+		}
+
+		for (VkImageView imageView : imageViews) {
+			vkDestroyImageView(device, imageView, allocator(VK_OBJECT_TYPE_IMAGE_VIEW));
+		}
+
+		vkDestroySwapchainKHR(device, oldSwapChain, allocator(VK_OBJECT_TYPE_SWAPCHAIN_KHR));
+	}
+
+	// a minimized window has a 0x0 framebuffer, which can't have a swap chain
+	bool isMinimized() {
+		if (window == nullptr)
+		{
+			return false;
+		}
+
+		int width, height;
+		glfwGetFramebufferSize(window, &width, &height);
+		return width == 0 || height == 0;
+	}
+	#pragma endregion RECREATE SWAP CHAIN
+
+	#pragma region --- HOST MEMORY ---
+	// allocation callbacks for creating or destroying an object of the given type
+	// the same type has to be passed to both, so the stats line up
+	const VkAllocationCallbacks* allocator(VkObjectType type) {
+		return hostAllocator.callbacks(type);
+	}
+	#pragma endregion HOST MEMORY
+
+	#pragma region --- DEBUG ---
+	void setupDebugMessenger() {
+		if (!enableValidationLayers)
+		{
+			return;
+		}
+
+		VkDebugUtilsMessengerCreateInfoEXT createInfo;
+		populateDebugMessengerCreateInfo(createInfo);
+
+		if (CreateDebugUtilsMessengerEXT(instance, &createInfo, allocator(VK_OBJECT_TYPE_DEBUG_UTILS_MESSENGER_EXT), &debugMessenger) != VK_SUCCESS)
+		{
+			yeet broken_shoe("failed to set up debug messenger!");
+		}
+	}
+
+	void populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT& createInfo) {
+		createInfo = {};
+		createInfo.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT;
+		// subscribe to everything, the logger filters at runtime
+		// default severities = VK_DEBUG_VERBOSE | VK_DEBUG_WARNING | VK_DEBUG_ERROR;
+		createInfo.messageSeverity = VK_DEBUG_VERBOSE | VK_DEBUG_INFO | VK_DEBUG_WARNING | VK_DEBUG_ERROR;
+		// default types = VK_DEBUG_TYPE_GENERAL | VK_DEBUG_TYPE_VALIDATION | VK_DEBUG_TYPE_PERFORMANCE;
+		createInfo.messageType = VK_DEBUG_TYPE_GENERAL | VK_DEBUG_TYPE_VALIDATION | VK_DEBUG_TYPE_PERFORMANCE;
+		createInfo.pfnUserCallback = debugCallback;
+		// handed to debugCallback
+		createInfo.pUserData = &logger;
+	}
+
+	// called on whichever thread the driver is reporting from,
+	// only copies the message into the logger's queue so it doesn't stall that thread
+	static VKAPI_ATTR VkBool32 VKAPI_CALL debugCallback(
+		VkDebugUtilsMessageSeverityFlagBitsEXT msgSeverity,
+		VkDebugUtilsMessageTypeFlagsEXT msgType,
+		const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData,
+		void* pUserData) {
+		auto logger = reinterpret_cast<Logger*>(pUserData);
+		logger->log(msgSeverity, msgType, pCallbackData->messageIdNumber, pCallbackData->pMessageIdName, pCallbackData->pMessage);
+
+		return VK_FALSE;
+	}
+
+	static VkResult CreateDebugUtilsMessengerEXT(
+		VkInstance instance,
+		const VkDebugUtilsMessengerCreateInfoEXT* pCreateInfo,
+		const VkAllocationCallbacks* pAllocator, // heh, Pal-Locator
+		VkDebugUtilsMessengerEXT* pDebugMessenger)
+	{
+		auto func = (PFN_vkCreateDebugUtilsMessengerEXT)vkGetInstanceProcAddr(instance, "vkCreateDebugUtilsMessengerEXT");
+
+		if (func != nullptr)
+		{
+			return func(instance, pCreateInfo, pAllocator, pDebugMessenger);
+		}
+		else {
+			return VK_ERROR_EXTENSION_NOT_PRESENT;
+		}
+	}
+
+	static VkResult CreateHeadlessSurfaceEXT(
+		VkInstance instance,
+		const VkHeadlessSurfaceCreateInfoEXT* pCreateInfo,
+		const VkAllocationCallbacks* pAllocator,
+		VkSurfaceKHR* pSurface)
+	{
+		auto func = (PFN_vkCreateHeadlessSurfaceEXT)vkGetInstanceProcAddr(instance, "vkCreateHeadlessSurfaceEXT");
+
+		if (func != nullptr)
+		{
+			return func(instance, pCreateInfo, pAllocator, pSurface);
+		}
+		else {
+			return VK_ERROR_EXTENSION_NOT_PRESENT;
+		}
+	}
+
+	static void DestroyDebugUtilsMessengerEXT(
+		VkInstance instance,
+		VkDebugUtilsMessengerEXT debugMessenger,
+		const VkAllocationCallbacks* pAllocator)
+	{
+		auto func = (PFN_vkDestroyDebugUtilsMessengerEXT)vkGetInstanceProcAddr(instance, "vkDestroyDebugUtilsMessengerEXT");
+
+		if (func != nullptr)
+		{
+			func(instance, debugMessenger, pAllocator);
+		}
+	}
+	#pragma endregion DEBUG
+	
+	#pragma region --- MAIN LOOP ---
+	void mainLoop() {
+		logger.log(LOG_SEVERITY_INFO, "present policies: F1 = lowest latency, F2 = power saving, F3 = fixed cap (+/- to change the cap)");
+		logger.log(LOG_SEVERITY_INFO, "logging: F4 = cycle severity filter, F5 = toggle general messages");
+		logger.log(LOG_SEVERITY_INFO, "F6 = toggle dynamic resolution, F7 = toggle frame capture, F8 = cycle sprite benchmark");
+		logger.log(LOG_SEVERITY_INFO, "F9 = cycle overdraw benchmark, F10 = toggle draw sorting");
+		applyFramePacing();
+
+		if (enableShaderHotReload)
+		{
+			startShaderHotReload();
+		}
+
+		// the trace already holds everything the simulation would have produced
+		if (!replaying)
+		{
+			startSimulation();
+		}
+
+		lastFrameStart = chrono::steady_clock::now();
+		lastStatsReport = lastFrameStart;
+
+		while (!shouldQuit())
+		{
+			// wait before polling, so the frame works with the freshest input possible
+			auto pacingWait = frameLimiter.wait();
+
+			auto frameStart = chrono::steady_clock::now();
+			if (window != nullptr)
+			{
+				glfwPollEvents();
+			}
+
+			if (isMinimized())
+			{
+				// nothing to present to, sleep until the window gets restored
+				glfwWaitEvents();
+				swapChainOutdated = true;
+				lastFrameStart = chrono::steady_clock::now();
+				continue;
+			}
+
+			if (requestedPresentPolicy != presentPolicy)
+			{
+				presentPolicy = requestedPresentPolicy;
+				// the present mode is baked into the swap chain
+				recreateSwapChain();
+				applyFramePacing();
+			}
+
+			if (captureRequested != captureActive)
+			{
+				if (captureRequested)
+				{
+					startCapture();
+				}
+				else
+				{
+					stopCapture();
+				}
+			}
+
+			if (dispatchBenchmarkRequested)
+			{
+				dispatchBenchmarkRequested = false;
+				benchmarkCommandDispatch();
+			}
+
+			if (textureBenchmarkRequested)
+			{
+				textureBenchmarkRequested = false;
+				benchmarkTextureCompression();
+			}
+
+			if (traceRequested != traceWriter.isOpen())
+			{
+				if (traceRequested)
+				{
+					startTrace();
+				}
+				else
+				{
+					stopTrace();
+				}
+			}
+
+			if (swapChainOutdated)
+			{
+				recreateSwapChain();
+			}
+
+			swapReloadedPipelines();
+
+			if (!replaying)
+			{
+				updateScene(frameStart);
+			}
+			updateLightSweep();
+
+			if (!drawFrame())
+			{
+				// the frame got skipped, its sprites get added again next time
+				spriteBatch.clear();
+				continue;
+			}
+
+			auto frameEnd = chrono::steady_clock::now();
+			frameStats.addFrame(
+				toMilliseconds(frameStart - lastFrameStart),
+				toMilliseconds(frameEnd - frameStart),
+				toMilliseconds(pacingWait));
+			hud.addFrame(
+				static_cast<float>(toMilliseconds(frameStart - lastFrameStart)),
+				static_cast<float>(toMilliseconds(frameEnd - frameStart)),
+				static_cast<float>(lastGpuTime));
+			if (replaying)
+			{
+				replayStats.addFrame(
+					toMilliseconds(frameStart - lastFrameStart),
+					toMilliseconds(frameEnd - frameStart),
+					toMilliseconds(pacingWait));
+			}
+			lastFrameStart = frameStart;
+
+			if (frameEnd - lastStatsReport >= chrono::duration<double>(STATS_REPORT_INTERVAL))
+			{
+				// other processes come and go, so the heaps get checked against fresh budgets
+				updateMemoryBudget();
+				residency.trim(submittedFrames);
+				reportFrameStats();
+				lastStatsReport = frameEnd;
+			}
+		}
+
+		// a rebuild might still be running on the watcher thread
+		shaderWatcher.stop();
+		swapReloadedPipelines();
+		stopSimulation();
+
+		// wait for the last frames to finish before cleaning up resources they might still be using
+		vkDeviceWaitIdle(device);
+		deletionQueue.flushAll();
+		if (captureActive)
+		{
+			stopCapture();
+		}
+		if (traceWriter.isOpen())
+		{
+			stopTrace();
+		}
+		if (replaying)
+		{
+			logReplaySummary();
+		}
+	}
+
+	bool shouldQuit() {
+		if (replayFinished)
+		{
+			return true;
+		}
+		return window != nullptr && glfwWindowShouldClose(window);
+	}
+
+	// benchmark changes, and the sprites of the newest world snapshot
+	void updateScene(chrono::steady_clock::time_point frameStart) {
+		if (meshBenchmarkChanged)
+		{
+			meshBenchmarkChanged = false;
+			setMeshBenchmark(meshBenchmark);
+		}
+		if (sceneBenchmarkChanged)
+		{
+			sceneBenchmarkChanged = false;
+			setSceneDrawCount(SCENE_BENCHMARK_COUNTS[sceneBenchmark]);
+		}
+		if (spriteBenchmarkChanged)
+		{
+			spriteBenchmarkChanged = false;
+			requestedSpriteAgents.store(SPRITE_BENCHMARK_COUNTS[spriteBenchmark], memory_order_relaxed);
+		}
+		simulationBounds.store(swapChainExtent, memory_order_relaxed);
+		addSpriteAgents(frameStart);
+	}
+
+	// every timeline gets the frame number as its value
+	// with async compute the scene goes first on its own, the compute queue waits for it and builds the depth pyramid,
+	// meanwhile the graphics queue upscales, and the next frame only waits for the pyramid right before writing depth again
+	void submitTimelineFrame(uint32_t imageIndex, uint64_t frameNumber, bool asyncCompute) {
+		// the depth buffer and the pyramid of the last frame with compute work have to be done with, whether this frame has some or not
+		VkPipelineStageFlags depthStages = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+		uint32_t computeWaits = lastComputeFrame > 0 ? 1 : 0;
+
+		#pragma region --- SCENE ---
+		uint64_t sceneWaitValue = lastComputeFrame;
+		VkTimelineSemaphoreSubmitInfo sceneTimelineInfo{};
+		sceneTimelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+		sceneTimelineInfo.waitSemaphoreValueCount = computeWaits;
+		sceneTimelineInfo.pWaitSemaphoreValues = &sceneWaitValue;
+		sceneTimelineInfo.signalSemaphoreValueCount = 1;
+		sceneTimelineInfo.pSignalSemaphoreValues = &frameNumber;
+
+		VkSubmitInfo sceneSubmit{};
+		sceneSubmit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		sceneSubmit.pNext = &sceneTimelineInfo;
+		sceneSubmit.waitSemaphoreCount = computeWaits;
+		sceneSubmit.pWaitSemaphores = &computeTimeline;
+		sceneSubmit.pWaitDstStageMask = &depthStages;
+		sceneSubmit.commandBufferCount = 1;
+		sceneSubmit.pCommandBuffers = &commandBuffers[currentFrame];
+		sceneSubmit.signalSemaphoreCount = 1;
+		sceneSubmit.pSignalSemaphores = &sceneTimeline;
+		#pragma endregion SCENE
+
+		#pragma region --- FRAME ---
+		// without async compute the scene and the rest of the frame are the same command buffer
+		array<VkSemaphore, 2> waitSemaphores = { imageAvailableSemaphores[currentFrame], computeTimeline };
+		// the swap chain image is first touched by the upscale blit
+		array<VkPipelineStageFlags, 2> waitStages = { VK_PIPELINE_STAGE_TRANSFER_BIT, depthStages };
+		// binary semaphores ignore their value
+		array<uint64_t, 2> waitValues = { 0, lastComputeFrame };
+		array<VkSemaphore, 2> signalSemaphores = { renderFinishedSemaphores[imageIndex], frameTimeline };
+		array<uint64_t, 2> signalValues = { 0, frameNumber };
+		uint32_t waitCount = asyncCompute ? 1 : 1 + computeWaits;
+
+		VkTimelineSemaphoreSubmitInfo frameTimelineInfo{};
+		frameTimelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+		frameTimelineInfo.waitSemaphoreValueCount = waitCount;
+		frameTimelineInfo.pWaitSemaphoreValues = waitValues.data();
+		frameTimelineInfo.signalSemaphoreValueCount = static_cast<uint32_t>(signalValues.size());
+		frameTimelineInfo.pSignalSemaphoreValues = signalValues.data();
+
+		VkSubmitInfo frameSubmit{};
+		frameSubmit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		frameSubmit.pNext = &frameTimelineInfo;
+		frameSubmit.waitSemaphoreCount = waitCount;
+		frameSubmit.pWaitSemaphores = waitSemaphores.data();
+		frameSubmit.pWaitDstStageMask = waitStages.data();
+		frameSubmit.commandBufferCount = 1;
+		frameSubmit.pCommandBuffers = asyncCompute ? &upscaleCommandBuffers[currentFrame] : &commandBuffers[currentFrame];
+		frameSubmit.signalSemaphoreCount = static_cast<uint32_t>(signalSemaphores.size());
+		frameSubmit.pSignalSemaphores = signalSemaphores.data();
+		#pragma endregion FRAME
+
+		array<VkSubmitInfo, 2> submits = { sceneSubmit, frameSubmit };
+		if (asyncCompute)
+		{
+			if (dispatch.vkQueueSubmit(graphicsQueue, 2, submits.data(), VK_NULL_HANDLE) != VK_SUCCESS)
+			{
+				yeet broken_shoe("failed to submit draw command buffer!");
+			}
+		}
+		else if (dispatch.vkQueueSubmit(graphicsQueue, 1, &frameSubmit, VK_NULL_HANDLE) != VK_SUCCESS)
+		{
+			yeet broken_shoe("failed to submit draw command buffer!");
+		}
+
+		if (!asyncCompute)
+		{
+			return;
+		}
+
+		#pragma region --- COMPUTE ---
+		VkCommandBuffer computeCommandBuffer = computeCommandBuffers[currentFrame];
+		dispatch.vkResetCommandBuffer(computeCommandBuffer, 0);
+		recordComputeCommandBuffer(computeCommandBuffer);
+
+		VkPipelineStageFlags computeStage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		VkTimelineSemaphoreSubmitInfo computeTimelineInfo{};
+		computeTimelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+		computeTimelineInfo.waitSemaphoreValueCount = 1;
+		computeTimelineInfo.pWaitSemaphoreValues = &frameNumber;
+		computeTimelineInfo.signalSemaphoreValueCount = 1;
+		computeTimelineInfo.pSignalSemaphoreValues = &frameNumber;
+
+		VkSubmitInfo computeSubmit{};
+		computeSubmit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		computeSubmit.pNext = &computeTimelineInfo;
+		computeSubmit.waitSemaphoreCount = 1;
+		computeSubmit.pWaitSemaphores = &sceneTimeline;
+		computeSubmit.pWaitDstStageMask = &computeStage;
+		computeSubmit.commandBufferCount = 1;
+		computeSubmit.pCommandBuffers = &computeCommandBuffer;
+		computeSubmit.signalSemaphoreCount = 1;
+		computeSubmit.pSignalSemaphores = &computeTimeline;
+
+		if (dispatch.vkQueueSubmit(computeQueue, 1, &computeSubmit, VK_NULL_HANDLE) != VK_SUCCESS)
+		{
+			yeet broken_shoe("failed to submit compute command buffer!");
+		}
+		lastComputeFrame = frameNumber;
+		frameStats.asyncComputeFrames++;
+		#pragma endregion COMPUTE
+	}
+
+	// returns false when no frame got presented, because the swap chain has to be recreated first
+	bool drawFrame() {
+		HostAllocator::ArenaScope arenaScope(HostArena::FRAME);
+
+		waitForFrame(frameNumbers[currentFrame], computeFrameNumbers[currentFrame]);
+		// frames finish in submission order, so everything up to this one is done as well
+		completedFrames = max(completedFrames, frameNumbers[currentFrame]);
+		deletionQueue.flush(completedFrames);
+		readGpuTime();
+		readComputeTime();
+		readSceneStatistics();
+
+		if (captureActive)
+		{
+			auto captureStart = chrono::steady_clock::now();
+			collectCaptures();
+			frameStats.captureTimeSum += toMilliseconds(chrono::steady_clock::now() - captureStart);
+		}
+
+		uint32_t imageIndex;
+		VkResult acquireResult = dispatch.vkAcquireNextImageKHR(device, swapChain, UINT64_MAX, imageAvailableSemaphores[currentFrame], VK_NULL_HANDLE, &imageIndex);
+
+		if (acquireResult == VK_ERROR_OUT_OF_DATE_KHR)
+		{
+			// the semaphore didn't get signaled and the fence is still signaled, so the frame can simply be retried
+			swapChainOutdated = true;
+			return false;
+		}
+		// suboptimal still acquired an image, present it and recreate afterwards
+		if (acquireResult != VK_SUCCESS && acquireResult != VK_SUBOPTIMAL_KHR)
+		{
+			yeet broken_shoe("failed to acquire swap chain image!");
+		}
+
+		// a previous frame in flight might still be rendering to this image
+		if (imageFrameNumbers[imageIndex] > completedFrames)
+		{
+			waitForFrame(imageFrameNumbers[imageIndex]);
+		}
+		uint64_t frameNumber = submittedFrames + 1;
+		imageFrameNumbers[imageIndex] = frameNumber;
+
+		// input that arrived up to now is what this frame will show
+		optional<chrono::steady_clock::time_point> frameInputTime = pendingInputTime;
+		pendingInputTime.reset();
+
+		// the frame's extent and whether it builds the depth pyramid come from the trace
+		if (replaying)
+		{
+			beginReplayFrame();
+		}
+
+		// nothing to overlap without the depth pyramid
+		bool asyncCompute = asyncComputeSupported && asyncComputeEnabled && hiZActive();
+
+		prepareSpriteTextures();
+		dispatch.vkResetCommandBuffer(commandBuffers[currentFrame], 0);
+		recordCommandBuffer(commandBuffers[currentFrame], imageIndex, asyncCompute);
+
+		#pragma region --- SUBMIT ---
+		VkSemaphore signalSemaphores[] = { renderFinishedSemaphores[imageIndex] };
+		if (timelineSemaphores)
+		{
+			submitTimelineFrame(imageIndex, frameNumber, asyncCompute);
+		}
+		else
+		{
+			VkSemaphore waitSemaphores[] = { imageAvailableSemaphores[currentFrame] };
+			// the swap chain image is first touched by the upscale blit
+			VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_TRANSFER_BIT };
+
+			VkSubmitInfo submitInfo{};
+			submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+			submitInfo.waitSemaphoreCount = 1;
+			submitInfo.pWaitSemaphores = waitSemaphores;
+			submitInfo.pWaitDstStageMask = waitStages;
+			submitInfo.commandBufferCount = 1;
+			submitInfo.pCommandBuffers = &commandBuffers[currentFrame];
+			submitInfo.signalSemaphoreCount = 1;
+			submitInfo.pSignalSemaphores = signalSemaphores;
+
+			dispatch.vkResetFences(device, 1, &inFlightFences[currentFrame]);
+
+			if (dispatch.vkQueueSubmit(graphicsQueue, 1, &submitInfo, inFlightFences[currentFrame]) != VK_SUCCESS)
+			{
+				yeet broken_shoe("failed to submit draw command buffer!");
+			}
+		}
+		frameNumbers[currentFrame] = ++submittedFrames;
+		computeFrameNumbers[currentFrame] = lastComputeFrame;
+		#pragma endregion SUBMIT
+
+		#pragma region --- PRESENT ---
+		VkPresentInfoKHR presentInfo{};
+		presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+		presentInfo.waitSemaphoreCount = 1;
+		presentInfo.pWaitSemaphores = signalSemaphores;
+		presentInfo.swapchainCount = 1;
+		presentInfo.pSwapchains = &swapChain;
+		presentInfo.pImageIndices = &imageIndex;
+		presentInfo.pResults = nullptr; // optional
+
+		VkResult presentResult = dispatch.vkQueuePresentKHR(presentQueue, &presentInfo);
+
+		if (presentResult == VK_ERROR_OUT_OF_DATE_KHR || presentResult == VK_SUBOPTIMAL_KHR)
+		{
+			swapChainOutdated = true;
+		}
+		else if (presentResult != VK_SUCCESS)
+		{
+			yeet broken_shoe("failed to present swap chain image!");
+		}
+		#pragma endregion PRESENT
+
+		// measured up to the moment the image is handed to the presentation engine,
+		// the time until it actually reaches the screen depends on the present mode and the display
+		if (frameInputTime.has_value())
+		{
+			frameStats.addLatency(toMilliseconds(chrono::steady_clock::now() - frameInputTime.value()));
+		}
+
+		currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+
+		if (++framesRendered == HOST_MEMORY_WARMUP_FRAMES)
+		{
+			hostAllocator.markSteadyState();
+		}
+
+		return true;
+	}
+	#pragma endregion MAIN LOOP
+
+	#pragma region --- SHADER HOT RELOAD ---
+	void startShaderHotReload() {
+		optional<filesystem::path> glslc = ShaderCompiler::findGlslc();
+		if (!glslc.has_value())
+		{
+			logger.log(LOG_SEVERITY_WARNING, "no glslc in the Vulkan SDK VULKAN_SDK points at or on the PATH, shader hot reload is off");
+			return;
+		}
+		glslcPath = glslc.value();
+
+		vector<string> sourceNames;
+		for (const auto& source : SHADER_SOURCES)
+		{
+			sourceNames.push_back(source.first);
+		}
+
+		shaderWatcher.start(SHADER_SOURCE_DIRECTORY, sourceNames, [this](const vector<string>& changedFiles) {
+			reloadShaders(changedFiles);
+		});
+		logger.log(LOG_SEVERITY_INFO, "watching " + SHADER_SOURCE_DIRECTORY + " for shader changes");
+	}
+
+	// runs on the watcher thread, the render loop keeps going with the current pipeline meanwhile
+	void reloadShaders(const vector<string>& changedFiles) {
+		auto start = chrono::steady_clock::now();
+
+		set<string> changedShaders;
+
+		for (const string& changedFile : changedFiles)
+		{
+			for (const auto& source : SHADER_SOURCES)
+			{
+				if (source.first != changedFile)
+				{
+					continue;
+				}
+
+				if (!compileShader(SHADER_SOURCE_DIRECTORY + "/" + source.first, source.second))
+				{
+					logger.log(LOG_SEVERITY_ERROR, "failed to compile " + source.first + ", keeping the current pipelines");
+					return;
+				}
+
+				changedShaders.insert(source.second);
+			}
+		}
+
+		auto changed = [&changedShaders](const string& vertShaderPath, const string& fragShaderPath) {
+			return changedShaders.count(vertShaderPath) > 0 || changedShaders.count(fragShaderPath) > 0;
+		};
+
+		// only the pipelines using a changed shader get rebuilt
+		try
+		{
+			if (changed(VERT_SHADER_PATH, FRAG_SHADER_PATH))
+			{
+				for (size_t i = 0; i < scenePipelines.size(); i++)
+				{
+					publishPipeline(reloadedScenePipelines[i], buildGraphicsPipeline(scenePipelineDescription(static_cast<ScenePipeline>(i))));
+				}
+			}
+			if (changed(SPRITE_VERT_SHADER_PATH, SPRITE_FRAG_SHADER_PATH))
+			{
+				for (size_t i = 0; i < spritePipelines.size(); i++)
+				{
+					publishPipeline(reloadedSpritePipelines[i], buildGraphicsPipeline(spritePipelineDescription(static_cast<SpriteBlend>(i))));
+				}
+			}
+			if (changed(MESH_VERT_SHADER_PATH, MESH_FRAG_SHADER_PATH))
+			{
+				publishPipeline(reloadedMeshPipeline, buildGraphicsPipeline(meshPipelineDescription()));
+			}
+			if (changed(HUD_VERT_SHADER_PATH, SPRITE_FRAG_SHADER_PATH))
+			{
+				publishPipeline(reloadedHudPipeline, buildGraphicsPipeline(hudPipelineDescription()));
+			}
+			if (hiZSupported && changedShaders.count(HI_Z_COMP_SHADER_PATH) > 0)
+			{
+				publishPipeline(reloadedHiZPipeline, buildComputePipeline(shaderCode(HI_Z_COMP_SHADER_PATH), hiZPipelineLayout));
+			}
+			if (changedShaders.count(CLUSTER_COMP_SHADER_PATH) > 0)
+			{
+				publishPipeline(reloadedLightBinningPipeline, buildComputePipeline(shaderCode(CLUSTER_COMP_SHADER_PATH), lightBinningPipelineLayout));
+			}
+		}
+		catch (const exception& e)
+		{
+			logger.log(LOG_SEVERITY_ERROR, string("shader reload failed: ") + e.what());
+			return;
+		}
+
+		logger.log(LOG_SEVERITY_INFO, "shaders reloaded in " + to_string(toMilliseconds(chrono::steady_clock::now() - start)) + " ms");
+	}
+
+	// compiles to a temporary file first, so a failed compile leaves the previous SPIR-V alone
+	bool compileShader(const string& sourcePath, const string& outputPath) const {
+		string temporaryPath = outputPath + ".tmp";
+
+		error_code error;
+		if (!ShaderCompiler::compile(glslcPath, sourcePath, temporaryPath))
+		{
+			filesystem::remove(temporaryPath, error);
+			return false;
+		}
+
+		filesystem::rename(temporaryPath, outputPath, error);
+		return !error;
+	}
+
+	void publishPipeline(atomic<VkPipeline>& reloaded, VkPipeline pipeline) {
+		// a pipeline the render loop didn't pick up yet was never used, so it can go right away
+		VkPipeline unused = reloaded.exchange(pipeline);
+		if (unused != VK_NULL_HANDLE)
+		{
+			vkDestroyPipeline(device, unused, allocator(VK_OBJECT_TYPE_PIPELINE));
+		}
+	}
+
+	// called by the render loop between frames
+	void swapReloadedPipelines() {
+		for (size_t i = 0; i < scenePipelines.size(); i++)
+		{
+			if (swapReloadedPipeline(reloadedScenePipelines[i], scenePipelines[i]))
+			{
+				// the static scene still refers to the old one
+				sceneVersion++;
+			}
+		}
+		for (size_t i = 0; i < spritePipelines.size(); i++)
+		{
+			swapReloadedPipeline(reloadedSpritePipelines[i], spritePipelines[i]);
+		}
+		swapReloadedPipeline(reloadedMeshPipeline, meshPipeline);
+		swapReloadedPipeline(reloadedHiZPipeline, hiZPipeline);
+		swapReloadedPipeline(reloadedLightBinningPipeline, lightBinningPipeline);
+		swapReloadedPipeline(reloadedHudPipeline, hudPipeline);
+	}
+
+	// returns whether there was a new one
+	bool swapReloadedPipeline(atomic<VkPipeline>& reloaded, VkPipeline& current) {
+		VkPipeline pipeline = reloaded.exchange(VK_NULL_HANDLE);
+		if (pipeline == VK_NULL_HANDLE)
+		{
+			return false;
+		}
+
+		// frames already submitted might still be using the old one
+		VkPipeline oldPipeline = current;
+		current = pipeline;
+		deletionQueue.push(submittedFrames, [this, oldPipeline]() {
+			vkDestroyPipeline(device, oldPipeline, allocator(VK_OBJECT_TYPE_PIPELINE));
+		});
+		return true;
+	}
+	#pragma endregion SHADER HOT RELOAD
+
+	#pragma region --- SCENE ---
+	// piles up large overlapping triangles at random depths on top of the original one,
+	// submitted in random order, so draw sorting has both overdraw and binds to save
+	void setSceneDrawCount(uint32_t count) {
+		uniform_real_distribution<float> unit(0.0f, 1.0f);
+		uniform_int_distribution<uint32_t> material(0, static_cast<uint32_t>(SCENE_MATERIALS.size()) - 1);
+
+		sceneDraws.resize(1);
+		sceneVersion++;
+		for (uint32_t i = 0; i < count; i++)
+		{
+			SceneDraw draw;
+			draw.x = unit(sceneRandom) * 1.6f - 0.8f;
+			draw.y = unit(sceneRandom) * 1.6f - 0.8f;
+			draw.scale = 0.5f + unit(sceneRandom) * 1.5f;
+			// in front of the far plane the depth buffer gets cleared to
+			draw.depth = unit(sceneRandom) * 0.99f;
+			draw.material = material(sceneRandom);
+			draw.pipeline = draw.material >= FIRST_TRANSPARENT_MATERIAL ? ScenePipeline::TRANSPARENT : ScenePipeline::OPAQUE;
+			sceneDraws.push_back(draw);
+		}
+
+		logger.log(LOG_SEVERITY_INFO, "overdraw benchmark: " + to_string(count) + " extra triangles");
+	}
+	#pragma endregion SCENE
+
+	#pragma region --- MESHES ---
+	void setMeshBenchmark(size_t benchmark) {
+		meshInstances.clear();
+		meshBvh.clear();
+		if (benchmark < MESH_BENCHMARK_COUNTS.size())
+		{
+			setMeshInstanceCount(MESH_BENCHMARK_COUNTS[benchmark]);
+		}
+		else
+		{
+			buildCity();
+		}
+	}
+
+	// 0 puts every imported mesh in a row, anything else fills a square grid below the camera going into the distance,
+	// so most instances end up small enough on screen for the coarser levels of detail
+	void setMeshInstanceCount(uint32_t count) {
+		if (count == 0)
+		{
+			for (uint32_t i = 0; i < cubeMesh; i++)
+			{
+				// positions follow the window shape, see layOutMeshRow
+				addMeshInstance(i, { 0.0f, 0.0f, 0.0f }, { 1.0f, 1.0f, 1.0f }, 0.0f, 1.0f);
+			}
+			return;
+		}
+
+		uniform_real_distribution<float> phase(0.0f, 6.2831853f);
+		uint32_t side = static_cast<uint32_t>(ceil(sqrt(static_cast<double>(count))));
+		for (uint32_t i = 0; i < min(count, MAX_MESH_INSTANCES); i++)
+		{
+			float column = static_cast<float>(i % side) - (side - 1) * 0.5f;
+			float row = static_cast<float>(i / side);
+			// the cube stands in when nothing got imported
+			addMeshInstance(cubeMesh > 0 ? i % cubeMesh : cubeMesh, { column * MESH_GRID_SPACING, -2.0f, -4.0f - row * MESH_GRID_SPACING },
+				{ 1.0f, 1.0f, 1.0f }, phase(meshRandom), 1.0f);
+		}
+
+		logger.log(LOG_SEVERITY_INFO, "mesh benchmark: " + to_string(meshInstances.size()) + " instances");
+		benchmarkMeshCulling();
+	}
+
+	// blocks of four buildings of random heights with streets between them, the camera stands where two streets cross,
+	// looking down one of them, so the buildings along it hide nearly everything behind them
+	void buildCity() {
+		uniform_real_distribution<float> height(4.0f, 30.0f);
+		const LoadedMesh& cube = meshes[cubeMesh];
+		// every building gets a quarter of what's left of its block after the street, with a small gap to its neighbours
+		float lot = (CITY_BLOCK_SIZE - CITY_STREET_WIDTH) * 0.5f;
+		float halfWidth = lot * 0.5f - 0.25f;
+		float ground = -2.0f;
+
+		for (uint32_t blockZ = 0; blockZ < CITY_BLOCKS; blockZ++)
+		{
+			for (uint32_t blockX = 0; blockX < CITY_BLOCKS; blockX++)
+			{
+				// a street runs along x = 0 and another one along z = 0
+				float centerX = (static_cast<float>(blockX) - CITY_BLOCKS * 0.5f + 0.5f) * CITY_BLOCK_SIZE;
+				float centerZ = -(static_cast<float>(blockZ) + 0.5f) * CITY_BLOCK_SIZE;
+				for (int building = 0; building < 4; building++)
+				{
+					float halfHeight = height(meshRandom) * 0.5f;
+					array<float, 3> halfExtent = { halfWidth, halfHeight, halfWidth };
+					array<float, 3> size;
+					for (int axis = 0; axis < 3; axis++)
+					{
+						size[axis] = halfExtent[axis] * cube.radius / cube.halfExtent[axis];
+					}
+					float x = centerX + (building % 2 == 0 ? -0.5f : 0.5f) * lot;
+					float z = centerZ + (building / 2 == 0 ? -0.5f : 0.5f) * lot;
+					addMeshInstance(cubeMesh, { x, ground + halfHeight, z }, size, 0.0f, 0.0f);
+				}
+			}
+		}
+
+		logger.log(LOG_SEVERITY_INFO, "city benchmark: " + to_string(meshInstances.size()) + " buildings");
+		benchmarkMeshCulling();
+	}
+
+	void addMeshInstance(uint32_t mesh, const array<float, 3>& position, const array<float, 3>& size, float phase, float spin) {
+		uint32_t index = static_cast<uint32_t>(meshInstances.size());
+		meshInstances.push_back({ mesh, position, size, phase, spin, 0, 0 });
+		meshInstances.back().cullObject = meshBvh.add(meshInstanceBounds(meshInstances.back()), index);
+	}
+
+	// spinning instances get a box that fits every angle they go through
+	Aabb meshInstanceBounds(const MeshInstance& instance) const {
+		const LoadedMesh& mesh = meshes[instance.mesh];
+		array<float, 3> halfExtent;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			halfExtent[axis] = mesh.halfExtent[axis] / mesh.radius * instance.size[axis];
+		}
+
+		array<float, 3> extent;
+		if (instance.spin != 0.0f)
+		{
+			float horizontal = sqrt(halfExtent[0] * halfExtent[0] + halfExtent[2] * halfExtent[2]);
+			extent = { horizontal, halfExtent[1], horizontal };
+		}
+		else
+		{
+			float cosPhase = abs(cos(instance.phase));
+			float sinPhase = abs(sin(instance.phase));
+			extent = { cosPhase * halfExtent[0] + sinPhase * halfExtent[2], halfExtent[1], sinPhase * halfExtent[0] + cosPhase * halfExtent[2] };
+		}
+
+		const array<float, 3>& p = instance.position;
+		return { { p[0] - extent[0], p[1] - extent[1], p[2] - extent[2] }, { p[0] + extent[0], p[1] + extent[1], p[2] + extent[2] } };
+	}
+
+	// times culling every instance against the frustum one by one, against the hierarchy on the render thread alone,
+	// and against the hierarchy with the workers helping
+	void benchmarkMeshCulling() {
+		const int iterations = 20;
+		auto time = [&](const function<void()>& cull) {
+			auto start = chrono::steady_clock::now();
+			for (int i = 0; i < iterations; i++)
+			{
+				cull();
+			}
+			return toMilliseconds(chrono::steady_clock::now() - start) / iterations;
+		};
+
+		auto buildStart = chrono::steady_clock::now();
+		meshBvh.update();
+		double buildTime = toMilliseconds(chrono::steady_clock::now() - buildStart);
+
+		Frustum frustum = Frustum::fromMatrix(meshProjection());
+		vector<Aabb> bounds;
+		for (const MeshInstance& instance : meshInstances)
+		{
+			bounds.push_back(meshInstanceBounds(instance));
+		}
+
+		vector<uint32_t> visible;
+		double bruteForceTime = time([&]() {
+			visible.clear();
+			for (uint32_t i = 0; i < bounds.size(); i++)
+			{
+				if (frustum.intersects(bounds[i]))
+				{
+					visible.push_back(i);
+				}
+			}
+		});
+		size_t visibleCount = visible.size();
+		double serialTime = time([&]() { meshBvh.cull(frustum, visible, false); });
+		double parallelTime = time([&]() { meshBvh.cull(frustum, visible, true); });
+
+		ostringstream message;
+		message << "cull benchmark: " << visibleCount << " of " << bounds.size() << " instances in view"
+			<< " | brute force " << bruteForceTime << " ms"
+			<< " | hierarchy " << serialTime << " ms on one thread, " << parallelTime << " ms with the workers"
+			<< " (" << bruteForceTime / max(min(serialTime, parallelTime), 0.0001) << "x faster)"
+			<< " | built in " << buildTime << " ms";
+		logger.log(LOG_SEVERITY_INFO, message.str());
+	}
+
+	// every mesh next to each other, far enough back to see the whole row
+	void layOutMeshRow(float aspect, float focal) {
+		float spacing = 2.2f;
+		float distance = max(3.0f, meshInstances.size() * spacing * 0.5f * focal / aspect + 1.5f);
+		for (size_t i = 0; i < meshInstances.size(); i++)
+		{
+			meshInstances[i].position = { (i - (meshInstances.size() - 1) * 0.5f) * spacing, 0.0f, -distance };
+			meshBvh.move(meshInstances[i].cullObject, meshInstanceBounds(meshInstances[i]));
+		}
+	}
+	#pragma endregion MESHES
+
+	#pragma region --- SPRITES ---
+	// on the simulation thread
+	void setSpriteAgentCount(uint32_t count, VkExtent2D bounds) {
+		uniform_real_distribution<float> unit(0.0f, 1.0f);
+		uniform_int_distribution<uint32_t> texture(0, SPRITE_TEXTURE_COUNT - 1);
+
+		spriteAgents.resize(count);
+		for (SpriteAgent& agent : spriteAgents)
+		{
+			agent.size = 4.0f + unit(spriteRandom) * 12.0f;
+			agent.x = unit(spriteRandom) * (bounds.width - agent.size);
+			agent.y = unit(spriteRandom) * (bounds.height - agent.size);
+			agent.previousX = agent.x;
+			agent.previousY = agent.y;
+			float angle = unit(spriteRandom) * 6.2831853f;
+			float speed = 20.0f + unit(spriteRandom) * 180.0f;
+			agent.velocityX = cos(angle) * speed;
+			agent.velocityY = sin(angle) * speed;
+			agent.color = 0x80000000
+				| (static_cast<uint32_t>(unit(spriteRandom) * 255.0f) << 16)
+				| (static_cast<uint32_t>(unit(spriteRandom) * 255.0f) << 8)
+				| static_cast<uint32_t>(unit(spriteRandom) * 255.0f);
+			agent.texture = static_cast<uint16_t>(texture(spriteRandom));
+			agent.blend = unit(spriteRandom) < 0.25f ? SpriteBlend::ADDITIVE : SpriteBlend::ALPHA;
+		}
+
+		logger.log(LOG_SEVERITY_INFO, "sprite benchmark: " + to_string(count) + " sprites");
+	}
+
+	// on the simulation thread, moves the agents one step, bouncing off the window edges
+	void stepSpriteAgents(float dt, VkExtent2D bounds) {
+		float width = static_cast<float>(bounds.width);
+		float height = static_cast<float>(bounds.height);
+
+		for (SpriteAgent& agent : spriteAgents)
+		{
+			agent.previousX = agent.x;
+			agent.previousY = agent.y;
+			agent.x += agent.velocityX * dt;
+			agent.y += agent.velocityY * dt;
+			if (agent.x < 0.0f || agent.x + agent.size > width)
+			{
+				agent.velocityX = -agent.velocityX;
+				agent.x = clamp(agent.x, 0.0f, max(0.0f, width - agent.size));
+			}
+			if (agent.y < 0.0f || agent.y + agent.size > height)
+			{
+				agent.velocityY = -agent.velocityY;
+				agent.y = clamp(agent.y, 0.0f, max(0.0f, height - agent.size));
+			}
+		}
+	}
+
+	// hands the newest snapshot's agents to the sprite batch, in between its previous and its latest step
+	// rendering lags one step behind the simulation that way, but moves smoothly at any frame rate
+	void addSpriteAgents(chrono::steady_clock::time_point frameStart) {
+		worldSnapshots.update();
+		const WorldSnapshot& snapshot = worldSnapshots.front();
+
+		float sinceStep = chrono::duration<float>(frameStart - snapshot.time).count();
+		float alpha = clamp(sinceStep * static_cast<float>(SIMULATION_RATE), 0.0f, 1.0f);
+
+		for (const SpriteAgentState& agent : snapshot.agents)
+		{
+			Sprite sprite;
+			sprite.x = agent.previousX + (agent.x - agent.previousX) * alpha;
+			sprite.y = agent.previousY + (agent.y - agent.previousY) * alpha;
+			sprite.width = agent.size;
+			sprite.height = agent.size;
+			sprite.color = agent.color;
+			sprite.texture = agent.texture;
+			sprite.blend = agent.blend;
+			spriteBatch.add(sprite);
+		}
+	}
+	#pragma endregion SPRITES
+
+	#pragma region --- SIMULATION ---
+	void startSimulation() {
+		simulationBounds.store(swapChainExtent, memory_order_relaxed);
+		simulationRunning = true;
+		simulationThread = thread(&EmergineApp::simulationLoop, this);
+	}
+
+	void stopSimulation() {
+		simulationRunning = false;
+		if (simulationThread.joinable())
+		{
+			simulationThread.join();
+		}
+	}
+
+	// steps are due at fixed times, a slow step only makes the following ones start late until they've caught up
+	void simulationLoop() {
+		const auto step = chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(1.0 / SIMULATION_RATE));
+		auto nextStep = chrono::steady_clock::now();
+		uint64_t stepNumber = 0;
+
+		while (simulationRunning.load(memory_order_relaxed))
+		{
+			this_thread::sleep_until(nextStep);
+
+			auto start = chrono::steady_clock::now();
+			VkExtent2D bounds = simulationBounds.load(memory_order_relaxed);
+			uint32_t agentCount = requestedSpriteAgents.load(memory_order_relaxed);
+			if (agentCount != spriteAgents.size())
+			{
+				setSpriteAgentCount(agentCount, bounds);
+			}
+			stepSpriteAgents(static_cast<float>(1.0 / SIMULATION_RATE), bounds);
+
+			// the slot still has the capacity of an earlier snapshot, so this doesn't allocate once the agent count settled
+			WorldSnapshot& snapshot = worldSnapshots.back();
+			snapshot.time = nextStep;
+			snapshot.step = ++stepNumber;
+			snapshot.agents.resize(spriteAgents.size());
+			for (size_t i = 0; i < spriteAgents.size(); i++)
+			{
+				const SpriteAgent& agent = spriteAgents[i];
+				snapshot.agents[i] = { agent.previousX, agent.previousY, agent.x, agent.y, agent.size, agent.color, agent.texture, agent.blend };
+			}
+			worldSnapshots.publish();
+
+			auto end = chrono::steady_clock::now();
+			simulationSteps.fetch_add(1, memory_order_relaxed);
+			simulationTimeNs.fetch_add(chrono::duration_cast<chrono::nanoseconds>(end - start).count(), memory_order_relaxed);
+
+			nextStep += step;
+			// after a breakpoint or a hitch, catching up on all of it would only stall for longer
+			if (end - nextStep > step * MAX_SIMULATION_CATCH_UP_STEPS)
+			{
+				uint64_t skipped = static_cast<uint64_t>((end - nextStep) / step);
+				simulationSkippedSteps.fetch_add(skipped, memory_order_relaxed);
+				nextStep += step * skipped;
+			}
+		}
+	}
+	#pragma endregion SIMULATION
+
+	#pragma region --- FRAME CAPTURE ---
+	void startCapture() {
+		captureActive = false;
+
+		// the swap chain images have to be created with TRANSFER_SRC to copy from them
+		if (!(swapChainImageUsage & VK_IMAGE_USAGE_TRANSFER_SRC_BIT))
+		{
+			recreateSwapChain();
+			if (!(swapChainImageUsage & VK_IMAGE_USAGE_TRANSFER_SRC_BIT))
+			{
+				logger.log(LOG_SEVERITY_ERROR, "frame capture unavailable, swap chain images can't be copied from");
+				captureRequested = false;
+				return;
+			}
+		}
+
+		error_code error;
+		filesystem::create_directories(CAPTURE_DIRECTORY, error);
+		string path = CAPTURE_DIRECTORY + "/capture_" + to_string(time(nullptr)) + ".emcap";
+		if (!captureWriter.open(path, CAPTURE_COMPRESS))
+		{
+			logger.log(LOG_SEVERITY_ERROR, "failed to open " + path + " for frame capture");
+			captureRequested = false;
+			return;
+		}
+
+		createCaptureBuffers();
+		captureFramesReported = captureWriter.framesWritten();
+		captureWriteTimeReported = captureWriter.writeTimeMs();
+		captureActive = true;
+		logger.log(LOG_SEVERITY_INFO, "capturing frames to " + path);
+	}
+
+	void stopCapture() {
+		drainCaptures();
+		captureWriter.close();
+		destroyCaptureBuffers();
+		captureActive = false;
+		captureRequested = false;
+
+		logger.log(LOG_SEVERITY_INFO, "frame capture stopped, " + to_string(captureWriter.framesWritten()) + " frames written ("
+			+ to_string(captureWriter.bytesWritten() / (1024 * 1024)) + " MiB)");
+	}
+
+	void createCaptureBuffers() {
+		// 4 bytes per pixel, which every format chooseSwapSurfaceFormat ends up with in practice has
+		captureSlotSize = static_cast<VkDeviceSize>(swapChainExtent.width) * swapChainExtent.height * 4;
+
+		VkBufferCreateInfo bufferInfo{};
+		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferInfo.size = captureSlotSize;
+		bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		for (CaptureSlot& slot : captureSlots)
+		{
+			if (vkCreateBuffer(device, &bufferInfo, allocator(VK_OBJECT_TYPE_BUFFER), &slot.buffer) != VK_SUCCESS)
+			{
+				yeet broken_shoe("failed to create capture buffer!");
+			}
+
+			VkMemoryRequirements memoryRequirements;
+			vkGetBufferMemoryRequirements(device, slot.buffer, &memoryRequirements);
+
+			// the CPU reads every byte, so cached memory is a lot faster than the usual write-combined kind
+			optional<uint32_t> memoryType = findOptionalMemoryType(memoryRequirements.memoryTypeBits,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT);
+			if (!memoryType.has_value())
+			{
+				memoryType = findMemoryType(memoryRequirements.memoryTypeBits,
+					VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+			}
+
+			VkPhysicalDeviceMemoryProperties memoryProperties;
+			vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+			captureMemoryCoherent = memoryProperties.memoryTypes[memoryType.value()].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+			VkMemoryAllocateInfo allocInfo{};
+			allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+			allocInfo.allocationSize = memoryRequirements.size;
+			allocInfo.memoryTypeIndex = memoryType.value();
+
+			if (allocateDeviceMemory(allocInfo, MemoryCategory::STAGING, slot.memory) != VK_SUCCESS)
+			{
+				yeet broken_shoe("failed to allocate capture buffer memory!");
+			}
+			vkBindBufferMemory(device, slot.buffer, slot.memory, 0);
+
+			void* mapped;
+			vkMapMemory(device, slot.memory, 0, captureSlotSize, 0, &mapped);
+			slot.mapped = static_cast<uint8_t*>(mapped);
+			slot.busy.store(false);
+			slot.frameNumber = 0;
+		}
+
+		nextCaptureSlot = 0;
+	}
+
+	// only once drainCaptures made sure neither the GPU nor the writer uses them anymore
+	void destroyCaptureBuffers() {
+		for (CaptureSlot& slot : captureSlots)
+		{
+			// memory gets unmapped when it's freed
+			vkDestroyBuffer(device, slot.buffer, allocator(VK_OBJECT_TYPE_BUFFER));
+			freeDeviceMemory(slot.memory);
+			slot.buffer = VK_NULL_HANDLE;
+			slot.memory = VK_NULL_HANDLE;
+			slot.mapped = nullptr;
+		}
+	}
+
+	// copies the swap chain image into the next readback buffer, right after the upscale
+	// returns false when the frame was dropped, because the next buffer is still busy
+	bool recordCapture(VkCommandBuffer commandBuffer, VkImage swapChainImage) {
+		CaptureSlot& slot = captureSlots[nextCaptureSlot];
+		if (slot.busy.load(memory_order_acquire))
+		{
+			frameStats.droppedCaptures++;
+			return false;
+		}
+
+		slot.busy.store(true, memory_order_relaxed);
+		// the number this frame will get when it's submitted
+		slot.frameNumber = submittedFrames + 1;
+		slot.extent = swapChainExtent;
+		nextCaptureSlot = (nextCaptureSlot + 1) % CAPTURE_RING_SIZE;
+
+		VkImageMemoryBarrier imageBarrier{};
+		imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		imageBarrier.image = swapChainImage;
+		imageBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		imageBarrier.subresourceRange.baseMipLevel = 0;
+		imageBarrier.subresourceRange.levelCount = 1;
+		imageBarrier.subresourceRange.baseArrayLayer = 0;
+		imageBarrier.subresourceRange.layerCount = 1;
+		imageBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		imageBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		imageBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		imageBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		dispatch.vkCmdPipelineBarrier(commandBuffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+			0, 0, nullptr, 0, nullptr, 1, &imageBarrier);
+
+		VkBufferImageCopy region{};
+		region.bufferOffset = 0;
+		// tightly packed
+		region.bufferRowLength = 0;
+		region.bufferImageHeight = 0;
+		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.mipLevel = 0;
+		region.imageSubresource.baseArrayLayer = 0;
+		region.imageSubresource.layerCount = 1;
+		region.imageOffset = { 0, 0, 0 };
+		region.imageExtent = { swapChainExtent.width, swapChainExtent.height, 1 };
+		dispatch.vkCmdCopyImageToBuffer(commandBuffer, swapChainImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, slot.buffer, 1, &region);
+
+		// makes the copy visible to the host once the fence got signaled
+		VkBufferMemoryBarrier bufferBarrier{};
+		bufferBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		bufferBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		bufferBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+		bufferBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		bufferBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		bufferBarrier.buffer = slot.buffer;
+		bufferBarrier.offset = 0;
+		bufferBarrier.size = VK_WHOLE_SIZE;
+		dispatch.vkCmdPipelineBarrier(commandBuffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT,
+			0, 0, nullptr, 1, &bufferBarrier, 0, nullptr);
+
+		frameStats.capturedFrames++;
+		return true;
+	}
+
+	// hands the readback buffers of finished frames to the writer, without waiting on anything
+	void collectCaptures() {
+		for (CaptureSlot& slot : captureSlots)
+		{
+			if (slot.frameNumber == 0 || slot.frameNumber > completedFrames)
+			{
+				continue;
+			}
+
+			if (!captureMemoryCoherent)
+			{
+				VkMappedMemoryRange range{};
+				range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+				range.memory = slot.memory;
+				range.offset = 0;
+				range.size = VK_WHOLE_SIZE;
+				dispatch.vkInvalidateMappedMemoryRanges(device, 1, &range);
+			}
+
+			CapturedFrame frame{};
+			frame.frameNumber = slot.frameNumber;
+			frame.width = slot.extent.width;
+			frame.height = slot.extent.height;
+			frame.format = static_cast<uint32_t>(swapChainImageFormat);
+			frame.pixels = slot.mapped;
+			frame.busy = &slot.busy;
+			captureWriter.submit(frame);
+
+			slot.frameNumber = 0;
+		}
+	}
+
+	// waits for every pending copy and write, only for stopping the capture or replacing the buffers
+	void drainCaptures() {
+		waitForFrame(submittedFrames, lastComputeFrame);
+		completedFrames = submittedFrames;
+		collectCaptures();
+		captureWriter.waitIdle();
+	}
+	#pragma endregion FRAME CAPTURE
+
+	#pragma region --- DEVICE DISPATCH ---
+	// what a vkCmd* call costs on the CPU through the loader's trampoline against straight through the dispatch table,
+	// recorded into a command buffer of its own that never gets submitted
+	// a state setting command and a push constant update, the draws themselves can't be recorded outside a render pass
+	void benchmarkCommandDispatch() {
+		VkCommandBufferAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.commandPool = commandPool;
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocInfo.commandBufferCount = 1;
+
+		VkCommandBuffer commandBuffer;
+		if (vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer) != VK_SUCCESS)
+		{
+			logger.log(LOG_SEVERITY_ERROR, "failed to allocate the dispatch benchmark command buffer");
+			return;
+		}
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+		// nanoseconds per call, of the fastest round
+		auto measure = [&](auto&& record) {
+			double best = DBL_MAX;
+			for (uint32_t round = 0; round < DISPATCH_BENCHMARK_ROUNDS; round++)
+			{
+				dispatch.vkResetCommandBuffer(commandBuffer, 0);
+				dispatch.vkBeginCommandBuffer(commandBuffer, &beginInfo);
+				auto start = chrono::steady_clock::now();
+				for (uint32_t i = 0; i < DISPATCH_BENCHMARK_CALLS; i++)
+				{
+					record();
+				}
+				double elapsed = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+				dispatch.vkEndCommandBuffer(commandBuffer);
+				best = min(best, elapsed / DISPATCH_BENCHMARK_CALLS);
+			}
+			return best;
+		};
+
+		VkViewport viewport{ 0.0f, 0.0f, static_cast<float>(renderExtent.width), static_cast<float>(renderExtent.height), 0.0f, 1.0f };
+		float transform[4] = { 0.0f, 0.0f, 1.0f, 0.5f };
+
+		double loaderViewport = measure([&]() { vkCmdSetViewport(commandBuffer, 0, 1, &viewport); });
+		double tableViewport = measure([&]() { dispatch.vkCmdSetViewport(commandBuffer, 0, 1, &viewport); });
+		double loaderPush = measure([&]() { vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(transform), transform); });
+		double tablePush = measure([&]() { dispatch.vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(transform), transform); });
+
+		vkFreeCommandBuffers(device, commandPool, 1, &commandBuffer);
+
+		ostringstream message;
+		message << "vkCmd* overhead over " << DISPATCH_BENCHMARK_CALLS << " calls"
+			<< " | vkCmdSetViewport loader " << loaderViewport << " ns, table " << tableViewport << " ns"
+			<< " | vkCmdPushConstants loader " << loaderPush << " ns, table " << tablePush << " ns"
+			<< (enableValidationLayers ? " | validation layers on, both go through them" : "");
+		logger.log(LOG_SEVERITY_INFO, message.str());
+	}
+	#pragma endregion DEVICE DISPATCH
+
+	#pragma region --- TEXTURE COMPRESSION ---
+	// encodes a generated texture in every format, on one thread and on all of them,
+	// and decodes it again to see how much got lost on the channels the format stores
+	void benchmarkTextureCompression() {
+		uint32_t size = TEXTURE_BENCHMARK_SIZE;
+		vector<uint32_t> pixels(static_cast<size_t>(size) * size);
+
+		// smooth gradients, a few hard edges, and a soft disc in alpha, somewhere between a photo and a sprite
+		for (uint32_t y = 0; y < size; y++)
+		{
+			for (uint32_t x = 0; x < size; x++)
+			{
+				float dx = (x + 0.5f) / size * 2.0f - 1.0f;
+				float dy = (y + 0.5f) / size * 2.0f - 1.0f;
+				uint32_t red = x * 255 / size;
+				uint32_t green = y * 255 / size;
+				uint32_t blue = ((x / 32 + y / 32) % 2 == 0) ? 200 : static_cast<uint32_t>(128.0f + 100.0f * sin(x * 0.05f));
+				uint32_t alpha = static_cast<uint32_t>(clamp(1.0f - sqrt(dx * dx + dy * dy), 0.0f, 1.0f) * 255.0f + 0.5f);
+				pixels[static_cast<size_t>(y) * size + x] = red | (green << 8) | (blue << 16) | (alpha << 24);
+			}
+		}
+
+		size_t threads = max(thread::hardware_concurrency(), 1u);
+		double megapixels = pixels.size() / 1000000.0;
+		VkDeviceSize uncompressedBytes = sizeof(uint32_t) * pixels.size();
+
+		ostringstream message;
+		message << "texture compression of " << size << "x" << size << " RGBA8 (" << toMegabytes(uncompressedBytes) << " MB)";
+		for (BlockFormat format : { BlockFormat::BC1, BlockFormat::BC3, BlockFormat::BC5, BlockFormat::BC7 })
+		{
+			auto start = chrono::steady_clock::now();
+			TextureCompressor::compress(pixels.data(), size, size, format, 1);
+			double singleThreaded = toMilliseconds(chrono::steady_clock::now() - start);
+
+			start = chrono::steady_clock::now();
+			vector<uint8_t> blocks = TextureCompressor::compress(pixels.data(), size, size, format, threads);
+			double multiThreaded = toMilliseconds(chrono::steady_clock::now() - start);
+
+			vector<uint32_t> decoded = TextureCompressor::decompress(blocks.data(), size, size, format);
+			int channels = format == BlockFormat::BC1 ? 3 : format == BlockFormat::BC5 ? 2 : 4;
+			double squaredError = 0.0;
+			for (size_t i = 0; i < pixels.size(); i++)
+			{
+				for (int channel = 0; channel < channels; channel++)
+				{
+					double difference = static_cast<double>((pixels[i] >> (channel * 8)) & 0xFF) - static_cast<double>((decoded[i] >> (channel * 8)) & 0xFF);
+					squaredError += difference * difference;
+				}
+			}
+			double meanSquaredError = max(squaredError / (pixels.size() * channels), 1e-9);
+
+			message << " | " << blockFormatName(format) << " " << uncompressedBytes / blocks.size() << "x smaller"
+				<< ", " << megapixels / (singleThreaded / 1000.0) << " MP/s on 1 thread, " << megapixels / (multiThreaded / 1000.0) << " MP/s on " << threads
+				<< ", PSNR " << 10.0 * log10(255.0 * 255.0 / meanSquaredError) << " dB"
+				<< (supportedBlockFormats.count(format) > 0 ? "" : ", not supported by this device");
+		}
+		logger.log(LOG_SEVERITY_INFO, message.str());
+	}
+	#pragma endregion TEXTURE COMPRESSION
+
+	#pragma region --- COMMAND TRACE ---
+	void startTrace() {
+		if (replaying)
+		{
+			logger.log(LOG_SEVERITY_WARNING, "can't record a trace while replaying one");
+			traceRequested = false;
+			return;
+		}
+
+		error_code error;
+		filesystem::create_directories(TRACE_DIRECTORY, error);
+		string path = TRACE_DIRECTORY + "/trace_" + to_string(time(nullptr)) + ".emtrace";
+		if (!traceWriter.open(path))
+		{
+			logger.log(LOG_SEVERITY_ERROR, "failed to open " + path + " for the command trace");
+			traceRequested = false;
+			return;
+		}
+
+		// the static buffers go first, so a replay doesn't need anything but the trace
+		vector<uint8_t> contents = readBackBuffer(meshVertexBuffer, meshVertexBufferSize);
+		traceWriter.upload(TraceBuffer::MESH_VERTICES, contents.data(), static_cast<uint32_t>(contents.size()));
+		contents = readBackBuffer(meshIndexBuffer, meshIndexBufferSize);
+		traceWriter.upload(TraceBuffer::MESH_INDICES, contents.data(), static_cast<uint32_t>(contents.size()));
+
+		logger.log(LOG_SEVERITY_INFO, "recording commands to " + path);
+	}
+
+	void stopTrace() {
+		traceWriter.close();
+		traceRequested = false;
+
+		logger.log(LOG_SEVERITY_INFO, "command trace stopped, " + to_string(traceWriter.framesWritten()) + " frames written ("
+			+ to_string(traceWriter.sizeWritten() / 1024) + " KiB)");
+	}
+
+	// before the main loop, the uploads of the trace replace what the engine loaded itself
+	void startReplay(const string& path) {
+		if (!traceReader.open(path))
+		{
+			yeet broken_shoe("failed to load command trace " + path + "!");
+		}
+
+		TraceCommand command;
+		traceReader.seekUploads();
+		while (traceReader.next(command))
+		{
+			if (command.op != TraceOp::UPLOAD || command.data == nullptr || command.size == 0)
+			{
+				continue;
+			}
+
+			switch (static_cast<TraceBuffer>(command.target))
+			{
+			case TraceBuffer::MESH_VERTICES:
+				vkDestroyBuffer(device, meshVertexBuffer, allocator(VK_OBJECT_TYPE_BUFFER));
+				freeDeviceMemory(meshVertexBufferMemory);
+				meshVertexBufferSize = command.size;
+				uploadDeviceLocalBuffer(command.data, meshVertexBufferSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+					MemoryCategory::MESHES, meshVertexBuffer, meshVertexBufferMemory);
+				break;
+			case TraceBuffer::MESH_INDICES:
+				vkDestroyBuffer(device, meshIndexBuffer, allocator(VK_OBJECT_TYPE_BUFFER));
+				freeDeviceMemory(meshIndexBufferMemory);
+				meshIndexBufferSize = command.size;
+				uploadDeviceLocalBuffer(command.data, meshIndexBufferSize, VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+					MemoryCategory::MESHES, meshIndexBuffer, meshIndexBufferMemory);
+				break;
+			default:
+				break;
+			}
+		}
+
+		replaying = true;
+		replayFrame = 0;
+		replayLoop = 0;
+		// every frame renders at the extent it was recorded with
+		resolutionScaler.enabled = false;
+		resolutionScaler.setScale(MAX_RENDER_SCALE);
+
+		logger.log(LOG_SEVERITY_INFO, "replaying " + to_string(traceReader.frameCount()) + " frames from " + path
+			+ ", " + to_string(options.replayLoops) + (options.replayLoops == 1 ? " time" : " times")
+			+ (options.headless ? ", headless" : ""));
+	}
+
+	// reads the frame's FRAME command, the rest of it gets issued by replayTraceFrame
+	void beginReplayFrame() {
+		traceReader.seekFrame(replayFrame);
+
+		TraceCommand command;
+		if (!traceReader.next(command) || command.op != TraceOp::FRAME)
+		{
+			yeet broken_shoe("command trace frame " + to_string(replayFrame) + " is broken!");
+		}
+
+		// the scene target only grows with the swap chain, a trace recorded on a larger window gets cut off
+		renderExtent = {
+			clamp(command.args[0], 1u, sceneTarget.extent.width),
+			clamp(command.args[1], 1u, sceneTarget.extent.height)
+		};
+		replayHiZ = (command.args[2] & TRACE_FRAME_HI_Z) != 0;
+	}
+
+	// issues the frame's commands in place of recordMeshes, recordScene and recordSprites
+	// anything that doesn't fit the engine as it is now, like an index past the end of a ring, gets clamped or skipped
+	void replayTraceFrame(VkCommandBuffer commandBuffer) {
+		auto start = chrono::steady_clock::now();
+
+		uint64_t draws = 0;
+		uint64_t triangles = 0;
+		uint64_t skippedDraws = 0;
+		// what the indexed draws read from, nothing until the trace binds something
+		TraceGroup boundGeometry = TraceGroup::COUNT;
+		TraceCommand command;
+		while (traceReader.next(command))
+		{
+			TraceGroup group = static_cast<TraceGroup>(command.target);
+			switch (command.op)
+			{
+			case TraceOp::STREAM:
+				replayStream(static_cast<TraceRing>(command.target), command.data, command.size);
+				break;
+			case TraceOp::BIND_PIPELINE:
+			{
+				VkPipeline pipeline = tracePipeline(group, command.index);
+				if (pipeline != VK_NULL_HANDLE)
+				{
+					dispatch.vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+				}
+				break;
+			}
+			case TraceOp::BIND_GEOMETRY:
+				boundGeometry = group;
+				if (group == TraceGroup::MESH)
+				{
+					// not part of the trace, the lights are off while replaying, but mesh.frag still reads the header
+					dispatch.vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, meshPipelineLayout,
+						0, 1, &lightingDescriptorSets[currentFrame], 0, nullptr);
+					array<VkBuffer, 2> vertexBuffers = { meshVertexBuffer, meshInstanceBuffers[currentFrame] };
+					array<VkDeviceSize, 2> offsets = { 0, 0 };
+					dispatch.vkCmdBindVertexBuffers(commandBuffer, 0, 2, vertexBuffers.data(), offsets.data());
+					dispatch.vkCmdBindIndexBuffer(commandBuffer, meshIndexBuffer, 0, VK_INDEX_TYPE_UINT32);
+				}
+				else if (group == TraceGroup::SPRITE)
+				{
+					VkDeviceSize offset = 0;
+					dispatch.vkCmdBindVertexBuffers(commandBuffer, 0, 1, &spriteVertexBuffers[currentFrame], &offset);
+					dispatch.vkCmdBindIndexBuffer(commandBuffer, spriteIndexBuffer, 0, VK_INDEX_TYPE_UINT16);
+				}
+				break;
+			case TraceOp::BIND_TEXTURE:
+			{
+				// the textures are generated at startup, the same index is the same texture
+				// prepareSpriteTextures made all of them resident before recording
+				size_t texture = command.args[0] % SPRITE_TEXTURE_COUNT;
+				dispatch.vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, spritePipelineLayout,
+					0, 1, &spriteTextures[texture].descriptorSet, 0, nullptr);
+				break;
+			}
+			case TraceOp::PUSH_CONSTANTS:
+			{
+				VkPipelineLayout layout = tracePipelineLayout(group);
+				if (layout != VK_NULL_HANDLE && command.data != nullptr && command.index + command.size <= tracePushConstantSize(group))
+				{
+					dispatch.vkCmdPushConstants(commandBuffer, layout, VK_SHADER_STAGE_VERTEX_BIT, command.index, command.size, command.data);
+				}
+				break;
+			}
+			case TraceOp::DRAW:
+				// vertexCount, instanceCount, firstVertex, firstInstance
+				if (!replayDrawFits(boundGeometry, command))
+				{
+					skippedDraws++;
+					break;
+				}
+				dispatch.vkCmdDraw(commandBuffer, command.args[0], command.args[1], command.args[2], command.args[3]);
+				draws++;
+				triangles += static_cast<uint64_t>(command.args[0] / 3) * command.args[1];
+				break;
+			case TraceOp::DRAW_INDEXED:
+				// indexCount, instanceCount, firstIndex, vertexOffset, firstInstance
+				if (!replayDrawFits(boundGeometry, command))
+				{
+					skippedDraws++;
+					break;
+				}
+				dispatch.vkCmdDrawIndexed(commandBuffer, command.args[0], command.args[1], command.args[2], static_cast<int32_t>(command.args[3]), command.args[4]);
+				draws++;
+				triangles += static_cast<uint64_t>(command.args[0] / 3) * command.args[1];
+				break;
+			default:
+				break;
+			}
+		}
+
+		if (skippedDraws > 0)
+		{
+			logger.log(LOG_SEVERITY_WARNING, "skipped replayed draws reading past the buffers they have bound");
+		}
+		frameStats.replayedDrawSum += draws;
+		frameStats.replayedTriangleSum += triangles;
+		frameStats.replayTimeSum += toMilliseconds(chrono::steady_clock::now() - start);
+
+		if (++replayFrame == traceReader.frameCount())
+		{
+			replayFrame = 0;
+			replayFinished = ++replayLoop >= options.replayLoops;
+		}
+	}
+
+	// whether a traced draw stays inside the buffers the engine has bound for the geometry it uses,
+	// a stale or foreign trace would otherwise have the GPU read past them
+	bool replayDrawFits(TraceGroup geometry, const TraceCommand& command) const {
+		uint64_t count = command.args[0];
+		uint64_t instanceCount = command.args[1];
+		uint64_t first = command.args[2];
+		if (command.op == TraceOp::DRAW)
+		{
+			// only the scene draws without an index buffer, it reads no buffers at all, its vertices are the triangle in shader.vert
+			return first + count <= 3;
+		}
+
+		int64_t vertexOffset = static_cast<int32_t>(command.args[3]);
+		uint64_t firstInstance = command.args[4];
+		switch (geometry)
+		{
+		case TraceGroup::MESH:
+			// the indices of a mesh are relative to its vertexOffset, which has to be one of the buffer's vertices
+			return first + count <= meshIndexBufferSize / sizeof(uint32_t)
+				&& vertexOffset >= 0 && static_cast<uint64_t>(vertexOffset) < meshVertexBufferSize / sizeof(MeshVertex)
+				&& firstInstance + instanceCount <= MAX_MESH_INSTANCES;
+		case TraceGroup::SPRITE:
+		{
+			// the quad indices before firstIndex + count reach up to this many vertices past vertexOffset
+			uint64_t quadVertices = (first + count + 5) / 6 * 4;
+			return first + count <= SpriteBatch::MAX_QUADS_PER_DRAW * 6
+				&& vertexOffset >= 0 && static_cast<uint64_t>(vertexOffset) + quadVertices <= static_cast<uint64_t>(MAX_SPRITES) * 4;
+		}
+		default:
+			return false;
+		}
+	}
+
+	// into this frame's ring, cut off at its end
+	void replayStream(TraceRing ring, const uint8_t* contents, uint32_t size) {
+		switch (ring)
+		{
+		case TraceRing::MESH_INSTANCES:
+			memcpy(meshInstanceData[currentFrame], contents, min<size_t>(size, sizeof(MeshInstanceData) * MAX_MESH_INSTANCES));
+			break;
+		case TraceRing::SPRITE_VERTICES:
+			memcpy(spriteVertices[currentFrame], contents, min<size_t>(size, sizeof(SpriteVertex) * 4 * MAX_SPRITES));
+			break;
+		default:
+			break;
+		}
+	}
+
+	// null for pipelines the trace knows and the engine doesn't
+	VkPipeline tracePipeline(TraceGroup group, uint8_t index) const {
+		switch (group)
+		{
+		case TraceGroup::SCENE:
+			return index < scenePipelines.size() ? scenePipelines[index] : VK_NULL_HANDLE;
+		case TraceGroup::MESH:
+			return meshPipeline;
+		case TraceGroup::SPRITE:
+			return index < spritePipelines.size() ? spritePipelines[index] : VK_NULL_HANDLE;
+		default:
+			return VK_NULL_HANDLE;
+		}
+	}
+
+	VkPipelineLayout tracePipelineLayout(TraceGroup group) const {
+		switch (group)
+		{
+		case TraceGroup::SCENE:
+			return pipelineLayout;
+		case TraceGroup::MESH:
+			return meshPipelineLayout;
+		case TraceGroup::SPRITE:
+			return spritePipelineLayout;
+		default:
+			return VK_NULL_HANDLE;
+		}
+	}
+
+	// the push constant range of each layout
+	static uint32_t tracePushConstantSize(TraceGroup group) {
+		switch (group)
+		{
+		case TraceGroup::SCENE:
+			// transform, color
+			return sizeof(float) * 8;
+		case TraceGroup::MESH:
+			// view projection, light direction
+			return sizeof(float) * 20;
+		case TraceGroup::SPRITE:
+			// pixel transform
+			return sizeof(float) * 4;
+		default:
+			return 0;
+		}
+	}
+
+	void logReplaySummary() {
+		if (replayStats.frameCount == 0)
+		{
+			return;
+		}
+
+		double frames = replayStats.frameCount;
+		ostringstream summary;
+		summary << "replay done, " << replayStats.frameCount << " frames"
+			<< " | frame " << replayStats.frameTimeSum / frames << " ms"
+			<< " (min " << replayStats.frameTimeMin << ", max " << replayStats.frameTimeMax << ")"
+			<< " | cpu " << replayStats.cpuTimeSum / frames << " ms";
+		if (replayStats.gpuTimeCount > 0)
+		{
+			summary << " | gpu " << replayStats.gpuTimeSum / replayStats.gpuTimeCount << " ms";
+		}
+		logger.log(LOG_SEVERITY_INFO, summary.str());
+	}
+	#pragma endregion COMMAND TRACE
+
+	#pragma region --- DYNAMIC RESOLUTION ---
+	// called once the fence of the current frame in flight has been waited on, so its timestamps are available
+	void readSceneStatistics() {
+		if (statisticsQueryPool == VK_NULL_HANDLE || !statisticsWritten[currentFrame])
+		{
+			return;
+		}
+
+		uint64_t fragmentInvocations = 0;
+		VkResult result = dispatch.vkGetQueryPoolResults(device, statisticsQueryPool, static_cast<uint32_t>(currentFrame), 1,
+			sizeof(fragmentInvocations), &fragmentInvocations, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+		if (result != VK_SUCCESS)
+		{
+			return;
+		}
+
+		VkExtent2D extent = statisticsExtents[currentFrame];
+		frameStats.overdrawSum += static_cast<double>(fragmentInvocations) / (static_cast<double>(extent.width) * extent.height);
+		frameStats.overdrawCount++;
+	}
+
+	void readGpuTime() {
+		if (timestampQueryPool == VK_NULL_HANDLE || !timestampsWritten[currentFrame])
+		{
+			return;
+		}
+
+		array<uint64_t, 2> timestamps{};
+		VkResult result = dispatch.vkGetQueryPoolResults(device, timestampQueryPool, static_cast<uint32_t>(currentFrame) * 2, 2,
+			sizeof(timestamps), timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+		if (result != VK_SUCCESS)
+		{
+			return;
+		}
+
+		double gpuTime = ((timestamps[1] - timestamps[0]) & timestampMask) * timestampPeriod / 1000000.0;
+		frameStats.addGpuTime(gpuTime);
+		lastGpuTime = gpuTime;
+		if (replaying)
+		{
+			replayStats.addGpuTime(gpuTime);
+		}
+		if (lightSweep.active)
+		{
+			lightSweep.gpuTimeSum += gpuTime;
+			lightSweep.gpuTimeCount++;
+		}
+
+		double budget = 1000.0 / targetFrameRate() * GPU_BUDGET_HEADROOM;
+		if (resolutionScaler.addGpuTime(gpuTime, budget))
+		{
+			updateRenderExtent();
+		}
+	}
+
+	// only what the compute queue spent, it overlaps the graphics time rather than adding to it
+	void readComputeTime() {
+		if (computeTimestampQueryPool == VK_NULL_HANDLE || !computeTimestampsWritten[currentFrame])
+		{
+			return;
+		}
+		computeTimestampsWritten[currentFrame] = false;
+
+		array<uint64_t, 2> timestamps{};
+		VkResult result = dispatch.vkGetQueryPoolResults(device, computeTimestampQueryPool, static_cast<uint32_t>(currentFrame) * 2, 2,
+			sizeof(timestamps), timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+		if (result != VK_SUCCESS)
+		{
+			return;
+		}
+
+		frameStats.computeTimeSum += ((timestamps[1] - timestamps[0]) & computeTimestampMask) * timestampPeriod / 1000000.0;
+		frameStats.computeTimeCount++;
+	}
+
+	void updateRenderExtent() {
+		float scale = resolutionScaler.getScale();
+		renderExtent = {
+			clamp(static_cast<uint32_t>(swapChainExtent.width * scale), 1u, sceneTarget.extent.width),
+			clamp(static_cast<uint32_t>(swapChainExtent.height * scale), 1u, sceneTarget.extent.height)
+		};
+	}
+
+	void toggleDynamicResolution() {
+		if (replaying)
+		{
+			logger.log(LOG_SEVERITY_WARNING, "dynamic resolution stays off while replaying, the trace sets the render extent");
+			return;
+		}
+		if (lightSweep.active)
+		{
+			logger.log(LOG_SEVERITY_WARNING, "dynamic resolution stays off until the light sweep is done");
+			return;
+		}
+
+		resolutionScaler.enabled = !resolutionScaler.enabled && timestampQueryPool != VK_NULL_HANDLE;
+		if (!resolutionScaler.enabled)
+		{
+			resolutionScaler.setScale(MAX_RENDER_SCALE);
+			updateRenderExtent();
+		}
+		logger.log(LOG_SEVERITY_INFO, string("dynamic resolution ") + (resolutionScaler.enabled ? "enabled" : "disabled"));
+	}
+	#pragma endregion DYNAMIC RESOLUTION
+
+	#pragma region --- FRAME PACING ---
+	void setFrameCap(int cap) {
+		frameCap = clamp(cap, MIN_FRAME_CAP, MAX_FRAME_CAP);
+
+		if (presentPolicy == PresentPolicy::FIXED_CAP)
+		{
+			applyFramePacing();
+		}
+	}
+
+	void applyFramePacing() {
+		switch (presentPolicy)
+		{
+		case PresentPolicy::LOWEST_LATENCY:
+			// rendering faster than the display only produces frames that never get shown
+			frameLimiter.setTargetFps(displayRefreshRate);
+			break;
+		case PresentPolicy::POWER_SAVING:
+			// FIFO already blocks on vertical blank, the limiter only smooths out the CPU side
+			frameLimiter.setTargetFps(displayRefreshRate);
+			break;
+		case PresentPolicy::FIXED_CAP:
+			frameLimiter.setTargetFps(frameCap);
+			break;
+		}
+		// a replay measures how fast the frames can go, not how evenly they're paced
+		if (replaying)
+		{
+			frameLimiter.setTargetFps(0);
+		}
+
+		ostringstream message;
+		message << "present policy: " << presentPolicyName(presentPolicy)
+			<< " (" << presentModeName(swapChainPresentMode) << ", ";
+		if (presentPolicy == PresentPolicy::FIXED_CAP)
+		{
+			message << frameCap << " fps cap)";
+		}
+		else
+		{
+			message << displayRefreshRate << " Hz display)";
+		}
+		logger.log(LOG_SEVERITY_INFO, message.str());
+	}
+
+	// frame rate the limiter aims for, which is also what the GPU time budget is based on
+	int targetFrameRate() {
+		return presentPolicy == PresentPolicy::FIXED_CAP ? frameCap : displayRefreshRate;
+	}
+
+	void reportFrameStats() {
+		if (frameStats.frameCount == 0)
+		{
+			return;
+		}
+
+		double frames = frameStats.frameCount;
+		double averageFrameTime = frameStats.frameTimeSum / frames;
+
+		ostringstream report;
+		report << "frame " << averageFrameTime << " ms"
+			<< " (min " << frameStats.frameTimeMin << ", max " << frameStats.frameTimeMax << ")"
+			<< " | " << 1000.0 / averageFrameTime << " fps"
+			<< " | cpu " << frameStats.cpuTimeSum / frames << " ms"
+			<< " | paced " << frameStats.pacingWaitSum / frames << " ms";
+
+		if (frameStats.latencyCount > 0)
+		{
+			report << " | input->present " << frameStats.latencySum / frameStats.latencyCount << " ms"
+				<< " (max " << frameStats.latencyMax << ")";
+		}
+
+		if (frameStats.gpuTimeCount > 0)
+		{
+			report << " | gpu " << frameStats.gpuTimeSum / frameStats.gpuTimeCount << " ms"
+				<< " at " << renderExtent.width << "x" << renderExtent.height
+				<< " (" << static_cast<int>(resolutionScaler.getScale() * 100.0f + 0.5f) << "%)";
+		}
+
+		// the gpu time stops at the scene pass, so the frame time with it on against off is what the overlap saves
+		if (asyncComputeSupported)
+		{
+			report << " | async compute " << (asyncComputeEnabled ? "on" : "off")
+				<< " (" << frameStats.asyncComputeFrames << " frames";
+			if (frameStats.computeTimeCount > 0)
+			{
+				report << ", " << frameStats.computeTimeSum / frameStats.computeTimeCount << " ms";
+			}
+			report << ")";
+		}
+
+		if (captureActive)
+		{
+			uint64_t framesWritten = captureWriter.framesWritten();
+			double writeTime = captureWriter.writeTimeMs();
+			uint64_t newlyWritten = framesWritten - captureFramesReported;
+
+			report << " | capture " << frameStats.captureTimeSum / frames << " ms/frame"
+				<< " (" << frameStats.capturedFrames << " captured, " << frameStats.droppedCaptures << " dropped"
+				<< ", writer " << (newlyWritten > 0 ? (writeTime - captureWriteTimeReported) / newlyWritten : 0.0) << " ms/frame)";
+
+			captureFramesReported = framesWritten;
+			captureWriteTimeReported = writeTime;
+		}
+
+		if (frameStats.sceneDrawSum > 0)
+		{
+			double binds = static_cast<double>(frameStats.pipelineBindSum + frameStats.materialBindSum) / frames;
+			report << " | scene " << frameStats.sceneDrawSum / frameStats.frameCount << " draws"
+				<< (sortSceneDraws ? " sorted" : " unsorted") << " (" << frameStats.drawSortTimeSum / frames << " ms)"
+				<< ", binds " << binds
+				<< " (" << static_cast<double>(frameStats.unsortedBindSum) / frames - binds << " saved)";
+			if (frameStats.overdrawCount > 0)
+			{
+				report << ", overdraw " << frameStats.overdrawSum / frameStats.overdrawCount << " fragments/pixel";
+			}
+		}
+
+		// with a static scene, the recording time of every reused frame is what got saved
+		if (frameStats.staticSceneReuses + frameStats.staticSceneRecords > 0)
+		{
+			report << " | static scene reused " << frameStats.staticSceneReuses << ", recorded " << frameStats.staticSceneRecords
+				<< " (" << frameStats.staticSceneSavedSum / frames << " ms/frame saved)";
+		}
+
+		if (simulationThread.joinable())
+		{
+			uint64_t steps = simulationSteps.load(memory_order_relaxed);
+			uint64_t skippedSteps = simulationSkippedSteps.load(memory_order_relaxed);
+			uint64_t timeNs = simulationTimeNs.load(memory_order_relaxed);
+			uint64_t newSteps = steps - simulationStepsReported;
+			report << " | simulation " << newSteps << " steps"
+				<< " (" << (newSteps > 0 ? (timeNs - simulationTimeNsReported) / 1000000.0 / newSteps : 0.0) << " ms/step"
+				<< ", " << skippedSteps - simulationSkippedStepsReported << " skipped)";
+			simulationStepsReported = steps;
+			simulationSkippedStepsReported = skippedSteps;
+			simulationTimeNsReported = timeNs;
+		}
+
+		if (frameStats.spriteSum > 0)
+		{
+			report << " | sprites " << frameStats.spriteSum / frameStats.frameCount
+				<< " in " << static_cast<double>(frameStats.spriteDrawSum) / frames << " draws"
+				<< " (" << frameStats.spriteTimeSum / frames << " ms)";
+		}
+
+		if (frameStats.meshInstanceSum > 0)
+		{
+			report << " | meshes " << frameStats.meshVisibleSum / frameStats.frameCount
+				<< " of " << frameStats.meshInstanceSum / frameStats.frameCount << " visible"
+				<< " (" << frameStats.meshOccludedSum / frameStats.frameCount << " of them occluded, "
+				<< 100.0 * frameStats.meshOccludedSum / max<uint64_t>(frameStats.meshVisibleSum, 1) << "%"
+				<< ", occlusion culling " << (hiZSupported && hiZEnabled ? "on" : "off")
+				<< ", culled in " << frameStats.cullTimeSum / frames << " ms)"
+				<< " in " << static_cast<double>(frameStats.meshDrawSum) / frames << " draws"
+				<< ", " << frameStats.meshTriangleSum / frameStats.frameCount << " triangles"
+				<< " (" << 100.0 * frameStats.meshTriangleSum / max<uint64_t>(frameStats.meshFullTriangleSum, 1) << "% of full detail"
+				<< ", LODs " << (meshLodEnabled ? "on" : "off")
+				<< ", " << static_cast<double>(frameStats.lodSwitchSum) / frames << " switches/frame)"
+				<< " (" << frameStats.meshTimeSum / frames << " ms)";
+		}
+
+		if (frameStats.lightSum > 0)
+		{
+			report << " | lights " << frameStats.lightSum / frameStats.frameCount << (clusteredLighting ? " clustered" : " unclustered")
+				<< " (" << frameStats.lightTimeSum / frames << " ms)";
+		}
+
+		if (hudEnabled)
+		{
+			report << " | hud " << frameStats.hudTimeSum / frames << " ms";
+		}
+
+		if (traceWriter.isOpen())
+		{
+			report << " | tracing " << traceWriter.framesWritten() << " frames (" << toMegabytes(traceWriter.sizeWritten()) << " MB)";
+		}
+		if (replaying)
+		{
+			report << " | replay frame " << replayFrame << "/" << traceReader.frameCount()
+				<< ", loop " << min(replayLoop + 1, options.replayLoops) << "/" << options.replayLoops
+				<< " (" << static_cast<double>(frameStats.replayedDrawSum) / frames << " draws"
+				<< ", " << static_cast<double>(frameStats.replayedTriangleSum) / frames << " triangles"
+				<< ", " << frameStats.replayTimeSum / frames << " ms)";
+		}
+
+		// only heaps the engine has anything on
+		for (uint32_t i = 0; i < residency.heapCount(); i++)
+		{
+			ResidencyManager::HeapStats heap = residency.heapStats(i);
+			const auto& categories = heap.categories;
+			if (accumulate(categories.begin(), categories.end(), VkDeviceSize{ 0 }) == 0)
+			{
+				continue;
+			}
+
+			report << " | heap " << i << " " << toMegabytes(heap.usage) << "/" << toMegabytes(heap.budget) << " MB"
+				<< " (textures " << toMegabytes(categories[static_cast<size_t>(MemoryCategory::TEXTURES)])
+				<< ", meshes " << toMegabytes(categories[static_cast<size_t>(MemoryCategory::MESHES)])
+				<< ", attachments " << toMegabytes(categories[static_cast<size_t>(MemoryCategory::ATTACHMENTS)])
+				<< ", staging " << toMegabytes(categories[static_cast<size_t>(MemoryCategory::STAGING)]);
+			if (heap.evictions + heap.degradations > 0)
+			{
+				report << ", " << heap.evictions << " evicted, " << heap.degradations << " degraded";
+			}
+			report << ")";
+		}
+
+		// should settle at 0 once the driver is warmed up
+		uint64_t hostAllocations = hostAllocator.allocationCount();
+		report << " | host allocs " << (hostAllocations - hostAllocationsReported) / frames << "/frame";
+		hostAllocationsReported = hostAllocations;
+
+		report << " | " << presentModeName(swapChainPresentMode);
+		// formatting the numbers is cheap enough, writing them out is left to the logger thread
+		logger.log(LOG_SEVERITY_INFO, report.str());
+
+		frameStats = FrameStats{};
+	}
+
+	static double toMilliseconds(chrono::steady_clock::duration duration) {
+		return chrono::duration<double, milli>(duration).count();
+	}
+
+	static double toMegabytes(VkDeviceSize size) {
+		return static_cast<double>(size) / (1024.0 * 1024.0);
+	}
+	#pragma endregion FRAME PACING
+
+	#pragma region --- CLEANUP ---
+	void cleanup() {
+		// usage right before teardown, the steady column holds what it was once the first frames were done
+		logger.log(LOG_SEVERITY_INFO, hostAllocator.report());
+
+		// destroy the swap chain and everything that depends on its images
+		cleanupSwapChain();
+
+		// destroy the synchronization objects
+		for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+		{
+			vkDestroySemaphore(device, imageAvailableSemaphores[i], allocator(VK_OBJECT_TYPE_SEMAPHORE));
+		}
+		// only one of the two got created
+		for (VkFence fence : inFlightFences)
+		{
+			vkDestroyFence(device, fence, allocator(VK_OBJECT_TYPE_FENCE));
+		}
+		vkDestroySemaphore(device, sceneTimeline, allocator(VK_OBJECT_TYPE_SEMAPHORE));
+		vkDestroySemaphore(device, frameTimeline, allocator(VK_OBJECT_TYPE_SEMAPHORE));
+		vkDestroySemaphore(device, computeTimeline, allocator(VK_OBJECT_TYPE_SEMAPHORE));
+
+		if (timestampQueryPool != VK_NULL_HANDLE)
+		{
+			vkDestroyQueryPool(device, timestampQueryPool, allocator(VK_OBJECT_TYPE_QUERY_POOL));
+		}
+		if (statisticsQueryPool != VK_NULL_HANDLE)
+		{
+			vkDestroyQueryPool(device, statisticsQueryPool, allocator(VK_OBJECT_TYPE_QUERY_POOL));
+		}
+		if (computeTimestampQueryPool != VK_NULL_HANDLE)
+		{
+			vkDestroyQueryPool(device, computeTimestampQueryPool, allocator(VK_OBJECT_TYPE_QUERY_POOL));
+		}
+
+		// destroy the mesh resources
+		vkDestroyBuffer(device, meshVertexBuffer, allocator(VK_OBJECT_TYPE_BUFFER));
+		freeDeviceMemory(meshVertexBufferMemory);
+		vkDestroyBuffer(device, meshIndexBuffer, allocator(VK_OBJECT_TYPE_BUFFER));
+		freeDeviceMemory(meshIndexBufferMemory);
+		for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+		{
+			vkDestroyBuffer(device, meshInstanceBuffers[i], allocator(VK_OBJECT_TYPE_BUFFER));
+			freeDeviceMemory(meshInstanceBufferMemory[i]);
+		}
+		vkDestroyPipeline(device, meshPipeline, allocator(VK_OBJECT_TYPE_PIPELINE));
+
+		// destroy the lighting resources, the descriptor sets go with the pool
+		for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+		{
+			vkDestroyBuffer(device, lightBuffers[i], allocator(VK_OBJECT_TYPE_BUFFER));
+			freeDeviceMemory(lightBufferMemory[i]);
+			vkDestroyBuffer(device, clusterBuffers[i], allocator(VK_OBJECT_TYPE_BUFFER));
+			freeDeviceMemory(clusterBufferMemory[i]);
+		}
+		vkDestroyPipeline(device, lightBinningPipeline, allocator(VK_OBJECT_TYPE_PIPELINE));
+		vkDestroyDescriptorPool(device, lightingDescriptorPool, allocator(VK_OBJECT_TYPE_DESCRIPTOR_POOL));
+
+		// destroy the occlusion culling resources, null handles are ignored when the device couldn't build the depth pyramid
+		vkDestroyPipeline(device, hiZPipeline, allocator(VK_OBJECT_TYPE_PIPELINE));
+		vkDestroySampler(device, hiZSampler, allocator(VK_OBJECT_TYPE_SAMPLER));
+
+		// destroy the HUD resources
+		vkDestroyPipeline(device, hudPipeline, allocator(VK_OBJECT_TYPE_PIPELINE));
+		vkDestroyDescriptorPool(device, hudDescriptorPool, allocator(VK_OBJECT_TYPE_DESCRIPTOR_POOL));
+		vkDestroySampler(device, hudSampler, allocator(VK_OBJECT_TYPE_SAMPLER));
+		vkDestroyImageView(device, hudAtlasView, allocator(VK_OBJECT_TYPE_IMAGE_VIEW));
+		vkDestroyImage(device, hudAtlasImage, allocator(VK_OBJECT_TYPE_IMAGE));
+		freeDeviceMemory(hudAtlasMemory);
+		for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+		{
+			vkDestroyBuffer(device, hudInstanceBuffers[i], allocator(VK_OBJECT_TYPE_BUFFER));
+			freeDeviceMemory(hudInstanceBufferMemory[i]);
+		}
+
+		// destroy the sprite resources
+		for (SpriteTexture& texture : spriteTextures)
+		{
+			vkDestroyImageView(device, texture.imageView, allocator(VK_OBJECT_TYPE_IMAGE_VIEW));
+			vkDestroyImage(device, texture.image, allocator(VK_OBJECT_TYPE_IMAGE));
+			freeDeviceMemory(texture.memory);
+		}
+		vkDestroyDescriptorPool(device, spriteDescriptorPool, allocator(VK_OBJECT_TYPE_DESCRIPTOR_POOL));
+		vkDestroySampler(device, spriteSampler, allocator(VK_OBJECT_TYPE_SAMPLER));
+		for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+		{
+			vkDestroyBuffer(device, spriteVertexBuffers[i], allocator(VK_OBJECT_TYPE_BUFFER));
+			freeDeviceMemory(spriteVertexBufferMemory[i]);
+		}
+		vkDestroyBuffer(device, spriteIndexBuffer, allocator(VK_OBJECT_TYPE_BUFFER));
+		freeDeviceMemory(spriteIndexBufferMemory);
+		for (VkPipeline pipeline : spritePipelines)
+		{
+			vkDestroyPipeline(device, pipeline, allocator(VK_OBJECT_TYPE_PIPELINE));
+		}
+
+		// destroy the command pools, command buffers are freed along with them
+		vkDestroyCommandPool(device, commandPool, allocator(VK_OBJECT_TYPE_COMMAND_POOL));
+		vkDestroyCommandPool(device, computeCommandPool, allocator(VK_OBJECT_TYPE_COMMAND_POOL));
+
+		// destroy the pipelines
+		for (VkPipeline pipeline : scenePipelines)
+		{
+			vkDestroyPipeline(device, pipeline, allocator(VK_OBJECT_TYPE_PIPELINE));
+		}
+		// destroy every pipeline layout and descriptor set layout, the pipelines using them are gone by now
+		layoutCache.destroy();
+		// destroy the render pass
+		vkDestroyRenderPass(device, renderPass, allocator(VK_OBJECT_TYPE_RENDER_PASS));
+
+		// destroy the logical device
+		vkDestroyDevice(device, allocator(VK_OBJECT_TYPE_DEVICE));
+
+		// destroy the debugger
+		if (enableValidationLayers)
+		{
+			DestroyDebugUtilsMessengerEXT(instance, debugMessenger, allocator(VK_OBJECT_TYPE_DEBUG_UTILS_MESSENGER_EXT));
+		}
+
+		// destroy the surface of the window
+		vkDestroySurfaceKHR(instance, surface, allocator(VK_OBJECT_TYPE_SURFACE_KHR));
+		// destroy the vulkan instance
+		vkDestroyInstance(instance, allocator(VK_OBJECT_TYPE_INSTANCE));
+
+		if (window != nullptr)
+		{
+			// destroy the window
+			glfwDestroyWindow(window);
+
+			// terminate glfw
+			glfwTerminate();
+		}
+	}
+	#pragma endregion CLEANUP
+};
+
+int main(int argc, char* argv[]) {
+	LaunchOptions options;
+	for (int i = 1; i < argc; i++)
+	{
+		string argument = argv[i];
+		if (argument == "--replay" && i + 1 < argc)
+		{
+			options.replayPath = argv[++i];
+		}
+		else if (argument == "--loops" && i + 1 < argc)
+		{
+			options.replayLoops = max(static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10)), 1u);
+		}
+		else if (argument == "--headless")
+		{
+			options.headless = true;
+		}
+		else if (argument == "--sync-assets")
+		{
+			options.synchronousAssets = true;
+		}
+		else
+		{
+			printError << "unknown argument " << argument << endl
+				<< "usage: Emergine [--replay <trace> [--loops <count>] [--headless]] [--sync-assets]" << endl;
+			return EXIT_FAILURE;
+		}
+	}
+	// without a window there's no input, so nothing but a replay could drive it
+	if (options.headless && !options.replayPath.has_value())
+	{
+		printError << "--headless only works together with --replay" << endl;
+		return EXIT_FAILURE;
 	}
-	#pragma endregion CLEANUP
-};
 
-int main() {
-	EmergineApp app;
+	EmergineApp app(options);
 
 	try
 	{